@@ -0,0 +1,649 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include "BlockCompression.h"
+#include "Image.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_SSE2 1
+#else
+#define BLOCK_COMPRESSION_SSE2 0
+#endif
+
+namespace {
+
+	constexpr int TEXELS = 16;
+
+	// Blocks per job, so small levels aren't split into uselessly small jobs
+	constexpr std::size_t BLOCKS_PER_JOB = 256;
+
+	// BC1 texels under this alpha are made transparent
+	constexpr float BC1_ALPHA_THRESHOLD = 128.0f;
+
+	// Palette index of each position along the line from the first endpoint to the second
+	constexpr unsigned int BC1_OPAQUE_INDICES[4] = { 0, 2, 3, 1 };
+	constexpr unsigned int BC1_TRANSPARENT_INDICES[3] = { 0, 2, 1 };
+	constexpr unsigned int BC1_TRANSPARENT_INDEX = 3;
+
+	// BC4 alpha positions run from the lower endpoint, which is stored second
+	constexpr std::uint64_t BC4_INDICES[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+
+	// BC7's 4 bit palette weights, out of 64
+	constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	constexpr unsigned int BC7_MODE_6 = 1 << 6;
+
+	// 4 floats, one SSE register where available
+#if BLOCK_COMPRESSION_SSE2
+	typedef __m128 Lanes;
+
+	inline Lanes Load(const float* values) { return _mm_load_ps(values); }
+	inline void Store(float* values, Lanes lanes) { _mm_store_ps(values, lanes); }
+	inline Lanes Splat(float value) { return _mm_set1_ps(value); }
+	inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+	inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+	inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+	inline Lanes Clamp(Lanes a, float low, float high) { return _mm_min_ps(_mm_max_ps(a, _mm_set1_ps(low)), _mm_set1_ps(high)); }
+
+	inline float Sum(Lanes a)
+	{
+		Lanes pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+	}
+#else
+	typedef struct Lanes
+	{
+		float v[4];
+	} Lanes;
+
+	inline Lanes Load(const float* values) { return Lanes{ { values[0], values[1], values[2], values[3] } }; }
+	inline void Store(float* values, Lanes lanes) { for (int l = 0; l < 4; l++) { values[l] = lanes.v[l]; } }
+	inline Lanes Splat(float value) { return Lanes{ { value, value, value, value } }; }
+	inline Lanes Add(Lanes a, Lanes b) { for (int l = 0; l < 4; l++) { a.v[l] += b.v[l]; } return a; }
+	inline Lanes Sub(Lanes a, Lanes b) { for (int l = 0; l < 4; l++) { a.v[l] -= b.v[l]; } return a; }
+	inline Lanes Mul(Lanes a, Lanes b) { for (int l = 0; l < 4; l++) { a.v[l] *= b.v[l]; } return a; }
+	inline Lanes Clamp(Lanes a, float low, float high) { for (int l = 0; l < 4; l++) { a.v[l] = std::clamp(a.v[l], low, high); } return a; }
+	inline float Sum(Lanes a) { return a.v[0] + a.v[1] + a.v[2] + a.v[3]; }
+#endif
+
+	// A block's texels channel by channel, 0 to 255
+	typedef struct Block
+	{
+		alignas(16) float channels[4][TEXELS];
+		alignas(16) float weights[TEXELS];      // How much each texel counts when fitting colours
+	} Block;
+
+	typedef struct Endpoints
+	{
+		float first[4];
+		float second[4];
+	} Endpoints;
+
+	void LoadBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, Block& block)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			const int row = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				const unsigned char* texel = rgba + ((std::size_t)row * width + std::min(blockX * 4 + x, width - 1)) * 4;
+				for (int c = 0; c < 4; c++) { block.channels[c][y * 4 + x] = texel[c]; }
+				block.weights[y * 4 + x] = 1.0f;
+			}
+		}
+	}
+
+	// Line through the weighted texels along their principal axis, clipped to their extent
+	Endpoints FitLine(const Block& block, int channels)
+	{
+		Lanes totalWeight = Splat(0.0f);
+		for (int g = 0; g < TEXELS; g += 4) { totalWeight = Add(totalWeight, Load(block.weights + g)); }
+		const float weightScale = 1.0f / Sum(totalWeight);
+
+		float mean[4] = {};
+		for (int c = 0; c < channels; c++)
+		{
+			Lanes sum = Splat(0.0f);
+			for (int g = 0; g < TEXELS; g += 4) { sum = Add(sum, Mul(Load(block.weights + g), Load(block.channels[c] + g))); }
+			mean[c] = Sum(sum) * weightScale;
+		}
+
+		Lanes centred[4][TEXELS / 4];
+		for (int c = 0; c < channels; c++)
+		{
+			for (int g = 0; g < TEXELS / 4; g++) { centred[c][g] = Sub(Load(block.channels[c] + g * 4), Splat(mean[c])); }
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < channels; i++)
+		{
+			for (int j = i; j < channels; j++)
+			{
+				Lanes sum = Splat(0.0f);
+				for (int g = 0; g < TEXELS / 4; g++) { sum = Add(sum, Mul(Mul(centred[i][g], centred[j][g]), Load(block.weights + g * 4))); }
+				covariance[i][j] = covariance[j][i] = Sum(sum);
+			}
+		}
+
+		// Power iteration, starting from the channel that varies most
+		int largest = 0;
+		for (int c = 1; c < channels; c++) { if (covariance[c][c] > covariance[largest][largest]) { largest = c; } }
+
+		float axis[4] = {};
+		for (int c = 0; c < channels; c++) { axis[c] = covariance[c][largest]; }
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = {}, size = 0.0f;
+			for (int i = 0; i < channels; i++)
+			{
+				for (int j = 0; j < channels; j++) { next[i] += covariance[i][j] * axis[j]; }
+				size = std::max(size, std::fabs(next[i]));
+			}
+			if (size < 1e-12f) { break; }
+			for (int c = 0; c < channels; c++) { axis[c] = next[c] / size; }
+		}
+
+		float length = 0.0f;
+		for (int c = 0; c < channels; c++) { length += axis[c] * axis[c]; }
+		length = std::sqrt(length);
+		for (int c = 0; c < channels; c++) { axis[c] = length > 1e-6f ? axis[c] / length : 0.0f; }
+
+		alignas(16) float projections[TEXELS];
+		for (int g = 0; g < TEXELS / 4; g++)
+		{
+			Lanes dot = Splat(0.0f);
+			for (int c = 0; c < channels; c++) { dot = Add(dot, Mul(centred[c][g], Splat(axis[c]))); }
+			Store(projections + g * 4, dot);
+		}
+
+		float low = 0.0f, high = 0.0f;
+		for (int i = 0; i < TEXELS; i++)
+		{
+			if (block.weights[i] == 0.0f) { continue; }
+			low = std::min(low, projections[i]);
+			high = std::max(high, projections[i]);
+		}
+
+		Endpoints endpoints = {};
+		for (int c = 0; c < channels; c++)
+		{
+			endpoints.first[c] = std::clamp(mean[c] + axis[c] * low, 0.0f, 255.0f);
+			endpoints.second[c] = std::clamp(mean[c] + axis[c] * high, 0.0f, 255.0f);
+		}
+		return endpoints;
+	}
+
+	// Where each texel's closest point on the line between the endpoints is, 0 to 1
+	void Project(const Block& block, int channels, const Endpoints& endpoints, float* t)
+	{
+		float direction[4] = {}, lengthSquared = 0.0f;
+		for (int c = 0; c < channels; c++)
+		{
+			direction[c] = endpoints.second[c] - endpoints.first[c];
+			lengthSquared += direction[c] * direction[c];
+		}
+
+		const float scale = lengthSquared > 1e-6f ? 1.0f / lengthSquared : 0.0f;
+		for (int g = 0; g < TEXELS; g += 4)
+		{
+			Lanes dot = Splat(0.0f);
+			for (int c = 0; c < channels; c++)
+			{
+				dot = Add(dot, Mul(Sub(Load(block.channels[c] + g), Splat(endpoints.first[c])), Splat(direction[c] * scale)));
+			}
+			Store(t + g, Clamp(dot, 0.0f, 1.0f));
+		}
+	}
+
+	// Weighted squared error of the texels reconstructed at fractions f along the endpoints
+	float Error(const Block& block, int channels, const Endpoints& endpoints, const float* f)
+	{
+		Lanes error = Splat(0.0f);
+		for (int g = 0; g < TEXELS; g += 4)
+		{
+			Lanes fraction = Load(f + g), weight = Load(block.weights + g);
+			for (int c = 0; c < channels; c++)
+			{
+				Lanes value = Add(Splat(endpoints.first[c]), Mul(fraction, Splat(endpoints.second[c] - endpoints.first[c])));
+				Lanes difference = Sub(Load(block.channels[c] + g), value);
+				error = Add(error, Mul(Mul(difference, difference), weight));
+			}
+		}
+		return Sum(error);
+	}
+
+	/**
+	* @brief    Least squares endpoints for texels fixed at fractions f along
+	*           the line between them
+	*
+	* @return   false if every texel is at the same fraction, so the endpoints
+	*           can't be separated
+	*/
+	bool Refit(const Block& block, int channels, const float* f, Endpoints& endpoints)
+	{
+		Lanes a = Splat(0.0f), b = Splat(0.0f), c = Splat(0.0f);
+		Lanes firstSums[4], secondSums[4];
+		for (int ch = 0; ch < channels; ch++) { firstSums[ch] = secondSums[ch] = Splat(0.0f); }
+
+		for (int g = 0; g < TEXELS; g += 4)
+		{
+			Lanes weight = Load(block.weights + g), toSecond = Load(f + g);
+			Lanes toFirst = Sub(Splat(1.0f), toSecond);
+			Lanes weightedFirst = Mul(weight, toFirst), weightedSecond = Mul(weight, toSecond);
+
+			a = Add(a, Mul(weightedFirst, toFirst));
+			b = Add(b, Mul(weightedFirst, toSecond));
+			c = Add(c, Mul(weightedSecond, toSecond));
+			for (int ch = 0; ch < channels; ch++)
+			{
+				Lanes value = Load(block.channels[ch] + g);
+				firstSums[ch] = Add(firstSums[ch], Mul(weightedFirst, value));
+				secondSums[ch] = Add(secondSums[ch], Mul(weightedSecond, value));
+			}
+		}
+
+		const float aa = Sum(a), bb = Sum(b), cc = Sum(c);
+		const float determinant = aa * cc - bb * bb;
+		if (std::fabs(determinant) < 1e-6f) { return false; }
+
+		for (int ch = 0; ch < channels; ch++)
+		{
+			const float firstSum = Sum(firstSums[ch]), secondSum = Sum(secondSums[ch]);
+			endpoints.first[ch] = std::clamp((cc * firstSum - bb * secondSum) / determinant, 0.0f, 255.0f);
+			endpoints.second[ch] = std::clamp((aa * secondSum - bb * firstSum) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	std::uint16_t To565(const float* rgb)
+	{
+		const int r = (int)(rgb[0] * 31.0f / 255.0f + 0.5f);
+		const int g = (int)(rgb[1] * 63.0f / 255.0f + 0.5f);
+		const int b = (int)(rgb[2] * 31.0f / 255.0f + 0.5f);
+		return (std::uint16_t)(r << 11 | g << 5 | b);
+	}
+
+	void From565(std::uint16_t color, float* rgb)
+	{
+		const int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+		rgb[0] = (float)(r << 3 | r >> 2);
+		rgb[1] = (float)(g << 2 | g >> 4);
+		rgb[2] = (float)(b << 3 | b >> 2);
+	}
+
+	typedef struct ColorBlock
+	{
+		std::uint16_t colors[2];
+		std::uint32_t indices;
+		float error;
+	} ColorBlock;
+
+	// Quantize endpoints to 565 and pick each texel's palette entry. f gets the entries' fractions along the line
+	ColorBlock QuantizeColor(const Block& block, const Endpoints& fitted, bool transparentMode, float* f)
+	{
+		ColorBlock encoded;
+		encoded.colors[0] = To565(fitted.first);
+		encoded.colors[1] = To565(fitted.second);
+
+		// The endpoints' order picks the mode: 4 colours if the first is larger, otherwise 3 and transparent
+		if (transparentMode ? encoded.colors[0] > encoded.colors[1] : encoded.colors[0] < encoded.colors[1])
+		{
+			std::swap(encoded.colors[0], encoded.colors[1]);
+		}
+
+		Endpoints quantized = {};
+		From565(encoded.colors[0], quantized.first);
+		From565(encoded.colors[1], quantized.second);
+
+		alignas(16) float t[TEXELS];
+		Project(block, 3, quantized, t);
+
+		const int steps = transparentMode ? 2 : 3;
+		encoded.indices = 0;
+		for (int i = 0; i < TEXELS; i++)
+		{
+			const int position = (int)(t[i] * steps + 0.5f);
+			f[i] = (float)position / steps;
+
+			unsigned int index = transparentMode ? BC1_TRANSPARENT_INDICES[position] : BC1_OPAQUE_INDICES[position];
+			if (block.weights[i] == 0.0f) { index = BC1_TRANSPARENT_INDEX; }
+			encoded.indices |= index << (i * 2);
+		}
+
+		encoded.error = Error(block, 3, quantized, f);
+		return encoded;
+	}
+
+	// BC1 colour block. With allowTransparent, texels under half alpha are made transparent
+	void EncodeColor(Block& block, bool allowTransparent, unsigned char* out)
+	{
+		bool transparentMode = false, anyOpaque = false;
+		for (int i = 0; i < TEXELS; i++)
+		{
+			if (allowTransparent && block.channels[3][i] < BC1_ALPHA_THRESHOLD)
+			{
+				block.weights[i] = 0.0f;
+				transparentMode = true;
+			}
+			else { anyOpaque = true; }
+		}
+
+		ColorBlock best = { { 0, 0 }, 0xFFFFFFFF, 0.0f };
+		if (anyOpaque)
+		{
+			alignas(16) float f[TEXELS];
+			best = QuantizeColor(block, FitLine(block, 3), transparentMode, f);
+
+			Endpoints refitted;
+			if (best.error > 0.0f && Refit(block, 3, f, refitted))
+			{
+				ColorBlock candidate = QuantizeColor(block, refitted, transparentMode, f);
+				if (candidate.error < best.error) { best = candidate; }
+			}
+		}
+
+		out[0] = (unsigned char)best.colors[0];
+		out[1] = (unsigned char)(best.colors[0] >> 8);
+		out[2] = (unsigned char)best.colors[1];
+		out[3] = (unsigned char)(best.colors[1] >> 8);
+		for (int b = 0; b < 4; b++) { out[4 + b] = (unsigned char)(best.indices >> (b * 8)); }
+	}
+
+	// BC4 block of the alpha channel, spanning the block's alpha range
+	void EncodeAlpha(const Block& block, unsigned char* out)
+	{
+		const float* alpha = block.channels[3];
+		float low = 255.0f, high = 0.0f;
+		for (int i = 0; i < TEXELS; i++)
+		{
+			low = std::min(low, alpha[i]);
+			high = std::max(high, alpha[i]);
+		}
+
+		// The larger endpoint first selects 8 evenly spaced values
+		out[0] = (unsigned char)high;
+		out[1] = (unsigned char)low;
+
+		std::uint64_t indices = 0;
+		if (high > low)
+		{
+			alignas(16) float positions[TEXELS];
+			const Lanes scale = Splat(7.0f / (high - low));
+			for (int g = 0; g < TEXELS; g += 4) { Store(positions + g, Mul(Sub(Load(alpha + g), Splat(low)), scale)); }
+
+			for (int i = 0; i < TEXELS; i++) { indices |= BC4_INDICES[(int)(positions[i] + 0.5f)] << (i * 3); }
+		}
+
+		for (int b = 0; b < 6; b++) { out[2 + b] = (unsigned char)(indices >> (b * 8)); }
+	}
+
+	typedef struct Mode6Block
+	{
+		int endpoints[2][4];    // 7 bits per channel
+		int pBits[2];           // Low bit shared by every channel of an endpoint
+		int indices[TEXELS];
+		float error;
+	} Mode6Block;
+
+	// Quantize an endpoint to 7 bits per channel plus the p-bit that suits it best
+	void QuantizeEndpoint(const float* value, int* quantized, int& pBit, float* decoded)
+	{
+		float bestError = INFINITY;
+		for (int p = 0; p < 2; p++)
+		{
+			int candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate[c] = std::clamp((int)((value[c] - p) * 0.5f + 0.5f), 0, 127);
+				float difference = value[c] - (candidate[c] * 2 + p);
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				pBit = p;
+				for (int c = 0; c < 4; c++) { quantized[c] = candidate[c]; }
+			}
+		}
+
+		for (int c = 0; c < 4; c++) { decoded[c] = (float)(quantized[c] * 2 + pBit); }
+	}
+
+	Mode6Block QuantizeMode6(const Block& block, const Endpoints& fitted, float* f)
+	{
+		Mode6Block encoded;
+		Endpoints quantized;
+		QuantizeEndpoint(fitted.first, encoded.endpoints[0], encoded.pBits[0], quantized.first);
+		QuantizeEndpoint(fitted.second, encoded.endpoints[1], encoded.pBits[1], quantized.second);
+
+		alignas(16) float t[TEXELS];
+		Project(block, 4, quantized, t);
+
+		// The weights are within a rounding of evenly spaced, so the nearest is the rounded position
+		for (int i = 0; i < TEXELS; i++)
+		{
+			encoded.indices[i] = (int)(t[i] * 15.0f + 0.5f);
+			f[i] = BC7_WEIGHTS[encoded.indices[i]] / 64.0f;
+		}
+
+		encoded.error = Error(block, 4, quantized, f);
+		return encoded;
+	}
+
+	// Appends bits to a 128 bit block, lowest bit first
+	typedef struct BitWriter
+	{
+		std::uint64_t words[2] = {};
+		int position = 0;
+
+		void Write(std::uint64_t value, int bits)
+		{
+			for (int b = 0; b < bits; b++, position++)
+			{
+				words[position >> 6] |= (value >> b & 1) << (position & 63);
+			}
+		}
+	} BitWriter;
+
+	void EncodeBC7(const Block& block, unsigned char* out)
+	{
+		alignas(16) float f[TEXELS];
+		Mode6Block best = QuantizeMode6(block, FitLine(block, 4), f);
+
+		Endpoints refitted;
+		if (best.error > 0.0f && Refit(block, 4, f, refitted))
+		{
+			Mode6Block candidate = QuantizeMode6(block, refitted, f);
+			if (candidate.error < best.error) { best = candidate; }
+		}
+
+		// The first texel's index is stored without its top bit, so it must be clear
+		if (best.indices[0] & 8)
+		{
+			for (int c = 0; c < 4; c++) { std::swap(best.endpoints[0][c], best.endpoints[1][c]); }
+			std::swap(best.pBits[0], best.pBits[1]);
+			for (int i = 0; i < TEXELS; i++) { best.indices[i] = 15 - best.indices[i]; }
+		}
+
+		BitWriter writer;
+		writer.Write(BC7_MODE_6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			writer.Write(best.endpoints[0][c], 7);
+			writer.Write(best.endpoints[1][c], 7);
+		}
+		writer.Write(best.pBits[0], 1);
+		writer.Write(best.pBits[1], 1);
+
+		writer.Write(best.indices[0], 3);
+		for (int i = 1; i < TEXELS; i++) { writer.Write(best.indices[i], 4); }
+
+		for (int b = 0; b < 16; b++) { out[b] = (unsigned char)(writer.words[b >> 3] >> ((b & 7) * 8)); }
+	}
+
+	// Synthetic image with gradients, hard edges, noise and soft alpha
+	std::vector<unsigned char> GenerateTestImage(int size)
+	{
+		std::vector<unsigned char> rgba((std::size_t)size * size * 4);
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				unsigned char* texel = rgba.data() + ((std::size_t)y * size + x) * 4;
+				const unsigned int noise = ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u) * 2654435761u >> 27;
+				const float dx = x - size * 0.5f, dy = y - size * 0.5f;
+				const float radius = std::sqrt(dx * dx + dy * dy) / (size * 0.5f);
+
+				texel[0] = (unsigned char)(x * 255 / size);
+				texel[1] = (unsigned char)((x / 64 + y / 64) % 2 ? 200 : 40);
+				texel[2] = (unsigned char)std::min<unsigned int>(y * 255 / size + noise, 255);
+				texel[3] = (unsigned char)(std::clamp(1.5f - radius, 0.0f, 1.0f) * 255.0f);
+			}
+		}
+		return rgba;
+	}
+}
+
+void textures::CompressImage(const unsigned char* rgba, int width, int height, PixelFormat format, unsigned char* blocks)
+{
+	const int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+	const std::size_t blockSize = ImageSize(format, 4, 4);
+	const std::size_t rowsPerJob = std::max<std::size_t>(BLOCKS_PER_JOB / blocksWide, 1);
+
+	jobs::ParallelFor(blocksHigh, rowsPerJob, [&](std::size_t begin, std::size_t end)
+	{
+		Block block;
+		for (std::size_t blockY = begin; blockY < end; blockY++)
+		{
+			for (int blockX = 0; blockX < blocksWide; blockX++)
+			{
+				LoadBlock(rgba, width, height, blockX, (int)blockY, block);
+				unsigned char* out = blocks + (blockY * blocksWide + blockX) * blockSize;
+
+				switch (format)
+				{
+				case PixelFormat::BC1:
+				case PixelFormat::BC1_SRGB:
+					EncodeColor(block, true, out);
+					break;
+				case PixelFormat::BC3:
+				case PixelFormat::BC3_SRGB:
+					EncodeAlpha(block, out);
+					EncodeColor(block, false, out + 8);
+					break;
+				default:
+					EncodeBC7(block, out);
+					break;
+				}
+			}
+		}
+	});
+}
+
+void textures::CompressMipChain(const unsigned char* rgbaChain, int width, int height, int levels, PixelFormat format, unsigned char* blocks)
+{
+	for (int level = 0; level < levels; level++)
+	{
+		const int levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+		CompressImage(rgbaChain, levelWidth, levelHeight, format, blocks);
+
+		rgbaChain += ImageSize(PixelFormat::RGBA8, levelWidth, levelHeight);
+		blocks += ImageSize(format, levelWidth, levelHeight);
+	}
+}
+
+void textures::RunCompressionBenchmark(const std::vector<std::string>& paths)
+{
+	constexpr int GENERATED_SIZE = 2048;
+	constexpr std::size_t RING_CAPACITY = 64 << 20;
+
+	typedef struct SourceImage
+	{
+		std::string name;
+		int width, height;
+		std::vector<unsigned char> rgba;
+	} SourceImage;
+
+	std::vector<SourceImage> images;
+	for (const std::string& path : paths)
+	{
+		MappedFile file;
+		image::ImageInfo info;
+		SourceImage source{ path, 0, 0, {} };
+
+		if (file.Open(path.c_str()) && image::ReadInfo(file.Data(), file.Size(), info))
+		{
+			source.width = info.width;
+			source.height = info.height;
+			source.rgba.resize(ImageSize(PixelFormat::RGBA8, info.width, info.height));
+			if (image::Decode(file.Data(), file.Size(), source.rgba.data()))
+			{
+				images.push_back(std::move(source));
+				continue;
+			}
+		}
+
+		std::cerr << "Failed to load " << path << std::endl;
+	}
+	if (paths.empty()) { images.push_back(SourceImage{ "generated", GENERATED_SIZE, GENERATED_SIZE, GenerateTestImage(GENERATED_SIZE) }); }
+
+	UploadRing ring;
+	if (!ring.Create(RING_CAPACITY))
+	{
+		std::cerr << "Failed to create the upload ring" << std::endl;
+		return;
+	}
+
+	const PixelFormat formats[] = { PixelFormat::BC1, PixelFormat::BC3, PixelFormat::BC7 };
+	const char* formatNames[] = { "BC1", "BC3", "BC7" };
+
+	std::cout << "Block compression on " << jobs::ThreadCount() << " threads\n";
+	std::cout << "image\tformat\tMpixels/s\tPSNR dB\n";
+
+	for (const SourceImage& source : images)
+	{
+		for (int f = 0; f < 3; f++)
+		{
+			std::vector<unsigned char> blocks(ImageSize(formats[f], source.width, source.height));
+
+			auto start = std::chrono::steady_clock::now();
+			CompressImage(source.rgba.data(), source.width, source.height, formats[f], blocks.data());
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << source.name << '\t' << formatNames[f] << '\t' << source.width * (double)source.height / 1e6 / seconds << '\t';
+			if (!IsSupported(formats[f]))
+			{
+				std::cout << "unsupported by the driver\n";
+				continue;
+			}
+
+			// Let the driver decode, so the PSNR is what will actually be sampled
+			Texture texture = Create2D(source.width, source.height, formats[f], 1);
+			ring.Upload(texture, 0, 0, blocks.data());
+			ring.Retire(true);
+
+			std::vector<unsigned char> decoded(source.rgba.size());
+			glBindTexture(GL_TEXTURE_2D, texture.id);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+			Release(texture);
+
+			double squaredError = 0.0;
+			for (std::size_t i = 0; i < decoded.size(); i++)
+			{
+				double difference = (double)decoded[i] - source.rgba[i];
+				squaredError += difference * difference;
+			}
+			double meanSquaredError = std::max(squaredError / decoded.size(), 1e-10);
+			std::cout << 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) << '\n';
+		}
+	}
+
+	std::cout << std::flush;
+}
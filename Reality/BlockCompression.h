@@ -0,0 +1,58 @@
+/**
+ * @file BlockCompression.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief CPU encoder for the BC1, BC3 and BC7 block compressed
+ *        formats, for compressing textures while assets load
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include "Texture.h"
+
+namespace textures {
+
+	/*
+	* Every 4x4 block is encoded independently, so rows of blocks are
+	* spread over the job system. Colours are fitted to a line through the
+	* block's texels: its mean and principal axis, with the texels'
+	* channels laid out channel by channel so 4 texels are projected at
+	* once with SIMD. Endpoints are quantized, then refitted once by least
+	* squares to the palette entries the texels picked, keeping whichever
+	* encoding is closer.
+	*
+	* BC1 blocks with texels under half alpha use BC1's 3 colour mode with
+	* those texels transparent. BC3 alpha uses the block's alpha range.
+	* BC7 blocks all use mode 6: one RGBA line with 16 palette entries,
+	* which handles most sprites well and is far quicker than searching
+	* BC7's other modes and partitions.
+	*/
+
+	/**
+	* @brief            Compress an RGBA8 image. Blocks past the image's edge
+	*                   repeat its last row and column
+	*
+	* @param format     one of the compressed formats
+	* @param blocks     ImageSize(format, width, height) bytes
+	*/
+	void CompressImage(const unsigned char* rgba, int width, int height, PixelFormat format, unsigned char* blocks);
+
+	/**
+	* @brief            Compress every level of an RGBA8 mip chain
+	*
+	* @param rgbaChain  levels laid out as for MipChainSize
+	* @param blocks     MipChainSize(format, width, height, levels) bytes
+	*/
+	void CompressMipChain(const unsigned char* rgbaChain, int width, int height, int levels, PixelFormat format, unsigned char* blocks);
+
+	/**
+	* @brief        Time compressing images to each format and print the throughput
+	*               and the PSNR of what the driver decodes. Uses a generated image
+	*               if paths is empty. Needs a current GL context
+	*/
+	void RunCompressionBenchmark(const std::vector<std::string>& paths);
+}
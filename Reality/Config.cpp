@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "Config.h"
+#include "Json.h"
+
+namespace {
+
+	// Every key Apply takes
+	const char* const KEYS[] = { "resolution", "fullscreen", "debug", "debug-mute", "annotations", "vsync", "fps", "msaa", "backend" };
+
+	constexpr std::size_t ANY = (std::size_t)-1;
+
+	// The golden images checked into the repo, relative to the working directory like Shaders/
+	const char* const GOLDEN_DIRECTORY = "Golden";
+
+	// The command line only options and how many arguments each takes
+	typedef struct OptionArity
+	{
+		const char* name;
+		std::size_t least, most;
+	} OptionArity;
+
+	const OptionArity LAUNCH_OPTIONS[] = {
+		{ "config", 1, 1 }, { "software", 0, 0 }, { "mesh", 1, 1 }, { "dump", 2, 2 }, { "record", 1, 1 },
+		{ "trace", 1, 1 }, { "convert", 2, 2 }, { "golden", 1, 2 }, { "benchmark", 1, ANY }
+	};
+
+	// Each benchmark and how many arguments it takes after its name
+	const OptionArity BENCHMARKS[] = {
+		{ "textures", 0, 0 }, { "decode", 1, ANY }, { "mips", 0, 0 }, { "bc", 0, ANY }, { "capture", 0, 0 },
+		{ "raster", 0, 0 }, { "encode", 0, 0 }, { "yuv", 0, 0 }, { "replay", 1, 2 }
+	};
+
+	// An option and the arguments after it, up to the next option
+	typedef struct Option
+	{
+		std::string name;
+		std::vector<std::string> arguments;
+	} Option;
+
+	const OptionArity* FindArity(const OptionArity* begin, const OptionArity* end, const std::string& name)
+	{
+		const OptionArity* found = std::find_if(begin, end, [&](const OptionArity& arity) { return name == arity.name; });
+		return found == end ? nullptr : found;
+	}
+
+	// Whether count arguments suit arity, reporting it if not
+	bool CheckArity(const OptionArity& arity, std::size_t count, const std::string& what)
+	{
+		if (count >= arity.least && count <= arity.most) { return true; }
+
+		std::cerr << what << " was given " << count << (count == 1 ? " argument" : " arguments") << " but takes ";
+		if (arity.least == arity.most) { std::cerr << arity.least; }
+		else if (arity.most == ANY) { std::cerr << "at least " << arity.least; }
+		else { std::cerr << arity.least << " to " << arity.most; }
+		std::cerr << std::endl;
+		return false;
+	}
+
+	bool ParseSwitch(const std::string& value, bool& on)
+	{
+		if (value == "on" || value == "true" || value == "1") { on = true; }
+		else if (value == "off" || value == "false" || value == "0") { on = false; }
+		else { return false; }
+		return true;
+	}
+
+	// Whole string as a number, nothing trailing
+	bool ParseNumber(const std::string& value, double& number)
+	{
+		std::istringstream stream(value);
+		return (bool)(stream >> number) && stream.peek() == std::char_traits<char>::eof() && number >= 0.0;
+	}
+
+	// A number or boolean from the config file in the form the command line would give it
+	std::string AsText(const json::Value& value)
+	{
+		switch (value.GetType())
+		{
+		case json::Type::String:  return value.AsString();
+		case json::Type::Boolean: return value.AsBoolean() ? "on" : "off";
+		case json::Type::Number:
+		{
+			std::ostringstream stream;
+			stream << value.AsNumber();
+			return stream.str();
+		}
+		default: return "";
+		}
+	}
+}
+
+bool config::Apply(Settings& settings, const std::string& key, const std::string& value)
+{
+	if (key == "resolution")
+	{
+		int width, height;
+		char separator, trailing;
+		if (std::sscanf(value.c_str(), "%d%c%d%c", &width, &separator, &height, &trailing) != 3 || separator != 'x' || width <= 0 || height <= 0) { return false; }
+		settings.width = width;
+		settings.height = height;
+	}
+	else if (key == "fullscreen") { return ParseSwitch(value, settings.fullscreen); }
+	else if (key == "debug")
+	{
+		if (value == "off") { settings.debug = DebugOutput::Off; }
+		else if (value == "warnings") { settings.debug = DebugOutput::Warnings; }
+		else if (value == "all") { settings.debug = DebugOutput::All; }
+		else { return false; }
+	}
+	else if (key == "debug-mute")
+	{
+		std::vector<unsigned int> ids;
+		std::istringstream stream(value);
+		for (std::string id; std::getline(stream, id, ',');)
+		{
+			double number;
+			if (!ParseNumber(id, number) || number != (unsigned int)number) { return false; }
+			ids.push_back((unsigned int)number);
+		}
+		settings.mutedDebugIds = ids;
+	}
+	else if (key == "annotations") { return ParseSwitch(value, settings.annotations); }
+	else if (key == "vsync") { return pacing::ParseSwapMode(value, settings.vsync); }
+	else if (key == "fps")
+	{
+		double fps;
+		if (!ParseNumber(value, fps)) { return false; }
+		settings.maxFramerate = fps;
+	}
+	else if (key == "msaa")
+	{
+		double samples;
+		if (!ParseNumber(value, samples) || samples != (int)samples) { return false; }
+		settings.msaaSamples = (int)samples;
+	}
+	else if (key == "backend")
+	{
+		if (value == "gl") { settings.backend = Backend::Gl; }
+		else if (value == "software") { settings.backend = Backend::Software; }
+		else { return false; }
+	}
+	else { return false; }
+
+	return true;
+}
+
+bool config::LoadFile(const std::string& path, Settings& settings)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		std::cerr << "Can't open config " << path << std::endl;
+		return false;
+	}
+
+	std::ostringstream ss;
+	ss << file.rdbuf();
+
+	json::Value root;
+	if (!json::Parse(ss.str(), root) || root.GetType() != json::Type::Object)
+	{
+		std::cerr << "Config " << path << " isn't a JSON object" << std::endl;
+		return false;
+	}
+
+	for (const auto& [key, value] : root.Members())
+	{
+		if (!Apply(settings, key, AsText(value))) { std::cerr << "Ignoring bad setting " << key << " in " << path << std::endl; }
+	}
+	return true;
+}
+
+bool config::ParseArguments(int argc, char** argv, Settings& settings, Launch& launch)
+{
+	// Split the command line into options, each with the arguments up to the next one
+	std::vector<Option> options;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.rfind("--", 0) == 0) { options.push_back(Option{ argument.substr(2), {} }); }
+		else if (!options.empty()) { options.back().arguments.push_back(argument); }
+		else
+		{
+			std::cerr << "Unexpected argument " << argument << " before any option" << std::endl;
+			return false;
+		}
+	}
+
+	// Check every option exists, is given once and has the right number of arguments before acting on any
+	bool valid = true;
+	for (std::size_t o = 0; o < options.size(); o++)
+	{
+		const Option& option = options[o];
+		const OptionArity settingArity = { option.name.c_str(), 1, 1 };
+		const OptionArity* arity = FindArity(std::begin(LAUNCH_OPTIONS), std::end(LAUNCH_OPTIONS), option.name);
+		if (!arity && std::find(std::begin(KEYS), std::end(KEYS), option.name) != std::end(KEYS)) { arity = &settingArity; }
+
+		if (!arity)
+		{
+			std::cerr << "Unknown option --" << option.name << std::endl;
+			valid = false;
+		}
+		else if (std::any_of(options.begin(), options.begin() + o, [&](const Option& earlier) { return earlier.name == option.name; }))
+		{
+			std::cerr << "--" << option.name << " is given more than once" << std::endl;
+			valid = false;
+		}
+		else { valid = CheckArity(*arity, option.arguments.size(), "--" + option.name) && valid; }
+	}
+	if (!valid) { return false; }
+
+	// The file first, so the options override it whatever order they came in
+	for (const Option& option : options)
+	{
+		if (option.name == "config") { valid = LoadFile(option.arguments[0], settings) && valid; }
+	}
+
+	for (const Option& option : options)
+	{
+		const std::string& name = option.name;
+		const std::vector<std::string>& arguments = option.arguments;
+
+		if (name == "config") { continue; }
+		else if (name == "software") { settings.backend = Backend::Software; }  // Short for --backend software
+		else if (name == "mesh") { launch.meshPath = arguments[0]; }
+		else if (name == "record") { launch.recordPath = arguments[0]; }
+		else if (name == "trace") { launch.tracePath = arguments[0]; }
+		else if (name == "dump")
+		{
+			if (arguments[0] == "qoi") { launch.dumpFormat = capture::FrameFormat::Qoi; }
+			else if (arguments[0] == "png") { launch.dumpFormat = capture::FrameFormat::Png; }
+			else
+			{
+				std::cerr << "--dump writes qoi or png, not " << arguments[0] << std::endl;
+				valid = false;
+			}
+			launch.dumpDirectory = arguments[1];
+		}
+		else if (name == "convert" || name == "golden" || name == "benchmark")
+		{
+			if (launch.command != Command::Run)
+			{
+				std::cerr << "Only one of --convert, --golden and --benchmark can be given" << std::endl;
+				valid = false;
+			}
+
+			launch.command = name == "convert" ? Command::Convert : name == "golden" ? Command::Golden : Command::Benchmark;
+			launch.arguments = arguments;
+
+			if (name == "golden" && arguments[0] != "check" && arguments[0] != "record")
+			{
+				std::cerr << "--golden takes check or record, not " << arguments[0] << std::endl;
+				valid = false;
+			}
+			else if (name == "golden" && arguments.size() == 1) { launch.arguments.push_back(GOLDEN_DIRECTORY); }
+			else if (name == "benchmark")
+			{
+				const OptionArity* benchmark = FindArity(std::begin(BENCHMARKS), std::end(BENCHMARKS), arguments[0]);
+				if (!benchmark)
+				{
+					std::cerr << "Unknown benchmark " << arguments[0] << std::endl;
+					valid = false;
+				}
+				else { valid = CheckArity(*benchmark, arguments.size() - 1, "--benchmark " + arguments[0]) && valid; }
+
+				double iterations;
+				if (arguments[0] == "replay" && arguments.size() == 3 && (!ParseNumber(arguments[2], iterations) || iterations < 1 || iterations != (int)iterations))
+				{
+					std::cerr << "--benchmark replay takes a whole number of iterations, not " << arguments[2] << std::endl;
+					valid = false;
+				}
+			}
+		}
+		else if (!Apply(settings, name, arguments[0]))
+		{
+			std::cerr << "Bad --" << name << " " << arguments[0] << std::endl;
+			valid = false;
+		}
+	}
+
+	return valid;
+}
+
+void config::PrintUsage(std::ostream& stream)
+{
+	stream <<
+		"Options, in any order:\n"
+		"  --config <file>                  settings from a JSON file, which the options below override\n"
+		"  --resolution <width>x<height>    --fullscreen on|off         --vsync off|on|adaptive\n"
+		"  --fps <limit>                    --msaa <samples>            --backend gl|software, or --software\n"
+		"  --debug off|warnings|all         --debug-mute <id>,<id>,...  --annotations on|off\n"
+		"  --mesh <file.rmesh|file.gltf|file.glb>  draw a mesh or glTF scene instead of the quad\n"
+		"  --dump <qoi|png> <directory>     write every frame drawn to directory\n"
+		"  --record <video file>            record the frames drawn through ffmpeg\n"
+		"  --trace <file>                   trace one frame's GL calls for --benchmark replay\n"
+		"One of these instead of drawing:\n"
+		"  --convert <in.obj|in.ply> <out.rmesh>\n"
+		"  --golden <check|record> [directory], Golden by default\n"
+		"  --benchmark textures|mips|capture|raster|encode|yuv\n"
+		"  --benchmark decode <images...> | bc [images...] | replay <trace> [iterations]\n";
+}
+
+std::string config::Describe(const Settings& settings)
+{
+	static const char* const DEBUG_NAMES[] = { "off", "warnings", "all" };
+
+	std::ostringstream stream;
+	if (settings.width > 0) { stream << settings.width << "x" << settings.height; }
+	else { stream << "default resolution"; }
+	stream << (settings.fullscreen ? " fullscreen" : " windowed")
+		<< ", debug " << DEBUG_NAMES[(int)settings.debug] << " (" << settings.mutedDebugIds.size() << " muted)"
+		<< ", annotations " << (settings.annotations ? "on" : "off")
+		<< ", vsync " << pacing::SwapModeName(settings.vsync)
+		<< ", fps limit " << settings.maxFramerate
+		<< ", msaa " << settings.msaaSamples
+		<< ", backend " << (settings.backend == Backend::Gl ? "gl" : "software");
+	return stream.str();
+}
@@ -0,0 +1,125 @@
+/**
+ * @file Config.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Launch settings read from a config file and the command
+ *        line, so one build can run lean or instrumented
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "FrameEncoder.h"
+#include "FramePacer.h"
+
+namespace config {
+
+	enum class DebugOutput
+	{
+		Off,       // No debug context or callback: what release runs should measure
+		Warnings,  // Every message but notifications
+		All
+	};
+
+	enum class Backend
+	{
+		Gl,
+		Software   // The CPU rasterizer, even when GL is available
+	};
+
+	typedef struct Settings
+	{
+		int width  = 0;           // 0 for the default: 1280x720 windowed, the monitor's own mode fullscreen
+		int height = 0;
+		bool fullscreen = false;
+		DebugOutput debug = DebugOutput::Warnings;
+		std::vector<unsigned int> mutedDebugIds;  // Debug message IDs never logged
+		bool annotations = false;   // Debug groups and object labels for GL capture tools
+		pacing::SwapMode vsync = pacing::SwapMode::On;
+		double maxFramerate = 0.0;  // CPU limit, 0 for none
+		int msaaSamples = 0;        // 0 for no multisampling
+		Backend backend = Backend::Gl;
+	} Settings;
+
+	// What a launch does instead of drawing the scene
+	enum class Command
+	{
+		Run,        // Draw the scene
+		Convert,    // --convert <in.obj|in.ply> <out.rmesh>
+		Golden,     // --golden <check|record> [directory]
+		Benchmark   // --benchmark <name> [arguments...]
+	};
+
+	// Options of one launch, which are only given on the command line
+	typedef struct Launch
+	{
+		Command command = Command::Run;
+		std::vector<std::string> arguments;  // The command's, in the order given
+		std::string meshPath;                // Binary mesh or glTF scene drawn instead of the quad
+		std::string dumpDirectory;           // Every frame drawn is written here
+		capture::FrameFormat dumpFormat = capture::FrameFormat::Qoi;
+		std::string recordPath;              // Video every frame drawn is recorded to through ffmpeg
+		std::string tracePath;               // One frame's GL calls are traced to this for --benchmark replay
+	} Launch;
+
+	/*
+	* Every setting has one key, used both in the config file and, with
+	* "--" in front, on the command line:
+	*
+	*   resolution   <width>x<height>
+	*   fullscreen   on | off
+	*   debug        off | warnings | all
+	*   debug-mute   <id>,<id>,... debug messages to leave out
+	*   annotations  on | off
+	*   vsync        off | on | adaptive
+	*   fps          <limit>, 0 for none
+	*   msaa         <samples>, 0 for none
+	*   backend      gl | software
+	*
+	* The file is a JSON object of those keys; values may be strings,
+	* numbers or booleans. "--config <file>" loads one, and any other
+	* options given override it, so an A/B run is the same file with one
+	* option changed.
+	*
+	* The launch options are command line only. Every option takes the
+	* arguments after it up to the next one starting with "--", so they
+	* can be given in any order, and an option given twice, one that
+	* doesn't exist or an argument that belongs to none fails the parse
+	* rather than being quietly ignored.
+	*/
+
+	/**
+	* @brief            Set one setting from its key and value as text
+	*
+	* @return           false, leaving settings unchanged, for an unknown
+	*                   key or a value it can't take
+	*/
+	bool Apply(Settings& settings, const std::string& key, const std::string& value);
+
+	/**
+	* @brief            Apply every setting in a JSON config file
+	*
+	* @return           false if it can't be read or parsed. Bad settings
+	*                   are reported and skipped
+	*/
+	bool LoadFile(const std::string& path, Settings& settings);
+
+	/**
+	* @brief            Load --config, then apply the other setting options
+	*                   and read the launch options, given in any order
+	*
+	* @return           false if the config file failed to load, or an option
+	*                   was unknown, repeated or bad. Each is reported
+	*/
+	bool ParseArguments(int argc, char** argv, Settings& settings, Launch& launch);
+
+	// Every option and what it takes, for when ParseArguments fails
+	void PrintUsage(std::ostream& stream);
+
+	// One line summary of settings, for logs
+	std::string Describe(const Settings& settings);
+}
@@ -0,0 +1,262 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include "DebugLog.h"
+
+namespace {
+
+	// How long the writer sleeps between flushes
+	constexpr std::chrono::milliseconds FLUSH_INTERVAL(20);
+
+	void GLAPIENTRY OnDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+		GLsizei length, const GLchar* message, const void* userParam)
+	{
+		((gldebug::DebugLog*)userParam)->Receive(source, type, id, severity, length, message);
+	}
+
+	// Bit for a source in the mute mask, 31 for unknown ones
+	unsigned int SourceBit(unsigned int source)
+	{
+		return source >= GL_DEBUG_SOURCE_API && source <= GL_DEBUG_SOURCE_OTHER ? source - GL_DEBUG_SOURCE_API : 31;
+	}
+
+	// Bit for a type in the mute mask. Markers and groups aren't contiguous with the rest
+	unsigned int TypeBit(unsigned int type)
+	{
+		if (type >= GL_DEBUG_TYPE_ERROR && type <= GL_DEBUG_TYPE_OTHER) { return type - GL_DEBUG_TYPE_ERROR; }
+		if (type >= GL_DEBUG_TYPE_MARKER && type <= GL_DEBUG_TYPE_POP_GROUP) { return 6 + type - GL_DEBUG_TYPE_MARKER; }
+		return 31;
+	}
+
+	std::uint64_t MessageKey(unsigned int source, unsigned int type, unsigned int id)
+	{
+		// Source and type enums fit 16 bits and are never 0, so neither is the key
+		return ((std::uint64_t)(source & 0xFFFF) << 48) | ((std::uint64_t)(type & 0xFFFF) << 32) | id;
+	}
+
+	const char* SourceName(unsigned int source)
+	{
+		switch (source)
+		{
+		case GL_DEBUG_SOURCE_API:             return "api";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+		case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+		default:                              return "other";
+		}
+	}
+
+	const char* TypeName(unsigned int type)
+	{
+		switch (type)
+		{
+		case GL_DEBUG_TYPE_ERROR:               return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+		case GL_DEBUG_TYPE_MARKER:              return "marker";
+		case GL_DEBUG_TYPE_PUSH_GROUP:          return "push group";
+		case GL_DEBUG_TYPE_POP_GROUP:           return "pop group";
+		default:                                return "other";
+		}
+	}
+
+	const char* SeverityName(unsigned int severity)
+	{
+		switch (severity)
+		{
+		case GL_DEBUG_SEVERITY_HIGH:   return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW:    return "low";
+		default:                       return "notification";
+		}
+	}
+}
+
+gldebug::DebugLog::DebugLog(std::ostream& output, std::size_t capacity)
+	: out(output), messages(capacity), repeats(std::make_unique<RepeatCounter[]>(REPEAT_TABLE_SIZE))
+{
+	writer = std::thread(&DebugLog::Run, this);
+}
+
+gldebug::DebugLog::~DebugLog()
+{
+	Finish();
+}
+
+void gldebug::DebugLog::Install()
+{
+	glEnable(GL_DEBUG_OUTPUT);
+
+	// Synchronous output would serialize the driver with the callback
+	glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(OnDebugMessage, this);
+}
+
+void gldebug::DebugLog::Uninstall()
+{
+	glDebugMessageCallback(nullptr, nullptr);
+	glDisable(GL_DEBUG_OUTPUT);
+}
+
+void gldebug::DebugLog::SetSourceMuted(unsigned int source, bool muted)
+{
+	const std::uint32_t bit = 1u << SourceBit(source);
+	if (muted) { mutedSources.fetch_or(bit, std::memory_order_relaxed); }
+	else { mutedSources.fetch_and(~bit, std::memory_order_relaxed); }
+}
+
+void gldebug::DebugLog::SetTypeMuted(unsigned int type, bool muted)
+{
+	const std::uint32_t bit = 1u << TypeBit(type);
+	if (muted) { mutedTypes.fetch_or(bit, std::memory_order_relaxed); }
+	else { mutedTypes.fetch_and(~bit, std::memory_order_relaxed); }
+}
+
+bool gldebug::DebugLog::SetIdMuted(unsigned int id, bool muted)
+{
+	const std::uint64_t entry = (std::uint64_t)id + 1;
+
+	if (!muted)
+	{
+		for (std::atomic<std::uint64_t>& slot : mutedIds)
+		{
+			std::uint64_t expected = entry;
+			slot.compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+		}
+		return true;
+	}
+
+	for (std::atomic<std::uint64_t>& slot : mutedIds)
+	{
+		if (slot.load(std::memory_order_relaxed) == entry) { return true; }
+	}
+	for (std::atomic<std::uint64_t>& slot : mutedIds)
+	{
+		std::uint64_t expected = 0;
+		if (slot.compare_exchange_strong(expected, entry, std::memory_order_relaxed)) { return true; }
+	}
+	return false;
+}
+
+bool gldebug::DebugLog::IsMuted(unsigned int source, unsigned int type, unsigned int id) const
+{
+	if (mutedSources.load(std::memory_order_relaxed) & (1u << SourceBit(source))) { return true; }
+	if (mutedTypes.load(std::memory_order_relaxed) & (1u << TypeBit(type))) { return true; }
+
+	const std::uint64_t entry = (std::uint64_t)id + 1;
+	for (const std::atomic<std::uint64_t>& slot : mutedIds)
+	{
+		if (slot.load(std::memory_order_relaxed) == entry) { return true; }
+	}
+	return false;
+}
+
+void gldebug::DebugLog::Receive(unsigned int source, unsigned int type, unsigned int id, unsigned int severity, int length, const char* text)
+{
+	if (IsMuted(source, type, id))
+	{
+		filtered.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// Find or claim the key's counter by linear probing. A full table counts nothing, and every message is queued
+	const std::uint64_t key = MessageKey(source, type, id);
+	for (std::size_t probe = 0; probe < REPEAT_TABLE_SIZE; probe++)
+	{
+		RepeatCounter& counter = repeats[(((key * 0x9E3779B97F4A7C15ull) >> 54) + probe) & (REPEAT_TABLE_SIZE - 1)];
+
+		std::uint64_t found = counter.key.load(std::memory_order_relaxed);
+		if (found == 0 && counter.key.compare_exchange_strong(found, key, std::memory_order_relaxed)) { found = key; }
+		if (found != key) { continue; }
+
+		if (counter.count.fetch_add(1, std::memory_order_relaxed) > 0)
+		{
+			repeated.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		break;
+	}
+
+	Message message;
+	message.source = source;
+	message.type = type;
+	message.id = id;
+	message.severity = severity;
+
+	// length is negative when the driver only null terminates
+	std::size_t size = length >= 0 ? (std::size_t)length : std::strlen(text);
+	size = std::min(size, MAX_MESSAGE_LENGTH - 1);
+	std::memcpy(message.text, text, size);
+	message.text[size] = '\0';
+
+	if (!messages.TryPush(message)) { dropped.fetch_add(1, std::memory_order_relaxed); }
+}
+
+void gldebug::DebugLog::Flush()
+{
+	std::ostringstream batch;
+
+	Message message;
+	while (messages.TryPop(message))
+	{
+		batch << "GL " << SeverityName(message.severity) << " " << TypeName(message.type) << " from "
+			<< SourceName(message.source) << " (" << message.id << "): " << message.text << "\n";
+		written.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	for (std::size_t c = 0; c < REPEAT_TABLE_SIZE; c++)
+	{
+		RepeatCounter& counter = repeats[c];
+		const std::uint64_t count = counter.count.load(std::memory_order_relaxed);
+		if (count <= 1 || count == counter.reported) { continue; }
+
+		// The first of each key is written above, so only later ones are repeats
+		const std::uint64_t since = count - std::max<std::uint64_t>(counter.reported, 1);
+		const std::uint64_t key = counter.key.load(std::memory_order_relaxed);
+		batch << "GL " << TypeName((unsigned int)(key >> 32 & 0xFFFF)) << " from " << SourceName((unsigned int)(key >> 48))
+			<< " (" << (unsigned int)key << ") repeated " << since << " more times\n";
+		counter.reported = count;
+	}
+
+	const std::string text = batch.str();
+	if (!text.empty()) { out.write(text.data(), text.size()).flush(); }
+}
+
+void gldebug::DebugLog::Run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopping)
+	{
+		stopSignal.wait_for(lock, FLUSH_INTERVAL, [this] { return stopping; });
+
+		lock.unlock();
+		Flush();
+		lock.lock();
+	}
+}
+
+void gldebug::DebugLog::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) { return; }
+		stopping = true;
+	}
+	stopSignal.notify_one();
+	writer.join();
+}
+
+gldebug::LogStats gldebug::DebugLog::Stats() const
+{
+	LogStats stats;
+	stats.written = written.load(std::memory_order_relaxed);
+	stats.repeats = repeated.load(std::memory_order_relaxed);
+	stats.filtered = filtered.load(std::memory_order_relaxed);
+	stats.dropped = dropped.load(std::memory_order_relaxed);
+	return stats;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file DebugLog.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief GL debug messages filtered, deduplicated and queued in the
+ *        driver's callback, and written out on a background thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "LockFreeQueue.h"
+
+namespace gldebug {
+
+	// Longer messages are cut short
+	constexpr std::size_t MAX_MESSAGE_LENGTH = 480;
+
+	// Distinct source, type and ID combinations counted before repeats stop being folded
+	constexpr std::size_t REPEAT_TABLE_SIZE = 1024;
+
+	// IDs that can be muted at once
+	constexpr std::size_t MAX_MUTED_IDS = 64;
+
+	typedef struct Message
+	{
+		unsigned int source;
+		unsigned int type;
+		unsigned int id;
+		unsigned int severity;
+		char text[MAX_MESSAGE_LENGTH];
+	} Message;
+
+	typedef struct LogStats
+	{
+		std::uint64_t written  = 0;  // Messages written out, the first of each ID
+		std::uint64_t repeats  = 0;  // Later messages with an ID already written, counted instead
+		std::uint64_t filtered = 0;  // Messages from muted sources, types or IDs
+		std::uint64_t dropped  = 0;  // Messages lost because the queue was full
+	} LogStats;
+
+	/*
+	* Drivers call the debug callback inline, on whichever thread made the
+	* call, and while GL_DEBUG_OUTPUT_SYNCHRONOUS is off from their own
+	* threads too, so anything slow in it slows GL down, and printing with
+	* std::endl flushes on every message. The callback here only filters,
+	* counts and copies the message into a lock-free queue; a writer thread
+	* wakes every few milliseconds to format and write what has queued.
+	*
+	* A message is keyed by its source, type and ID. The first of each key
+	* is queued; later ones only increment its counter in a lock-free hash
+	* table, and the writer reports how many times each repeated since it
+	* last looked, so a warning issued every draw costs one atomic add
+	* rather than a line a frame.
+	*
+	* Sources, types and IDs can be muted or unmuted from any thread while
+	* messages arrive. Severity is filtered in the driver instead, with
+	* glDebugMessageControl, which stops the messages being generated at
+	* all; muting here is for noisy messages that can't be singled out by
+	* severity.
+	*/
+	class DebugLog
+	{
+	public:
+		/**
+		* @brief            Start the writer thread
+		*
+		* @param out        where messages are written. Must outlive the log
+		* @param capacity   messages queued before new ones are dropped
+		*/
+		explicit DebugLog(std::ostream& out = std::cerr, std::size_t capacity = 256);
+
+		// Finishes. Uninstall first if the context is still alive
+		~DebugLog();
+
+		DebugLog(const DebugLog&) = delete;
+		DebugLog& operator=(const DebugLog&) = delete;
+
+		// Enable asynchronous debug output in the current context and send it here. GL thread only
+		void Install();
+
+		// Stop the current context sending messages here. GL thread only
+		void Uninstall();
+
+		// Mute or unmute a GL_DEBUG_SOURCE_* or GL_DEBUG_TYPE_*. Any thread
+		void SetSourceMuted(unsigned int source, bool muted);
+		void SetTypeMuted(unsigned int type, bool muted);
+
+		// Mute or unmute an ID from any source. False if MAX_MUTED_IDS are already muted. Any thread
+		bool SetIdMuted(unsigned int id, bool muted);
+
+		// Write everything queued and stop the writer
+		void Finish();
+
+		LogStats Stats() const;
+
+		// Called by the driver
+		void Receive(unsigned int source, unsigned int type, unsigned int id, unsigned int severity, int length, const char* text);
+
+	private:
+		typedef struct RepeatCounter
+		{
+			std::atomic<std::uint64_t> key = 0;    // 0 while unused
+			std::atomic<std::uint64_t> count = 0;
+			std::uint64_t reported = 0;            // Writer only
+		} RepeatCounter;
+
+		bool IsMuted(unsigned int source, unsigned int type, unsigned int id) const;
+
+		// Writer thread: write queued messages and new repeats
+		void Flush();
+		void Run();
+
+		std::ostream& out;
+		LockFreeQueue<Message> messages;
+		std::unique_ptr<RepeatCounter[]> repeats;
+
+		std::atomic<std::uint32_t> mutedSources = 0;  // Bit per source, from GL_DEBUG_SOURCE_API
+		std::atomic<std::uint32_t> mutedTypes = 0;    // Bit per type, see TypeBit
+		std::atomic<std::uint64_t> mutedIds[MAX_MUTED_IDS] = {};  // ID + 1, 0 while unused
+
+		std::atomic<std::uint64_t> written = 0;
+		std::atomic<std::uint64_t> repeated = 0;
+		std::atomic<std::uint64_t> filtered = 0;
+		std::atomic<std::uint64_t> dropped = 0;
+
+		std::mutex mutex;
+		std::condition_variable stopSignal;
+		bool stopping = false;
+		std::thread writer;
+	};
+}
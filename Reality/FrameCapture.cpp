@@ -0,0 +1,311 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "FrameCapture.h"
+#include "GpuAnnotations.h"
+
+namespace {
+
+	bool HasBufferStorage()
+	{
+		return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	}
+
+	// Colour the benchmark clears frame index to, so the consumer can tell which frame it got
+	void BenchmarkColor(std::uint64_t index, unsigned char rgba[4])
+	{
+		rgba[0] = (unsigned char)(index * 7);
+		rgba[1] = (unsigned char)(index * 13);
+		rgba[2] = (unsigned char)(index * 29);
+		rgba[3] = 255;
+	}
+}
+
+capture::FrameCapture::FrameCapture(Consumer frameConsumer, int depth)
+	: consumer(std::move(frameConsumer)), start(std::chrono::steady_clock::now())
+{
+	for (int s = 0; s < std::max(depth, 1); s++) { slots.push_back(std::make_unique<Slot>()); }
+	consumerThread = std::thread([this] { Consume(); });
+}
+
+capture::FrameCapture::~FrameCapture()
+{
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueSignal.notify_all();
+	consumerThread.join();
+
+	DestroyBuffers();
+}
+
+bool capture::FrameCapture::CreateBuffers(int newWidth, int newHeight)
+{
+	DestroyBuffers();
+	width = newWidth;
+	height = newHeight;
+
+	const std::size_t size = (std::size_t)width * height * 4;
+	const bool persistent = HasBufferStorage();
+
+	// Persistent and coherent: the consumer reads GPU writes straight from the mapping once the fence signals
+	const unsigned int flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	for (std::unique_ptr<Slot>& slot : slots)
+	{
+		glGenBuffers(1, &slot->buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+		annotate::Label(GL_BUFFER, slot->buffer, "Frame capture readback");
+
+		if (persistent)
+		{
+			glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+			slot->mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+		}
+		else
+		{
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+			slot->pixels.resize(size);
+		}
+
+		if (persistent && !slot->mapped)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			std::cerr << "Failed to map a frame capture buffer" << std::endl;
+			DestroyBuffers();
+			return false;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return true;
+}
+
+void capture::FrameCapture::DestroyBuffers()
+{
+	for (std::unique_ptr<Slot>& slot : slots)
+	{
+		if (slot->buffer)
+		{
+			if (slot->mapped)
+			{
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+			glDeleteBuffers(1, &slot->buffer);
+		}
+
+		slot->buffer = 0;
+		slot->mapped = nullptr;
+		slot->pixels.clear();
+	}
+
+	nextSlot = 0;
+	width = height = 0;
+}
+
+bool capture::FrameCapture::Capture(int newWidth, int newHeight)
+{
+	auto begin = std::chrono::steady_clock::now();
+	const std::uint64_t index = frameIndex++;
+
+	Collect(false);
+
+	// Buffers can only be resized once none of them is in use
+	if (newWidth != width || newHeight != height)
+	{
+		bool idle = reading.empty();
+		for (const std::unique_ptr<Slot>& slot : slots) { idle &= slot->state == SlotState::Free; }
+
+		if (idle && newWidth > 0 && newHeight > 0) { CreateBuffers(newWidth, newHeight); }
+	}
+
+	Slot& slot = *slots[nextSlot];
+	const bool issued = newWidth == width && newHeight == height && slot.buffer && slot.state == SlotState::Free;
+
+	if (issued)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.frame = CapturedFrame{ index, std::chrono::duration<double>(begin - start).count(), width, height, nullptr };
+		slot.state = SlotState::Reading;
+		reading.push_back(&slot);
+		nextSlot = (nextSlot + 1) % slots.size();
+	}
+	else { dropped++; }
+
+	captureSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	return issued;
+}
+
+void capture::FrameCapture::Collect(bool wait)
+{
+	while (!reading.empty())
+	{
+		Slot* slot = reading.front();
+		GLsync fence = (GLsync)slot->fence;
+
+		if (wait)
+		{
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+		}
+		else if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) { break; }
+
+		glDeleteSync(fence);
+		slot->fence = nullptr;
+		reading.pop_front();
+
+		if (slot->mapped) { slot->frame.pixels = slot->mapped; }
+		else
+		{
+			// The read has finished, so mapping doesn't wait
+			const std::size_t size = slot->pixels.size();
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+			const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+			if (mapped)
+			{
+				std::memcpy(slot->pixels.data(), mapped, size);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			if (!mapped)
+			{
+				slot->state = SlotState::Free;
+				dropped++;
+				continue;
+			}
+			slot->frame.pixels = slot->pixels.data();
+		}
+
+		slot->state = SlotState::Consuming;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			consumeQueue.push_back(slot);
+		}
+		queueSignal.notify_one();
+		captured++;
+	}
+}
+
+void capture::FrameCapture::Flush()
+{
+	Collect(true);
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	slotReleased.wait(lock, [this]
+	{
+		return std::all_of(slots.begin(), slots.end(), [](const std::unique_ptr<Slot>& slot) { return slot->state == SlotState::Free; });
+	});
+}
+
+void capture::FrameCapture::Consume()
+{
+	while (true)
+	{
+		Slot* slot;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueSignal.wait(lock, [this] { return stopping || !consumeQueue.empty(); });
+			if (consumeQueue.empty()) { return; }
+
+			slot = consumeQueue.front();
+			consumeQueue.pop_front();
+		}
+
+		consumer(slot->frame);
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			slot->state = SlotState::Free;
+		}
+		slotReleased.notify_all();
+	}
+}
+
+capture::CaptureStats capture::FrameCapture::Stats() const
+{
+	CaptureStats stats;
+	stats.captured = captured;
+	stats.dropped = dropped;
+	stats.captureSeconds = captureSeconds;
+	return stats;
+}
+
+void capture::RunCaptureBenchmark()
+{
+	constexpr int FRAMES_PER_SIZE = 240;
+
+	std::cout << "Frame readback (" << (HasBufferStorage() ? "persistent" : "mapped") << " PBO ring against glReadPixels)\n";
+	std::cout << "size\tring ms/frame\tdirect ms/frame\tdropped\tcorrupt\n";
+
+	for (int size = 256; size <= 2048; size *= 2)
+	{
+		// Render into an offscreen framebuffer so sizes don't depend on the window
+		unsigned int framebuffer, renderbuffer;
+		glGenRenderbuffers(1, &renderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+
+		std::atomic<std::uint64_t> corrupt = 0;
+		double ringSeconds;
+		CaptureStats stats;
+		{
+			// Every frame is checked against the colour it was cleared to, at its first and last pixel
+			FrameCapture capture([&corrupt](const CapturedFrame& frame)
+			{
+				unsigned char expected[4];
+				BenchmarkColor(frame.index, expected);
+				const std::size_t last = ((std::size_t)frame.width * frame.height - 1) * 4;
+				if (std::memcmp(frame.pixels, expected, 4) != 0 || std::memcmp(frame.pixels + last, expected, 4) != 0) { corrupt++; }
+			});
+
+			glFinish();
+			for (int frame = 0; frame < FRAMES_PER_SIZE; frame++)
+			{
+				unsigned char color[4];
+				BenchmarkColor(frame, color);
+				glClearColor(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+
+				capture.Capture(size, size);
+				glFlush();  // Stands in for the swap
+			}
+
+			capture.Flush();
+			stats = capture.Stats();
+			ringSeconds = stats.captureSeconds;
+		}
+
+		std::vector<unsigned char> pixels((std::size_t)size * size * 4);
+		glFinish();
+		auto start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < FRAMES_PER_SIZE; frame++)
+		{
+			glClear(GL_COLOR_BUFFER_BIT);
+			glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		}
+		double directSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << size << "x" << size << '\t' << ringSeconds * 1000.0 / FRAMES_PER_SIZE << '\t'
+			<< directSeconds * 1000.0 / FRAMES_PER_SIZE << '\t' << stats.dropped << '\t' << corrupt << '\n';
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &renderbuffer);
+	}
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	std::cout << std::flush;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file FrameCapture.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Reads rendered frames back from the GPU through a ring of
+ *        pixel pack buffers without ever waiting on the GPU, and
+ *        hands them to a consumer thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace capture {
+
+	// A frame handed to the consumer
+	typedef struct CapturedFrame
+	{
+		std::uint64_t index;          // Frames captured before it, dropped ones included
+		double seconds;               // When it was captured, since the capture was created
+		int width;
+		int height;
+		const unsigned char* pixels;  // RGBA8, width * 4 bytes a row, bottom row first as GL reads them
+	} CapturedFrame;
+
+	typedef struct CaptureStats
+	{
+		std::uint64_t captured  = 0;    // Frames read back and handed to the consumer
+		std::uint64_t dropped   = 0;    // Frames skipped because every buffer was still busy
+		double captureSeconds   = 0.0;  // Time the GL thread spent in Capture
+	} CaptureStats;
+
+	/*
+	* Capture issues glReadPixels into the next pack buffer of the ring and
+	* fences it, which only queues the copy. Later Capture calls poll the
+	* fences without waiting, and each finished buffer is handed to the
+	* consumer thread: with GL 4.4 or ARB_buffer_storage the buffers stay
+	* persistently mapped and the consumer reads straight out of them,
+	* otherwise the GL thread maps the buffer and copies it out first.
+	* A buffer goes back into the ring once the consumer returns. If the
+	* buffer a frame needs is still being read or consumed, that frame is
+	* dropped instead of stalling the render loop, so a slow consumer
+	* lowers the captured framerate, never the rendered one.
+	*/
+	class FrameCapture
+	{
+	public:
+		using Consumer = std::function<void(const CapturedFrame& frame)>;
+
+		/**
+		* @brief            Start the consumer thread. Nothing is created in GL until
+		*                   the first Capture
+		*
+		* @param consumer   called on the consumer thread, in capture order. pixels are
+		*                   only valid until it returns
+		* @param depth      pack buffers in the ring, so frames a buffer has to be
+		*                   read and consumed in before it is needed again
+		*/
+		explicit FrameCapture(Consumer consumer, int depth = 3);
+
+		// Flushes and stops the consumer thread. GL thread only
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+
+		/**
+		* @brief            Queue a read of the bound read framebuffer and hand
+		*                   earlier reads that have finished to the consumer. Call
+		*                   once a frame after drawing and before swapping. GL thread only
+		*
+		* @param width      framebuffer size. When it changes, frames are dropped until
+		*                   the buffers in flight are consumed and can be resized
+		* @return           false if the frame was dropped
+		*/
+		bool Capture(int width, int height);
+
+		// Wait for every read in flight and for the consumer to finish with them. GL thread only
+		void Flush();
+
+		CaptureStats Stats() const;
+
+	private:
+		enum class SlotState
+		{
+			Free,
+			Reading,    // glReadPixels queued, fence pending
+			Consuming   // Handed to the consumer thread
+		};
+
+		typedef struct Slot
+		{
+			unsigned int buffer = 0;
+			unsigned char* mapped = nullptr;            // Persistent mapping, if buffer storage is available
+			std::vector<unsigned char> pixels;          // Copied out of the buffer otherwise
+			void* fence = nullptr;                      // GLsync of the read
+			CapturedFrame frame = {};
+			std::atomic<SlotState> state = SlotState::Free;
+		} Slot;
+
+		bool CreateBuffers(int width, int height);
+		void DestroyBuffers();
+
+		// Hand reads that have finished to the consumer, waiting for them if wait is set
+		void Collect(bool wait);
+
+		void Consume();
+
+		Consumer consumer;
+		std::vector<std::unique_ptr<Slot>> slots;
+		std::size_t nextSlot = 0;
+		std::deque<Slot*> reading;    // Slots with reads in flight, oldest first
+		int width  = 0;
+		int height = 0;
+		std::uint64_t frameIndex = 0;
+		std::chrono::steady_clock::time_point start;
+
+		std::thread consumerThread;
+		std::deque<Slot*> consumeQueue;
+		std::mutex queueMutex;
+		std::condition_variable queueSignal;
+		std::condition_variable slotReleased;
+		bool stopping = false;
+
+		std::uint64_t captured = 0;
+		std::uint64_t dropped  = 0;
+		double captureSeconds  = 0.0;
+	};
+
+	/**
+	* @brief    Time capturing frames of a range of sizes through the ring
+	*           against synchronous glReadPixels, check the frames arrive
+	*           intact, and print the results. Needs a current GL context
+	*/
+	void RunCaptureBenchmark();
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include "FrameEncoder.h"
+#include "Image.h"
+#include "ImageEncoder.h"
+#include "JobSystem.h"
+
+namespace {
+
+	std::filesystem::path FramePath(const std::filesystem::path& directory, std::uint64_t index, capture::FrameFormat format)
+	{
+		char name[48];
+		std::snprintf(name, sizeof(name), "frame_%06llu.%s", (unsigned long long)index, format == capture::FrameFormat::Png ? "png" : "qoi");
+		return directory / name;
+	}
+
+	// A frame for the benchmark: a gradient with a bar moving across it, bottom row first like a capture
+	void GenerateFrame(std::uint64_t index, int width, int height, unsigned char* rgba)
+	{
+		const int barX = (int)(index * 16 % width);
+		for (int y = 0; y < height; y++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				unsigned char* pixel = rgba + ((std::size_t)y * width + x) * 4;
+				const bool bar = x >= barX && x < barX + width / 8;
+				pixel[0] = bar ? 255 : (unsigned char)(x * 255 / width);
+				pixel[1] = bar ? 255 : (unsigned char)(y * 255 / height);
+				pixel[2] = (unsigned char)((x ^ y) & 0x3F);
+				pixel[3] = 255;
+			}
+		}
+	}
+}
+
+capture::FrameEncoder::FrameEncoder(const std::filesystem::path& outputDirectory, FrameFormat frameFormat, int maxFramesInFlight)
+	: directory(outputDirectory), format(frameFormat)
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) { std::cerr << "Failed to create " << directory.string() << ": " << error.message() << std::endl; }
+
+	for (int f = 0; f < std::max(maxFramesInFlight, 1); f++)
+	{
+		frames.push_back(std::make_unique<Frame>());
+		freeFrames.push_back(frames.back().get());
+	}
+
+	writer = std::thread([this] { Write(); });
+}
+
+capture::FrameEncoder::~FrameEncoder()
+{
+	Finish();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	frameEncoded.notify_all();
+	writer.join();
+}
+
+void capture::FrameEncoder::Submit(const CapturedFrame& captured)
+{
+	auto begin = std::chrono::steady_clock::now();
+
+	Frame* frame;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		frameFreed.wait(lock, [this] { return !freeFrames.empty(); });
+		frame = freeFrames.back();
+		freeFrames.pop_back();
+		stats.blockedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	frame->index = captured.index;
+	frame->width = captured.width;
+	frame->height = captured.height;
+	frame->pixels.assign(captured.pixels, captured.pixels + (std::size_t)captured.width * captured.height * 4);
+
+	jobs::Submit([this, frame] { Encode(frame); });
+}
+
+void capture::FrameEncoder::Encode(Frame* frame)
+{
+	auto begin = std::chrono::steady_clock::now();
+
+	if (format == FrameFormat::Png) { image::EncodePng(frame->pixels.data(), frame->width, frame->height, true, frame->encoded); }
+	else { image::EncodeQoi(frame->pixels.data(), frame->width, frame->height, true, frame->encoded); }
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		encodedFrames.push_back(frame);
+		stats.encodeSeconds += seconds;
+	}
+	frameEncoded.notify_one();
+}
+
+void capture::FrameEncoder::Write()
+{
+	std::vector<Frame*> batch;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameEncoded.wait(lock, [this] { return stopping || !encodedFrames.empty(); });
+			if (encodedFrames.empty()) { return; }
+
+			batch.swap(encodedFrames);
+		}
+
+		// Oldest first, as frames finish encoding out of order
+		std::sort(batch.begin(), batch.end(), [](const Frame* a, const Frame* b) { return a->index < b->index; });
+
+		auto begin = std::chrono::steady_clock::now();
+		std::uint64_t bytes = 0;
+		for (const Frame* frame : batch)
+		{
+			const std::filesystem::path path = FramePath(directory, frame->index, format);
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write((const char*)frame->encoded.data(), (std::streamsize)frame->encoded.size());
+
+			if (!file) { std::cerr << "Failed to write " << path.string() << std::endl; }
+			else { bytes += frame->encoded.size(); }
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freeFrames.insert(freeFrames.end(), batch.begin(), batch.end());
+			stats.frames += batch.size();
+			stats.bytes += bytes;
+			stats.writeSeconds += seconds;
+		}
+		frameFreed.notify_all();
+		batch.clear();
+	}
+}
+
+void capture::FrameEncoder::Finish()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	frameFreed.wait(lock, [this] { return freeFrames.size() == frames.size(); });
+}
+
+capture::EncoderStats capture::FrameEncoder::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void capture::RunEncodeBenchmark()
+{
+	constexpr int WIDTH = 1280, HEIGHT = 720;
+	constexpr int FRAME_COUNT = 120;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reality_encode_benchmark";
+	const std::size_t frameSize = (std::size_t)WIDTH * HEIGHT * 4;
+	std::vector<unsigned char> pixels(frameSize);
+
+	std::cout << "Frame encoding (" << WIDTH << "x" << HEIGHT << ", " << jobs::ThreadCount() << " threads)\n";
+	std::cout << "format\tframes/s\tMB/s in\tratio\tblocked ms/frame\tround trip\n";
+
+	for (FrameFormat format : { FrameFormat::Qoi, FrameFormat::Png })
+	{
+		EncoderStats stats;
+		double seconds;
+		{
+			FrameEncoder encoder(directory, format);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int f = 0; f < FRAME_COUNT; f++)
+			{
+				GenerateFrame(f, WIDTH, HEIGHT, pixels.data());
+				encoder.Submit(CapturedFrame{ (std::uint64_t)f, 0.0, WIDTH, HEIGHT, pixels.data() });
+			}
+			encoder.Finish();
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stats = encoder.Stats();
+		}
+
+		// The first frame should decode to what was submitted, flipped to top row first
+		bool matches = false;
+		std::ifstream file(FramePath(directory, 0, format), std::ios::binary);
+		std::vector<unsigned char> encoded((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		image::ImageInfo info;
+		if (image::ReadInfo(encoded.data(), encoded.size(), info) && info.width == WIDTH && info.height == HEIGHT)
+		{
+			std::vector<unsigned char> decoded(frameSize);
+			matches = image::Decode(encoded.data(), encoded.size(), decoded.data());
+
+			GenerateFrame(0, WIDTH, HEIGHT, pixels.data());
+			const std::size_t rowSize = (std::size_t)WIDTH * 4;
+			for (int y = 0; y < HEIGHT && matches; y++)
+			{
+				matches = std::memcmp(decoded.data() + y * rowSize, pixels.data() + (HEIGHT - 1 - y) * rowSize, rowSize) == 0;
+			}
+		}
+
+		std::cout << (format == FrameFormat::Png ? "png" : "qoi") << '\t' << FRAME_COUNT / seconds << '\t'
+			<< frameSize * FRAME_COUNT / seconds / 1e6 << '\t' << (double)stats.bytes / (frameSize * stats.frames) << '\t'
+			<< stats.blockedSeconds * 1000.0 / FRAME_COUNT << '\t' << (matches ? "ok" : "FAILED") << '\n';
+	}
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+	std::cout << std::flush;
+}
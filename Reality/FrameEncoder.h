@@ -0,0 +1,114 @@
+/**
+ * @file FrameEncoder.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Compresses captured frames to PNG or QOI on the job system
+ *        and writes them to disk from a writer thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameCapture.h"
+
+namespace capture {
+
+	enum class FrameFormat
+	{
+		Qoi,  // Fast enough to keep up with rendering
+		Png   // Smaller and opens anywhere, but several times slower to encode
+	};
+
+	typedef struct EncoderStats
+	{
+		std::uint64_t frames  = 0;    // Frames written
+		std::uint64_t bytes   = 0;    // Bytes written
+		double encodeSeconds  = 0.0;  // Time spent encoding, summed over every worker
+		double writeSeconds   = 0.0;  // Time the writer thread spent writing
+		double blockedSeconds = 0.0;  // Time Submit waited for a frame to be written
+	} EncoderStats;
+
+	/*
+	* The encoder owns a fixed pool of frames. Submit copies a captured
+	* frame into a free one and queues it to be encoded on the job system,
+	* and once encoded the frame goes to the writer thread. The writer
+	* takes every frame that has finished since it last woke and writes
+	* each to its own file with a single write of the whole encoded
+	* buffer, then hands the frame back to the pool, keeping its buffers
+	* for the next frame so nothing is allocated once the pool is warm.
+	*
+	* When every frame in the pool is in flight, Submit blocks until the
+	* writer frees one, so memory stays bounded by the pool however far
+	* the disk falls behind. Called from FrameCapture's consumer, that
+	* backpressure makes FrameCapture drop frames rather than slow the
+	* render loop.
+	*/
+	class FrameEncoder
+	{
+	public:
+		/**
+		* @brief                    Start the writer thread
+		*
+		* @param directory          where frames are written, as frame_<index>.png or
+		*                           .qoi. Created if it doesn't exist
+		* @param maxFramesInFlight  frames being copied, encoded or written at once
+		*/
+		FrameEncoder(const std::filesystem::path& directory, FrameFormat format, int maxFramesInFlight = 8);
+
+		// Finishes and stops the writer thread
+		~FrameEncoder();
+
+		FrameEncoder(const FrameEncoder&) = delete;
+		FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+		// Copy frame and queue it to be encoded and written. Blocks while every frame is in flight
+		void Submit(const CapturedFrame& frame);
+
+		// Wait for every submitted frame to be written
+		void Finish();
+
+		EncoderStats Stats() const;
+
+	private:
+		typedef struct Frame
+		{
+			std::uint64_t index = 0;
+			int width  = 0;
+			int height = 0;
+			std::vector<unsigned char> pixels;
+			std::vector<unsigned char> encoded;
+		} Frame;
+
+		void Encode(Frame* frame);
+		void Write();
+
+		std::filesystem::path directory;
+		FrameFormat format;
+
+		std::vector<std::unique_ptr<Frame>> frames;
+		std::vector<Frame*> freeFrames;
+		std::vector<Frame*> encodedFrames;   // Waiting for the writer
+		mutable std::mutex mutex;
+		std::condition_variable frameFreed;
+		std::condition_variable frameEncoded;
+		std::thread writer;
+		bool stopping = false;
+
+		EncoderStats stats;
+	};
+
+	/**
+	* @brief    Encode and write a run of generated frames in each format,
+	*           check the first decodes back to the same pixels, and print
+	*           the throughput. CPU only
+	*/
+	void RunEncodeBenchmark();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file FrameHandoff.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Double buffered state handed from the thread that prepares
+ *        frames to the thread that draws them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+typedef struct HandoffStats
+{
+	std::uint64_t published = 0;
+	double producerWaitSeconds = 0.0;  // Waiting for the consumer to finish with a frame: drawing is the bottleneck
+	double consumerWaitSeconds = 0.0;  // Waiting for a frame to be published: preparing them is
+} HandoffStats;
+
+/*
+* Two frames of state. The producer fills the back one while the
+* consumer reads the front one, so preparing frame N + 1 overlaps
+* drawing frame N and neither copies nor locks the state itself.
+* Publish swaps them, once the consumer has taken and released the
+* front one, so the producer runs at most a frame ahead and every
+* frame published is drawn.
+*/
+template <typename T>
+class FrameHandoff
+{
+public:
+	FrameHandoff() = default;
+	FrameHandoff(const FrameHandoff&) = delete;
+	FrameHandoff& operator=(const FrameHandoff&) = delete;
+
+	// Producer: the frame to fill before the next Publish
+	T& Back() { return frames[1 - front]; }
+
+	// Producer: hand Back() to the consumer, waiting until it has released the last frame. False once stopped
+	bool Publish()
+	{
+		auto begin = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(mutex);
+		released.wait(lock, [this] { return stopped || (!fresh && !reading); });
+		stats.producerWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		if (stopped) { return false; }
+
+		front = 1 - front;
+		fresh = true;
+		stats.published++;
+		lock.unlock();
+
+		publishedSignal.notify_one();
+		return true;
+	}
+
+	// Producer: wait at most timeout for Publish to be able to go straight through, so the
+	// producer can do other work while it waits. True once it can, or once stopped
+	template <typename Rep, typename Period>
+	bool WaitPublishable(std::chrono::duration<Rep, Period> timeout)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(mutex);
+		bool publishable = released.wait_for(lock, timeout, [this] { return stopped || (!fresh && !reading); });
+		stats.producerWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		return publishable;
+	}
+
+	// Consumer: wait for the next published frame, null once stopped. Valid until Release
+	const T* Acquire()
+	{
+		auto begin = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock(mutex);
+		publishedSignal.wait(lock, [this] { return stopped || fresh; });
+		stats.consumerWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		if (stopped) { return nullptr; }
+
+		fresh = false;
+		reading = true;
+		return &frames[front];
+	}
+
+	// Consumer: done with the frame Acquire returned, letting the producer publish over it
+	void Release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			reading = false;
+		}
+		released.notify_one();
+	}
+
+	// Wake both sides and make every later call return at once
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopped = true;
+		}
+		released.notify_all();
+		publishedSignal.notify_all();
+	}
+
+	HandoffStats Stats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+private:
+	T frames[2] = {};
+	int front = 0;
+	bool fresh = false;     // front was published and not yet acquired
+	bool reading = false;   // The consumer holds front
+	bool stopped = false;
+
+	mutable std::mutex mutex;
+	std::condition_variable released;
+	std::condition_variable publishedSignal;
+	HandoffStats stats;
+};
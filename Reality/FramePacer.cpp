@@ -0,0 +1,152 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include "FramePacer.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+// Missing from SDKs before Windows 10 1803
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace {
+
+	// Bounds on the spun margin: sleeps are never trusted closer than the
+	// lower, and a timer worse than the upper is spun no further
+	constexpr double MIN_SPIN_SECONDS = 0.0002;
+	constexpr double MAX_SPIN_SECONDS = 0.004;
+
+	// Weight of the newest sleep in the overshoot average
+	constexpr double OVERSHOOT_WEIGHT = 0.1;
+}
+
+bool pacing::ParseSwapMode(const std::string& name, SwapMode& mode)
+{
+	if (name == "off") { mode = SwapMode::Off; }
+	else if (name == "on") { mode = SwapMode::On; }
+	else if (name == "adaptive") { mode = SwapMode::Adaptive; }
+	else { return false; }
+	return true;
+}
+
+const char* pacing::SwapModeName(SwapMode mode)
+{
+	switch (mode)
+	{
+	case SwapMode::Off: return "off";
+	case SwapMode::On:  return "on";
+	default:            return "adaptive";
+	}
+}
+
+pacing::FramePacer::FramePacer(SwapMode swapMode, double maxFramerate)
+	: mode(swapMode), spinSeconds(MAX_SPIN_SECONDS)
+{
+	if (mode == SwapMode::Adaptive && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+	{
+		std::cerr << "Adaptive vsync isn't supported, using vsync" << std::endl;
+		mode = SwapMode::On;
+	}
+
+	// -1 swaps late frames immediately instead of waiting for the next vertical blank
+	glfwSwapInterval(mode == SwapMode::Off ? 0 : mode == SwapMode::On ? 1 : -1);
+
+	if (maxFramerate > 0.0) { period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFramerate)); }
+
+#ifdef _WIN32
+	// Windows 10 1803 and later; older versions fall back to Sleep
+	timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+}
+
+pacing::FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (timer) { CloseHandle(timer); }
+#endif
+}
+
+void pacing::FramePacer::WaitUntil(Clock::time_point until)
+{
+	const Clock::time_point wake = until - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinSeconds));
+	Clock::time_point now = Clock::now();
+
+	if (wake > now)
+	{
+#ifdef _WIN32
+		if (timer)
+		{
+			// Negative due times are relative, in 100ns units
+			LARGE_INTEGER due;
+			due.QuadPart = -(LONGLONG)(std::chrono::duration<double>(wake - now).count() * 1e7);
+			SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0);
+			WaitForSingleObject(timer, INFINITE);
+		}
+		else { std::this_thread::sleep_until(wake); }
+#else
+		std::this_thread::sleep_until(wake);
+#endif
+
+		now = Clock::now();
+		const double overshoot = std::max(std::chrono::duration<double>(now - wake).count(), 0.0);
+		overshootAverage += (overshoot - overshootAverage) * OVERSHOOT_WEIGHT;
+		overshootTotal += overshoot;
+		sleeps++;
+
+		// Twice the typical lateness covers most of the spread
+		spinSeconds = std::clamp(overshootAverage * 2.0, MIN_SPIN_SECONDS, MAX_SPIN_SECONDS);
+	}
+
+	while (Clock::now() < until) { std::this_thread::yield(); }
+}
+
+void pacing::FramePacer::EndFrame()
+{
+	Clock::time_point now = Clock::now();
+
+	if (period > Clock::duration::zero())
+	{
+		if (!started) { deadline = now; }
+		deadline += period;
+
+		// Too far behind to catch up without a burst of short frames
+		if (now > deadline + period) { deadline = now; }
+		else { WaitUntil(deadline); }
+
+		now = Clock::now();
+	}
+
+	if (started)
+	{
+		const double frameSeconds = std::chrono::duration<double>(now - lastFrame).count();
+		frames++;
+		const double delta = frameSeconds - mean;
+		mean += delta / frames;
+		squaredDeviations += delta * (frameSeconds - mean);
+		worst = std::max(worst, frameSeconds);
+		if (period > Clock::duration::zero() && frameSeconds > 1.5 * std::chrono::duration<double>(period).count()) { late++; }
+	}
+
+	started = true;
+	lastFrame = now;
+}
+
+pacing::PacingStats pacing::FramePacer::Stats() const
+{
+	PacingStats stats;
+	stats.frames = frames;
+	stats.meanMs = mean * 1000.0;
+	stats.jitterMs = frames > 1 ? std::sqrt(squaredDeviations / (frames - 1)) * 1000.0 : 0.0;
+	stats.worstMs = worst * 1000.0;
+	stats.late = late;
+	stats.sleepOvershootMs = sleeps > 0 ? overshootTotal / sleeps * 1000.0 : 0.0;
+	return stats;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file FramePacer.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Sets the swap interval and limits the framerate on the CPU,
+ *        measuring how evenly frames are paced
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace pacing {
+
+	enum class SwapMode
+	{
+		Off,       // Swap immediately: lowest latency, tears, renders as fast as it can
+		On,        // Wait for vertical blank: no tearing, a frame of latency
+		Adaptive   // Wait for vertical blank unless the frame is late, then tear rather than wait a whole refresh
+	};
+
+	// "off", "on" or "adaptive", false for anything else
+	bool ParseSwapMode(const std::string& name, SwapMode& mode);
+	const char* SwapModeName(SwapMode mode);
+
+	typedef struct PacingStats
+	{
+		std::uint64_t frames = 0;
+		double meanMs   = 0.0;  // Mean time between frames
+		double jitterMs = 0.0;  // Standard deviation of it
+		double worstMs  = 0.0;
+		std::uint64_t late = 0; // Frames over half as long again as the limit asked for
+		double sleepOvershootMs = 0.0;  // Mean time sleeps ran past what they were asked for
+	} PacingStats;
+
+	/*
+	* The limiter keeps a deadline a frame period after the last one and
+	* waits for it at the end of each frame. Sleeps wake up late by an
+	* amount that depends on the OS timer, so it sleeps until a margin
+	* before the deadline and spins the rest, which costs a little CPU but
+	* lands within microseconds. The margin follows how late recent sleeps
+	* woke, so it stays as short as the timer allows. On Windows sleeping
+	* uses a high resolution waitable timer, as Sleep rounds up to the
+	* 15.6ms system tick.
+	*
+	* A frame that misses its deadline by more than a period moves the
+	* deadline to now instead of rushing the following frames to catch up.
+	*/
+	class FramePacer
+	{
+	public:
+		/**
+		* @brief                Set the swap interval of the current context
+		*
+		* @param mode           Adaptive falls back to On without EXT_swap_control_tear
+		* @param maxFramerate   frames per second the CPU limits to, 0 for no limit
+		*/
+		FramePacer(SwapMode mode, double maxFramerate = 0.0);
+		~FramePacer();
+
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		// Wait for the limiter, then time the frame. Call once a frame, after swapping
+		void EndFrame();
+
+		SwapMode Mode() const { return mode; }
+		PacingStats Stats() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		// Sleep until a margin before deadline, then spin to it
+		void WaitUntil(Clock::time_point deadline);
+
+		SwapMode mode;
+		Clock::duration period = Clock::duration::zero();
+		Clock::time_point deadline;
+		Clock::time_point lastFrame;
+		bool started = false;
+
+		double spinSeconds;             // Margin before the deadline spun rather than slept
+		double overshootAverage = 0.0;  // Recent sleeps' lateness
+		double overshootTotal   = 0.0;
+		std::uint64_t sleeps    = 0;
+
+		void* timer = nullptr;          // Windows waitable timer
+
+		// Frame times, by Welford's method
+		std::uint64_t frames = 0;
+		double mean = 0.0;
+		double squaredDeviations = 0.0;
+		double worst = 0.0;
+		std::uint64_t late = 0;
+	};
+}
@@ -0,0 +1,466 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include "GlTrace.h"
+
+namespace {
+
+	using gltrace::Op;
+	using gltrace::UniformKind;
+
+	// Untimed iterations first, so driver caches and shader variants are warm
+	constexpr int WARMUP_ITERATIONS = 5;
+
+	// Bounds checked reads from the trace. A read past the end sets failed and returns zeros
+	typedef struct Reader
+	{
+		const unsigned char* data;
+		std::size_t size;
+		std::size_t position = 0;
+		bool failed = false;
+
+		template <typename T>
+		T Get()
+		{
+			T value = {};
+			if (const unsigned char* bytes = Bytes(sizeof(T))) { std::memcpy(&value, bytes, sizeof(T)); }
+			return value;
+		}
+
+		const unsigned char* Bytes(std::uint64_t count)
+		{
+			if (failed || count > size - position)
+			{
+				failed = true;
+				return nullptr;
+			}
+			position += count;
+			return data + position - count;
+		}
+
+		std::string String()
+		{
+			std::uint32_t length = Get<std::uint32_t>();
+			const unsigned char* bytes = Bytes(length);
+			return bytes ? std::string((const char*)bytes, length) : std::string();
+		}
+
+		bool Done() const { return failed || position == size; }
+	} Reader;
+
+	// A call with the trace's names already mapped to the replay's objects
+	typedef struct Command
+	{
+		Op op;
+		UniformKind kind = UniformKind::Float1;
+		std::int64_t args[6] = {};
+		std::vector<unsigned char> bytes;  // Uniform values and buffer contents, aligned as new aligns
+		bool hasBytes = false;
+	} Command;
+
+	// The replay's objects, by the names the traced frame used
+	typedef struct Objects
+	{
+		std::unordered_map<std::uint32_t, GLuint> buffers;
+		std::unordered_map<std::uint32_t, GLuint> programs;
+		std::unordered_map<std::uint32_t, GLuint> vertexArrays;
+		std::unordered_map<std::uint64_t, GLint> uniformLocations;  // Traced program << 32 | traced location
+	} Objects;
+
+	GLuint Find(const std::unordered_map<std::uint32_t, GLuint>& objects, std::uint32_t name)
+	{
+		auto found = objects.find(name);
+		return found == objects.end() ? 0 : found->second;
+	}
+
+	std::uint64_t UniformKey(std::uint32_t program, std::int32_t location)
+	{
+		return (std::uint64_t)program << 32 | (std::uint32_t)location;
+	}
+
+	bool CreateProgram(Reader& reader, Objects& objects)
+	{
+		const std::uint32_t name = reader.Get<std::uint32_t>();
+		const GLuint program = glCreateProgram();
+		objects.programs[name] = program;
+
+		const std::uint32_t shaderCount = reader.Get<std::uint32_t>();
+		for (std::uint32_t s = 0; s < shaderCount && !reader.failed; s++)
+		{
+			const GLenum type = reader.Get<std::uint32_t>();
+			const std::string source = reader.String();
+			const char* text = source.c_str();
+
+			GLuint shader = glCreateShader(type);
+			glShaderSource(shader, 1, &text, nullptr);
+			glCompileShader(shader);
+
+			GLint compiled;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+			if (!compiled)
+			{
+				char log[1024];
+				glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+				std::cerr << "Traced shader failed to compile: " << log << std::endl;
+				glDeleteShader(shader);
+				return false;
+			}
+
+			glAttachShader(program, shader);
+			glDeleteShader(shader);
+		}
+
+		const std::uint32_t attributeCount = reader.Get<std::uint32_t>();
+		for (std::uint32_t a = 0; a < attributeCount && !reader.failed; a++)
+		{
+			const std::int32_t location = reader.Get<std::int32_t>();
+			const std::string attribute = reader.String();
+
+			// Built in inputs have no location
+			if (location >= 0) { glBindAttribLocation(program, location, attribute.c_str()); }
+		}
+
+		glLinkProgram(program);
+		GLint linked;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked)
+		{
+			char log[1024];
+			glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+			std::cerr << "Traced program failed to link: " << log << std::endl;
+			return false;
+		}
+
+		const std::uint32_t uniformCount = reader.Get<std::uint32_t>();
+		for (std::uint32_t u = 0; u < uniformCount && !reader.failed; u++)
+		{
+			const std::int32_t location = reader.Get<std::int32_t>();
+			const std::string uniform = reader.String();
+			objects.uniformLocations[UniformKey(name, location)] = glGetUniformLocation(program, uniform.c_str());
+		}
+
+		return !reader.failed;
+	}
+
+	void CreateVertexArray(Reader& reader, Objects& objects)
+	{
+		const std::uint32_t name = reader.Get<std::uint32_t>();
+
+		// The default vertex array is only set up, not created
+		GLuint vertexArray = 0;
+		if (name != 0) { glGenVertexArrays(1, &vertexArray); }
+		objects.vertexArrays[name] = vertexArray;
+		glBindVertexArray(vertexArray);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Find(objects.buffers, reader.Get<std::uint32_t>()));
+
+		const std::uint32_t attributeCount = reader.Get<std::uint32_t>();
+		for (std::uint32_t a = 0; a < attributeCount && !reader.failed; a++)
+		{
+			const GLuint index = reader.Get<std::uint32_t>();
+			const bool enabled = reader.Get<std::uint8_t>();
+			const GLint size = reader.Get<std::int32_t>();
+			const GLenum type = reader.Get<std::uint32_t>();
+			const GLboolean normalized = reader.Get<std::uint8_t>();
+			const GLsizei stride = reader.Get<std::int32_t>();
+			const GLuint buffer = Find(objects.buffers, reader.Get<std::uint32_t>());
+			const std::uint64_t offset = reader.Get<std::uint64_t>();
+
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glVertexAttribPointer(index, size, type, normalized, stride, (const void*)(std::uintptr_t)offset);
+			if (enabled) { glEnableVertexAttribArray(index); }
+			else { glDisableVertexAttribArray(index); }
+		}
+	}
+
+	// Create every object the frame uses
+	bool RunSetup(Reader reader, Objects& objects)
+	{
+		while (!reader.Done())
+		{
+			switch ((Op)reader.Get<std::uint8_t>())
+			{
+			case Op::CreateBuffer:
+			{
+				const std::uint32_t name = reader.Get<std::uint32_t>();
+				const GLenum usage = reader.Get<std::uint32_t>();
+				const std::uint64_t size = reader.Get<std::uint64_t>();
+				const unsigned char* contents = reader.Bytes(size);
+				if (!contents) { break; }
+
+				GLuint buffer;
+				glGenBuffers(1, &buffer);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+				glBufferData(GL_COPY_WRITE_BUFFER, size, contents, usage);
+				objects.buffers[name] = buffer;
+				break;
+			}
+			case Op::CreateProgram:
+				if (!CreateProgram(reader, objects)) { return false; }
+				break;
+			case Op::CreateVertexArray:
+				CreateVertexArray(reader, objects);
+				break;
+			default:
+				reader.failed = true;
+				break;
+			}
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return !reader.failed;
+	}
+
+	// Decode the calls once, mapping names, so the timed loop only makes GL calls
+	bool DecodeCalls(Reader reader, const Objects& objects, std::vector<Command>& commands)
+	{
+		static const int UNIFORM_COMPONENTS[] = { 1, 2, 3, 4, 16, 1 };
+		std::uint32_t program = 0;  // As traced, to look up uniform locations
+
+		while (!reader.Done())
+		{
+			Command command;
+			command.op = (Op)reader.Get<std::uint8_t>();
+			std::int64_t* args = command.args;
+
+			switch (command.op)
+			{
+			case Op::Viewport:
+				for (int a = 0; a < 4; a++) { args[a] = reader.Get<std::int32_t>(); }
+				break;
+			case Op::ClearColor:
+				command.bytes.resize(4 * sizeof(float));
+				if (const unsigned char* color = reader.Bytes(command.bytes.size())) { std::memcpy(command.bytes.data(), color, command.bytes.size()); }
+				break;
+			case Op::Clear:
+				args[0] = reader.Get<std::uint32_t>();
+				break;
+			case Op::UseProgram:
+				program = reader.Get<std::uint32_t>();
+				args[0] = Find(objects.programs, program);
+				break;
+			case Op::Uniform:
+			{
+				command.kind = (UniformKind)reader.Get<std::uint8_t>();
+				if ((std::size_t)command.kind >= std::size(UNIFORM_COMPONENTS)) { return false; }
+
+				const std::int32_t location = reader.Get<std::int32_t>();
+				auto found = objects.uniformLocations.find(UniformKey(program, location));
+				args[0] = found == objects.uniformLocations.end() ? -1 : found->second;
+				args[1] = reader.Get<std::int32_t>();
+				args[2] = reader.Get<std::uint8_t>();
+
+				if (args[1] < 0) { return false; }
+
+				// Only copied once the trace is known to hold them, so a corrupt count can't allocate
+				const std::uint64_t size = (std::uint64_t)args[1] * UNIFORM_COMPONENTS[(int)command.kind] * 4;
+				if (const unsigned char* values = reader.Bytes(size)) { command.bytes.assign(values, values + size); }
+				break;
+			}
+			case Op::BindBuffer:
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = Find(objects.buffers, reader.Get<std::uint32_t>());
+				break;
+			case Op::BufferData:
+			{
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = reader.Get<std::uint32_t>();
+				args[2] = reader.Get<std::uint64_t>();
+				command.hasBytes = reader.Get<std::uint8_t>();
+				if (command.hasBytes)
+				{
+					const unsigned char* contents = reader.Bytes(args[2]);
+					if (contents) { command.bytes.assign(contents, contents + args[2]); }
+				}
+				break;
+			}
+			case Op::BufferSubData:
+			{
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = reader.Get<std::uint64_t>();
+				args[2] = reader.Get<std::uint64_t>();
+				const unsigned char* contents = reader.Bytes(args[2]);
+				if (contents) { command.bytes.assign(contents, contents + args[2]); }
+				break;
+			}
+			case Op::BindVertexArray:
+				args[0] = Find(objects.vertexArrays, reader.Get<std::uint32_t>());
+				break;
+			case Op::VertexAttribPointer:
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = reader.Get<std::int32_t>();
+				args[2] = reader.Get<std::uint32_t>();
+				args[3] = reader.Get<std::uint8_t>();
+				args[4] = reader.Get<std::int32_t>();
+				args[5] = (std::int64_t)reader.Get<std::uint64_t>();
+				break;
+			case Op::EnableVertexAttribArray:
+			case Op::DisableVertexAttribArray:
+				args[0] = reader.Get<std::uint32_t>();
+				break;
+			case Op::DrawElements:
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = reader.Get<std::int32_t>();
+				args[2] = reader.Get<std::uint32_t>();
+				args[3] = (std::int64_t)reader.Get<std::uint64_t>();
+				break;
+			case Op::DrawArrays:
+				args[0] = reader.Get<std::uint32_t>();
+				args[1] = reader.Get<std::int32_t>();
+				args[2] = reader.Get<std::int32_t>();
+				break;
+			default:
+				return false;
+			}
+
+			commands.push_back(std::move(command));
+		}
+
+		return !reader.failed;
+	}
+
+	void Execute(const std::vector<Command>& commands)
+	{
+		for (const Command& command : commands)
+		{
+			const std::int64_t* args = command.args;
+			const float* floats = (const float*)command.bytes.data();
+
+			switch (command.op)
+			{
+			case Op::Viewport:   glViewport((GLint)args[0], (GLint)args[1], (GLsizei)args[2], (GLsizei)args[3]); break;
+			case Op::ClearColor: glClearColor(floats[0], floats[1], floats[2], floats[3]); break;
+			case Op::Clear:      glClear((GLbitfield)args[0]); break;
+			case Op::UseProgram: glUseProgram((GLuint)args[0]); break;
+			case Op::Uniform:
+			{
+				const GLint location = (GLint)args[0];
+				const GLsizei count = (GLsizei)args[1];
+				switch (command.kind)
+				{
+				case UniformKind::Float1:  glUniform1fv(location, count, floats); break;
+				case UniformKind::Float2:  glUniform2fv(location, count, floats); break;
+				case UniformKind::Float3:  glUniform3fv(location, count, floats); break;
+				case UniformKind::Float4:  glUniform4fv(location, count, floats); break;
+				case UniformKind::Matrix4: glUniformMatrix4fv(location, count, (GLboolean)args[2], floats); break;
+				case UniformKind::Int1:    glUniform1iv(location, count, (const GLint*)floats); break;
+				}
+				break;
+			}
+			case Op::BindBuffer:    glBindBuffer((GLenum)args[0], (GLuint)args[1]); break;
+			case Op::BufferData:    glBufferData((GLenum)args[0], (GLsizeiptr)args[2], command.hasBytes ? command.bytes.data() : nullptr, (GLenum)args[1]); break;
+			case Op::BufferSubData: glBufferSubData((GLenum)args[0], (GLintptr)args[1], (GLsizeiptr)args[2], command.bytes.data()); break;
+			case Op::BindVertexArray: glBindVertexArray((GLuint)args[0]); break;
+			case Op::VertexAttribPointer:
+				glVertexAttribPointer((GLuint)args[0], (GLint)args[1], (GLenum)args[2], (GLboolean)args[3], (GLsizei)args[4], (const void*)(std::uintptr_t)args[5]);
+				break;
+			case Op::EnableVertexAttribArray:  glEnableVertexAttribArray((GLuint)args[0]); break;
+			case Op::DisableVertexAttribArray: glDisableVertexAttribArray((GLuint)args[0]); break;
+			case Op::DrawElements: glDrawElements((GLenum)args[0], (GLsizei)args[1], (GLenum)args[2], (const void*)(std::uintptr_t)args[3]); break;
+			case Op::DrawArrays:   glDrawArrays((GLenum)args[0], (GLint)args[1], (GLsizei)args[2]); break;
+			default: break;
+			}
+		}
+	}
+
+	// FNV-1a, to tell whether two replays drew the same pixels
+	std::uint64_t Checksum(const std::vector<unsigned char>& bytes)
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (unsigned char byte : bytes) { hash = (hash ^ byte) * 0x100000001B3ull; }
+		return hash;
+	}
+}
+
+bool gltrace::Replay(const std::string& path, int iterations)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::vector<unsigned char> trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Reader header{ trace.data(), trace.size() };
+	const unsigned char* magic = header.Bytes(4);
+	const std::uint32_t version = header.Get<std::uint32_t>();
+	const int width = header.Get<std::int32_t>();
+	const int height = header.Get<std::int32_t>();
+	const std::uint64_t setupSize = header.Get<std::uint64_t>();
+	const unsigned char* setup = header.Bytes(setupSize);
+	const std::uint64_t callsSize = header.Get<std::uint64_t>();
+	const unsigned char* calls = header.Bytes(callsSize);
+
+	if (header.failed || std::memcmp(magic, "RGLT", 4) != 0 || version != TRACE_VERSION || width <= 0 || height <= 0)
+	{
+		std::cerr << path << " isn't a GL trace this build can replay" << std::endl;
+		return false;
+	}
+
+	// Draw offscreen, so the result doesn't depend on the window or its pixel ownership
+	GLuint framebuffer, colorBuffer;
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+	auto setupStart = std::chrono::steady_clock::now();
+	Objects objects;
+	std::vector<Command> commands;
+	bool valid = RunSetup(Reader{ setup, setupSize }, objects) && DecodeCalls(Reader{ calls, callsSize }, objects, commands);
+	glFinish();
+	double setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+
+	if (!valid) { std::cerr << "Failed to set up " << path << std::endl; }
+	else
+	{
+		std::size_t draws = std::count_if(commands.begin(), commands.end(),
+			[](const Command& command) { return command.op == Op::DrawElements || command.op == Op::DrawArrays; });
+
+		for (int i = 0; i < WARMUP_ITERATIONS; i++) { Execute(commands); }
+		glFinish();
+
+		std::vector<unsigned char> pixels((std::size_t)width * height * 4);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+		// Finishing each iteration times the driver and GPU work, not just submitting it
+		std::vector<double> times;
+		for (int i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			Execute(commands);
+			glFinish();
+			times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0);
+		}
+		std::sort(times.begin(), times.end());
+
+		double total = 0.0;
+		for (double time : times) { total += time; }
+
+		std::cout << "Replay of " << path << " (" << width << "x" << height << ", " << commands.size() << " calls, "
+			<< draws << " draws, set up in " << setupSeconds * 1000.0 << " ms) on " << glGetString(GL_RENDERER) << "\n";
+		std::cout << "iterations\tmean ms\tmedian ms\tmin ms\tmax ms\tchecksum\n";
+		if (!times.empty())
+		{
+			std::cout << times.size() << '\t' << total / times.size() << '\t' << times[times.size() / 2] << '\t'
+				<< times.front() << '\t' << times.back() << '\t' << std::hex << Checksum(pixels) << std::dec << "\n";
+		}
+		std::cout << std::flush;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	for (const auto& [name, buffer] : objects.buffers) { glDeleteBuffers(1, &buffer); }
+	for (const auto& [name, program] : objects.programs) { glDeleteProgram(program); }
+	for (const auto& [name, vertexArray] : objects.vertexArrays)
+	{
+		if (vertexArray) { glDeleteVertexArrays(1, &vertexArray); }
+	}
+
+	return valid;
+}
@@ -0,0 +1,531 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "GlTrace.h"
+
+namespace {
+
+	using gltrace::Op;
+	using gltrace::UniformKind;
+
+	// The GLEW pointers a traced frame swaps. Holds the tracing versions
+	// while idle and the driver's while tracing, so swapping both ways is the same
+	typedef struct TracedFunctions
+	{
+		PFNGLUSEPROGRAMPROC UseProgram;
+		PFNGLUNIFORM1FPROC Uniform1f;
+		PFNGLUNIFORM1IPROC Uniform1i;
+		PFNGLUNIFORM2FVPROC Uniform2fv;
+		PFNGLUNIFORM3FVPROC Uniform3fv;
+		PFNGLUNIFORM4FVPROC Uniform4fv;
+		PFNGLUNIFORMMATRIX4FVPROC UniformMatrix4fv;
+		PFNGLBINDBUFFERPROC BindBuffer;
+		PFNGLBUFFERDATAPROC BufferData;
+		PFNGLBUFFERSUBDATAPROC BufferSubData;
+		PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+		PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+		PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+		PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+	} TracedFunctions;
+
+	// The frame being traced. GL thread only
+	typedef struct Recorder
+	{
+		bool active = false;
+		int width = 0, height = 0;
+		std::vector<unsigned char> setup;
+		std::vector<unsigned char> calls;
+		std::unordered_set<unsigned int> buffers, programs, vertexArrays;  // Already written to setup
+		gltrace::TraceStats stats;
+	} Recorder;
+
+	Recorder recorder;
+	TracedFunctions functions;
+
+	template <typename T>
+	void Put(std::vector<unsigned char>& out, T value)
+	{
+		const unsigned char* bytes = (const unsigned char*)&value;
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	void PutBytes(std::vector<unsigned char>& out, const void* data, std::size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		out.insert(out.end(), bytes, bytes + size);
+	}
+
+	void PutString(std::vector<unsigned char>& out, const std::string& text)
+	{
+		Put<std::uint32_t>(out, (std::uint32_t)text.size());
+		PutBytes(out, text.data(), text.size());
+	}
+
+	// Start a call record
+	std::vector<unsigned char>& Call(Op op)
+	{
+		recorder.stats.calls++;
+		recorder.calls.push_back((unsigned char)op);
+		return recorder.calls;
+	}
+
+	/*
+	* Snapshots. Each object is written to setup the first time the frame
+	* touches it, as it was then. They bind through the driver's functions,
+	* so the bindings they need aren't traced.
+	*/
+
+	void SnapshotBuffer(unsigned int buffer)
+	{
+		if (buffer == 0 || !recorder.buffers.insert(buffer).second) { return; }
+
+		// Read through the copy binding so the bindings the frame uses are left alone
+		GLint previous, size = 0, usage = GL_STATIC_DRAW;
+		glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previous);
+		functions.BindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+
+		std::vector<unsigned char>& setup = recorder.setup;
+		setup.push_back((unsigned char)Op::CreateBuffer);
+		Put<std::uint32_t>(setup, buffer);
+		Put<std::uint32_t>(setup, usage);
+		Put<std::uint64_t>(setup, size);
+
+		const std::size_t offset = setup.size();
+		setup.resize(offset + size);
+		if (size > 0) { glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, setup.data() + offset); }
+
+		functions.BindBuffer(GL_COPY_READ_BUFFER, previous);
+	}
+
+	// Write the uniform values program holds as calls, so each replay starts from them
+	void RecordUniformValues(unsigned int program, const std::vector<std::pair<GLint, GLenum>>& uniforms)
+	{
+		for (const auto& [location, type] : uniforms)
+		{
+			UniformKind kind;
+			int components;
+			switch (type)
+			{
+			case GL_FLOAT:      kind = UniformKind::Float1;  components = 1;  break;
+			case GL_FLOAT_VEC2: kind = UniformKind::Float2;  components = 2;  break;
+			case GL_FLOAT_VEC3: kind = UniformKind::Float3;  components = 3;  break;
+			case GL_FLOAT_VEC4: kind = UniformKind::Float4;  components = 4;  break;
+			case GL_FLOAT_MAT4: kind = UniformKind::Matrix4; components = 16; break;
+			case GL_INT: case GL_BOOL: case GL_SAMPLER_2D: kind = UniformKind::Int1; components = 1; break;
+			default: continue;
+			}
+
+			// Floats and ints are both 4 bytes
+			std::uint32_t values[16];
+			if (kind == UniformKind::Int1) { glGetUniformiv(program, location, (GLint*)values); }
+			else { glGetUniformfv(program, location, (GLfloat*)values); }
+
+			std::vector<unsigned char>& out = Call(Op::Uniform);
+			Put<std::uint8_t>(out, (std::uint8_t)kind);
+			Put<std::int32_t>(out, location);
+			Put<std::int32_t>(out, 1);
+			Put<std::uint8_t>(out, GL_FALSE);
+			PutBytes(out, values, components * 4);
+		}
+	}
+
+	void SnapshotProgram(unsigned int program)
+	{
+		if (program == 0 || !recorder.programs.insert(program).second) { return; }
+
+		std::vector<unsigned char>& setup = recorder.setup;
+		setup.push_back((unsigned char)Op::CreateProgram);
+		Put<std::uint32_t>(setup, program);
+
+		// Shaders deleted after linking stay attached, with their source, until the program goes
+		GLint shaderCount = 0;
+		glGetProgramiv(program, GL_ATTACHED_SHADERS, &shaderCount);
+		std::vector<GLuint> shaders(shaderCount);
+		if (shaderCount > 0) { glGetAttachedShaders(program, shaderCount, nullptr, shaders.data()); }
+
+		Put<std::uint32_t>(setup, (std::uint32_t)shaderCount);
+		for (GLuint shader : shaders)
+		{
+			GLint type, length = 0;
+			glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+			glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+
+			std::string source(std::max(length, 1), '\0');
+			GLsizei written = 0;
+			glGetShaderSource(shader, (GLsizei)source.size(), &written, source.data());
+			source.resize(written);
+
+			Put<std::uint32_t>(setup, type);
+			PutString(setup, source);
+		}
+
+		// Attribute and uniform locations by name, as the replay's driver may number them differently
+		GLint attributeCount = 0, uniformCount = 0, maxLength = 0, maxUniformLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+		glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformLength);
+		std::string name(std::max({ maxLength, maxUniformLength, 1 }), '\0');
+
+		Put<std::uint32_t>(setup, (std::uint32_t)attributeCount);
+		for (GLint a = 0; a < attributeCount; a++)
+		{
+			GLsizei length;
+			GLint size;
+			GLenum type;
+			glGetActiveAttrib(program, a, (GLsizei)name.size(), &length, &size, &type, name.data());
+			std::string attribute = name.substr(0, length);
+
+			Put<std::int32_t>(setup, glGetAttribLocation(program, attribute.c_str()));
+			PutString(setup, attribute);
+		}
+
+		std::vector<std::pair<GLint, GLenum>> values;
+		std::vector<std::pair<GLint, std::string>> uniforms;
+		for (GLint u = 0; u < uniformCount; u++)
+		{
+			GLsizei length;
+			GLint size;
+			GLenum type;
+			glGetActiveUniform(program, u, (GLsizei)name.size(), &length, &size, &type, name.data());
+			std::string uniform = name.substr(0, length);
+
+			// Members of uniform blocks have no location
+			GLint location = glGetUniformLocation(program, uniform.c_str());
+			if (location < 0) { continue; }
+
+			uniforms.emplace_back(location, uniform);
+			if (size == 1) { values.emplace_back(location, type); }
+		}
+
+		Put<std::uint32_t>(setup, (std::uint32_t)uniforms.size());
+		for (const auto& [location, uniform] : uniforms)
+		{
+			Put<std::int32_t>(setup, location);
+			PutString(setup, uniform);
+		}
+
+		RecordUniformValues(program, values);
+	}
+
+	// vertexArray must be bound
+	void SnapshotVertexArray(unsigned int vertexArray)
+	{
+		if (!recorder.vertexArrays.insert(vertexArray).second) { return; }
+
+		typedef struct Attribute
+		{
+			GLint index = 0, enabled = 0, size = 0, type = 0, normalized = 0, stride = 0, buffer = 0;
+			void* pointer = nullptr;
+		} Attribute;
+
+		GLint elementBuffer, maxAttributes;
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+		glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+		SnapshotBuffer(elementBuffer);
+
+		std::vector<Attribute> attributes;
+		for (GLint i = 0; i < maxAttributes; i++)
+		{
+			Attribute attribute;
+			attribute.index = i;
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &attribute.enabled);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &attribute.buffer);
+			if (!attribute.enabled && attribute.buffer == 0) { continue; }
+
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attribute.size);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &attribute.type);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attribute.normalized);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &attribute.stride);
+			glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &attribute.pointer);
+
+			if (attribute.enabled && attribute.buffer == 0) { recorder.stats.unsupported++; }
+			SnapshotBuffer(attribute.buffer);
+			attributes.push_back(attribute);
+		}
+
+		std::vector<unsigned char>& setup = recorder.setup;
+		setup.push_back((unsigned char)Op::CreateVertexArray);
+		Put<std::uint32_t>(setup, vertexArray);
+		Put<std::uint32_t>(setup, elementBuffer);
+		Put<std::uint32_t>(setup, (std::uint32_t)attributes.size());
+		for (const Attribute& attribute : attributes)
+		{
+			Put<std::uint32_t>(setup, attribute.index);
+			Put<std::uint8_t>(setup, (std::uint8_t)attribute.enabled);
+			Put<std::int32_t>(setup, attribute.size);
+			Put<std::uint32_t>(setup, attribute.type);
+			Put<std::uint8_t>(setup, (std::uint8_t)attribute.normalized);
+			Put<std::int32_t>(setup, attribute.stride);
+			Put<std::uint32_t>(setup, attribute.buffer);
+			Put<std::uint64_t>(setup, (std::uint64_t)(std::uintptr_t)attribute.pointer);
+		}
+	}
+
+	void RecordUniform(UniformKind kind, GLint location, GLsizei count, GLboolean transpose, const void* values, std::size_t valueBytes)
+	{
+		std::vector<unsigned char>& out = Call(Op::Uniform);
+		Put<std::uint8_t>(out, (std::uint8_t)kind);
+		Put<std::int32_t>(out, location);
+		Put<std::int32_t>(out, count);
+		Put<std::uint8_t>(out, transpose);
+		PutBytes(out, values, valueBytes);
+	}
+
+	/*
+	* The versions of the traced functions GLEW's pointers lead to while a
+	* frame is traced. Each records the call and forwards it.
+	*/
+
+	void GLAPIENTRY TraceUseProgram(GLuint program)
+	{
+		Put<std::uint32_t>(Call(Op::UseProgram), program);
+		functions.UseProgram(program);
+		SnapshotProgram(program);
+	}
+
+	void GLAPIENTRY TraceUniform1f(GLint location, GLfloat value)
+	{
+		RecordUniform(UniformKind::Float1, location, 1, GL_FALSE, &value, sizeof(value));
+		functions.Uniform1f(location, value);
+	}
+
+	void GLAPIENTRY TraceUniform1i(GLint location, GLint value)
+	{
+		RecordUniform(UniformKind::Int1, location, 1, GL_FALSE, &value, sizeof(value));
+		functions.Uniform1i(location, value);
+	}
+
+	void GLAPIENTRY TraceUniform2fv(GLint location, GLsizei count, const GLfloat* values)
+	{
+		RecordUniform(UniformKind::Float2, location, count, GL_FALSE, values, count * 2 * sizeof(GLfloat));
+		functions.Uniform2fv(location, count, values);
+	}
+
+	void GLAPIENTRY TraceUniform3fv(GLint location, GLsizei count, const GLfloat* values)
+	{
+		RecordUniform(UniformKind::Float3, location, count, GL_FALSE, values, count * 3 * sizeof(GLfloat));
+		functions.Uniform3fv(location, count, values);
+	}
+
+	void GLAPIENTRY TraceUniform4fv(GLint location, GLsizei count, const GLfloat* values)
+	{
+		RecordUniform(UniformKind::Float4, location, count, GL_FALSE, values, count * 4 * sizeof(GLfloat));
+		functions.Uniform4fv(location, count, values);
+	}
+
+	void GLAPIENTRY TraceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* values)
+	{
+		RecordUniform(UniformKind::Matrix4, location, count, transpose, values, count * 16 * sizeof(GLfloat));
+		functions.UniformMatrix4fv(location, count, transpose, values);
+	}
+
+	void GLAPIENTRY TraceBindBuffer(GLenum target, GLuint buffer)
+	{
+		SnapshotBuffer(buffer);
+
+		std::vector<unsigned char>& out = Call(Op::BindBuffer);
+		Put<std::uint32_t>(out, target);
+		Put<std::uint32_t>(out, buffer);
+		functions.BindBuffer(target, buffer);
+	}
+
+	void GLAPIENTRY TraceBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		std::vector<unsigned char>& out = Call(Op::BufferData);
+		Put<std::uint32_t>(out, target);
+		Put<std::uint32_t>(out, usage);
+		Put<std::uint64_t>(out, size);
+		Put<std::uint8_t>(out, data != nullptr);
+		if (data) { PutBytes(out, data, size); }
+		functions.BufferData(target, size, data, usage);
+	}
+
+	void GLAPIENTRY TraceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		std::vector<unsigned char>& out = Call(Op::BufferSubData);
+		Put<std::uint32_t>(out, target);
+		Put<std::uint64_t>(out, offset);
+		Put<std::uint64_t>(out, size);
+		PutBytes(out, data, size);
+		functions.BufferSubData(target, offset, size, data);
+	}
+
+	void GLAPIENTRY TraceBindVertexArray(GLuint vertexArray)
+	{
+		Put<std::uint32_t>(Call(Op::BindVertexArray), vertexArray);
+		functions.BindVertexArray(vertexArray);
+		SnapshotVertexArray(vertexArray);
+	}
+
+	void GLAPIENTRY TraceVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		GLint arrayBuffer;
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+		if (arrayBuffer == 0) { recorder.stats.unsupported++; }
+
+		std::vector<unsigned char>& out = Call(Op::VertexAttribPointer);
+		Put<std::uint32_t>(out, index);
+		Put<std::int32_t>(out, size);
+		Put<std::uint32_t>(out, type);
+		Put<std::uint8_t>(out, normalized);
+		Put<std::int32_t>(out, stride);
+		Put<std::uint64_t>(out, (std::uint64_t)(std::uintptr_t)pointer);
+		functions.VertexAttribPointer(index, size, type, normalized, stride, pointer);
+	}
+
+	void GLAPIENTRY TraceEnableVertexAttribArray(GLuint index)
+	{
+		Put<std::uint32_t>(Call(Op::EnableVertexAttribArray), index);
+		functions.EnableVertexAttribArray(index);
+	}
+
+	void GLAPIENTRY TraceDisableVertexAttribArray(GLuint index)
+	{
+		Put<std::uint32_t>(Call(Op::DisableVertexAttribArray), index);
+		functions.DisableVertexAttribArray(index);
+	}
+
+	void SwapFunctions()
+	{
+		std::swap(__glewUseProgram, functions.UseProgram);
+		std::swap(__glewUniform1f, functions.Uniform1f);
+		std::swap(__glewUniform1i, functions.Uniform1i);
+		std::swap(__glewUniform2fv, functions.Uniform2fv);
+		std::swap(__glewUniform3fv, functions.Uniform3fv);
+		std::swap(__glewUniform4fv, functions.Uniform4fv);
+		std::swap(__glewUniformMatrix4fv, functions.UniformMatrix4fv);
+		std::swap(__glewBindBuffer, functions.BindBuffer);
+		std::swap(__glewBufferData, functions.BufferData);
+		std::swap(__glewBufferSubData, functions.BufferSubData);
+		std::swap(__glewBindVertexArray, functions.BindVertexArray);
+		std::swap(__glewVertexAttribPointer, functions.VertexAttribPointer);
+		std::swap(__glewEnableVertexAttribArray, functions.EnableVertexAttribArray);
+		std::swap(__glewDisableVertexAttribArray, functions.DisableVertexAttribArray);
+	}
+}
+
+bool gltrace::Tracing()
+{
+	return recorder.active;
+}
+
+bool gltrace::BeginFrame(int framebufferWidth, int framebufferHeight)
+{
+	if (recorder.active) { return false; }
+
+	recorder = Recorder();
+	recorder.active = true;
+	recorder.width = framebufferWidth;
+	recorder.height = framebufferHeight;
+
+	functions = {
+		TraceUseProgram, TraceUniform1f, TraceUniform1i, TraceUniform2fv, TraceUniform3fv, TraceUniform4fv,
+		TraceUniformMatrix4fv, TraceBindBuffer, TraceBufferData, TraceBufferSubData, TraceBindVertexArray,
+		TraceVertexAttribPointer, TraceEnableVertexAttribArray, TraceDisableVertexAttribArray
+	};
+	SwapFunctions();
+
+	// The state the frame starts in, which replay restores before every iteration
+	GLint viewport[4];
+	GLfloat clearColor[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	PutBytes(Call(Op::Viewport), viewport, sizeof(viewport));
+	PutBytes(Call(Op::ClearColor), clearColor, sizeof(clearColor));
+
+	GLint vertexArray, arrayBuffer, program;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+	Put<std::uint32_t>(Call(Op::BindVertexArray), vertexArray);
+	SnapshotVertexArray(vertexArray);
+
+	SnapshotBuffer(arrayBuffer);
+	std::vector<unsigned char>& bind = Call(Op::BindBuffer);
+	Put<std::uint32_t>(bind, GL_ARRAY_BUFFER);
+	Put<std::uint32_t>(bind, arrayBuffer);
+
+	Put<std::uint32_t>(Call(Op::UseProgram), program);
+	SnapshotProgram(program);
+
+	// Only the frame's own calls count
+	recorder.stats.calls = 0;
+	return true;
+}
+
+bool gltrace::EndFrame(const std::string& path, TraceStats& stats)
+{
+	if (!recorder.active) { return false; }
+
+	SwapFunctions();
+	recorder.active = false;
+
+	std::vector<unsigned char> file;
+	PutBytes(file, "RGLT", 4);
+	Put<std::uint32_t>(file, TRACE_VERSION);
+	Put<std::int32_t>(file, recorder.width);
+	Put<std::int32_t>(file, recorder.height);
+	Put<std::uint64_t>(file, recorder.setup.size());
+	PutBytes(file, recorder.setup.data(), recorder.setup.size());
+	Put<std::uint64_t>(file, recorder.calls.size());
+	PutBytes(file, recorder.calls.data(), recorder.calls.size());
+
+	recorder.stats.bytes = file.size();
+	stats = recorder.stats;
+
+	// Free the snapshots now rather than holding them until the next trace
+	recorder = Recorder();
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out.write((const char*)file.data(), file.size()))
+	{
+		std::cerr << "Failed to write GL trace " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void gltrace::Clear(unsigned int mask)
+{
+	if (recorder.active) { Put<std::uint32_t>(Call(Op::Clear), mask); }
+	glClear(mask);
+}
+
+void gltrace::DrawElements(unsigned int mode, int count, unsigned int type, const void* indices)
+{
+	if (recorder.active)
+	{
+		GLint elementBuffer;
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+		if (elementBuffer == 0) { recorder.stats.unsupported++; }
+
+		std::vector<unsigned char>& out = Call(Op::DrawElements);
+		Put<std::uint32_t>(out, mode);
+		Put<std::int32_t>(out, count);
+		Put<std::uint32_t>(out, type);
+		Put<std::uint64_t>(out, (std::uint64_t)(std::uintptr_t)indices);
+		recorder.stats.draws++;
+	}
+	glDrawElements(mode, count, type, indices);
+}
+
+void gltrace::DrawArrays(unsigned int mode, int first, int count)
+{
+	if (recorder.active)
+	{
+		std::vector<unsigned char>& out = Call(Op::DrawArrays);
+		Put<std::uint32_t>(out, mode);
+		Put<std::int32_t>(out, first);
+		Put<std::int32_t>(out, count);
+		recorder.stats.draws++;
+	}
+	glDrawArrays(mode, first, count);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file GlTrace.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Records one frame's GL calls and the buffers and programs
+ *        they use to a file, and replays it in a loop for timing
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace gltrace {
+
+	/*
+	* While a frame is traced, the GLEW function pointers of the calls the
+	* renderer makes are swapped for ones that append the call to a byte
+	* stream and forward it to the driver, and swapped back afterwards, so
+	* tracing costs nothing on frames that aren't traced and needs no
+	* changes to the code making the calls.
+	*
+	* GL 1.1 entry points are linked straight from the driver rather than
+	* through GLEW pointers, so the few the renderer draws with go through
+	* Clear, DrawElements and DrawArrays here instead, which call straight
+	* through unless a frame is being traced.
+	*
+	* The first time a traced call touches a buffer, program or vertex
+	* array, its contents, shader sources or attribute layout are read
+	* back and written ahead of the calls, along with the viewport, clear
+	* colour, program and uniforms the frame started with. The file then
+	* holds everything needed to draw the frame again in a bare context,
+	* such as llvmpipe on a build machine, without the application, its
+	* assets or its threads.
+	*
+	* File layout, little endian: "RGLT", version, framebuffer width and
+	* height, then a setup section and a call section, each a byte count
+	* followed by records of an Op and its operands. Replay runs setup
+	* once and the calls in a loop.
+	*/
+
+	constexpr std::uint32_t TRACE_VERSION = 1;
+
+	enum class Op : std::uint8_t
+	{
+		// Setup
+		CreateBuffer = 1,     // name, usage, size, bytes
+		CreateProgram,        // name, shaders (type, source), attributes (location, name), uniforms (location, name)
+		CreateVertexArray,    // name, element buffer, attributes (index, enabled, size, type, normalized, stride, buffer, offset)
+
+		// Calls
+		Viewport = 16,
+		ClearColor,
+		Clear,
+		UseProgram,
+		Uniform,              // kind, location, count, values
+		BindBuffer,
+		BufferData,           // target, usage, size, whether bytes follow, bytes
+		BufferSubData,
+		BindVertexArray,
+		VertexAttribPointer,
+		EnableVertexAttribArray,
+		DisableVertexAttribArray,
+		DrawElements,
+		DrawArrays
+	};
+
+	// Which glUniform* an Op::Uniform replays
+	enum class UniformKind : std::uint8_t
+	{
+		Float1, Float2, Float3, Float4, Matrix4, Int1
+	};
+
+	typedef struct TraceStats
+	{
+		std::uint64_t calls = 0;
+		std::uint64_t draws = 0;
+		std::uint64_t bytes = 0;        // Size of the file
+		std::uint64_t unsupported = 0;  // Calls recorded with client memory pointers, which replay can't reproduce
+	} TraceStats;
+
+	// Whether a frame is being traced
+	bool Tracing();
+
+	/**
+	* @brief            Start tracing the calls the current context makes. GL thread only
+	*
+	* @return           false if a frame is already being traced
+	*/
+	bool BeginFrame(int framebufferWidth, int framebufferHeight);
+
+	/**
+	* @brief            Stop tracing and write the frame to path
+	*
+	* @return           false if nothing was being traced or the file couldn't be written
+	*/
+	bool EndFrame(const std::string& path, TraceStats& stats);
+
+	// The GL 1.1 calls the renderer draws with, traced when a frame is
+	void Clear(unsigned int mask);
+	void DrawElements(unsigned int mode, int count, unsigned int type, const void* indices);
+	void DrawArrays(unsigned int mode, int first, int count);
+
+	/**
+	* @brief            Replay a traced frame into an offscreen framebuffer in a
+	*                   loop, finishing each iteration, and print how long they
+	*                   took. The current context must be able to draw it
+	*
+	* @param iterations frames timed, after a few untimed ones to warm up
+	* @return           false if the file couldn't be read or set up
+	*/
+	bool Replay(const std::string& path, int iterations);
+}
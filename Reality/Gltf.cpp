@@ -0,0 +1,605 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "Gltf.h"
+#include "GlTrace.h"
+#include "GpuAnnotations.h"
+#include "Json.h"
+#include "MappedFile.h"
+
+namespace {
+
+	constexpr std::uint32_t GLB_MAGIC      = 0x46546C67;  // "glTF"
+	constexpr std::uint32_t GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+	constexpr std::uint32_t GLB_CHUNK_BIN  = 0x004E4942;  // "BIN\0"
+
+	// Scene graphs deeper than this are treated as cyclic
+	constexpr int MAX_NODE_DEPTH = 64;
+
+	// Largest accessor built from zeros and sparse values alone, with no buffer view bounding it
+	constexpr std::size_t MAX_MATERIALIZED_BYTES = (std::size_t)256 << 20;
+
+	typedef struct ByteRange
+	{
+		const unsigned char* data;
+		std::size_t size;
+	} ByteRange;
+
+	// Where an accessor's elements live on the GPU
+	typedef struct GpuAccessor
+	{
+		unsigned int buffer;
+		const unsigned char* data;  // The same elements in memory, alive until loading finishes
+		std::size_t offset;
+		std::size_t stride;
+		std::size_t count;
+		int components;
+		unsigned int componentType;
+		bool normalized;
+	} GpuAccessor;
+
+	// Everything that has to stay alive while a file is loading
+	typedef struct LoadContext
+	{
+		json::Value root;
+		std::vector<MappedFile> files;
+		std::vector<std::vector<unsigned char>> decodedBuffers;  // From data URIs
+		std::vector<std::vector<unsigned char>> materialized;    // Sparse accessors' elements
+		std::vector<ByteRange> buffers;
+		std::vector<unsigned int> gpuBuffers;
+		gltf::Scene* scene;
+	} LoadContext;
+
+	int ComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") { return 1; }
+		if (type == "VEC2")   { return 2; }
+		if (type == "VEC3")   { return 3; }
+		if (type == "VEC4" || type == "MAT2") { return 4; }
+		if (type == "MAT3")   { return 9; }
+		if (type == "MAT4")   { return 16; }
+		return 0;
+	}
+
+	// glTF component types are the GL type enums
+	std::size_t ComponentSize(unsigned int componentType)
+	{
+		switch (componentType)
+		{
+		case GL_BYTE:  case GL_UNSIGNED_BYTE:  return 1;
+		case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+		case GL_UNSIGNED_INT: case GL_FLOAT:   return 4;
+		default: return 0;
+		}
+	}
+
+	bool DecodeBase64(std::string_view text, std::vector<unsigned char>& bytes)
+	{
+		auto sextet = [](char c) -> int
+		{
+			if (c >= 'A' && c <= 'Z') { return c - 'A'; }
+			if (c >= 'a' && c <= 'z') { return c - 'a' + 26; }
+			if (c >= '0' && c <= '9') { return c - '0' + 52; }
+			if (c == '+') { return 62; }
+			if (c == '/') { return 63; }
+			return -1;
+		};
+
+		unsigned int accumulator = 0;
+		int bits = 0;
+		for (char c : text)
+		{
+			if (c == '=') { break; }
+
+			int value = sextet(c);
+			if (value < 0) { return false; }
+
+			accumulator = (accumulator << 6) | (unsigned int)value;
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				bytes.push_back((unsigned char)(accumulator >> bits));
+			}
+		}
+
+		return true;
+	}
+
+	// Whether count elements of elementSize bytes, stride apart from offset, fit in size bytes.
+	// Divides rather than multiplies so hostile counts can't overflow. stride must not be 0
+	bool ElementsFit(std::size_t offset, std::size_t count, std::size_t stride, std::size_t elementSize, std::size_t size)
+	{
+		if (offset > size) { return false; }
+		if (count == 0) { return true; }
+
+		std::size_t available = size - offset;
+		return elementSize <= available && count - 1 <= (available - elementSize) / stride;
+	}
+
+	// The bytes of a buffer view and the buffer they are in, if the view lies inside it
+	bool ResolveView(const LoadContext& context, std::size_t index, ByteRange& bytes, std::size_t& bufferIndex)
+	{
+		const json::Value& view = context.root["bufferViews"][index];
+		bufferIndex = view["buffer"].AsIndex((std::size_t)-1);
+		if (view.IsNull() || bufferIndex >= context.buffers.size()) { return false; }
+
+		const ByteRange& buffer = context.buffers[bufferIndex];
+		std::size_t offset = view["byteOffset"].AsIndex();
+		std::size_t length = view["byteLength"].AsIndex();
+		if (offset > buffer.size || length > buffer.size - offset) { return false; }
+
+		bytes = ByteRange(buffer.data + offset, length);
+		return true;
+	}
+
+	/**
+	* @brief        Create an immutable GL buffer from data. With buffer storage
+	*               the driver reads straight from data, which may be a file
+	*               mapping, instead of going through a staging copy
+	*/
+	unsigned int CreateBuffer(const void* data, std::size_t size)
+	{
+		unsigned int buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+		if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) { glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, 0); }
+		else { glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STATIC_DRAW); }
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		return buffer;
+	}
+
+	// Point every glTF buffer at its bytes, mapping or decoding them as needed
+	bool ResolveBuffers(LoadContext& context, const std::filesystem::path& directory, ByteRange binChunk)
+	{
+		const json::Value& buffers = context.root["buffers"];
+		context.files.reserve(buffers.Size());
+
+		for (std::size_t b = 0; b < buffers.Size(); b++)
+		{
+			const json::Value& buffer = buffers[b];
+			std::size_t byteLength = buffer["byteLength"].AsIndex();
+			ByteRange bytes;
+
+			if (!buffer.Has("uri"))
+			{
+				// Only the first buffer of a .glb may omit its URI, meaning the BIN chunk
+				if (b != 0 || !binChunk.data) { return false; }
+				bytes = binChunk;
+			}
+			else
+			{
+				const std::string& uri = buffer["uri"].AsString();
+				if (uri.rfind("data:", 0) == 0)
+				{
+					std::size_t comma = uri.find(";base64,");
+					if (comma == std::string::npos) { return false; }
+
+					context.decodedBuffers.emplace_back();
+					if (!DecodeBase64(std::string_view(uri).substr(comma + 8), context.decodedBuffers.back())) { return false; }
+					bytes = ByteRange(context.decodedBuffers.back().data(), context.decodedBuffers.back().size());
+				}
+				else
+				{
+					context.files.emplace_back();
+					if (!context.files.back().Open((directory / uri).string().c_str()))
+					{
+						std::cerr << "Failed to open glTF buffer " << uri << std::endl;
+						return false;
+					}
+					bytes = ByteRange(context.files.back().Data(), context.files.back().Size());
+				}
+			}
+
+			if (bytes.size < byteLength) { return false; }
+			bytes.size = byteLength;
+			context.buffers.push_back(bytes);
+		}
+
+		return true;
+	}
+
+	/**
+	* @brief            Find where accessor's elements live on the GPU, uploading
+	*                   glTF buffers the first time an accessor uses them
+	*
+	* @param context    file being loaded
+	* @param index      accessor to resolve
+	* @param accessor   receives the accessor's location and layout
+	* @return           whether the accessor is valid
+	*/
+	bool ResolveAccessor(LoadContext& context, std::size_t index, GpuAccessor& accessor)
+	{
+		const json::Value& description = context.root["accessors"][index];
+		if (description.IsNull()) { return false; }
+
+		accessor.componentType = (unsigned int)description["componentType"].AsIndex();
+		accessor.components    = ComponentCount(description["type"].AsString());
+		accessor.count         = description["count"].AsIndex();
+		accessor.normalized    = description["normalized"].AsBoolean();
+
+		const std::size_t elementSize = ComponentSize(accessor.componentType) * accessor.components;
+		if (elementSize == 0 || accessor.count == 0) { return false; }
+
+		// Locate the dense data, if any, and check it fits in its buffer view
+		const unsigned char* dense = nullptr;
+		std::size_t denseStride = elementSize;
+		std::size_t viewIndex = description["bufferView"].AsIndex((std::size_t)-1);
+		std::size_t bufferIndex = 0, denseOffset = 0;
+
+		if (viewIndex != (std::size_t)-1)
+		{
+			ByteRange view;
+			if (!ResolveView(context, viewIndex, view, bufferIndex)) { return false; }
+
+			std::size_t accessorOffset = description["byteOffset"].AsIndex();
+			denseStride = context.root["bufferViews"][viewIndex]["byteStride"].AsIndex(elementSize);
+			if (denseStride < elementSize || !ElementsFit(accessorOffset, accessor.count, denseStride, elementSize, view.size)) { return false; }
+
+			dense = view.data + accessorOffset;
+			denseOffset = (std::size_t)(dense - context.buffers[bufferIndex].data);
+		}
+
+		const json::Value& sparse = description["sparse"];
+		if (dense && sparse.IsNull())
+		{
+			// The common case: draw straight out of the file's buffer
+			if (context.gpuBuffers[bufferIndex] == 0)
+			{
+				context.gpuBuffers[bufferIndex] = CreateBuffer(context.buffers[bufferIndex].data, context.buffers[bufferIndex].size);
+				if (annotate::Enabled()) { annotate::Label(GL_BUFFER, context.gpuBuffers[bufferIndex], "glTF buffer " + std::to_string(bufferIndex)); }
+			}
+
+			accessor.buffer = context.gpuBuffers[bufferIndex];
+			accessor.data   = dense;
+			accessor.offset = denseOffset;
+			accessor.stride = denseStride;
+			return true;
+		}
+
+		// Materialize the accessor: dense data (or zeros) with the sparse substitutions applied.
+		// Dense data already fits in its view, so only zeros need a limit
+		if (!dense && accessor.count > MAX_MATERIALIZED_BYTES / elementSize) { return false; }
+		std::vector<unsigned char> elements(accessor.count * elementSize, 0);
+		if (dense)
+		{
+			for (std::size_t e = 0; e < accessor.count; e++) { std::memcpy(&elements[e * elementSize], dense + e * denseStride, elementSize); }
+		}
+
+		if (!sparse.IsNull())
+		{
+			std::size_t sparseCount = sparse["count"].AsIndex();
+			const json::Value& indices = sparse["indices"];
+			const json::Value& values = sparse["values"];
+
+			unsigned int indexType = (unsigned int)indices["componentType"].AsIndex();
+			std::size_t indexSize = ComponentSize(indexType);
+			if (indexType != GL_UNSIGNED_BYTE && indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT) { return false; }
+
+			ByteRange indexView, valueView;
+			std::size_t indexBuffer, valueBuffer;
+			if (!ResolveView(context, indices["bufferView"].AsIndex((std::size_t)-1), indexView, indexBuffer) ||
+				!ResolveView(context, values["bufferView"].AsIndex((std::size_t)-1), valueView, valueBuffer)) { return false; }
+
+			std::size_t indexOffset = indices["byteOffset"].AsIndex();
+			std::size_t valueOffset = values["byteOffset"].AsIndex();
+			if (!ElementsFit(indexOffset, sparseCount, indexSize, indexSize, indexView.size) ||
+				!ElementsFit(valueOffset, sparseCount, elementSize, elementSize, valueView.size)) { return false; }
+
+			for (std::size_t s = 0; s < sparseCount; s++)
+			{
+				const unsigned char* indexBytes = indexView.data + indexOffset + s * indexSize;
+				std::uint32_t target = 0;
+				if (indexSize == 1) { target = *indexBytes; }
+				else if (indexSize == 2) { std::uint16_t value; std::memcpy(&value, indexBytes, 2); target = value; }
+				else { std::memcpy(&target, indexBytes, 4); }
+
+				if (target >= accessor.count) { return false; }
+				std::memcpy(&elements[target * elementSize], valueView.data + valueOffset + s * elementSize, elementSize);
+			}
+		}
+
+		accessor.buffer = CreateBuffer(elements.data(), elements.size());
+		if (annotate::Enabled()) { annotate::Label(GL_BUFFER, accessor.buffer, "glTF sparse accessor " + std::to_string(index)); }
+		accessor.offset = 0;
+		accessor.stride = elementSize;
+		context.scene->buffers.push_back(accessor.buffer);
+
+		// The heap block moves with the vector, so data stays valid
+		context.materialized.push_back(std::move(elements));
+		accessor.data = context.materialized.back().data();
+		return true;
+	}
+
+	// Whether every index is below vertexCount. glTF doesn't promise alignment, so each index is copied out
+	template <typename IndexType>
+	bool IndicesInRange(const unsigned char* indices, std::size_t indexCount, std::size_t vertexCount)
+	{
+		IndexType largest = 0;
+		for (std::size_t i = 0; i < indexCount; i++)
+		{
+			IndexType index;
+			std::memcpy(&index, indices + i * sizeof(IndexType), sizeof(IndexType));
+			largest = std::max(largest, index);
+		}
+
+		return largest < vertexCount;
+	}
+
+	bool IndicesInRange(const GpuAccessor& indices, std::size_t vertexCount)
+	{
+		switch (indices.componentType)
+		{
+		case GL_UNSIGNED_BYTE:  return IndicesInRange<std::uint8_t>(indices.data, indices.count, vertexCount);
+		case GL_UNSIGNED_SHORT: return IndicesInRange<std::uint16_t>(indices.data, indices.count, vertexCount);
+		case GL_UNSIGNED_INT:   return IndicesInRange<std::uint32_t>(indices.data, indices.count, vertexCount);
+		default:                return false;
+		}
+	}
+
+	bool LoadPrimitive(LoadContext& context, const json::Value& description, gltf::Primitive& primitive)
+	{
+		GpuAccessor position;
+		if (!description["attributes"].Has("POSITION") ||
+			!ResolveAccessor(context, description["attributes"]["POSITION"].AsIndex(), position)) { return false; }
+
+		primitive.mode = (unsigned int)description["mode"].AsIndex(GL_TRIANGLES);
+		if (primitive.mode > GL_TRIANGLE_FAN) { return false; }  // glTF modes are GL_POINTS through GL_TRIANGLE_FAN
+
+		glGenVertexArrays(1, &primitive.vertexArray);
+		glBindVertexArray(primitive.vertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, position.buffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, position.components, position.componentType, position.normalized,
+			(int)position.stride, (const void*)position.offset);
+
+		primitive.count = (unsigned int)position.count;
+
+		if (description.Has("indices"))
+		{
+			GpuAccessor indices;
+			bool valid = ResolveAccessor(context, description["indices"].AsIndex(), indices) && indices.components == 1 &&
+				indices.stride == ComponentSize(indices.componentType) &&
+				(indices.componentType == GL_UNSIGNED_BYTE || indices.componentType == GL_UNSIGNED_SHORT || indices.componentType == GL_UNSIGNED_INT) &&
+				IndicesInRange(indices, position.count);  // Out of range indices read past the vertex buffers
+
+			if (!valid)
+			{
+				glBindVertexArray(0);
+				return false;
+			}
+
+			// The element buffer binding is part of the vertex array's state
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.buffer);
+			primitive.count = (unsigned int)indices.count;
+			primitive.indexType = indices.componentType;
+			primitive.indexOffset = indices.offset;
+		}
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	void Multiply(const float lhs[16], const float rhs[16], float result[16])
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++) { sum += lhs[k * 4 + row] * rhs[column * 4 + k]; }
+				result[column * 4 + row] = sum;
+			}
+		}
+	}
+
+	// A node's transform relative to its parent, from its matrix or its translation, rotation and scale
+	void LocalTransform(const json::Value& node, float transform[16])
+	{
+		const json::Value& matrix = node["matrix"];
+		if (matrix.Size() == 16)
+		{
+			for (std::size_t i = 0; i < 16; i++) { transform[i] = (float)matrix[i].AsNumber(); }
+			return;
+		}
+
+		const json::Value& t = node["translation"];
+		const json::Value& r = node["rotation"];
+		const json::Value& s = node["scale"];
+
+		float x = (float)r[0].AsNumber(0.0), y = (float)r[1].AsNumber(0.0), z = (float)r[2].AsNumber(0.0), w = (float)r[3].AsNumber(1.0);
+		float sx = (float)s[0].AsNumber(1.0), sy = (float)s[1].AsNumber(1.0), sz = (float)s[2].AsNumber(1.0);
+
+		// T * R * S, with R built from the unit quaternion (x, y, z, w)
+		float trs[16] = {
+			(1 - 2 * (y * y + z * z)) * sx, (2 * (x * y + z * w)) * sx,     (2 * (x * z - y * w)) * sx,     0,
+			(2 * (x * y - z * w)) * sy,     (1 - 2 * (x * x + z * z)) * sy, (2 * (y * z + x * w)) * sy,     0,
+			(2 * (x * z + y * w)) * sz,     (2 * (y * z - x * w)) * sz,     (1 - 2 * (x * x + y * y)) * sz, 0,
+			(float)t[0].AsNumber(), (float)t[1].AsNumber(), (float)t[2].AsNumber(), 1
+		};
+		std::memcpy(transform, trs, sizeof(trs));
+	}
+
+	void VisitNode(const LoadContext& context, std::size_t nodeIndex, const float parent[16],
+		const std::vector<std::pair<std::size_t, std::size_t>>& meshPrimitives, int depth)
+	{
+		const json::Value& node = context.root["nodes"][nodeIndex];
+		if (node.IsNull() || depth > MAX_NODE_DEPTH) { return; }
+
+		float local[16], world[16];
+		LocalTransform(node, local);
+		Multiply(parent, local, world);
+
+		std::size_t meshIndex = node["mesh"].AsIndex((std::size_t)-1);
+		if (meshIndex < meshPrimitives.size())
+		{
+			gltf::MeshInstance instance;
+			instance.firstPrimitive = meshPrimitives[meshIndex].first;
+			instance.primitiveCount = meshPrimitives[meshIndex].second;
+			std::memcpy(instance.worldTransform, world, sizeof(world));
+			context.scene->instances.push_back(instance);
+		}
+
+		const json::Value& children = node["children"];
+		for (std::size_t c = 0; c < children.Size(); c++) { VisitNode(context, children[c].AsIndex(), world, meshPrimitives, depth + 1); }
+	}
+
+	bool LoadDocument(LoadContext& context, const std::filesystem::path& directory, ByteRange binChunk)
+	{
+		if (context.root["asset"]["version"].AsString().rfind("2.", 0) != 0)
+		{
+			std::cerr << "Only glTF 2.x is supported" << std::endl;
+			return false;
+		}
+
+		if (!ResolveBuffers(context, directory, binChunk)) { return false; }
+		context.gpuBuffers.assign(context.buffers.size(), 0);
+
+		// Every primitive of every mesh, remembering where each mesh's run starts
+		const json::Value& meshes = context.root["meshes"];
+		std::vector<std::pair<std::size_t, std::size_t>> meshPrimitives;
+		for (std::size_t m = 0; m < meshes.Size(); m++)
+		{
+			const json::Value& primitives = meshes[m]["primitives"];
+			meshPrimitives.emplace_back(context.scene->primitives.size(), primitives.Size());
+
+			for (std::size_t p = 0; p < primitives.Size(); p++)
+			{
+				context.scene->primitives.emplace_back();
+				if (!LoadPrimitive(context, primitives[p], context.scene->primitives.back())) { return false; }
+
+				if (annotate::Enabled())
+				{
+					const std::string& name = meshes[m]["name"].AsString();
+					annotate::Label(GL_VERTEX_ARRAY, context.scene->primitives.back().vertexArray,
+						(name.empty() ? "glTF mesh " + std::to_string(m) : name) + " primitive " + std::to_string(p));
+				}
+			}
+		}
+
+		for (unsigned int buffer : context.gpuBuffers)
+		{
+			if (buffer) { context.scene->buffers.push_back(buffer); }
+		}
+
+		// Instance meshes through the default scene's node hierarchy, or
+		// draw every mesh once if the file doesn't describe a scene
+		const float identity[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+		const json::Value& scene = context.root["scenes"][context.root["scene"].AsIndex(0)];
+		if (!scene.IsNull())
+		{
+			const json::Value& nodes = scene["nodes"];
+			for (std::size_t n = 0; n < nodes.Size(); n++) { VisitNode(context, nodes[n].AsIndex(), identity, meshPrimitives, 0); }
+		}
+		else
+		{
+			for (const auto& [first, count] : meshPrimitives)
+			{
+				gltf::MeshInstance instance = { first, count, {} };
+				std::memcpy(instance.worldTransform, identity, sizeof(identity));
+				context.scene->instances.push_back(instance);
+			}
+		}
+
+		return true;
+	}
+}
+
+bool gltf::Load(const char* path, Scene& scene)
+{
+	scene = Scene();
+
+	LoadContext context;
+	context.scene = &scene;
+
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		std::cerr << "Failed to open " << path << std::endl;
+		return false;
+	}
+
+	std::string_view document;
+	ByteRange binChunk = { nullptr, 0 };
+
+	std::uint32_t magic = 0;
+	if (file.Size() >= sizeof(magic)) { std::memcpy(&magic, file.Data(), sizeof(magic)); }
+
+	if (magic == GLB_MAGIC)
+	{
+		// 12 byte header, then chunks of (length, type, data) padded to 4 bytes
+		std::uint32_t header[3];
+		if (file.Size() < sizeof(header)) { return false; }
+		std::memcpy(header, file.Data(), sizeof(header));
+		if (header[1] != 2 || header[2] > file.Size()) { return false; }
+
+		std::size_t at = sizeof(header);
+		while (at + 8 <= header[2])
+		{
+			std::uint32_t chunk[2];
+			std::memcpy(chunk, file.Data() + at, sizeof(chunk));
+			at += sizeof(chunk);
+			if (chunk[0] > header[2] - at) { return false; }
+
+			if (chunk[1] == GLB_CHUNK_JSON && document.empty()) { document = std::string_view((const char*)file.Data() + at, chunk[0]); }
+			else if (chunk[1] == GLB_CHUNK_BIN && !binChunk.data) { binChunk = ByteRange(file.Data() + at, chunk[0]); }
+
+			at += (chunk[0] + 3) & ~3u;
+		}
+	}
+	else { document = std::string_view((const char*)file.Data(), file.Size()); }
+
+	bool loaded = json::Parse(document, context.root) &&
+		LoadDocument(context, std::filesystem::path(path).parent_path(), binChunk);
+
+	if (!loaded)
+	{
+		std::cerr << path << " is not a glTF file this loader supports" << std::endl;
+
+		// Buffers uploaded before the failure still need deleting
+		for (unsigned int buffer : context.gpuBuffers)
+		{
+			if (buffer) { scene.buffers.push_back(buffer); }
+		}
+		Release(scene);
+		return false;
+	}
+
+	return true;
+}
+
+void gltf::Draw(const Scene& scene)
+{
+	for (const MeshInstance& instance : scene.instances)
+	{
+		for (std::size_t p = instance.firstPrimitive; p < instance.firstPrimitive + instance.primitiveCount; p++)
+		{
+			const Primitive& primitive = scene.primitives[p];
+			glBindVertexArray(primitive.vertexArray);
+
+			if (primitive.indexType) { gltrace::DrawElements(primitive.mode, primitive.count, primitive.indexType, (const void*)primitive.indexOffset); }
+			else { gltrace::DrawArrays(primitive.mode, 0, primitive.count); }
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+void gltf::Release(Scene& scene)
+{
+	for (const Primitive& primitive : scene.primitives)
+	{
+		if (primitive.vertexArray) { glDeleteVertexArrays(1, &primitive.vertexArray); }
+	}
+
+	if (!scene.buffers.empty()) { glDeleteBuffers((int)scene.buffers.size(), scene.buffers.data()); }
+	scene = Scene();
+}
@@ -0,0 +1,68 @@
+/**
+ * @file Gltf.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief glTF 2.0 (.gltf and .glb) scene loader. Binary buffers
+ *        go from the memory mapped file straight into GPU buffers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace gltf {
+
+	// One glTF mesh primitive, ready to draw
+	typedef struct Primitive
+	{
+		unsigned int vertexArray = 0;
+		unsigned int mode = 0;          // GL primitive type
+		unsigned int count = 0;         // Indices, or vertices if not indexed
+		unsigned int indexType = 0;     // 0 if not indexed
+		std::size_t indexOffset = 0;    // Byte offset into the bound element buffer
+	} Primitive;
+
+	// A node of the scene that references a glTF mesh
+	typedef struct MeshInstance
+	{
+		std::size_t firstPrimitive;
+		std::size_t primitiveCount;
+		float worldTransform[16];       // Column major. Not applied by the generic shaders yet
+	} MeshInstance;
+
+	typedef struct Scene
+	{
+		std::vector<unsigned int> buffers;  // GL buffers, one per glTF buffer plus one per sparse accessor
+		std::vector<Primitive> primitives;
+		std::vector<MeshInstance> instances;
+	} Scene;
+
+	/*
+	* Each glTF buffer becomes one immutable GL buffer created with
+	* glBufferStorage (glBufferData without GL 4.4 or ARB_buffer_storage)
+	* directly from the mapped file, so the data isn't copied on the CPU.
+	* Accessors point into those buffers with their byte stride and offset.
+	* Sparse accessors, and accessors without a buffer view, are the only
+	* data materialized on the CPU since their values don't exist in any
+	* buffer as stored. Position goes to attribute 0.
+	*/
+
+	/**
+	* @brief        Load a .gltf or .glb file. Buffers referenced by URI
+	*               are read relative to path, or decoded if data URIs
+	*
+	* @param path   file to load
+	* @param scene  receives the loaded scene
+	* @return       whether the file could be loaded. On failure scene is empty
+	*/
+	bool Load(const char* path, Scene& scene);
+
+	// Draw every mesh instance of scene
+	void Draw(const Scene& scene);
+
+	// Delete scene's GL objects
+	void Release(Scene& scene);
+}
@@ -0,0 +1,594 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "Colors.h"
+#include "GlTrace.h"
+#include "GoldenImages.h"
+#include "Image.h"
+#include "ImageEncoder.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "Rasterizer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define GOLDEN_SSE2 1
+#else
+#define GOLDEN_SSE2 0
+#endif
+
+namespace {
+
+	constexpr int WIDTH = 640, HEIGHT = 360;
+
+	// Renders of each scene timed, after one to warm up
+	constexpr int RENDERS = 10;
+
+	// GL rasterizes edges with its own subpixel precision, so GL renders pass
+	// with edge pixels differing from the golden rather than matching exactly.
+	// SSIM is taken of luma alone, so a swapped colour also has to show up as
+	// more than the fraction of pixels edges account for
+	constexpr double GL_MIN_SSIM = 0.98;
+	constexpr double GL_MAX_DIFFERING = 0.01;
+
+	// Rows compared by one job
+	constexpr std::size_t ROWS_PER_JOB = 16;
+
+	// SSIM window and the distance between windows
+	constexpr int WINDOW = 8;
+	constexpr int WINDOW_STEP = 4;
+
+	// SSIM stabilising constants for 8 bit values
+	constexpr double C1 = (0.01 * 255) * (0.01 * 255);
+	constexpr double C2 = (0.03 * 255) * (0.03 * 255);
+
+	// Changed pixels and the largest channel change of one row
+	void CompareRow(const unsigned char* expected, const unsigned char* actual, int width, std::uint64_t& differing, int& maxDifference)
+	{
+		differing = 0;
+		maxDifference = 0;
+		int x = 0;
+
+#if GOLDEN_SSE2
+		__m128i largest = _mm_setzero_si128();
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(expected + x * 4));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(actual + x * 4));
+			const __m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+			largest = _mm_max_epu8(largest, difference);
+
+			const __m128i same = _mm_cmpeq_epi32(difference, _mm_setzero_si128());
+			differing += 4 - std::popcount((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(same)));
+		}
+
+		unsigned char lanes[16];
+		_mm_storeu_si128((__m128i*)lanes, largest);
+		maxDifference = *std::max_element(lanes, lanes + 16);
+#endif
+
+		for (; x < width; x++)
+		{
+			int pixelDifference = 0;
+			for (int c = 0; c < 4; c++) { pixelDifference = std::max(pixelDifference, std::abs(expected[x * 4 + c] - actual[x * 4 + c])); }
+
+			differing += pixelDifference != 0;
+			maxDifference = std::max(maxDifference, pixelDifference);
+		}
+	}
+
+	void ToLuma(const unsigned char* rgba, int width, float* luma)
+	{
+		for (int x = 0; x < width; x++, rgba += 4) { luma[x] = 0.299f * rgba[0] + 0.587f * rgba[1] + 0.114f * rgba[2]; }
+	}
+
+	// SSIM of the window whose top left is at a and b, in luma planes width wide
+	double WindowSsim(const float* a, const float* b, int width)
+	{
+		float sums[5];   // a, b, a^2, b^2, ab
+
+#if GOLDEN_SSE2
+		__m128 sumA = _mm_setzero_ps(), sumB = _mm_setzero_ps();
+		__m128 sumAA = _mm_setzero_ps(), sumBB = _mm_setzero_ps(), sumAB = _mm_setzero_ps();
+		for (int row = 0; row < WINDOW; row++, a += width, b += width)
+		{
+			for (int half = 0; half < WINDOW; half += 4)
+			{
+				const __m128 va = _mm_loadu_ps(a + half), vb = _mm_loadu_ps(b + half);
+				sumA = _mm_add_ps(sumA, va);
+				sumB = _mm_add_ps(sumB, vb);
+				sumAA = _mm_add_ps(sumAA, _mm_mul_ps(va, va));
+				sumBB = _mm_add_ps(sumBB, _mm_mul_ps(vb, vb));
+				sumAB = _mm_add_ps(sumAB, _mm_mul_ps(va, vb));
+			}
+		}
+
+		const __m128 vectors[5] = { sumA, sumB, sumAA, sumBB, sumAB };
+		for (int s = 0; s < 5; s++)
+		{
+			float lanes[4];
+			_mm_storeu_ps(lanes, vectors[s]);
+			sums[s] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+		}
+#else
+		std::fill_n(sums, 5, 0.0f);
+		for (int row = 0; row < WINDOW; row++, a += width, b += width)
+		{
+			for (int x = 0; x < WINDOW; x++)
+			{
+				sums[0] += a[x];
+				sums[1] += b[x];
+				sums[2] += a[x] * a[x];
+				sums[3] += b[x] * b[x];
+				sums[4] += a[x] * b[x];
+			}
+		}
+#endif
+
+		constexpr double N = WINDOW * WINDOW;
+		const double meanA = sums[0] / N, meanB = sums[1] / N;
+		// Left unclamped so identical windows give exactly 1, rounding and all
+		const double varianceA = sums[2] / N - meanA * meanA;
+		const double varianceB = sums[3] / N - meanB * meanB;
+		const double covariance = sums[4] / N - meanA * meanB;
+
+		return ((2.0 * meanA * meanB + C1) * (2.0 * covariance + C2)) /
+			((meanA * meanA + meanB * meanB + C1) * (varianceA + varianceB + C2));
+	}
+
+	// Scenes
+
+	// Stays the same on every run and platform, unlike the standard distributions
+	class Random
+	{
+	public:
+		explicit Random(std::uint32_t seed) : state(seed) {}
+
+		float Range(float low, float high)
+		{
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * (float)(state >> 8) / 16777216.0f;
+		}
+
+		std::uint32_t Color()
+		{
+			const float rgba[4] = { Range(0.0f, 1.0f), Range(0.0f, 1.0f), Range(0.0f, 1.0f), 1.0f };
+			return raster::PackColor(rgba);
+		}
+
+	private:
+		std::uint32_t state;
+	};
+
+	// Triangles drawn one draw each, each in its own colour
+	typedef struct Geometry
+	{
+		std::vector<PositionVertex2D> vertices;
+		std::vector<std::uint32_t> indices;
+		std::vector<std::uint32_t> colors;
+	} Geometry;
+
+	void DrawGeometry(raster::Rasterizer& rasterizer, const Geometry& geometry)
+	{
+		for (std::size_t t = 0; t < geometry.colors.size(); t++)
+		{
+			rasterizer.DrawIndexed(std::span<const PositionVertex2D>(geometry.vertices), geometry.indices.data() + t * 3, 3, 4,
+				raster::GenericVertexShader(), raster::GenericFragmentShader{ geometry.colors[t] });
+		}
+	}
+
+	// The quad the GL loop draws
+	const Geometry& Quad()
+	{
+		static const Geometry quad = { { { -0.5f, 0.5f }, { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f } },
+			{ 1, 2, 3, 0, 1, 3 }, { raster::PackColor(colors::Red), raster::PackColor(colors::Red) } };
+
+		return quad;
+	}
+
+	// Overlapping triangles of every size, which must land in the order they were drawn
+	const Geometry& Overlapping()
+	{
+		static const Geometry triangles = []
+		{
+			Geometry geometry;
+			Random random(1);
+			for (std::uint32_t t = 0; t < 300; t++)
+			{
+				const float x = random.Range(-1.0f, 1.0f), y = random.Range(-1.0f, 1.0f), size = random.Range(0.005f, 0.6f);
+				for (int v = 0; v < 3; v++)
+				{
+					geometry.vertices.push_back({ x + random.Range(-size, size), y + random.Range(-size, size) });
+					geometry.indices.push_back(t * 3 + v);
+				}
+				geometry.colors.push_back(random.Color());
+			}
+			return geometry;
+		}();
+
+		return triangles;
+	}
+
+	// A fan of thin slices sharing edges and a centre, where the fill rule decides every edge pixel
+	const Geometry& Fan()
+	{
+		static const Geometry fan = []
+		{
+			constexpr int SLICES = 96;
+			Geometry geometry;
+			Random random(2);
+			geometry.vertices.push_back({ 0.013f, -0.021f });
+			for (int s = 0; s < SLICES; s++)
+			{
+				const float angle = s * 6.2831853f / SLICES;
+				geometry.vertices.push_back({ 0.9f * std::cos(angle), 0.9f * std::sin(angle) });
+			}
+			for (std::uint32_t s = 0; s < SLICES; s++)
+			{
+				geometry.indices.insert(geometry.indices.end(), { 0, 1 + s, 1 + (s + 1) % SLICES });
+				geometry.colors.push_back(random.Color());
+			}
+			return geometry;
+		}();
+
+		return fan;
+	}
+
+	// Triangles reaching far outside the screen, which are clipped to the guard band
+	const Geometry& Clipped()
+	{
+		static const Geometry triangles = []
+		{
+			Geometry geometry;
+			Random random(3);
+			for (std::uint32_t t = 0; t < 12; t++)
+			{
+				for (int v = 0; v < 3; v++)
+				{
+					geometry.vertices.push_back({ random.Range(-60.0f, 60.0f), random.Range(-60.0f, 60.0f) });
+					geometry.indices.push_back(t * 3 + v);
+				}
+				geometry.colors.push_back(random.Color());
+			}
+			return geometry;
+		}();
+
+		return triangles;
+	}
+
+	// Colours each pixel by its position, so the kernels' per pixel path is covered too
+	typedef struct PatternShader
+	{
+		static constexpr bool IS_FLAT = false;
+
+		std::uint32_t u_Tint;
+
+		void Shade(int x, int y, int count, std::uint32_t* colors) const
+		{
+			for (int i = 0; i < count; i++)
+			{
+				const std::uint32_t px = (std::uint32_t)(x + i), py = (std::uint32_t)y;
+				colors[i] = ((px ^ py) & 8) ? u_Tint : (px & 0xFF) | (py & 0xFF) << 8 | 0x80u << 16 | 0xFFu << 24;
+			}
+		}
+	} PatternShader;
+
+	void DrawShaded(raster::Rasterizer& rasterizer)
+	{
+		static const Geometry triangles = []
+		{
+			Geometry geometry;
+			Random random(4);
+			for (std::uint32_t t = 0; t < 40; t++)
+			{
+				const float x = random.Range(-1.0f, 1.0f), y = random.Range(-1.0f, 1.0f);
+				for (int v = 0; v < 3; v++)
+				{
+					geometry.vertices.push_back({ x + random.Range(-0.4f, 0.4f), y + random.Range(-0.4f, 0.4f) });
+					geometry.indices.push_back(t * 3 + v);
+				}
+				geometry.colors.push_back(random.Color());
+			}
+			return geometry;
+		}();
+
+		for (std::size_t t = 0; t < triangles.colors.size(); t++)
+		{
+			rasterizer.DrawIndexed(std::span<const PositionVertex2D>(triangles.vertices), triangles.indices.data() + t * 3, 3, 4,
+				raster::GenericVertexShader(), PatternShader{ triangles.colors[t] });
+		}
+	}
+
+	typedef struct Scene
+	{
+		const char* name;
+		const Geometry& (*geometry)();                  // Drawn with the generic shaders, so on the GL path too
+		void (*draw)(raster::Rasterizer& rasterizer);  // Otherwise drawn with shaders only the rasterizer has
+	} Scene;
+
+	const Scene SCENES[] = {
+		{ "quad", Quad, nullptr },
+		{ "overlapping", Overlapping, nullptr },
+		{ "fan", Fan, nullptr },
+		{ "clipped", Clipped, nullptr },
+		{ "shaded", nullptr, DrawShaded }
+	};
+
+	// Render a scene, returning its RGBA8 pixels top row first and the time a render took
+	std::vector<unsigned char> Render(const Scene& scene, raster::Kernel kernel, double& milliseconds)
+	{
+		raster::Rasterizer rasterizer(WIDTH, HEIGHT);
+		rasterizer.SetKernel(kernel);
+
+		auto render = [&]
+		{
+			rasterizer.Clear(colors::Black);
+			if (scene.geometry) { DrawGeometry(rasterizer, scene.geometry()); }
+			else { scene.draw(rasterizer); }
+			rasterizer.Finish();
+		};
+
+		render();
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < RENDERS; r++) { render(); }
+		milliseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / RENDERS;
+
+		std::vector<unsigned char> rgba((std::size_t)WIDTH * HEIGHT * 4);
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			std::memcpy(rgba.data() + (std::size_t)y * WIDTH * 4, rasterizer.Pixels() + (std::size_t)y * rasterizer.Stride(), (std::size_t)WIDTH * 4);
+		}
+		return rgba;
+	}
+
+	// The floats GL turns back into exactly the bytes of a colour packed like PackColor
+	void UnpackColor(std::uint32_t packed, float rgba[4])
+	{
+		for (int c = 0; c < 4; c++) { rgba[c] = (float)((packed >> (c * 8)) & 0xFF) / 255.0f; }
+	}
+
+	/**
+	* @brief            Render a scene's geometry the way the application draws, uploaded
+	*                   with mesh::Upload and drawn with program, the generic shaders,
+	*                   into an offscreen framebuffer. Returns pixels like Render
+	*
+	* @param program    linked generic shader program
+	*/
+	std::vector<unsigned char> RenderGl(const Geometry& geometry, unsigned int program, double& milliseconds)
+	{
+		unsigned int framebuffer, renderbuffer;
+		glGenRenderbuffers(1, &renderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+		glViewport(0, 0, WIDTH, HEIGHT);
+
+		mesh::IndexedMesh indexed;
+		indexed.vertices = geometry.vertices;
+		for (std::size_t i = 0; i < geometry.indices.size(); i += 3)
+		{
+			indexed.AddTriangle(Triangle2D(geometry.indices[i], geometry.indices[i + 1], geometry.indices[i + 2]));
+		}
+
+		// A mesh of one colour goes through the optimizer and is drawn in one draw, like the
+		// application's meshes. Otherwise triangles must stay in order to keep their colours,
+		// and each run of one colour is a draw
+		const bool singleColor = std::all_of(geometry.colors.begin(), geometry.colors.end(),
+			[&](std::uint32_t color) { return color == geometry.colors[0]; });
+		if (singleColor) { mesh::Optimize(indexed); }
+
+		mesh::GpuMesh gpuMesh = mesh::Upload(indexed);
+		glUseProgram(program);
+		const int colorLocation = glGetUniformLocation(program, "u_Color");
+		glUniform2f(glGetUniformLocation(program, "u_Offset"), 0.0f, 0.0f);
+
+		auto render = [&]
+		{
+			glClearColor(colors::Black[0], colors::Black[1], colors::Black[2], colors::Black[3]);
+			gltrace::Clear(GL_COLOR_BUFFER_BIT);
+
+			float color[4];
+			if (singleColor)
+			{
+				UnpackColor(geometry.colors[0], color);
+				glUniform4fv(colorLocation, 1, color);
+				mesh::Draw(gpuMesh);
+			}
+			else
+			{
+				for (std::size_t first = 0, last; first < geometry.colors.size(); first = last)
+				{
+					for (last = first + 1; last < geometry.colors.size() && geometry.colors[last] == geometry.colors[first]; last++) {}
+
+					UnpackColor(geometry.colors[first], color);
+					glUniform4fv(colorLocation, 1, color);
+					gltrace::DrawElements(GL_TRIANGLES, (int)((last - first) * 3), gpuMesh.indexType,
+						(const void*)(first * 3 * indexed.indices.Stride()));
+				}
+			}
+
+			glFinish();
+		};
+
+		render();
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < RENDERS; r++) { render(); }
+		milliseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / RENDERS;
+
+		// GL's rows are bottom first
+		std::vector<unsigned char> bottomUp((std::size_t)WIDTH * HEIGHT * 4), rgba(bottomUp.size());
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			std::memcpy(rgba.data() + (std::size_t)y * WIDTH * 4, bottomUp.data() + (std::size_t)(HEIGHT - 1 - y) * WIDTH * 4, (std::size_t)WIDTH * 4);
+		}
+
+		mesh::Release(gpuMesh);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &renderbuffer);
+		return rgba;
+	}
+
+	bool WritePng(const std::filesystem::path& path, const std::vector<unsigned char>& rgba)
+	{
+		std::vector<unsigned char> png;
+		image::EncodePng(rgba.data(), WIDTH, HEIGHT, false, png);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)png.data(), (std::streamsize)png.size());
+		if (!file) { std::cerr << "Failed to write " << path.string() << std::endl; }
+		return (bool)file;
+	}
+
+	bool ReadPng(const std::filesystem::path& path, std::vector<unsigned char>& rgba)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		image::ImageInfo info;
+		if (!image::ReadInfo(data.data(), data.size(), info) || info.width != WIDTH || info.height != HEIGHT) { return false; }
+
+		rgba.resize((std::size_t)WIDTH * HEIGHT * 4);
+		return image::Decode(data.data(), data.size(), rgba.data());
+	}
+}
+
+golden::ImageDiff golden::Compare(const unsigned char* expected, const unsigned char* actual, int width, int height)
+{
+	const std::size_t rowSize = (std::size_t)width * 4;
+	std::vector<std::uint64_t> rowDiffering(height);
+	std::vector<int> rowMaxDifference(height);
+	std::vector<float> expectedLuma((std::size_t)width * height), actualLuma((std::size_t)width * height);
+
+	jobs::ParallelFor(height, ROWS_PER_JOB, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t y = begin; y < end; y++)
+		{
+			CompareRow(expected + y * rowSize, actual + y * rowSize, width, rowDiffering[y], rowMaxDifference[y]);
+			ToLuma(expected + y * rowSize, width, expectedLuma.data() + y * width);
+			ToLuma(actual + y * rowSize, width, actualLuma.data() + y * width);
+		}
+	});
+
+	ImageDiff diff;
+	for (int y = 0; y < height; y++)
+	{
+		diff.differingPixels += rowDiffering[y];
+		diff.maxDifference = std::max(diff.maxDifference, rowMaxDifference[y]);
+	}
+
+	// Images smaller than a window are only similar if they're the same
+	if (width < WINDOW || height < WINDOW)
+	{
+		diff.ssim = diff.differingPixels == 0 ? 1.0 : 0.0;
+		return diff;
+	}
+
+	const int windowsWide = (width - WINDOW) / WINDOW_STEP + 1, windowsHigh = (height - WINDOW) / WINDOW_STEP + 1;
+	std::vector<double> rowSsim(windowsHigh);
+	jobs::ParallelFor(windowsHigh, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t wy = begin; wy < end; wy++)
+		{
+			double sum = 0.0;
+			for (int wx = 0; wx < windowsWide; wx++)
+			{
+				const std::size_t offset = wy * WINDOW_STEP * width + (std::size_t)wx * WINDOW_STEP;
+				sum += WindowSsim(expectedLuma.data() + offset, actualLuma.data() + offset, width);
+			}
+			rowSsim[wy] = sum;
+		}
+	});
+
+	double total = 0.0;
+	for (double sum : rowSsim) { total += sum; }
+	diff.ssim = total / ((double)windowsWide * windowsHigh);
+	return diff;
+}
+
+bool golden::RunGoldenTests(const std::string& directory, bool record, unsigned int glProgram)
+{
+	std::error_code error;
+	if (record) { std::filesystem::create_directories(directory, error); }
+
+	std::vector<raster::Kernel> kernels;
+	for (raster::Kernel kernel : { raster::Kernel::Scalar, raster::Kernel::Sse2, raster::Kernel::Avx2 })
+	{
+		if (raster::IsSupported(kernel)) { kernels.push_back(kernel); }
+	}
+
+	std::cout << "Golden images (" << WIDTH << "x" << HEIGHT << ", " << jobs::ThreadCount() << " threads) in " << directory << "\n";
+	if (glProgram) { std::cout << "GL on " << glGetString(GL_RENDERER) << " passes with SSIM >= " << GL_MIN_SSIM << " and at most "
+		<< GL_MAX_DIFFERING * 100.0 << "% of pixels differing\n"; }
+	else { std::cout << "No GL context, so only the rasterizer is checked\n"; }
+	std::cout << "scene\tkernel\tms/render\tdiffering\tmax diff\tssim\tresult\n";
+
+	bool passed = true;
+	for (const Scene& scene : SCENES)
+	{
+		const std::filesystem::path goldenPath = std::filesystem::path(directory) / (std::string(scene.name) + ".png");
+
+		std::vector<unsigned char> expected;
+		double milliseconds;
+		if (record)
+		{
+			expected = Render(scene, raster::Kernel::Scalar, milliseconds);
+			bool written = WritePng(goldenPath, expected);
+			passed &= written;
+
+			std::cout << scene.name << '\t' << raster::KernelName(raster::Kernel::Scalar) << '\t' << milliseconds
+				<< "\t\t\t\t" << (written ? "recorded" : "FAILED") << '\n';
+		}
+		else if (!ReadPng(goldenPath, expected))
+		{
+			std::cout << scene.name << "\t\t\t\t\t\tMISSING " << goldenPath.string() << '\n';
+			passed = false;
+			continue;
+		}
+
+		for (raster::Kernel kernel : kernels)
+		{
+			if (record && kernel == raster::Kernel::Scalar) { continue; }
+
+			std::vector<unsigned char> actual = Render(scene, kernel, milliseconds);
+			ImageDiff diff = Compare(expected.data(), actual.data(), WIDTH, HEIGHT);
+			bool matches = diff.differingPixels == 0;
+			passed &= matches;
+
+			if (!matches) { WritePng(std::filesystem::path(directory) / (std::string(scene.name) + "." + raster::KernelName(kernel) + ".png"), actual); }
+
+			std::cout << scene.name << '\t' << raster::KernelName(kernel) << '\t' << milliseconds << '\t' << diff.differingPixels << '\t'
+				<< diff.maxDifference << '\t' << diff.ssim << '\t' << (matches ? "ok" : "FAILED") << '\n';
+		}
+
+		if (glProgram && scene.geometry)
+		{
+			std::vector<unsigned char> actual = RenderGl(scene.geometry(), glProgram, milliseconds);
+			ImageDiff diff = Compare(expected.data(), actual.data(), WIDTH, HEIGHT);
+			bool similar = diff.ssim >= GL_MIN_SSIM && diff.differingPixels <= GL_MAX_DIFFERING * WIDTH * HEIGHT;
+			passed &= similar;
+
+			if (!similar) { WritePng(std::filesystem::path(directory) / (std::string(scene.name) + ".gl.png"), actual); }
+
+			std::cout << scene.name << "\tgl\t" << milliseconds << '\t' << diff.differingPixels << '\t'
+				<< diff.maxDifference << '\t' << diff.ssim << '\t' << (similar ? "ok" : "FAILED") << '\n';
+		}
+	}
+
+	std::cout << (passed ? "All scenes match" : "Scenes differ from their golden images") << std::endl;
+	return passed;
+}
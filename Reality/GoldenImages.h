@@ -0,0 +1,68 @@
+/**
+ * @file GoldenImages.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Renders a fixed set of scenes with the software rasterizer
+ *        and through GL offscreen, and compares them against stored
+ *        golden images, so changes to the draw paths can be shown not
+ *        to change their output
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace golden {
+
+	typedef struct ImageDiff
+	{
+		std::uint64_t differingPixels = 0;    // Pixels with any channel changed
+		int maxDifference             = 0;    // Largest change of any channel
+		double ssim                   = 1.0;  // Mean structural similarity of luma, 1 when identical
+	} ImageDiff;
+
+	/**
+	* @brief    Compare two RGBA8 images of the same size, width * 4 bytes a
+	*           row, exactly and perceptually. SSIM is taken over 8x8
+	*           windows 4 pixels apart. Uses SSE2 where available, split
+	*           across the job system
+	*/
+	ImageDiff Compare(const unsigned char* expected, const unsigned char* actual, int width, int height);
+
+	/*
+	* Every scene is drawn with each rasterization kernel the CPU supports
+	* and must match its golden image exactly, as the rasterizer is
+	* deterministic: a kernel or setup change that moves a single pixel
+	* fails. SSIM and the largest channel change are reported to tell a
+	* rounding slip from a broken draw. Each failing render is written
+	* next to the golden as <scene>.<kernel>.png to look at.
+	*
+	* Recording renders with the scalar kernel, the reference the SIMD
+	* kernels are held to. Its recordings are kept in Reality/Golden and
+	* checked with --golden check, run from Reality/ like the application.
+	*
+	* Given a GL program, the scenes drawn with the generic shaders are
+	* also drawn the way the application draws them: optimized where
+	* the colours allow, uploaded with mesh::Upload and drawn with the
+	* program into an offscreen framebuffer. GL and the rasterizer round
+	* edges differently, so instead of matching exactly these pass with
+	* SSIM above a threshold and few enough pixels changed to be edges,
+	* which still catches a wrong colour, a dropped or misplaced triangle
+	* or a broken shader. They are written as <scene>.gl.png when they
+	* fail.
+	*/
+
+	/**
+	* @brief            Render every scene, print a table of results with the
+	*                   time each render took, and return whether all matched
+	*
+	* @param directory  holds <scene>.png for each scene
+	* @param record     write the golden images instead of checking against them
+	* @param glProgram  linked generic shader program on the current context,
+	*                   or 0 to check the rasterizer alone
+	*/
+	bool RunGoldenTests(const std::string& directory, bool record, unsigned int glProgram = 0);
+}
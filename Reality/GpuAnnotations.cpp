@@ -0,0 +1,42 @@
+#include <GL/glew.h>
+#include <iostream>
+#include "GpuAnnotations.h"
+
+namespace {
+
+	std::atomic<bool> supported = false;
+}
+
+std::atomic<bool> annotate::detail::enabled = false;
+
+void annotate::Init()
+{
+	supported.store(GLEW_VERSION_4_3 || GLEW_KHR_debug, std::memory_order_relaxed);
+}
+
+void annotate::SetEnabled(bool on)
+{
+	if (on && !supported.load(std::memory_order_relaxed))
+	{
+		std::cerr << "GL annotations need GL 4.3 or KHR_debug" << std::endl;
+		on = false;
+	}
+	detail::enabled.store(on, std::memory_order_relaxed);
+}
+
+void annotate::Label(unsigned int identifier, unsigned int name, const char* label)
+{
+	if (!Enabled() || name == 0) { return; }
+	glObjectLabel(identifier, name, -1, label);
+}
+
+void annotate::Scope::Push(const char* name)
+{
+	// The ID is for the application's own use, and the tools show the name
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+void annotate::Scope::Pop()
+{
+	glPopDebugGroup();
+}
@@ -0,0 +1,79 @@
+/**
+ * @file GpuAnnotations.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Debug groups around passes and labels on GL objects, so GL
+ *        captures and profilers show names instead of numbers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <string>
+
+namespace annotate {
+
+	/*
+	* Tools like apitrace, RenderDoc and vendor profilers show GL objects
+	* by number and a frame as a flat list of calls. KHR_debug lets the
+	* application name objects with glObjectLabel and nest calls in named
+	* groups with glPushDebugGroup, which those tools show instead.
+	*
+	* Annotations cost a driver call each, and drivers with debug output
+	* on echo every group as a message, so they are off unless asked for.
+	* Every entry point checks one relaxed atomic first, so turned off
+	* they cost a load and a branch. They can be turned on and off at any
+	* time from any thread; groups already pushed are still popped. An
+	* object is only labelled if annotations were on when it was created.
+	*/
+
+	namespace detail { extern std::atomic<bool> enabled; }
+
+	// Whether annotations are being made. Check it before building a label that costs anything
+	inline bool Enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+	// Find out whether the current context supports KHR_debug. GL thread, once, before SetEnabled
+	void Init();
+
+	// Turn annotations on or off. Stays off without KHR_debug. Any thread
+	void SetEnabled(bool enabled);
+
+	/**
+	* @brief                Name a GL object, if annotations are on
+	*
+	* @param identifier     GL_BUFFER, GL_PROGRAM, GL_VERTEX_ARRAY, GL_TEXTURE...
+	* @param name           the object, which must have been bound or created already
+	*/
+	void Label(unsigned int identifier, unsigned int name, const char* label);
+	inline void Label(unsigned int identifier, unsigned int name, const std::string& label) { Label(identifier, name, label.c_str()); }
+
+	// Pushes a debug group for its lifetime, if annotations were on when it was made
+	class Scope
+	{
+	public:
+		explicit Scope(const char* name)
+		{
+			if (Enabled())
+			{
+				Push(name);
+				pushed = true;
+			}
+		}
+
+		~Scope()
+		{
+			if (pushed) { Pop(); }
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		static void Push(const char* name);
+		static void Pop();
+
+		bool pushed = false;
+	};
+}
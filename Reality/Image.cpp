@@ -0,0 +1,1118 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Image.h"
+#include "Zlib.h"
+
+namespace {
+
+	std::uint32_t ReadBigEndian32(const unsigned char* bytes)
+	{
+		return ((std::uint32_t)bytes[0] << 24) | ((std::uint32_t)bytes[1] << 16) | ((std::uint32_t)bytes[2] << 8) | bytes[3];
+	}
+
+	std::uint16_t ReadBigEndian16(const unsigned char* bytes)
+	{
+		return (std::uint16_t)((bytes[0] << 8) | bytes[1]);
+	}
+
+	bool ValidSize(std::uint32_t width, std::uint32_t height)
+	{
+		return width > 0 && height > 0 && width <= image::MAX_DIMENSION && height <= image::MAX_DIMENSION;
+	}
+
+	unsigned char ClampToByte(int value)
+	{
+		return (unsigned char)std::clamp(value, 0, 255);
+	}
+
+	/* PNG */
+
+	constexpr unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// Where each of the 7 Adam7 passes starts and how far apart its pixels are
+	constexpr int ADAM7_X[7]      = { 0, 4, 0, 2, 0, 1, 0 };
+	constexpr int ADAM7_Y[7]      = { 0, 0, 4, 0, 2, 0, 1 };
+	constexpr int ADAM7_X_STEP[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	constexpr int ADAM7_Y_STEP[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	enum PngColorType
+	{
+		PNG_GREY       = 0,
+		PNG_RGB        = 2,
+		PNG_PALETTE    = 3,
+		PNG_GREY_ALPHA = 4,
+		PNG_RGBA       = 6
+	};
+
+	typedef struct PngImage
+	{
+		int width;
+		int height;
+		int bitDepth;
+		int colorType;
+		int channels;
+		bool interlaced;
+
+		unsigned char palette[256][4];
+		bool hasColorKey;            // tRNS for grey and RGB: pixels equal to colorKey are transparent
+		std::uint16_t colorKey[3];
+	} PngImage;
+
+	int PngChannels(int colorType)
+	{
+		switch (colorType)
+		{
+		case PNG_GREY:       return 1;
+		case PNG_RGB:        return 3;
+		case PNG_PALETTE:    return 1;
+		case PNG_GREY_ALPHA: return 2;
+		case PNG_RGBA:       return 4;
+		default:             return 0;
+		}
+	}
+
+	bool ValidPngDepth(int colorType, int bitDepth)
+	{
+		switch (colorType)
+		{
+		case PNG_GREY:    return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+		case PNG_PALETTE: return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+		default:          return bitDepth == 8 || bitDepth == 16;
+		}
+	}
+
+	unsigned char Paeth(int left, int above, int aboveLeft)
+	{
+		int estimate = left + above - aboveLeft;
+		int toLeft = std::abs(estimate - left), toAbove = std::abs(estimate - above), toAboveLeft = std::abs(estimate - aboveLeft);
+
+		if (toLeft <= toAbove && toLeft <= toAboveLeft) { return (unsigned char)left; }
+		return (unsigned char)(toAbove <= toAboveLeft ? above : aboveLeft);
+	}
+
+	// Undo a scanline's filter in place. previous is the unfiltered row above, all zeros for the first row
+	bool Unfilter(int filter, unsigned char* row, const unsigned char* previous, std::size_t rowSize, std::size_t pixelSize)
+	{
+		switch (filter)
+		{
+		case 0: return true;
+		case 1:
+			for (std::size_t i = pixelSize; i < rowSize; i++) { row[i] += row[i - pixelSize]; }
+			return true;
+		case 2:
+			for (std::size_t i = 0; i < rowSize; i++) { row[i] += previous[i]; }
+			return true;
+		case 3:
+			for (std::size_t i = 0; i < pixelSize; i++) { row[i] += previous[i] >> 1; }
+			for (std::size_t i = pixelSize; i < rowSize; i++) { row[i] += (row[i - pixelSize] + previous[i]) >> 1; }
+			return true;
+		case 4:
+			for (std::size_t i = 0; i < pixelSize; i++) { row[i] += previous[i]; }
+			for (std::size_t i = pixelSize; i < rowSize; i++)
+			{
+				row[i] += Paeth(row[i - pixelSize], previous[i], previous[i - pixelSize]);
+			}
+			return true;
+		default: return false;
+		}
+	}
+
+	// Sample index of an unfiltered row at bitDepth, at full precision
+	unsigned int PngSample(const unsigned char* row, std::size_t index, int bitDepth)
+	{
+		switch (bitDepth)
+		{
+		case 8:  return row[index];
+		case 16: return ReadBigEndian16(row + index * 2);
+		default:
+		{
+			std::size_t bit = index * bitDepth;
+			return (row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1);
+		}
+		}
+	}
+
+	// Expand count pixels of an unfiltered row to RGBA, pixelStride bytes apart in out
+	void PngRowToRgba(const PngImage& png, const unsigned char* row, int count, unsigned char* out, std::size_t pixelStride)
+	{
+		// The common formats first
+		if (png.bitDepth == 8 && png.colorType == PNG_RGBA)
+		{
+			for (int x = 0; x < count; x++, out += pixelStride) { std::memcpy(out, row + x * 4, 4); }
+			return;
+		}
+		if (png.bitDepth == 8 && png.colorType == PNG_RGB && !png.hasColorKey)
+		{
+			for (int x = 0; x < count; x++, out += pixelStride)
+			{
+				out[0] = row[x * 3];
+				out[1] = row[x * 3 + 1];
+				out[2] = row[x * 3 + 2];
+				out[3] = 255;
+			}
+			return;
+		}
+
+		const int maxValue = (1 << png.bitDepth) - 1;
+		auto toByte = [&png, maxValue](unsigned int sample)
+		{
+			if (png.bitDepth == 16) { return (unsigned char)(sample >> 8); }
+			return (unsigned char)(sample * 255 / maxValue);
+		};
+
+		for (int x = 0; x < count; x++, out += pixelStride)
+		{
+			std::size_t first = (std::size_t)x * png.channels;
+			switch (png.colorType)
+			{
+			case PNG_PALETTE:
+				std::memcpy(out, png.palette[PngSample(row, first, png.bitDepth)], 4);
+				break;
+			case PNG_GREY:
+			{
+				unsigned int grey = PngSample(row, first, png.bitDepth);
+				out[0] = out[1] = out[2] = toByte(grey);
+				out[3] = png.hasColorKey && grey == png.colorKey[0] ? 0 : 255;
+				break;
+			}
+			case PNG_GREY_ALPHA:
+				out[0] = out[1] = out[2] = toByte(PngSample(row, first, png.bitDepth));
+				out[3] = toByte(PngSample(row, first + 1, png.bitDepth));
+				break;
+			case PNG_RGB:
+			{
+				unsigned int red = PngSample(row, first, png.bitDepth);
+				unsigned int green = PngSample(row, first + 1, png.bitDepth);
+				unsigned int blue = PngSample(row, first + 2, png.bitDepth);
+				out[0] = toByte(red);
+				out[1] = toByte(green);
+				out[2] = toByte(blue);
+				out[3] = png.hasColorKey && red == png.colorKey[0] && green == png.colorKey[1] && blue == png.colorKey[2] ? 0 : 255;
+				break;
+			}
+			default:
+				for (int c = 0; c < 4; c++) { out[c] = toByte(PngSample(row, first + c, png.bitDepth)); }
+			}
+		}
+	}
+
+	// Bytes of filtered data for a width x height pass, counting each row's filter byte
+	std::size_t PngPassSize(const PngImage& png, int width, int height)
+	{
+		if (width == 0 || height == 0) { return 0; }
+		return ((std::size_t)width * png.channels * png.bitDepth + 7) / 8 * height + height;
+	}
+
+	/**
+	* @brief        Unfilter one pass of raw and write its pixels into rgba
+	*
+	* @param raw    the pass's filtered rows, unfiltered in place
+	* @return       whether every row had a valid filter
+	*/
+	bool DecodePngPass(const PngImage& png, unsigned char* raw, int passWidth, int passHeight,
+		int x0, int y0, int xStep, int yStep, unsigned char* rgba)
+	{
+		if (passWidth == 0 || passHeight == 0) { return true; }
+
+		const std::size_t rowSize = ((std::size_t)passWidth * png.channels * png.bitDepth + 7) / 8;
+		const std::size_t pixelSize = std::max(png.channels * png.bitDepth / 8, 1);
+
+		std::vector<unsigned char> zeros(rowSize, 0);
+		const unsigned char* previous = zeros.data();
+
+		for (int y = 0; y < passHeight; y++)
+		{
+			unsigned char* row = raw + 1;
+			if (!Unfilter(raw[0], row, previous, rowSize, pixelSize)) { return false; }
+
+			unsigned char* out = rgba + ((std::size_t)(y0 + y * yStep) * png.width + x0) * 4;
+			PngRowToRgba(png, row, passWidth, out, (std::size_t)xStep * 4);
+
+			previous = row;
+			raw += rowSize + 1;
+		}
+
+		return true;
+	}
+
+	bool ReadPngInfo(const unsigned char* data, std::size_t size, image::ImageInfo& info)
+	{
+		// Signature then IHDR, which must be the first chunk
+		if (size < 33 || std::memcmp(data, PNG_SIGNATURE, 8) != 0 || std::memcmp(data + 12, "IHDR", 4) != 0) { return false; }
+
+		std::uint32_t width = ReadBigEndian32(data + 16), height = ReadBigEndian32(data + 20);
+		if (!ValidSize(width, height)) { return false; }
+
+		info.format = image::Format::Png;
+		info.width = (int)width;
+		info.height = (int)height;
+		return true;
+	}
+
+	bool DecodePng(const unsigned char* data, std::size_t size, unsigned char* rgba)
+	{
+		image::ImageInfo info;
+		if (!ReadPngInfo(data, size, info)) { return false; }
+
+		PngImage png = {};
+		png.width = info.width;
+		png.height = info.height;
+		for (int p = 0; p < 256; p++) { png.palette[p][3] = 255; }
+
+		bool hasPalette = false;
+		std::vector<unsigned char> compressed;
+
+		// Chunk CRCs aren't checked, the zlib stream has its own checksum
+		std::size_t at = 8;
+		while (true)
+		{
+			if (size - at < 12) { return false; }
+
+			std::uint32_t length = ReadBigEndian32(data + at);
+			const unsigned char* type = data + at + 4;
+			const unsigned char* chunk = data + at + 8;
+			if (length > size - at - 12) { return false; }
+
+			if (std::memcmp(type, "IHDR", 4) == 0)
+			{
+				if (length != 13) { return false; }
+
+				png.bitDepth = chunk[8];
+				png.colorType = chunk[9];
+				png.channels = PngChannels(png.colorType);
+				png.interlaced = chunk[12] == 1;
+				if (png.channels == 0 || !ValidPngDepth(png.colorType, png.bitDepth) || chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1)
+				{
+					return false;
+				}
+			}
+			else if (std::memcmp(type, "PLTE", 4) == 0)
+			{
+				if (length % 3 != 0 || length > 768) { return false; }
+
+				for (std::uint32_t p = 0; p < length / 3; p++) { std::memcpy(png.palette[p], chunk + p * 3, 3); }
+				hasPalette = true;
+			}
+			else if (std::memcmp(type, "tRNS", 4) == 0)
+			{
+				if (png.colorType == PNG_PALETTE)
+				{
+					for (std::uint32_t p = 0; p < std::min<std::uint32_t>(length, 256); p++) { png.palette[p][3] = chunk[p]; }
+				}
+				else if (png.colorType == PNG_GREY && length >= 2)
+				{
+					png.hasColorKey = true;
+					png.colorKey[0] = ReadBigEndian16(chunk);
+				}
+				else if (png.colorType == PNG_RGB && length >= 6)
+				{
+					png.hasColorKey = true;
+					for (int c = 0; c < 3; c++) { png.colorKey[c] = ReadBigEndian16(chunk + c * 2); }
+				}
+			}
+			else if (std::memcmp(type, "IDAT", 4) == 0) { compressed.insert(compressed.end(), chunk, chunk + length); }
+			else if (std::memcmp(type, "IEND", 4) == 0) { break; }
+			else if (!(type[0] & 0x20)) { return false; }  // Unknown chunk the image can't be decoded without
+
+			at += length + 12;
+		}
+
+		if (png.colorType == PNG_PALETTE && !hasPalette) { return false; }
+
+		std::size_t rawSize = 0;
+		if (png.interlaced)
+		{
+			for (int pass = 0; pass < 7; pass++)
+			{
+				int passWidth = std::max(png.width - ADAM7_X[pass] + ADAM7_X_STEP[pass] - 1, 0) / ADAM7_X_STEP[pass];
+				int passHeight = std::max(png.height - ADAM7_Y[pass] + ADAM7_Y_STEP[pass] - 1, 0) / ADAM7_Y_STEP[pass];
+				rawSize += PngPassSize(png, passWidth, passHeight);
+			}
+		}
+		else { rawSize = PngPassSize(png, png.width, png.height); }
+
+		std::vector<unsigned char> raw;
+		if (!zlib::Inflate(compressed.data(), compressed.size(), raw, rawSize, rawSize) || raw.size() != rawSize) { return false; }
+
+		if (!png.interlaced) { return DecodePngPass(png, raw.data(), png.width, png.height, 0, 0, 1, 1, rgba); }
+
+		unsigned char* pass = raw.data();
+		for (int p = 0; p < 7; p++)
+		{
+			int passWidth = std::max(png.width - ADAM7_X[p] + ADAM7_X_STEP[p] - 1, 0) / ADAM7_X_STEP[p];
+			int passHeight = std::max(png.height - ADAM7_Y[p] + ADAM7_Y_STEP[p] - 1, 0) / ADAM7_Y_STEP[p];
+
+			if (!DecodePngPass(png, pass, passWidth, passHeight, ADAM7_X[p], ADAM7_Y[p], ADAM7_X_STEP[p], ADAM7_Y_STEP[p], rgba))
+			{
+				return false;
+			}
+			pass += PngPassSize(png, passWidth, passHeight);
+		}
+
+		return true;
+	}
+
+	/* QOI */
+
+	constexpr std::size_t QOI_HEADER_SIZE = 14;
+	constexpr std::size_t QOI_END_MARKER_SIZE = 8;
+
+	enum QoiOp
+	{
+		QOI_OP_INDEX = 0x00,
+		QOI_OP_DIFF  = 0x40,
+		QOI_OP_LUMA  = 0x80,
+		QOI_OP_RUN   = 0xC0,
+		QOI_OP_RGB   = 0xFE,
+		QOI_OP_RGBA  = 0xFF
+	};
+
+	bool ReadQoiInfo(const unsigned char* data, std::size_t size, image::ImageInfo& info)
+	{
+		if (size < QOI_HEADER_SIZE + QOI_END_MARKER_SIZE || std::memcmp(data, "qoif", 4) != 0) { return false; }
+
+		std::uint32_t width = ReadBigEndian32(data + 4), height = ReadBigEndian32(data + 8);
+		if (!ValidSize(width, height) || (data[12] != 3 && data[12] != 4)) { return false; }
+
+		info.format = image::Format::Qoi;
+		info.width = (int)width;
+		info.height = (int)height;
+		return true;
+	}
+
+	bool DecodeQoi(const unsigned char* data, std::size_t size, unsigned char* rgba)
+	{
+		image::ImageInfo info;
+		if (!ReadQoiInfo(data, size, info)) { return false; }
+
+		unsigned char seen[64][4] = { 0 };
+		unsigned char pixel[4] = { 0, 0, 0, 255 };
+		int run = 0;
+
+		const unsigned char* at = data + QOI_HEADER_SIZE;
+		const unsigned char* end = data + size - QOI_END_MARKER_SIZE;
+		const std::size_t pixelCount = (std::size_t)info.width * info.height;
+
+		for (std::size_t p = 0; p < pixelCount; p++, rgba += 4)
+		{
+			if (run > 0)
+			{
+				run--;
+				std::memcpy(rgba, pixel, 4);
+				continue;
+			}
+
+			if (at >= end) { return false; }
+			unsigned char op = *at++;
+
+			if (op == QOI_OP_RGB)
+			{
+				if (end - at < 3) { return false; }
+				std::memcpy(pixel, at, 3);
+				at += 3;
+			}
+			else if (op == QOI_OP_RGBA)
+			{
+				if (end - at < 4) { return false; }
+				std::memcpy(pixel, at, 4);
+				at += 4;
+			}
+			else
+			{
+				switch (op & 0xC0)
+				{
+				case QOI_OP_INDEX:
+					std::memcpy(pixel, seen[op], 4);
+					break;
+				case QOI_OP_DIFF:
+					pixel[0] += ((op >> 4) & 3) - 2;
+					pixel[1] += ((op >> 2) & 3) - 2;
+					pixel[2] += (op & 3) - 2;
+					break;
+				case QOI_OP_LUMA:
+				{
+					if (at >= end) { return false; }
+					unsigned char second = *at++;
+					int greenDifference = (op & 0x3F) - 32;
+					pixel[0] += greenDifference - 8 + ((second >> 4) & 0x0F);
+					pixel[1] += greenDifference;
+					pixel[2] += greenDifference - 8 + (second & 0x0F);
+					break;
+				}
+				case QOI_OP_RUN:
+					run = op & 0x3F;
+					break;
+				}
+			}
+
+			std::memcpy(seen[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64], pixel, 4);
+			std::memcpy(rgba, pixel, 4);
+		}
+
+		return true;
+	}
+
+	/* JPEG */
+
+	// Natural order index of each coefficient in zigzag order
+	constexpr std::uint8_t ZIGZAG[64] = {
+		 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 };
+
+	enum JpegMarker
+	{
+		JPEG_SOF0 = 0xC0,   // Baseline
+		JPEG_SOF1 = 0xC1,   // Extended sequential
+		JPEG_SOF2 = 0xC2,   // Progressive
+		JPEG_DHT  = 0xC4,
+		JPEG_JPG  = 0xC8,
+		JPEG_DAC  = 0xCC,
+		JPEG_SOF15 = 0xCF,
+		JPEG_RST0 = 0xD0,
+		JPEG_RST7 = 0xD7,
+		JPEG_SOI  = 0xD8,
+		JPEG_EOI  = 0xD9,
+		JPEG_SOS  = 0xDA,
+		JPEG_DQT  = 0xDB,
+		JPEG_DRI  = 0xDD,
+		JPEG_APP14 = 0xEE
+	};
+
+	bool IsStartOfFrame(int marker)
+	{
+		return marker >= JPEG_SOF0 && marker <= JPEG_SOF15 && marker != JPEG_DHT && marker != JPEG_JPG && marker != JPEG_DAC;
+	}
+
+	// Codes up to this long are decoded with one table lookup
+	constexpr int JPEG_FAST_BITS = 9;
+
+	typedef struct JpegHuffman
+	{
+		std::uint16_t fast[1 << JPEG_FAST_BITS];   // (length << 8) | value, 0 if the code is longer
+		int maxCode[18];                            // Largest code of each length, -1 if none
+		int valueOffset[17];                        // Added to a code of each length to index values
+		std::uint8_t values[256];
+	} JpegHuffman;
+
+	bool BuildJpegHuffman(JpegHuffman& huffman, const unsigned char* counts, const unsigned char* values, int valueCount)
+	{
+		std::memset(huffman.fast, 0, sizeof(huffman.fast));
+		std::memcpy(huffman.values, values, valueCount);
+
+		int code = 0, index = 0;
+		for (int length = 1; length <= 16; length++)
+		{
+			huffman.valueOffset[length] = index - code;
+
+			for (int c = 0; c < counts[length - 1]; c++, code++, index++)
+			{
+				if (length > JPEG_FAST_BITS) { continue; }
+
+				int shift = JPEG_FAST_BITS - length;
+				for (int suffix = 0; suffix < (1 << shift); suffix++)
+				{
+					huffman.fast[(code << shift) | suffix] = (std::uint16_t)((length << 8) | values[index]);
+				}
+			}
+
+			huffman.maxCode[length] = counts[length - 1] ? code - 1 : -1;
+			if (code > (1 << length)) { return false; }
+			code <<= 1;
+		}
+
+		huffman.maxCode[17] = INT32_MAX;
+		return true;
+	}
+
+	// Reads entropy coded data most significant bit first, removing stuffed zero bytes
+	class JpegBitReader
+	{
+	public:
+		JpegBitReader(const unsigned char* begin, const unsigned char* dataEnd) : at(begin), end(dataEnd) {}
+
+		void Fill()
+		{
+			while (bitCount <= 24)
+			{
+				std::uint32_t byte = 0;
+				if (!atMarker && at < end)
+				{
+					byte = *at;
+					if (byte != 0xFF) { at++; }
+					else if (end - at >= 2 && at[1] == 0) { at += 2; }
+					else
+					{
+						// A marker ends the data. Zeros are fed in after it
+						atMarker = true;
+						byte = 0;
+					}
+				}
+
+				bits |= byte << (24 - bitCount);
+				bitCount += 8;
+			}
+		}
+
+		std::uint32_t Peek(int count) const { return bits >> (32 - count); }
+
+		void Consume(int count)
+		{
+			bits <<= count;
+			bitCount -= count;
+		}
+
+		int Decode(const JpegHuffman& huffman)
+		{
+			Fill();
+
+			std::uint16_t entry = huffman.fast[Peek(JPEG_FAST_BITS)];
+			if (entry)
+			{
+				Consume(entry >> 8);
+				return entry & 255;
+			}
+
+			for (int length = JPEG_FAST_BITS + 1; length <= 16; length++)
+			{
+				int code = (int)Peek(length);
+				if (code <= huffman.maxCode[length])
+				{
+					Consume(length);
+					return huffman.values[code + huffman.valueOffset[length]];
+				}
+			}
+
+			return -1;
+		}
+
+		// Read a count bit magnitude and sign extend it to a coefficient
+		int Receive(int count)
+		{
+			if (count == 0) { return 0; }
+
+			Fill();
+			int value = (int)Peek(count);
+			Consume(count);
+
+			return value < (1 << (count - 1)) ? value - (1 << count) + 1 : value;
+		}
+
+		// Skip to the restart marker that should follow an interval
+		void Restart()
+		{
+			bits = 0;
+			bitCount = 0;
+			atMarker = false;
+
+			while (end - at >= 2 && !(at[0] == 0xFF && at[1] >= JPEG_RST0 && at[1] <= JPEG_RST7)) { at++; }
+			if (end - at >= 2) { at += 2; }
+		}
+
+		const unsigned char* Position() const { return at; }
+
+	private:
+		const unsigned char* at;
+		const unsigned char* end;
+		std::uint32_t bits = 0;
+		int bitCount = 0;
+		bool atMarker = false;
+	};
+
+	// libjpeg's accurate integer IDCT. 13 bits of fraction for the constants and 2 extra between passes
+	constexpr int IDCT_CONST_BITS = 13;
+	constexpr int IDCT_PASS1_BITS = 2;
+
+	constexpr int FIX_0_298631336 = 2446;
+	constexpr int FIX_0_390180644 = 3196;
+	constexpr int FIX_0_541196100 = 4433;
+	constexpr int FIX_0_765366865 = 6270;
+	constexpr int FIX_0_899976223 = 7373;
+	constexpr int FIX_1_175875602 = 9633;
+	constexpr int FIX_1_501321110 = 12299;
+	constexpr int FIX_1_847759065 = 15137;
+	constexpr int FIX_1_961570560 = 16069;
+	constexpr int FIX_2_053119869 = 16819;
+	constexpr int FIX_2_562915447 = 20995;
+	constexpr int FIX_3_072711026 = 25172;
+
+	int Descale(int value, int bits)
+	{
+		return (value + (1 << (bits - 1))) >> bits;
+	}
+
+	// One 8 point IDCT over in[0], in[stride], ... The even and odd halves are combined into out
+	template <typename In>
+	void Idct8(const In* in, int stride, int* out, int outStride, int descaleBits)
+	{
+		int z2 = in[2 * stride], z3 = in[6 * stride];
+		int z1 = (z2 + z3) * FIX_0_541196100;
+		int tmp2 = z1 - z3 * FIX_1_847759065;
+		int tmp3 = z1 + z2 * FIX_0_765366865;
+
+		z2 = in[0];
+		z3 = in[4 * stride];
+		int tmp0 = (z2 + z3) * (1 << IDCT_CONST_BITS);
+		int tmp1 = (z2 - z3) * (1 << IDCT_CONST_BITS);
+
+		int tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+		int tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+
+		tmp0 = in[7 * stride];
+		tmp1 = in[5 * stride];
+		tmp2 = in[3 * stride];
+		tmp3 = in[1 * stride];
+
+		z1 = tmp0 + tmp3;
+		z2 = tmp1 + tmp2;
+		z3 = tmp0 + tmp2;
+		int z4 = tmp1 + tmp3;
+		int z5 = (z3 + z4) * FIX_1_175875602;
+
+		tmp0 *= FIX_0_298631336;
+		tmp1 *= FIX_2_053119869;
+		tmp2 *= FIX_3_072711026;
+		tmp3 *= FIX_1_501321110;
+		z1 *= -FIX_0_899976223;
+		z2 *= -FIX_2_562915447;
+		z3 = z3 * -FIX_1_961570560 + z5;
+		z4 = z4 * -FIX_0_390180644 + z5;
+
+		tmp0 += z1 + z3;
+		tmp1 += z2 + z4;
+		tmp2 += z2 + z3;
+		tmp3 += z1 + z4;
+
+		out[0 * outStride] = Descale(tmp10 + tmp3, descaleBits);
+		out[7 * outStride] = Descale(tmp10 - tmp3, descaleBits);
+		out[1 * outStride] = Descale(tmp11 + tmp2, descaleBits);
+		out[6 * outStride] = Descale(tmp11 - tmp2, descaleBits);
+		out[2 * outStride] = Descale(tmp12 + tmp1, descaleBits);
+		out[5 * outStride] = Descale(tmp12 - tmp1, descaleBits);
+		out[3 * outStride] = Descale(tmp13 + tmp0, descaleBits);
+		out[4 * outStride] = Descale(tmp13 - tmp0, descaleBits);
+	}
+
+	// Inverse transform dequantized coefficients in natural order to 8x8 samples
+	void InverseDct(const std::int16_t* coefficients, unsigned char* out, std::size_t outStride)
+	{
+		int workspace[64];
+
+		// Columns. Ones with only a DC term are common and come out flat
+		for (int column = 0; column < 8; column++)
+		{
+			const std::int16_t* in = coefficients + column;
+			if (!(in[8] | in[16] | in[24] | in[32] | in[40] | in[48] | in[56]))
+			{
+				int dc = in[0] * (1 << IDCT_PASS1_BITS);
+				for (int row = 0; row < 8; row++) { workspace[row * 8 + column] = dc; }
+				continue;
+			}
+
+			Idct8(in, 8, workspace + column, 8, IDCT_CONST_BITS - IDCT_PASS1_BITS);
+		}
+
+		// Rows, undoing both passes' scaling and the level shift
+		for (int row = 0; row < 8; row++)
+		{
+			int samples[8];
+			Idct8(workspace + row * 8, 1, samples, 1, IDCT_CONST_BITS + IDCT_PASS1_BITS + 3);
+
+			for (int x = 0; x < 8; x++) { out[row * outStride + x] = ClampToByte(samples[x] + 128); }
+		}
+	}
+
+	class JpegDecoder
+	{
+	public:
+		JpegDecoder(const unsigned char* data, std::size_t size) : begin(data), end(data + size) {}
+
+		// Parse up to the frame header
+		bool ReadInfo(image::ImageInfo& info)
+		{
+			if (!ParseSegments(true)) { return false; }
+
+			info.format = image::Format::Jpeg;
+			info.width = width;
+			info.height = height;
+			return true;
+		}
+
+		bool Decode(unsigned char* rgba)
+		{
+			if (!ParseSegments(false) || !frameRead) { return false; }
+
+			ToRgba(rgba);
+			return true;
+		}
+
+	private:
+		typedef struct Component
+		{
+			int id;
+			int horizontalSampling;
+			int verticalSampling;
+			int quantTable;
+			int dcTable;
+			int acTable;
+			int dcPrediction;
+			std::size_t planeStride;
+			std::vector<unsigned char> plane;  // Whole MCUs of samples, larger than the image
+		} Component;
+
+		// Walk the marker segments, decoding scans as they come unless headerOnly
+		bool ParseSegments(bool headerOnly)
+		{
+			const unsigned char* at = begin;
+			if (end - at < 2 || at[0] != 0xFF || at[1] != JPEG_SOI) { return false; }
+			at += 2;
+
+			while (true)
+			{
+				// Markers can be preceded by any number of 0xFF fill bytes
+				while (at < end && *at != 0xFF) { at++; }
+				while (at < end && *at == 0xFF) { at++; }
+				if (at >= end) { return false; }
+
+				// Stuffed zeros can only be left over from the end of a scan
+				int marker = *at++;
+				if (marker == JPEG_EOI) { return true; }
+				if (marker == 0 || (marker >= JPEG_RST0 && marker <= JPEG_RST7)) { continue; }
+
+				if (end - at < 2) { return false; }
+				std::size_t length = ReadBigEndian16(at);
+				if (length < 2 || (std::size_t)(end - at) < length) { return false; }
+
+				const unsigned char* segment = at + 2;
+				const unsigned char* segmentEnd = at + length;
+				at = segmentEnd;
+
+				if (IsStartOfFrame(marker))
+				{
+					// Only sequential Huffman coding
+					if (marker != JPEG_SOF0 && marker != JPEG_SOF1) { return false; }
+					if (!ReadFrame(segment, segmentEnd)) { return false; }
+					if (headerOnly) { return true; }
+				}
+				else if (marker == JPEG_DQT) { if (!ReadQuantTables(segment, segmentEnd)) { return false; } }
+				else if (marker == JPEG_DHT) { if (!ReadHuffmanTables(segment, segmentEnd)) { return false; } }
+				else if (marker == JPEG_DRI)
+				{
+					if (segmentEnd - segment < 2) { return false; }
+					restartInterval = ReadBigEndian16(segment);
+				}
+				else if (marker == JPEG_APP14)
+				{
+					// Adobe's marker says whether 3 components are YCbCr or stored as RGB
+					if (segmentEnd - segment >= 12 && std::memcmp(segment, "Adobe", 5) == 0) { adobeTransform = segment[11]; }
+				}
+				else if (marker == JPEG_SOS)
+				{
+					if (headerOnly || !frameRead) { return false; }
+
+					const unsigned char* scanEnd;
+					if (!DecodeScan(segment, segmentEnd, scanEnd)) { return false; }
+					at = scanEnd;
+				}
+			}
+		}
+
+		bool ReadFrame(const unsigned char* at, const unsigned char* segmentEnd)
+		{
+			if (frameRead || segmentEnd - at < 6) { return false; }
+
+			int precision = at[0];
+			height = ReadBigEndian16(at + 1);
+			width = ReadBigEndian16(at + 3);
+			int componentCount = at[5];
+			at += 6;
+
+			// A height of 0 would come later in a DNL marker, which isn't supported
+			if (precision != 8 || !ValidSize(width, height) || (componentCount != 1 && componentCount != 3)) { return false; }
+			if (segmentEnd - at < componentCount * 3) { return false; }
+
+			components.resize(componentCount);
+			for (Component& component : components)
+			{
+				component.id = at[0];
+				component.horizontalSampling = at[1] >> 4;
+				component.verticalSampling = at[1] & 15;
+				component.quantTable = at[2];
+				at += 3;
+
+				if (component.horizontalSampling < 1 || component.horizontalSampling > 4 ||
+					component.verticalSampling < 1 || component.verticalSampling > 4 || component.quantTable > 3) { return false; }
+
+				maxHorizontalSampling = std::max(maxHorizontalSampling, component.horizontalSampling);
+				maxVerticalSampling = std::max(maxVerticalSampling, component.verticalSampling);
+			}
+
+			mcusX = (width + maxHorizontalSampling * 8 - 1) / (maxHorizontalSampling * 8);
+			mcusY = (height + maxVerticalSampling * 8 - 1) / (maxVerticalSampling * 8);
+
+			for (Component& component : components)
+			{
+				component.planeStride = (std::size_t)mcusX * component.horizontalSampling * 8;
+				component.plane.resize(component.planeStride * mcusY * component.verticalSampling * 8);
+			}
+
+			frameRead = true;
+			return true;
+		}
+
+		bool ReadQuantTables(const unsigned char* at, const unsigned char* segmentEnd)
+		{
+			while (at < segmentEnd)
+			{
+				int precision = at[0] >> 4, table = at[0] & 15;
+				std::size_t tableSize = precision ? 128 : 64;
+				if (table > 3 || precision > 1 || (std::size_t)(segmentEnd - at - 1) < tableSize) { return false; }
+				at++;
+
+				for (int k = 0; k < 64; k++) { quantTables[table][k] = precision ? ReadBigEndian16(at + k * 2) : at[k]; }
+				at += tableSize;
+			}
+
+			return true;
+		}
+
+		bool ReadHuffmanTables(const unsigned char* at, const unsigned char* segmentEnd)
+		{
+			while (at < segmentEnd)
+			{
+				if (segmentEnd - at < 17) { return false; }
+
+				int tableClass = at[0] >> 4, table = at[0] & 15;
+				const unsigned char* counts = at + 1;
+				int valueCount = 0;
+				for (int length = 0; length < 16; length++) { valueCount += counts[length]; }
+				at += 17;
+
+				if (tableClass > 1 || table > 3 || valueCount > 256 || segmentEnd - at < valueCount) { return false; }
+
+				JpegHuffman& huffman = tableClass == 0 ? dcTables[table] : acTables[table];
+				if (!BuildJpegHuffman(huffman, counts, at, valueCount)) { return false; }
+				at += valueCount;
+			}
+
+			return true;
+		}
+
+		bool DecodeBlock(JpegBitReader& reader, Component& component, int blockX, int blockY)
+		{
+			const std::uint16_t* quant = quantTables[component.quantTable];
+			std::int16_t coefficients[64] = { 0 };
+
+			int magnitude = reader.Decode(dcTables[component.dcTable]);
+			if (magnitude < 0 || magnitude > 11) { return false; }
+
+			component.dcPrediction += reader.Receive(magnitude);
+			coefficients[0] = (std::int16_t)(component.dcPrediction * quant[0]);
+
+			for (int k = 1; k < 64;)
+			{
+				int runSize = reader.Decode(acTables[component.acTable]);
+				if (runSize < 0) { return false; }
+
+				int run = runSize >> 4, size = runSize & 15;
+				if (size == 0)
+				{
+					// 16 zeros, or end of block
+					if (run != 15) { break; }
+					k += 16;
+					continue;
+				}
+
+				k += run;
+				if (k > 63) { return false; }
+				coefficients[ZIGZAG[k]] = (std::int16_t)(reader.Receive(size) * quant[k]);
+				k++;
+			}
+
+			unsigned char* out = component.plane.data() + (std::size_t)blockY * 8 * component.planeStride + blockX * 8;
+			InverseDct(coefficients, out, component.planeStride);
+			return true;
+		}
+
+		bool DecodeScan(const unsigned char* at, const unsigned char* segmentEnd, const unsigned char*& scanEnd)
+		{
+			if (segmentEnd - at < 1) { return false; }
+			int scanComponentCount = at[0];
+			if (scanComponentCount < 1 || scanComponentCount > (int)components.size() || segmentEnd - at < 4 + scanComponentCount * 2) { return false; }
+			at++;
+
+			std::vector<Component*> scanComponents;
+			for (int c = 0; c < scanComponentCount; c++, at += 2)
+			{
+				auto found = std::find_if(components.begin(), components.end(), [id = at[0]](const Component& component) { return component.id == id; });
+				if (found == components.end()) { return false; }
+
+				found->dcTable = at[1] >> 4;
+				found->acTable = at[1] & 15;
+				found->dcPrediction = 0;
+				if (found->dcTable > 3 || found->acTable > 3) { return false; }
+				scanComponents.push_back(&*found);
+			}
+
+			JpegBitReader reader(segmentEnd, end);
+
+			// A scan with one component codes its blocks one at a time over just the
+			// part of the plane covering the image. Otherwise each MCU holds every
+			// component's horizontal x vertical sampling blocks
+			int unitsX = mcusX, unitsY = mcusY;
+			if (scanComponentCount == 1)
+			{
+				const Component& component = *scanComponents[0];
+				int componentWidth = (width * component.horizontalSampling + maxHorizontalSampling - 1) / maxHorizontalSampling;
+				int componentHeight = (height * component.verticalSampling + maxVerticalSampling - 1) / maxVerticalSampling;
+				unitsX = (componentWidth + 7) / 8;
+				unitsY = (componentHeight + 7) / 8;
+			}
+
+			int untilRestart = restartInterval;
+			for (int unitY = 0; unitY < unitsY; unitY++)
+			{
+				for (int unitX = 0; unitX < unitsX; unitX++)
+				{
+					if (restartInterval && untilRestart-- == 0)
+					{
+						reader.Restart();
+						for (Component* component : scanComponents) { component->dcPrediction = 0; }
+						untilRestart = restartInterval - 1;
+					}
+
+					if (scanComponentCount == 1)
+					{
+						if (!DecodeBlock(reader, *scanComponents[0], unitX, unitY)) { return false; }
+						continue;
+					}
+
+					for (Component* component : scanComponents)
+					{
+						for (int y = 0; y < component->verticalSampling; y++)
+						{
+							for (int x = 0; x < component->horizontalSampling; x++)
+							{
+								int blockX = unitX * component->horizontalSampling + x;
+								int blockY = unitY * component->verticalSampling + y;
+								if (!DecodeBlock(reader, *component, blockX, blockY)) { return false; }
+							}
+						}
+					}
+				}
+			}
+
+			scanEnd = reader.Position();
+			return true;
+		}
+
+		// Upsample the planes to full size and convert them to RGBA
+		void ToRgba(unsigned char* rgba) const
+		{
+			if (components.size() == 1)
+			{
+				const Component& grey = components[0];
+				for (int y = 0; y < height; y++)
+				{
+					const unsigned char* row = grey.plane.data() + (std::size_t)y * grey.planeStride;
+					for (int x = 0; x < width; x++, rgba += 4)
+					{
+						rgba[0] = rgba[1] = rgba[2] = row[x];
+						rgba[3] = 255;
+					}
+				}
+				return;
+			}
+
+			// Without Adobe's marker, components named R, G and B also mean RGB
+			bool isRgb = adobeTransform == 0 ||
+				(adobeTransform < 0 && components[0].id == 'R' && components[1].id == 'G' && components[2].id == 'B');
+
+			// Source column of each component for every output column
+			std::vector<int> columns[3];
+			for (int c = 0; c < 3; c++)
+			{
+				columns[c].resize(width);
+				for (int x = 0; x < width; x++) { columns[c][x] = x * components[c].horizontalSampling / maxHorizontalSampling; }
+			}
+
+			for (int y = 0; y < height; y++)
+			{
+				const unsigned char* rows[3];
+				for (int c = 0; c < 3; c++)
+				{
+					int sourceY = y * components[c].verticalSampling / maxVerticalSampling;
+					rows[c] = components[c].plane.data() + (std::size_t)sourceY * components[c].planeStride;
+				}
+
+				for (int x = 0; x < width; x++, rgba += 4)
+				{
+					int first = rows[0][columns[0][x]], second = rows[1][columns[1][x]], third = rows[2][columns[2][x]];
+					if (isRgb)
+					{
+						rgba[0] = (unsigned char)first;
+						rgba[1] = (unsigned char)second;
+						rgba[2] = (unsigned char)third;
+					}
+					else
+					{
+						// JFIF YCbCr to RGB in 16.16 fixed point
+						int blueDifference = second - 128, redDifference = third - 128;
+						int luma = (first << 16) + 32768;
+						rgba[0] = ClampToByte((luma + 91881 * redDifference) >> 16);
+						rgba[1] = ClampToByte((luma - 22554 * blueDifference - 46802 * redDifference) >> 16);
+						rgba[2] = ClampToByte((luma + 116130 * blueDifference) >> 16);
+					}
+					rgba[3] = 255;
+				}
+			}
+		}
+
+		const unsigned char* begin;
+		const unsigned char* end;
+
+		std::uint16_t quantTables[4][64] = {};   // In zigzag order
+		JpegHuffman dcTables[4] = {};
+		JpegHuffman acTables[4] = {};
+		int restartInterval = 0;
+		int adobeTransform = -1;
+
+		bool frameRead = false;
+		int width = 0;
+		int height = 0;
+		int maxHorizontalSampling = 1;
+		int maxVerticalSampling = 1;
+		int mcusX = 0;
+		int mcusY = 0;
+		std::vector<Component> components;
+	};
+}
+
+bool image::ReadInfo(const unsigned char* data, std::size_t size, ImageInfo& info)
+{
+	info = ImageInfo();
+
+	if (size >= 8 && std::memcmp(data, PNG_SIGNATURE, 8) == 0) { return ReadPngInfo(data, size, info); }
+	if (size >= 4 && std::memcmp(data, "qoif", 4) == 0) { return ReadQoiInfo(data, size, info); }
+	if (size >= 2 && data[0] == 0xFF && data[1] == JPEG_SOI) { return JpegDecoder(data, size).ReadInfo(info); }
+
+	return false;
+}
+
+bool image::Decode(const unsigned char* data, std::size_t size, unsigned char* rgba)
+{
+	ImageInfo info;
+	if (!ReadInfo(data, size, info)) { return false; }
+
+	switch (info.format)
+	{
+	case Format::Png:  return DecodePng(data, size, rgba);
+	case Format::Qoi:  return DecodeQoi(data, size, rgba);
+	case Format::Jpeg: return JpegDecoder(data, size).Decode(rgba);
+	default:           return false;
+	}
+}
@@ -0,0 +1,61 @@
+/**
+ * @file Image.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief PNG, JPEG and QOI decoding to 8 bit RGBA
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+
+namespace image {
+
+	enum class Format
+	{
+		Unknown,
+		Png,
+		Jpeg,
+		Qoi
+	};
+
+	typedef struct ImageInfo
+	{
+		Format format = Format::Unknown;
+		int width  = 0;
+		int height = 0;
+	} ImageInfo;
+
+	// Largest width or height accepted, to keep width * height * 4 well inside size_t
+	constexpr int MAX_DIMENSION = 1 << 15;
+
+	/**
+	* @brief        Read an image's format and size from its header
+	*               without decoding it, so the caller can size the
+	*               memory it decodes into
+	*
+	* @return       whether data starts with a supported image header
+	*/
+	bool ReadInfo(const unsigned char* data, std::size_t size, ImageInfo& info);
+
+	/*
+	* PNG: every color type and bit depth, palettes, tRNS transparency and
+	*      Adam7 interlacing. 16 bit channels keep their high byte
+	* JPEG: baseline and extended sequential Huffman coded, greyscale or
+	*       YCbCr with any sampling factors. Progressive and arithmetic
+	*       coded files are rejected
+	* QOI: RGB and RGBA
+	*/
+
+	/**
+	* @brief        Decode an image to RGBA8, top row first
+	*
+	* @param rgba   receives the pixels. Must hold width * height * 4
+	*               bytes as reported by ReadInfo
+	* @return       whether the image decoded. rgba's contents are
+	*               unspecified if it didn't
+	*/
+	bool Decode(const unsigned char* data, std::size_t size, unsigned char* rgba);
+}
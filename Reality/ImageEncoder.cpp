@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "ImageEncoder.h"
+#include "JobSystem.h"
+#include "Zlib.h"
+
+namespace {
+
+	constexpr unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// Rows filtered by one job
+	constexpr std::size_t FILTER_ROWS = 32;
+
+	// The zlib stream is split over IDAT chunks this size so their CRCs can be found in parallel
+	constexpr std::size_t IDAT_SIZE = 1 << 20;
+
+	// QOI ops, from the specification
+	constexpr unsigned char QOI_OP_INDEX = 0x00;
+	constexpr unsigned char QOI_OP_DIFF  = 0x40;
+	constexpr unsigned char QOI_OP_LUMA  = 0x80;
+	constexpr unsigned char QOI_OP_RUN   = 0xC0;
+	constexpr unsigned char QOI_OP_RGB   = 0xFE;
+	constexpr unsigned char QOI_OP_RGBA  = 0xFF;
+	constexpr int QOI_MAX_RUN = 62;
+	constexpr unsigned char QOI_END[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	std::uint32_t Crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0)
+	{
+		static const std::array<std::uint32_t, 256> table = []
+		{
+			std::array<std::uint32_t, 256> entries;
+			for (std::uint32_t n = 0; n < 256; n++)
+			{
+				std::uint32_t c = n;
+				for (int k = 0; k < 8; k++) { c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1; }
+				entries[n] = c;
+			}
+			return entries;
+		}();
+
+		crc = ~crc;
+		for (std::size_t i = 0; i < size; i++) { crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8); }
+		return ~crc;
+	}
+
+	void PutBigEndian(unsigned char* out, std::uint32_t value)
+	{
+		for (int b = 0; b < 4; b++) { out[b] = (unsigned char)(value >> (24 - b * 8)); }
+	}
+
+	// CRC of a chunk's type and then its data
+	std::uint32_t ChunkCrc(const char* type, const unsigned char* data, std::size_t size)
+	{
+		return Crc32(data, size, Crc32((const unsigned char*)type, 4));
+	}
+
+	// crc is the chunk's ChunkCrc, passed in so it can be found beforehand
+	void AppendPngChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data, std::size_t size,
+		std::uint32_t crc)
+	{
+		unsigned char header[8];
+		PutBigEndian(header, (std::uint32_t)size);
+		std::memcpy(header + 4, type, 4);
+		out.insert(out.end(), header, header + 8);
+		if (size > 0) { out.insert(out.end(), data, data + size); }
+
+		unsigned char trailer[4];
+		PutBigEndian(trailer, crc);
+		out.insert(out.end(), trailer, trailer + 4);
+	}
+
+	unsigned char Paeth(int left, int up, int upLeft)
+	{
+		const int estimate = left + up - upLeft;
+		const int toLeft = std::abs(estimate - left), toUp = std::abs(estimate - up), toUpLeft = std::abs(estimate - upLeft);
+		if (toLeft <= toUp && toLeft <= toUpLeft) { return (unsigned char)left; }
+		return (unsigned char)(toUp <= toUpLeft ? up : upLeft);
+	}
+
+	// Filter one row with whichever of the 5 filters leaves the smallest sum of
+	// absolute differences, the usual guess at what compresses best
+	void FilterRow(const unsigned char* row, const unsigned char* above, std::size_t rowSize, unsigned char* out)
+	{
+		constexpr int BYTES_PER_PIXEL = 4;
+
+		std::uint64_t costs[5] = { 0 };
+		for (std::size_t i = 0; i < rowSize; i++)
+		{
+			const int left = i >= BYTES_PER_PIXEL ? row[i - BYTES_PER_PIXEL] : 0;
+			const int up = above ? above[i] : 0;
+			const int upLeft = above && i >= BYTES_PER_PIXEL ? above[i - BYTES_PER_PIXEL] : 0;
+			const unsigned char predictions[5] = { 0, (unsigned char)left, (unsigned char)up, (unsigned char)((left + up) >> 1), Paeth(left, up, upLeft) };
+
+			for (int f = 0; f < 5; f++) { costs[f] += std::abs((int)(signed char)(unsigned char)(row[i] - predictions[f])); }
+		}
+
+		const int filter = (int)(std::min_element(costs, costs + 5) - costs);
+		out[0] = (unsigned char)filter;
+
+		for (std::size_t i = 0; i < rowSize; i++)
+		{
+			const int left = i >= BYTES_PER_PIXEL ? row[i - BYTES_PER_PIXEL] : 0;
+			const int up = above ? above[i] : 0;
+			const int upLeft = above && i >= BYTES_PER_PIXEL ? above[i - BYTES_PER_PIXEL] : 0;
+
+			unsigned char prediction;
+			switch (filter)
+			{
+			case 1:  prediction = (unsigned char)left; break;
+			case 2:  prediction = (unsigned char)up; break;
+			case 3:  prediction = (unsigned char)((left + up) >> 1); break;
+			case 4:  prediction = Paeth(left, up, upLeft); break;
+			default: prediction = 0;
+			}
+			out[1 + i] = (unsigned char)(row[i] - prediction);
+		}
+	}
+}
+
+void image::EncodePng(const unsigned char* rgba, int width, int height, bool bottomUp, std::vector<unsigned char>& out)
+{
+	const std::size_t rowSize = (std::size_t)width * 4;
+	auto row = [&](int y) { return rgba + (std::size_t)(bottomUp ? height - 1 - y : y) * rowSize; };
+
+	std::vector<unsigned char> filtered((rowSize + 1) * height);
+	jobs::ParallelFor(height, FILTER_ROWS, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t y = begin; y < end; y++)
+		{
+			FilterRow(row((int)y), y > 0 ? row((int)y - 1) : nullptr, rowSize, filtered.data() + y * (rowSize + 1));
+		}
+	});
+
+	std::vector<unsigned char> compressed;
+	zlib::Deflate(filtered.data(), filtered.size(), compressed);
+
+	const std::size_t idatCount = std::max<std::size_t>((compressed.size() + IDAT_SIZE - 1) / IDAT_SIZE, 1);
+	std::vector<std::uint32_t> idatCrcs(idatCount);
+	jobs::ParallelFor(idatCount, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t c = begin; c < end; c++)
+		{
+			const std::size_t offset = c * IDAT_SIZE;
+			idatCrcs[c] = ChunkCrc("IDAT", compressed.data() + offset, std::min(IDAT_SIZE, compressed.size() - offset));
+		}
+	});
+
+	out.clear();
+	out.reserve(compressed.size() + 64 + idatCount * 12);
+	out.insert(out.end(), PNG_SIGNATURE, PNG_SIGNATURE + 8);
+
+	// 8 bits per channel, RGBA, deflate, adaptive filtering, not interlaced
+	unsigned char header[13] = { 0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0 };
+	PutBigEndian(header, (std::uint32_t)width);
+	PutBigEndian(header + 4, (std::uint32_t)height);
+	AppendPngChunk(out, "IHDR", header, sizeof(header), ChunkCrc("IHDR", header, sizeof(header)));
+
+	for (std::size_t c = 0; c < idatCount; c++)
+	{
+		const std::size_t offset = c * IDAT_SIZE;
+		AppendPngChunk(out, "IDAT", compressed.data() + offset, std::min(IDAT_SIZE, compressed.size() - offset), idatCrcs[c]);
+	}
+
+	AppendPngChunk(out, "IEND", nullptr, 0, ChunkCrc("IEND", nullptr, 0));
+}
+
+void image::EncodeQoi(const unsigned char* rgba, int width, int height, bool bottomUp, std::vector<unsigned char>& out)
+{
+	const std::size_t rowSize = (std::size_t)width * 4;
+
+	// Every pixel written as QOI_OP_RGBA at worst
+	out.resize(14 + (std::size_t)width * height * 5 + sizeof(QOI_END));
+	unsigned char* at = out.data();
+
+	std::memcpy(at, "qoif", 4);
+	PutBigEndian(at + 4, (std::uint32_t)width);
+	PutBigEndian(at + 8, (std::uint32_t)height);
+	at[12] = 4;   // RGBA
+	at[13] = 0;   // sRGB colour with linear alpha
+	at += 14;
+
+	std::uint32_t seen[64] = { 0 };
+	unsigned char previous[4] = { 0, 0, 0, 255 };
+	int run = 0;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = rgba + (std::size_t)(bottomUp ? height - 1 - y : y) * rowSize;
+		for (int x = 0; x < width; x++)
+		{
+			const unsigned char* pixel = row + (std::size_t)x * 4;
+
+			if (std::memcmp(pixel, previous, 4) == 0)
+			{
+				run++;
+				if (run == QOI_MAX_RUN)
+				{
+					*at++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0)
+			{
+				*at++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+
+			std::uint32_t packed;
+			std::memcpy(&packed, pixel, 4);
+			const int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+
+			if (seen[hash] == packed) { *at++ = (unsigned char)(QOI_OP_INDEX | hash); }
+			else
+			{
+				seen[hash] = packed;
+
+				if (pixel[3] == previous[3])
+				{
+					const int red = (signed char)(pixel[0] - previous[0]);
+					const int green = (signed char)(pixel[1] - previous[1]);
+					const int blue = (signed char)(pixel[2] - previous[2]);
+					const int redFromGreen = red - green, blueFromGreen = blue - green;
+
+					if (red >= -2 && red <= 1 && green >= -2 && green <= 1 && blue >= -2 && blue <= 1)
+					{
+						*at++ = (unsigned char)(QOI_OP_DIFF | ((red + 2) << 4) | ((green + 2) << 2) | (blue + 2));
+					}
+					else if (green >= -32 && green <= 31 && redFromGreen >= -8 && redFromGreen <= 7 && blueFromGreen >= -8 && blueFromGreen <= 7)
+					{
+						*at++ = (unsigned char)(QOI_OP_LUMA | (green + 32));
+						*at++ = (unsigned char)(((redFromGreen + 8) << 4) | (blueFromGreen + 8));
+					}
+					else
+					{
+						*at++ = QOI_OP_RGB;
+						std::memcpy(at, pixel, 3);
+						at += 3;
+					}
+				}
+				else
+				{
+					*at++ = QOI_OP_RGBA;
+					std::memcpy(at, pixel, 4);
+					at += 4;
+				}
+			}
+
+			std::memcpy(previous, pixel, 4);
+		}
+	}
+
+	if (run > 0) { *at++ = (unsigned char)(QOI_OP_RUN | (run - 1)); }
+
+	std::memcpy(at, QOI_END, sizeof(QOI_END));
+	at += sizeof(QOI_END);
+	out.resize(at - out.data());
+}
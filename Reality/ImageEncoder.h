@@ -0,0 +1,34 @@
+/**
+ * @file ImageEncoder.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief PNG and QOI encoding of 8 bit RGBA, for writing captured
+ *        frames to disk
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <vector>
+
+namespace image {
+
+	/*
+	* QOI encodes in one pass at memory speed and is the format to dump
+	* frames in at full framerate. PNG is for when other tools need to
+	* open the frames: rows are filtered and the zlib stream compressed in
+	* parallel on the job system, so one frame still uses every core.
+	*/
+
+	/**
+	* @brief            Encode RGBA8 pixels, width * 4 bytes a row, as a PNG
+	*
+	* @param bottomUp   rows are stored bottom row first, as glReadPixels returns them
+	* @param out        receives the file, replacing its contents
+	*/
+	void EncodePng(const unsigned char* rgba, int width, int height, bool bottomUp, std::vector<unsigned char>& out);
+
+	// Encode RGBA8 pixels as a QOI file, the same way as EncodePng
+	void EncodeQoi(const unsigned char* rgba, int width, int height, bool bottomUp, std::vector<unsigned char>& out);
+}
@@ -0,0 +1,132 @@
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include "Input.h"
+
+std::int64_t input::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+input::InputSystem::InputSystem(GLFWwindow* inputWindow, std::size_t capacity)
+	: window(inputWindow), events(capacity)
+{
+	// Start from where the cursor is, not the origin
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	cursorX.store(x, std::memory_order_relaxed);
+	cursorY.store(y, std::memory_order_relaxed);
+	cursorTime.store(Now(), std::memory_order_relaxed);
+
+	glfwSetWindowUserPointer(window, this);
+	glfwSetKeyCallback(window, OnKey);
+	glfwSetMouseButtonCallback(window, OnMouseButton);
+	glfwSetCursorPosCallback(window, OnCursorMove);
+	glfwSetScrollCallback(window, OnScroll);
+}
+
+input::InputSystem::~InputSystem()
+{
+	glfwSetKeyCallback(window, nullptr);
+	glfwSetMouseButtonCallback(window, nullptr);
+	glfwSetCursorPosCallback(window, nullptr);
+	glfwSetScrollCallback(window, nullptr);
+	glfwSetWindowUserPointer(window, nullptr);
+}
+
+void input::InputSystem::Poll()
+{
+	glfwPollEvents();
+}
+
+void input::InputSystem::Queue(const Event& event)
+{
+	if (!events.TryPush(event)) { dropped.fetch_add(1, std::memory_order_relaxed); }
+}
+
+void input::InputSystem::OnKey(GLFWwindow* window, int key, int /* scancode */, int action, int mods)
+{
+	InputSystem* system = (InputSystem*)glfwGetWindowUserPointer(window);
+	system->Queue(Event{ EventType::Key, key, action, mods, 0.0, 0.0, Now() });
+}
+
+void input::InputSystem::OnMouseButton(GLFWwindow* window, int button, int action, int mods)
+{
+	InputSystem* system = (InputSystem*)glfwGetWindowUserPointer(window);
+
+	// Buttons carry where they were pressed, which the cursor callback may not have reported yet
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	system->Queue(Event{ EventType::MouseButton, button, action, mods, x, y, Now() });
+}
+
+void input::InputSystem::OnCursorMove(GLFWwindow* window, double x, double y)
+{
+	InputSystem* system = (InputSystem*)glfwGetWindowUserPointer(window);
+	const std::int64_t time = Now();
+
+	// Only the main thread writes, so the sequence needs no compare and swap
+	const std::uint32_t sequence = system->cursorSequence.load(std::memory_order_relaxed);
+	system->cursorSequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	system->cursorX.store(x, std::memory_order_relaxed);
+	system->cursorY.store(y, std::memory_order_relaxed);
+	system->cursorTime.store(time, std::memory_order_relaxed);
+	system->cursorSequence.store(sequence + 2, std::memory_order_release);
+
+	system->Queue(Event{ EventType::CursorMove, 0, 0, 0, x, y, time });
+}
+
+void input::InputSystem::OnScroll(GLFWwindow* window, double x, double y)
+{
+	InputSystem* system = (InputSystem*)glfwGetWindowUserPointer(window);
+	system->Queue(Event{ EventType::Scroll, 0, 0, 0, x, y, Now() });
+}
+
+bool input::InputSystem::Next(Event& event)
+{
+	if (!events.TryPop(event)) { return false; }
+
+	consumed.fetch_add(1, std::memory_order_relaxed);
+	queueNanoseconds.fetch_add(Now() - event.time, std::memory_order_relaxed);
+	return true;
+}
+
+input::Cursor input::InputSystem::LatestCursor() const
+{
+	Cursor cursor;
+	while (true)
+	{
+		const std::uint32_t before = cursorSequence.load(std::memory_order_acquire);
+		if (before & 1) { continue; }  // Mid write
+
+		cursor.x = cursorX.load(std::memory_order_relaxed);
+		cursor.y = cursorY.load(std::memory_order_relaxed);
+		cursor.time = cursorTime.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (cursorSequence.load(std::memory_order_relaxed) == before) { return cursor; }
+	}
+}
+
+void input::InputSystem::RecordPresented(const Cursor& cursor)
+{
+	if (cursor.time <= lastPresentedTime) { return; }
+	lastPresentedTime = cursor.time;
+
+	const std::int64_t latency = Now() - cursor.time;
+	latched.fetch_add(1, std::memory_order_relaxed);
+	latchNanoseconds.fetch_add(latency, std::memory_order_relaxed);
+	if (latency > worstLatchNanoseconds.load(std::memory_order_relaxed)) { worstLatchNanoseconds.store(latency, std::memory_order_relaxed); }
+}
+
+input::LatencyStats input::InputSystem::Stats() const
+{
+	LatencyStats stats;
+	stats.events = consumed.load(std::memory_order_relaxed);
+	stats.dropped = dropped.load(std::memory_order_relaxed);
+	stats.queueMs = stats.events > 0 ? queueNanoseconds.load(std::memory_order_relaxed) / 1e6 / stats.events : 0.0;
+	stats.latched = latched.load(std::memory_order_relaxed);
+	stats.latchToSwapMs = stats.latched > 0 ? latchNanoseconds.load(std::memory_order_relaxed) / 1e6 / stats.latched : 0.0;
+	stats.worstLatchToSwapMs = worstLatchNanoseconds.load(std::memory_order_relaxed) / 1e6;
+	return stats;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file Input.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Timestamped window input, queued for the simulation and
+ *        latched as late as possible by the render thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "LockFreeQueue.h"
+
+struct GLFWwindow;
+
+namespace input {
+
+	enum class EventType
+	{
+		Key,
+		MouseButton,
+		CursorMove,
+		Scroll
+	};
+
+	typedef struct Event
+	{
+		EventType type;
+		int code;           // GLFW key or mouse button
+		int action;         // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+		int mods;
+		double x, y;        // Cursor position in screen coordinates, or scroll offsets
+		std::int64_t time;  // Steady clock nanoseconds when GLFW delivered it
+	} Event;
+
+	// Where the cursor was last seen, and when
+	typedef struct Cursor
+	{
+		double x = 0.0, y = 0.0;
+		std::int64_t time = 0;
+	} Cursor;
+
+	typedef struct LatencyStats
+	{
+		std::uint64_t events  = 0;    // Events handed to the simulation
+		std::uint64_t dropped = 0;    // Events lost because the queue was full
+		double queueMs        = 0.0;  // Mean time from delivery to the simulation taking the event
+		std::uint64_t latched = 0;    // Frames drawn with a late latched cursor
+		double latchToSwapMs  = 0.0;  // Mean time from the latched cursor's delivery to its frame's swap
+		double worstLatchToSwapMs = 0.0;
+	} LatencyStats;
+
+	// Steady clock nanoseconds, the clock events are stamped with
+	std::int64_t Now();
+
+	/*
+	* GLFW only delivers input from glfwPollEvents on the main thread, and
+	* only with the time it was delivered, so the earlier and more often it
+	* polls the closer those times are to the real ones. The main thread
+	* polls through Poll, which queues every event with its time on a
+	* lock-free queue for the simulation, and keeps polling while it waits
+	* for the render thread rather than sleeping.
+	*
+	* Cursor moves also update one latest position, readable from any
+	* thread without locking. The render thread reads it right before it
+	* submits the draws that depend on it, a frame after the simulation
+	* saw the input, and so puts the newest position on screen a frame
+	* sooner. That's late latching; RecordPresented then measures how old
+	* the latched position was by the time its frame was swapped.
+	*/
+	class InputSystem
+	{
+	public:
+		/**
+		* @brief            Install input callbacks on window. Main thread only
+		*
+		* @param capacity   events queued before new ones are dropped
+		*/
+		explicit InputSystem(GLFWwindow* window, std::size_t capacity = 1024);
+
+		// Removes the callbacks
+		~InputSystem();
+
+		InputSystem(const InputSystem&) = delete;
+		InputSystem& operator=(const InputSystem&) = delete;
+
+		// Poll GLFW, queueing the events it delivers. Main thread only
+		void Poll();
+
+		// Take the oldest queued event. One consumer at a time
+		bool Next(Event& event);
+
+		// The newest cursor position. Any thread
+		Cursor LatestCursor() const;
+
+		// Record that a frame drawn with cursor, from LatestCursor, was just swapped.
+		// Cursors already recorded are skipped, so a still mouse doesn't count. One thread at a time
+		void RecordPresented(const Cursor& cursor);
+
+		LatencyStats Stats() const;
+
+	private:
+		static void OnKey(GLFWwindow* window, int key, int scancode, int action, int mods);
+		static void OnMouseButton(GLFWwindow* window, int button, int action, int mods);
+		static void OnCursorMove(GLFWwindow* window, double x, double y);
+		static void OnScroll(GLFWwindow* window, double x, double y);
+
+		void Queue(const Event& event);
+
+		GLFWwindow* window;
+		LockFreeQueue<Event> events;
+
+		// Latest cursor behind a sequence lock: odd while the main thread writes it
+		std::atomic<std::uint32_t> cursorSequence = 0;
+		std::atomic<double> cursorX = 0.0;
+		std::atomic<double> cursorY = 0.0;
+		std::atomic<std::int64_t> cursorTime = 0;
+
+		std::atomic<std::uint64_t> dropped = 0;
+		std::atomic<std::uint64_t> consumed = 0;
+		std::atomic<std::int64_t> queueNanoseconds = 0;
+		std::int64_t lastPresentedTime = 0;
+		std::atomic<std::uint64_t> latched = 0;
+		std::atomic<std::int64_t> latchNanoseconds = 0;
+		std::atomic<std::int64_t> worstLatchNanoseconds = 0;
+	};
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+namespace {
+
+	class WorkerPool
+	{
+	public:
+		WorkerPool()
+		{
+			// The thread waiting on a ParallelFor works too, so leave it a core
+			unsigned int workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+			for (unsigned int w = 0; w < workerCount; w++) { workers.emplace_back([this] { Work(); }); }
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				stopping = true;
+			}
+			queueSignal.notify_all();
+
+			for (std::thread& worker : workers) { worker.join(); }
+		}
+
+		void Push(std::function<void()> job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				queue.push_back(std::move(job));
+			}
+			queueSignal.notify_one();
+		}
+
+		unsigned int WorkerCount() const { return (unsigned int)workers.size(); }
+
+	private:
+		void Work()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(queueMutex);
+					queueSignal.wait(lock, [this] { return stopping || !queue.empty(); });
+					if (queue.empty()) { return; }
+
+					job = std::move(queue.front());
+					queue.pop_front();
+				}
+
+				job();
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> queue;
+		std::mutex queueMutex;
+		std::condition_variable queueSignal;
+		bool stopping = false;
+	};
+
+	WorkerPool& Pool()
+	{
+		static WorkerPool pool;
+		return pool;
+	}
+
+	// Shared between a ParallelFor and the helpers it queued. Helpers can
+	// start after the loop has finished, so it is reference counted
+	typedef struct ParallelForState
+	{
+		std::function<void(std::size_t, std::size_t)> body;
+		std::size_t count;
+		std::size_t rangeSize;
+		std::size_t rangeCount;
+		std::atomic<std::size_t> nextRange = 0;
+		std::atomic<std::size_t> rangesDone = 0;
+		std::mutex doneMutex;
+		std::condition_variable doneSignal;
+	} ParallelForState;
+
+	// Claim and run ranges until none are left
+	void RunRanges(ParallelForState& state)
+	{
+		std::size_t range;
+		while ((range = state.nextRange.fetch_add(1, std::memory_order_relaxed)) < state.rangeCount)
+		{
+			std::size_t begin = range * state.rangeSize;
+			state.body(begin, std::min(begin + state.rangeSize, state.count));
+
+			if (state.rangesDone.fetch_add(1, std::memory_order_acq_rel) + 1 == state.rangeCount)
+			{
+				std::lock_guard<std::mutex> lock(state.doneMutex);
+				state.doneSignal.notify_all();
+			}
+		}
+	}
+}
+
+unsigned int jobs::ThreadCount()
+{
+	return Pool().WorkerCount() + 1;
+}
+
+void jobs::Submit(std::function<void()> job)
+{
+	Pool().Push(std::move(job));
+}
+
+void jobs::ParallelFor(std::size_t count, std::size_t grainSize,
+	const std::function<void(std::size_t begin, std::size_t end)>& body)
+{
+	if (count == 0) { return; }
+
+	// A few ranges per thread lets fast threads pick up the slack of slow ones
+	const std::size_t threads = ThreadCount();
+	std::size_t rangeSize = std::max<std::size_t>(grainSize, (count + threads * 4 - 1) / (threads * 4));
+	std::size_t rangeCount = (count + rangeSize - 1) / rangeSize;
+
+	if (rangeCount == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+	state->body = body;
+	state->count = count;
+	state->rangeSize = rangeSize;
+	state->rangeCount = rangeCount;
+
+	std::size_t helpers = std::min<std::size_t>(rangeCount - 1, Pool().WorkerCount());
+	for (std::size_t h = 0; h < helpers; h++) { Submit([state] { RunRanges(*state); }); }
+
+	RunRanges(*state);
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->doneSignal.wait(lock, [&state] { return state->rangesDone.load(std::memory_order_acquire) == state->rangeCount; });
+}
@@ -0,0 +1,39 @@
+/**
+ * @file JobSystem.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Shared pool of worker threads for splitting loading and
+ *        processing work across every core
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <functional>
+
+namespace jobs {
+
+	// Number of threads that run jobs, counting the thread that waits on them
+	unsigned int ThreadCount();
+
+	/**
+	* @brief        Queue job to run on a worker thread and return immediately
+	*
+	* @param job    work to run. Must not throw
+	*/
+	void Submit(std::function<void()> job);
+
+	/**
+	* @brief            Call body over [0, count) split into ranges of at least
+	*                   grainSize elements, spread across the workers and the
+	*                   calling thread. Returns once every range has run
+	*
+	* @param count      number of elements
+	* @param grainSize  smallest range handed to one call of body
+	* @param body       called as body(begin, end) for each range. Must not throw
+	*/
+	void ParallelFor(std::size_t count, std::size_t grainSize,
+		const std::function<void(std::size_t begin, std::size_t end)>& body);
+}
@@ -0,0 +1,228 @@
+#include <charconv>
+#include "Json.h"
+
+namespace json {
+
+	class Parser
+	{
+	public:
+		explicit Parser(std::string_view document) : at(document.data()), end(document.data() + document.size()) {}
+
+		bool ParseDocument(Value& root)
+		{
+			if (!ParseValue(root, 0)) { return false; }
+
+			SkipWhitespace();
+			return at == end;
+		}
+
+	private:
+		// Deeper documents are rejected instead of overflowing the stack
+		static constexpr int MAX_DEPTH = 128;
+
+		void SkipWhitespace()
+		{
+			while (at < end && (*at == ' ' || *at == '\t' || *at == '\n' || *at == '\r')) { at++; }
+		}
+
+		bool Consume(std::string_view literal)
+		{
+			if ((std::size_t)(end - at) < literal.size() || std::string_view(at, literal.size()) != literal) { return false; }
+
+			at += literal.size();
+			return true;
+		}
+
+		bool ParseValue(Value& value, int depth)
+		{
+			if (depth > MAX_DEPTH) { return false; }
+
+			SkipWhitespace();
+			if (at == end) { return false; }
+
+			switch (*at)
+			{
+			case '{': return ParseObject(value, depth);
+			case '[': return ParseArray(value, depth);
+			case '"':
+				value.type = Type::String;
+				return ParseString(value.text);
+			case 't':
+				value.type = Type::Boolean;
+				value.boolean = true;
+				return Consume("true");
+			case 'f':
+				value.type = Type::Boolean;
+				value.boolean = false;
+				return Consume("false");
+			case 'n':
+				value.type = Type::Null;
+				return Consume("null");
+			default:
+			{
+				value.type = Type::Number;
+				std::from_chars_result result = std::from_chars(at, end, value.number);
+				if (result.ec != std::errc()) { return false; }
+
+				at = result.ptr;
+				return true;
+			}
+			}
+		}
+
+		bool ParseObject(Value& value, int depth)
+		{
+			value.type = Type::Object;
+			at++;  // {
+
+			SkipWhitespace();
+			if (at < end && *at == '}') { at++; return true; }
+
+			while (true)
+			{
+				SkipWhitespace();
+				std::pair<std::string, Value> member;
+				if (at == end || *at != '"' || !ParseString(member.first)) { return false; }
+
+				SkipWhitespace();
+				if (!Consume(":") || !ParseValue(member.second, depth + 1)) { return false; }
+				value.members.push_back(std::move(member));
+
+				SkipWhitespace();
+				if (Consume("}")) { return true; }
+				if (!Consume(",")) { return false; }
+			}
+		}
+
+		bool ParseArray(Value& value, int depth)
+		{
+			value.type = Type::Array;
+			at++;  // [
+
+			SkipWhitespace();
+			if (at < end && *at == ']') { at++; return true; }
+
+			while (true)
+			{
+				value.elements.emplace_back();
+				if (!ParseValue(value.elements.back(), depth + 1)) { return false; }
+
+				SkipWhitespace();
+				if (Consume("]")) { return true; }
+				if (!Consume(",")) { return false; }
+			}
+		}
+
+		bool ParseHex4(unsigned int& codePoint)
+		{
+			if (end - at < 4) { return false; }
+
+			std::from_chars_result result = std::from_chars(at, at + 4, codePoint, 16);
+			if (result.ec != std::errc() || result.ptr != at + 4) { return false; }
+
+			at += 4;
+			return true;
+		}
+
+		void AppendUtf8(std::string& text, unsigned int codePoint)
+		{
+			if (codePoint < 0x80) { text += (char)codePoint; }
+			else if (codePoint < 0x800)
+			{
+				text += (char)(0xC0 | (codePoint >> 6));
+				text += (char)(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				text += (char)(0xE0 | (codePoint >> 12));
+				text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+				text += (char)(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				text += (char)(0xF0 | (codePoint >> 18));
+				text += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+				text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+				text += (char)(0x80 | (codePoint & 0x3F));
+			}
+		}
+
+		bool ParseString(std::string& text)
+		{
+			at++;  // "
+
+			while (at < end)
+			{
+				char c = *at++;
+				if (c == '"') { return true; }
+				if (c != '\\') { text += c; continue; }
+				if (at == end) { return false; }
+
+				switch (*at++)
+				{
+				case '"':  text += '"';  break;
+				case '\\': text += '\\'; break;
+				case '/':  text += '/';  break;
+				case 'b':  text += '\b'; break;
+				case 'f':  text += '\f'; break;
+				case 'n':  text += '\n'; break;
+				case 'r':  text += '\r'; break;
+				case 't':  text += '\t'; break;
+				case 'u':
+				{
+					unsigned int codePoint;
+					if (!ParseHex4(codePoint)) { return false; }
+
+					// Code points above the BMP are written as a surrogate pair
+					if (codePoint >= 0xD800 && codePoint < 0xDC00)
+					{
+						unsigned int low;
+						if (!Consume("\\u") || !ParseHex4(low) || low < 0xDC00 || low >= 0xE000) { return false; }
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					AppendUtf8(text, codePoint);
+					break;
+				}
+				default: return false;
+				}
+			}
+
+			return false;
+		}
+
+		const char* at;
+		const char* end;
+	};
+}
+
+namespace {
+
+	const json::Value NULL_VALUE;
+}
+
+const json::Value& json::Value::operator[](std::string_view key) const
+{
+	for (const auto& member : members)
+	{
+		if (member.first == key) { return member.second; }
+	}
+
+	return NULL_VALUE;
+}
+
+const json::Value& json::Value::operator[](std::size_t index) const
+{
+	return index < elements.size() ? elements[index] : NULL_VALUE;
+}
+
+std::size_t json::Value::Size() const
+{
+	return type == Type::Array ? elements.size() : members.size();
+}
+
+bool json::Parse(std::string_view document, Value& root)
+{
+	root = Value();
+	return Parser(document).ParseDocument(root);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file Json.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Small read-only JSON document model, enough to read
+ *        asset manifests such as glTF's
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace json {
+
+	enum class Type { Null, Boolean, Number, String, Array, Object };
+
+	class Value
+	{
+	public:
+		Type GetType() const { return type; }
+		bool IsNull() const { return type == Type::Null; }
+
+		// Member key of an object, or a null value if missing
+		const Value& operator[](std::string_view key) const;
+
+		// Element index of an array, or a null value if out of range
+		const Value& operator[](std::size_t index) const;
+
+		// Number of elements or members, 0 for other types
+		std::size_t Size() const;
+
+		bool Has(std::string_view key) const { return !(*this)[key].IsNull(); }
+
+		// Value converted to the requested type, or fallback if it is another type
+		double AsNumber(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+		std::size_t AsIndex(std::size_t fallback = 0) const
+		{
+			// Negative, NaN and out of range numbers can't be cast to an index
+			bool representable = number >= 0 && number < (double)std::numeric_limits<std::size_t>::max();
+			return type == Type::Number && representable ? (std::size_t)number : fallback;
+		}
+		bool AsBoolean(bool fallback = false) const { return type == Type::Boolean ? boolean : fallback; }
+		const std::string& AsString() const { return text; }
+
+		const std::vector<std::pair<std::string, Value>>& Members() const { return members; }
+
+	private:
+		friend class Parser;
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string text;
+		std::vector<Value> elements;
+		std::vector<std::pair<std::string, Value>> members;
+	};
+
+	/**
+	* @brief            Parse a complete JSON document
+	*
+	* @param document   UTF-8 text
+	* @param root       receives the parsed document
+	* @return           whether document is valid JSON
+	*/
+	bool Parse(std::string_view document, Value& root);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file LockFreeQueue.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Bounded multi-producer multi-consumer queue that never
+ *        takes a lock, for handing work between threads
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/*
+* Ring of slots that each carry a sequence number (Vyukov's bounded MPMC
+* queue). A producer claims a position with one compare-and-swap on the
+* enqueue counter and then owns that slot until it publishes the element by
+* bumping the slot's sequence, and consumers do the same on the dequeue side.
+* Producers and consumers only contend with their own side, and the
+* counters live on separate cache lines so the two sides don't false share.
+*/
+template <typename T>
+class LockFreeQueue
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit LockFreeQueue(std::size_t capacity)
+	{
+		std::size_t size = 2;
+		while (size < capacity) { size <<= 1; }
+
+		mask = size - 1;
+		slots = std::make_unique<Slot[]>(size);
+		for (std::size_t s = 0; s < size; s++) { slots[s].sequence.store(s, std::memory_order_relaxed); }
+	}
+
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	// Returns false without blocking if the queue is full
+	bool TryPush(T value)
+	{
+		std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		Slot* slot;
+
+		while (true)
+		{
+			slot = &slots[position & mask];
+			std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+			}
+			else if (difference < 0) { return false; }
+			else { position = enqueuePosition.load(std::memory_order_relaxed); }
+		}
+
+		slot->value = std::move(value);
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false without blocking if the queue is empty
+	bool TryPop(T& value)
+	{
+		std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		Slot* slot;
+
+		while (true)
+		{
+			slot = &slots[position & mask];
+			std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+
+			if (difference == 0)
+			{
+				if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+			}
+			else if (difference < 0) { return false; }
+			else { position = dequeuePosition.load(std::memory_order_relaxed); }
+		}
+
+		value = std::move(slot->value);
+		slot->sequence.store(position + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t Capacity() const { return mask + 1; }
+
+	// Only a snapshot while other threads push or pop
+	std::size_t SizeApprox() const
+	{
+		return enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+	typedef struct Slot
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	} Slot;
+
+	std::unique_ptr<Slot[]> slots;
+	std::size_t mask;
+
+	alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueuePosition = 0;
+	alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeuePosition = 0;
+};
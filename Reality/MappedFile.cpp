@@ -0,0 +1,127 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this == &other) { return *this; }
+
+	Close();
+	std::swap(data, other.data);
+	std::swap(size, other.size);
+#ifdef _WIN32
+	std::swap(fileHandle, other.fileHandle);
+	std::swap(mappingHandle, other.mappingHandle);
+#endif
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	// FILE_FLAG_SEQUENTIAL_SCAN lets the cache manager read ahead aggressively
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle    = file;
+	mappingHandle = mapping;
+	data = (const unsigned char*)view;
+	size = (std::size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) { UnmapViewOfFile(data); }
+	if (mappingHandle) { CloseHandle(mappingHandle); }
+	if (fileHandle) { CloseHandle(fileHandle); }
+
+	data = nullptr;
+	size = 0;
+	fileHandle = mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	int file = open(path, O_RDONLY);
+	if (file < 0) { return false; }
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);  // The mapping keeps its own reference to the file
+	if (view == MAP_FAILED) { return false; }
+
+	// Loaders walk the file front to back
+	madvise(view, (std::size_t)status.st_size, MADV_SEQUENTIAL);
+	madvise(view, (std::size_t)status.st_size, MADV_WILLNEED);
+
+	data = (const unsigned char*)view;
+	size = (std::size_t)status.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) { munmap((void*)data, size); }
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
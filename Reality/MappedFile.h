@@ -0,0 +1,47 @@
+/**
+ * @file MappedFile.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Read-only memory mapping of a whole file so loaders
+ *        can read assets without copying them into buffers first
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/**
+	* @brief        Map the file at path, replacing any current mapping
+	*
+	* @param path   file to map
+	* @return       whether the file could be opened and mapped
+	*/
+	bool Open(const char* path);
+	void Close();
+
+	const unsigned char* Data() const { return data; }
+	std::size_t Size() const { return size; }
+	bool IsOpen() const { return data != nullptr; }
+
+private:
+	const unsigned char* data = nullptr;
+	std::size_t size = 0;
+
+#ifdef _WIN32
+	void* fileHandle    = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,214 @@
+#include <GL/glew.h>
+#include <cstring>
+#include <utility>
+#include "GlTrace.h"
+#include "GpuAnnotations.h"
+#include "Mesh.h"
+
+mesh::IndexStream::IndexStream(std::size_t vertexCount)
+{
+	stride = vertexCount > MAX_SHORT_INDEXED_VERTICES ? sizeof(unsigned int) : sizeof(unsigned short);
+}
+
+void mesh::IndexStream::Push(unsigned int index)
+{
+	// Widen the stream the first time an index doesn't fit in 16 bits
+	if (stride == sizeof(unsigned short) && index >= MAX_SHORT_INDEXED_VERTICES) { Repack(sizeof(unsigned int)); }
+
+	std::size_t end = bytes.size();
+	bytes.resize(end + stride);
+	Set(end / stride, index);
+}
+
+void mesh::IndexStream::Set(std::size_t position, unsigned int index)
+{
+	if (stride == sizeof(unsigned short))
+	{
+		unsigned short shortIndex = (unsigned short)index;
+		std::memcpy(&bytes[position * stride], &shortIndex, sizeof(shortIndex));
+	}
+	else { std::memcpy(&bytes[position * stride], &index, sizeof(index)); }
+}
+
+unsigned int mesh::IndexStream::operator[](std::size_t position) const
+{
+	if (stride == sizeof(unsigned short))
+	{
+		unsigned short shortIndex;
+		std::memcpy(&shortIndex, &bytes[position * stride], sizeof(shortIndex));
+		return shortIndex;
+	}
+
+	unsigned int index;
+	std::memcpy(&index, &bytes[position * stride], sizeof(index));
+	return index;
+}
+
+void mesh::IndexStream::FitTo(std::size_t vertexCount)
+{
+	Repack(vertexCount > MAX_SHORT_INDEXED_VERTICES ? sizeof(unsigned int) : sizeof(unsigned short));
+}
+
+void mesh::IndexStream::Reserve(std::size_t count)
+{
+	bytes.reserve(count * stride);
+}
+
+void mesh::IndexStream::Resize(std::size_t count)
+{
+	bytes.resize(count * stride);
+}
+
+void mesh::IndexStream::Clear()
+{
+	bytes.clear();
+}
+
+unsigned int mesh::IndexStream::GLType() const
+{
+	return stride == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void mesh::IndexStream::Repack(std::size_t newStride)
+{
+	if (newStride == stride) { return; }
+
+	IndexStream repacked;
+	repacked.stride = newStride;
+	repacked.bytes.resize(Count() * newStride);
+
+	for (std::size_t i = 0; i < Count(); i++) { repacked.Set(i, (*this)[i]); }
+
+	*this = std::move(repacked);
+}
+
+unsigned int mesh::IndexedMesh::AddVertex(const PositionVertex2D& vertex)
+{
+	vertices.push_back(vertex);
+	return (unsigned int)(vertices.size() - 1);
+}
+
+void mesh::IndexedMesh::AddTriangle(const Triangle2D& triangle)
+{
+	indices.Push(triangle.vertA);
+	indices.Push(triangle.vertB);
+	indices.Push(triangle.vertC);
+}
+
+Triangle2D mesh::IndexedMesh::GetTriangle(std::size_t triangle) const
+{
+	return Triangle2D(indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2]);
+}
+
+mesh::Adjacency::Adjacency(const IndexedMesh& mesh)
+{
+	const std::size_t triangleCount = mesh.TriangleCount();
+
+	// Count how many triangles use each vertex, then prefix sum
+	// the counts into the start of each vertex's triangle list
+	vertexTriangleOffsets.assign(mesh.vertices.size() + 1, 0);
+	for (std::size_t i = 0; i < mesh.indices.Count(); i++) { vertexTriangleOffsets[mesh.indices[i] + 1]++; }
+	for (std::size_t v = 1; v < vertexTriangleOffsets.size(); v++) { vertexTriangleOffsets[v] += vertexTriangleOffsets[v - 1]; }
+
+	// Scatter triangles into their vertices' lists
+	std::vector<unsigned int> cursor(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+	vertexTriangles.resize(mesh.indices.Count());
+	for (std::size_t i = 0; i < mesh.indices.Count(); i++) { vertexTriangles[cursor[mesh.indices[i]]++] = (unsigned int)(i / 3); }
+
+	// An edge's neighbour is the other triangle around its first vertex that also uses its second vertex.
+	// Both ends of an edge with no neighbour are on the boundary
+	edgeNeighbours.assign(triangleCount * 3, NO_NEIGHBOUR);
+	boundaryVertices.assign(mesh.vertices.size(), false);
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		for (unsigned int edge = 0; edge < 3; edge++)
+		{
+			unsigned int from = mesh.indices[t * 3 + edge];
+			unsigned int to   = mesh.indices[t * 3 + (edge + 1) % 3];
+
+			for (unsigned int other : TrianglesAroundVertex(from))
+			{
+				if (other == t) { continue; }
+
+				Triangle2D candidate = mesh.GetTriangle(other);
+				if (candidate.vertA == to || candidate.vertB == to || candidate.vertC == to)
+				{
+					edgeNeighbours[t * 3 + edge] = other;
+					break;
+				}
+			}
+
+			if (edgeNeighbours[t * 3 + edge] == NO_NEIGHBOUR)
+			{
+				boundaryVertices[from] = true;
+				boundaryVertices[to]   = true;
+			}
+		}
+	}
+}
+
+std::span<const unsigned int> mesh::Adjacency::TrianglesAroundVertex(unsigned int vertex) const
+{
+	return std::span<const unsigned int>(vertexTriangles.data() + vertexTriangleOffsets[vertex],
+		vertexTriangleOffsets[vertex + 1] - vertexTriangleOffsets[vertex]);
+}
+
+unsigned int mesh::Adjacency::NeighbourAcrossEdge(unsigned int triangle, unsigned int edge) const
+{
+	return edgeNeighbours[triangle * 3 + edge];
+}
+
+bool mesh::Adjacency::IsBoundaryVertex(unsigned int vertex) const
+{
+	return boundaryVertices[vertex];
+}
+
+mesh::GpuMesh mesh::Upload(const IndexedMesh& mesh)
+{
+	return Upload(mesh.vertices, mesh.indices.Data(), mesh.indices.Count(), mesh.indices.Stride());
+}
+
+mesh::GpuMesh mesh::Upload(std::span<const PositionVertex2D> vertices, const void* indices,
+	std::size_t indexCount, std::size_t indexStride)
+{
+	GpuMesh gpuMesh;
+	gpuMesh.indexCount = (unsigned int)indexCount;
+	gpuMesh.indexType  = indexStride == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	// Both streams are already in the layout the GPU
+	// expects so each one is a single copy
+	glGenBuffers(1, &gpuMesh.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, gpuMesh.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size_bytes(), vertices.data(), GL_STATIC_DRAW);
+	annotate::Label(GL_BUFFER, gpuMesh.vertexBuffer, "Mesh vertices");
+
+	glGenBuffers(1, &gpuMesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuMesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexStride, indices, GL_STATIC_DRAW);
+	annotate::Label(GL_BUFFER, gpuMesh.indexBuffer, "Mesh indices");
+
+	Bind(gpuMesh);
+
+	return gpuMesh;
+}
+
+void mesh::Bind(const GpuMesh& gpuMesh)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, gpuMesh.vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuMesh.indexBuffer);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PositionVertex2D), 0);
+}
+
+void mesh::Draw(const GpuMesh& gpuMesh)
+{
+	gltrace::DrawElements(GL_TRIANGLES, gpuMesh.indexCount, gpuMesh.indexType, nullptr);
+}
+
+void mesh::Release(GpuMesh& gpuMesh)
+{
+	glDeleteBuffers(1, &gpuMesh.vertexBuffer);
+	glDeleteBuffers(1, &gpuMesh.indexBuffer);
+	gpuMesh = GpuMesh();
+}
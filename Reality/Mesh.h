@@ -0,0 +1,159 @@
+/**
+ * @file Mesh.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Defines an indexed mesh whose vertex and index streams
+ *        live in flat arrays that can be uploaded to the GPU as-is
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// struct representing a vertex that
+// carries an x and y coordinate
+typedef struct PositionVertex2D
+{
+	float posX;
+	float posY;
+} PositionVertex2D;
+
+// struct representing a triangle as three
+// indices into a mesh's vertex stream
+typedef struct Triangle2D
+{
+	unsigned int vertA;
+	unsigned int vertB;
+	unsigned int vertC;
+} Triangle2D;
+
+namespace mesh {
+
+	// Meshes with at most this many vertices use 16-bit indices.
+	// 0xFFFF itself is left free so it can serve as a primitive restart index
+	constexpr std::size_t MAX_SHORT_INDEXED_VERTICES = 0xFFFF;
+
+	// Returned by adjacency queries when an edge has no neighbour
+	constexpr unsigned int NO_NEIGHBOUR = 0xFFFFFFFF;
+
+	/**
+	* @brief    Tightly packed stream of 16 or 32-bit indices.
+	*           The width is picked from the number of vertices
+	*           being indexed so small meshes use half the memory
+	*/
+	class IndexStream
+	{
+	public:
+		IndexStream() = default;
+		explicit IndexStream(std::size_t vertexCount);
+
+		void Push(unsigned int index);
+		void Set(std::size_t position, unsigned int index);
+		unsigned int operator[](std::size_t position) const;
+
+		// Re-pack the stream with the smallest width able to address vertexCount vertices
+		void FitTo(std::size_t vertexCount);
+
+		void Reserve(std::size_t count);
+		void Resize(std::size_t count);
+		void Clear();
+
+		std::size_t Count() const { return bytes.size() / stride; }
+		std::size_t Stride() const { return stride; }
+		std::size_t SizeInBytes() const { return bytes.size(); }
+		const void* Data() const { return bytes.data(); }
+
+		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		unsigned int GLType() const;
+
+	private:
+		void Repack(std::size_t newStride);
+
+		std::vector<unsigned char> bytes;
+		std::size_t stride = sizeof(unsigned short);
+	};
+
+	// Vertex stream plus an index stream of triangles into it
+	typedef struct IndexedMesh
+	{
+		std::vector<PositionVertex2D> vertices;
+		IndexStream indices;
+
+		unsigned int AddVertex(const PositionVertex2D& vertex);
+		void AddTriangle(const Triangle2D& triangle);
+
+		std::size_t TriangleCount() const { return indices.Count() / 3; }
+		Triangle2D GetTriangle(std::size_t triangle) const;
+
+	} IndexedMesh;
+
+	/**
+	* @brief    Connectivity of an indexed mesh. Built once from the
+	*           mesh and stored in flat arrays (CSR layout) so queries
+	*           do not chase pointers
+	*/
+	class Adjacency
+	{
+	public:
+		explicit Adjacency(const IndexedMesh& mesh);
+
+		// Triangles that use vertex
+		std::span<const unsigned int> TrianglesAroundVertex(unsigned int vertex) const;
+
+		// Triangle sharing edge (0: A->B, 1: B->C, 2: C->A) with triangle,
+		// NO_NEIGHBOUR if the edge is on the boundary
+		unsigned int NeighbourAcrossEdge(unsigned int triangle, unsigned int edge) const;
+
+		bool IsBoundaryVertex(unsigned int vertex) const;
+
+	private:
+		std::vector<unsigned int> vertexTriangleOffsets;  // vertexCount + 1 entries
+		std::vector<unsigned int> vertexTriangles;
+		std::vector<unsigned int> edgeNeighbours;  // 3 per triangle
+		std::vector<bool> boundaryVertices;        // Whether an edge with no neighbour uses the vertex
+	};
+
+	// Handles to a mesh that lives on the GPU
+	typedef struct GpuMesh
+	{
+		unsigned int vertexBuffer = 0;
+		unsigned int indexBuffer  = 0;
+		unsigned int indexCount   = 0;
+		unsigned int indexType    = 0;
+	} GpuMesh;
+
+	/**
+	* @brief        Upload both streams of mesh with one copy each
+	*               and describe the vertex layout at attribute 0
+	*
+	* @param mesh   mesh to upload
+	* @return       handles to the uploaded buffers
+	*/
+	GpuMesh Upload(const IndexedMesh& mesh);
+
+	/**
+	* @brief                Upload vertex and index streams that live outside
+	*                       an IndexedMesh, e.g. in a memory mapped file
+	*
+	* @param vertices       vertex stream
+	* @param indices        packed index stream
+	* @param indexCount     number of indices in indices
+	* @param indexStride    2 or 4 byte indices
+	* @return               handles to the uploaded buffers
+	*/
+	GpuMesh Upload(std::span<const PositionVertex2D> vertices, const void* indices,
+		std::size_t indexCount, std::size_t indexStride);
+
+	// Bind gpuMesh's buffers and vertex layout
+	void Bind(const GpuMesh& gpuMesh);
+
+	// Draw every triangle of the currently bound gpuMesh
+	void Draw(const GpuMesh& gpuMesh);
+
+	// Delete gpuMesh's buffers
+	void Release(GpuMesh& gpuMesh);
+}
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "MeshFile.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+
+namespace {
+
+	std::uint64_t AlignUp(std::uint64_t offset)
+	{
+		return (offset + mesh::MESH_FILE_ALIGNMENT - 1) & ~(std::uint64_t)(mesh::MESH_FILE_ALIGNMENT - 1);
+	}
+
+	// Write zeros until stream is at offset
+	void PadTo(std::ofstream& stream, std::uint64_t offset)
+	{
+		static const char zeros[mesh::MESH_FILE_ALIGNMENT] = {};
+		std::uint64_t position = (std::uint64_t)stream.tellp();
+		stream.write(zeros, (std::streamsize)(offset - position));
+	}
+
+	// Whether every index names one of vertexCount vertices, so a corrupt
+	// file can't make the GPU read past the vertex buffer
+	template <typename IndexType>
+	bool IndicesInRange(const IndexType* indices, std::uint64_t indexCount, std::uint64_t vertexCount)
+	{
+		IndexType largest = 0;
+		for (std::uint64_t i = 0; i < indexCount; i++) { largest = std::max(largest, indices[i]); }
+		return indexCount == 0 || largest < vertexCount;
+	}
+}
+
+bool mesh::WriteMeshFile(const IndexedMesh& mesh, const char* path)
+{
+	std::ofstream meshStream(path, std::ios::binary | std::ios::trunc);
+	if (!meshStream) { return false; }
+
+	MeshFileHeader header = {};
+	std::memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+	header.version      = MESH_FILE_VERSION;
+	header.vertexFormat = VERTEX_FORMAT_POSITION_2D;
+	header.vertexStride = sizeof(PositionVertex2D);
+	header.indexStride  = (std::uint32_t)mesh.indices.Stride();
+	header.vertexCount  = mesh.vertices.size();
+	header.vertexOffset = AlignUp(sizeof(MeshFileHeader));
+	header.indexCount   = mesh.indices.Count();
+	header.indexOffset  = AlignUp(header.vertexOffset + header.vertexCount * header.vertexStride);
+
+	meshStream.write((const char*)&header, sizeof(header));
+
+	PadTo(meshStream, header.vertexOffset);
+	meshStream.write((const char*)mesh.vertices.data(), (std::streamsize)(header.vertexCount * header.vertexStride));
+
+	PadTo(meshStream, header.indexOffset);
+	meshStream.write((const char*)mesh.indices.Data(), (std::streamsize)mesh.indices.SizeInBytes());
+
+	return (bool)meshStream;
+}
+
+bool mesh::MappedMesh::Open(const char* path)
+{
+	header = nullptr;
+	if (!file.Open(path)) { return false; }
+
+	if (file.Size() < sizeof(MeshFileHeader))
+	{
+		std::cerr << path << " is too small to be a mesh file" << std::endl;
+		return false;
+	}
+
+	const MeshFileHeader* candidate = (const MeshFileHeader*)file.Data();
+	if (std::memcmp(candidate->magic, MESH_FILE_MAGIC, sizeof(candidate->magic)) != 0 ||
+		candidate->version != MESH_FILE_VERSION)
+	{
+		std::cerr << path << " is not a version " << MESH_FILE_VERSION << " mesh file" << std::endl;
+		return false;
+	}
+
+	if (candidate->vertexFormat != VERTEX_FORMAT_POSITION_2D || candidate->vertexStride != sizeof(PositionVertex2D) ||
+		(candidate->indexStride != sizeof(unsigned short) && candidate->indexStride != sizeof(unsigned int)))
+	{
+		std::cerr << path << " uses a vertex or index layout this build doesn't support" << std::endl;
+		return false;
+	}
+
+	// Both blobs must be aligned and lie entirely inside the file.
+	// Divide rather than multiply so huge counts can't overflow
+	const std::uint64_t fileSize = file.Size();
+	bool verticesFit = candidate->vertexOffset <= fileSize &&
+		candidate->vertexCount <= (fileSize - candidate->vertexOffset) / candidate->vertexStride;
+	bool indicesFit = candidate->indexOffset <= fileSize &&
+		candidate->indexCount <= (fileSize - candidate->indexOffset) / candidate->indexStride;
+
+	if (!verticesFit || !indicesFit || candidate->vertexOffset % MESH_FILE_ALIGNMENT || candidate->indexOffset % MESH_FILE_ALIGNMENT)
+	{
+		std::cerr << path << " is truncated or corrupt" << std::endl;
+		return false;
+	}
+
+	const unsigned char* indices = file.Data() + candidate->indexOffset;
+	bool indicesValid = candidate->indexStride == sizeof(unsigned short)
+		? IndicesInRange((const unsigned short*)indices, candidate->indexCount, candidate->vertexCount)
+		: IndicesInRange((const unsigned int*)indices, candidate->indexCount, candidate->vertexCount);
+
+	if (!indicesValid)
+	{
+		std::cerr << path << " has indices past its " << candidate->vertexCount << " vertices" << std::endl;
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+std::span<const PositionVertex2D> mesh::MappedMesh::Vertices() const
+{
+	if (!header) { return {}; }
+	return std::span<const PositionVertex2D>((const PositionVertex2D*)(file.Data() + header->vertexOffset), (std::size_t)header->vertexCount);
+}
+
+const void* mesh::MappedMesh::Indices() const
+{
+	return header ? file.Data() + header->indexOffset : nullptr;
+}
+
+mesh::GpuMesh mesh::Upload(const MappedMesh& mappedMesh)
+{
+	return Upload(mappedMesh.Vertices(), mappedMesh.Indices(), mappedMesh.IndexCount(), mappedMesh.IndexStride());
+}
+
+bool mesh::ConvertToMeshFile(const char* sourcePath, const char* meshPath)
+{
+	IndexedMesh sourceMesh;
+
+	auto start = std::chrono::steady_clock::now();
+	if (!Import(sourcePath, sourceMesh))
+	{
+		std::cerr << "Failed to read " << sourcePath << std::endl;
+		return false;
+	}
+	std::chrono::duration<double> importTime = std::chrono::steady_clock::now() - start;
+	double megabytes = std::filesystem::file_size(sourcePath) / (double)(1 << 20);
+
+	std::cout << sourcePath << ": " << sourceMesh.vertices.size() << " vertices, " << sourceMesh.TriangleCount()
+		<< " triangles, imported at " << megabytes / importTime.count() << " MB/s" << std::endl;
+
+	OptimizationReport report = Optimize(sourceMesh);
+	std::cout << "ACMR " << report.acmrBefore << " -> " << report.acmrAfter << std::endl;
+
+	if (!WriteMeshFile(sourceMesh, meshPath))
+	{
+		std::cerr << "Failed to write " << meshPath << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file MeshFile.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Versioned binary mesh container. The vertex and index
+ *        blobs are stored exactly as the GPU reads them so a
+ *        memory mapped file uploads without being parsed
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstdint>
+#include "MappedFile.h"
+#include "Mesh.h"
+
+namespace mesh {
+
+	/*
+	* File layout, all fields little endian:
+	*
+	*   MeshFileHeader
+	*   padding up to MESH_FILE_ALIGNMENT
+	*   vertexCount * vertexStride bytes of vertices
+	*   padding up to MESH_FILE_ALIGNMENT
+	*   indexCount * indexStride bytes of indices
+	*/
+	constexpr char          MESH_FILE_MAGIC[4]  = { 'R', 'M', 'S', 'H' };
+	constexpr std::uint32_t MESH_FILE_VERSION   = 1;
+	constexpr std::size_t   MESH_FILE_ALIGNMENT = 64;  // Cache line, so blobs never straddle one needlessly
+
+	// Layout of each vertex in the vertex blob
+	enum VertexFormat : std::uint32_t
+	{
+		VERTEX_FORMAT_POSITION_2D = 1  // PositionVertex2D
+	};
+
+	typedef struct MeshFileHeader
+	{
+		char          magic[4];
+		std::uint32_t version;
+		std::uint32_t vertexFormat;
+		std::uint32_t vertexStride;
+		std::uint32_t indexStride;
+		std::uint32_t reserved;
+		std::uint64_t vertexCount;
+		std::uint64_t vertexOffset;  // From the start of the file
+		std::uint64_t indexCount;
+		std::uint64_t indexOffset;   // From the start of the file
+	} MeshFileHeader;
+
+	static_assert(sizeof(MeshFileHeader) == 56, "MeshFileHeader is read straight from disk and must not change size");
+
+	/**
+	* @brief        Write mesh to path in the binary mesh format
+	*
+	* @param mesh   mesh to write
+	* @param path   file to create or overwrite
+	* @return       whether the whole file was written
+	*/
+	bool WriteMeshFile(const IndexedMesh& mesh, const char* path);
+
+	/**
+	* @brief    A binary mesh file mapped into memory. The streams
+	*           point into the mapping and are valid while it is open
+	*/
+	class MappedMesh
+	{
+	public:
+		/**
+		* @brief        Map path and validate its header, blob bounds and indices
+		*
+		* @param path   binary mesh file
+		* @return       whether path is a mesh file this version can read
+		*/
+		bool Open(const char* path);
+
+		std::span<const PositionVertex2D> Vertices() const;
+		const void* Indices() const;
+		std::size_t IndexCount() const { return header ? (std::size_t)header->indexCount : 0; }
+		std::size_t IndexStride() const { return header ? header->indexStride : 0; }
+
+	private:
+		MappedFile file;
+		const MeshFileHeader* header = nullptr;
+	};
+
+	// Upload straight from the mapping, with no intermediate copy
+	GpuMesh Upload(const MappedMesh& mappedMesh);
+
+	/**
+	* @brief            Offline conversion of an OBJ or PLY file to a
+	*                   binary mesh. The mesh is optimized on the way so
+	*                   loading the result does no work besides the upload
+	*
+	* @param sourcePath OBJ or PLY file to read. Only x and y of each position are kept
+	* @param meshPath   binary mesh file to write
+	* @return           whether the conversion succeeded
+	*/
+	bool ConvertToMeshFile(const char* sourcePath, const char* meshPath);
+}
@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+
+namespace {
+
+	// Chunks are large enough that splitting costs nothing next to parsing
+	constexpr std::size_t CHUNK_SIZE = 1 << 20;
+
+	typedef struct TextChunk
+	{
+		const char* begin;
+		const char* end;
+	} TextChunk;
+
+	// Split [begin, end) into chunks of roughly CHUNK_SIZE that start at the beginning of a line
+	std::vector<TextChunk> SplitLines(const char* begin, const char* end)
+	{
+		std::vector<TextChunk> chunks;
+		const char* chunkBegin = begin;
+
+		while (chunkBegin < end)
+		{
+			const char* chunkEnd = chunkBegin + std::min<std::size_t>(CHUNK_SIZE, end - chunkBegin);
+			chunkEnd = (const char*)std::memchr(chunkEnd, '\n', end - chunkEnd);
+			chunkEnd = chunkEnd ? chunkEnd + 1 : end;
+
+			chunks.push_back(TextChunk(chunkBegin, chunkEnd));
+			chunkBegin = chunkEnd;
+		}
+
+		return chunks;
+	}
+
+	// Call onLine(first, eol) for each line in chunk that isn't blank.
+	// first is the line's first non-whitespace character
+	template <typename OnLine>
+	void ForEachLine(const TextChunk& chunk, OnLine&& onLine)
+	{
+		const char* line = chunk.begin;
+		while (line < chunk.end)
+		{
+			const char* eol = (const char*)std::memchr(line, '\n', chunk.end - line);
+			if (!eol) { eol = chunk.end; }
+
+			while (line < eol && (*line == ' ' || *line == '\t')) { line++; }
+			if (line < eol && *line != '\r') { onLine(line, eol); }
+
+			line = eol + 1;
+		}
+	}
+
+	const char* SkipSpaces(const char* text, const char* end)
+	{
+		while (text < end && (*text == ' ' || *text == '\t')) { text++; }
+		return text;
+	}
+
+	const char* SkipToken(const char* text, const char* end)
+	{
+		while (text < end && *text != ' ' && *text != '\t' && *text != '\r') { text++; }
+		return text;
+	}
+
+	// from_chars parses floats without locale lookups or allocations, but rejects a leading '+'
+	template <typename Number>
+	const char* ParseNumber(const char* text, const char* end, Number& value)
+	{
+		text = SkipSpaces(text, end);
+		if (text < end && *text == '+') { text++; }
+
+		std::from_chars_result result = std::from_chars(text, end, value);
+		return result.ec == std::errc() ? result.ptr : nullptr;
+	}
+
+	// Copy every chunk's triangles into mesh's index stream at the chunk's offset, in parallel
+	bool MergeTriangles(const std::vector<std::vector<unsigned int>>& chunkIndices, mesh::IndexedMesh& mesh)
+	{
+		std::vector<std::size_t> indexBase(chunkIndices.size() + 1, 0);
+		for (std::size_t c = 0; c < chunkIndices.size(); c++) { indexBase[c + 1] = indexBase[c] + chunkIndices[c].size(); }
+
+		mesh.indices = mesh::IndexStream(mesh.vertices.size());
+		mesh.indices.Resize(indexBase.back());
+
+		const unsigned int vertexCount = (unsigned int)mesh.vertices.size();
+		std::atomic<bool> outOfRange = false;
+
+		jobs::ParallelFor(chunkIndices.size(), 1, [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t c = begin; c < end; c++)
+			{
+				for (std::size_t i = 0; i < chunkIndices[c].size(); i++)
+				{
+					unsigned int index = chunkIndices[c][i];
+					if (index >= vertexCount) { outOfRange.store(true, std::memory_order_relaxed); }
+					else { mesh.indices.Set(indexBase[c] + i, index); }
+				}
+			}
+		});
+
+		return !outOfRange;
+	}
+
+	/*
+	* PLY
+	*/
+
+	enum class PlyType { Invalid, Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+	typedef struct PlyProperty
+	{
+		std::string name;
+		PlyType type;
+		bool isList;
+		PlyType countType;
+	} PlyProperty;
+
+	typedef struct PlyElement
+	{
+		std::string name;
+		std::size_t count;
+		std::vector<PlyProperty> properties;
+	} PlyElement;
+
+	enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+	PlyType ParsePlyType(std::string_view name)
+	{
+		if (name == "char"   || name == "int8")    { return PlyType::Int8; }
+		if (name == "uchar"  || name == "uint8")   { return PlyType::UInt8; }
+		if (name == "short"  || name == "int16")   { return PlyType::Int16; }
+		if (name == "ushort" || name == "uint16")  { return PlyType::UInt16; }
+		if (name == "int"    || name == "int32")   { return PlyType::Int32; }
+		if (name == "uint"   || name == "uint32")  { return PlyType::UInt32; }
+		if (name == "float"  || name == "float32") { return PlyType::Float32; }
+		if (name == "double" || name == "float64") { return PlyType::Float64; }
+		return PlyType::Invalid;
+	}
+
+	std::size_t PlyTypeSize(PlyType type)
+	{
+		switch (type)
+		{
+		case PlyType::Int8:  case PlyType::UInt8:   return 1;
+		case PlyType::Int16: case PlyType::UInt16:  return 2;
+		case PlyType::Int32: case PlyType::UInt32: case PlyType::Float32: return 4;
+		case PlyType::Float64: return 8;
+		default: return 0;
+		}
+	}
+
+	// Read a binary scalar of type at data, byte swapping if the file's endianness differs
+	double ReadPlyScalar(const unsigned char* data, PlyType type, bool swap)
+	{
+		unsigned char bytes[8];
+		std::size_t size = PlyTypeSize(type);
+		for (std::size_t b = 0; b < size; b++) { bytes[b] = data[swap ? size - 1 - b : b]; }
+
+		switch (type)
+		{
+		case PlyType::Int8:    { std::int8_t   value; std::memcpy(&value, bytes, 1); return value; }
+		case PlyType::UInt8:   { std::uint8_t  value; std::memcpy(&value, bytes, 1); return value; }
+		case PlyType::Int16:   { std::int16_t  value; std::memcpy(&value, bytes, 2); return value; }
+		case PlyType::UInt16:  { std::uint16_t value; std::memcpy(&value, bytes, 2); return value; }
+		case PlyType::Int32:   { std::int32_t  value; std::memcpy(&value, bytes, 4); return value; }
+		case PlyType::UInt32:  { std::uint32_t value; std::memcpy(&value, bytes, 4); return value; }
+		case PlyType::Float32: { float         value; std::memcpy(&value, bytes, 4); return value; }
+		case PlyType::Float64: { double        value; std::memcpy(&value, bytes, 8); return value; }
+		default: return 0.0;
+		}
+	}
+
+	/**
+	* @brief            Parse the header at the start of a PLY file
+	*
+	* @param text       start of the file
+	* @param end        end of the file
+	* @param format     receives the body's encoding
+	* @param elements   receives the elements in the order the body stores them
+	* @return           start of the body, nullptr if the header is malformed
+	*/
+	const char* ParsePlyHeader(const char* text, const char* end, PlyFormat& format, std::vector<PlyElement>& elements)
+	{
+		bool sawFormat = false;
+		bool firstLine = true;
+
+		while (text < end)
+		{
+			const char* eol = (const char*)std::memchr(text, '\n', end - text);
+			if (!eol) { return nullptr; }
+
+			std::string_view line(text, eol - text);
+			if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+			text = eol + 1;
+
+			// Split the line into whitespace separated words
+			std::vector<std::string_view> words;
+			for (std::size_t at = 0; at < line.size();)
+			{
+				at = line.find_first_not_of(" \t", at);
+				if (at == std::string_view::npos) { break; }
+				std::size_t wordEnd = std::min(line.find_first_of(" \t", at), line.size());
+				words.push_back(line.substr(at, wordEnd - at));
+				at = wordEnd;
+			}
+
+			if (firstLine)
+			{
+				if (words.size() != 1 || words[0] != "ply") { return nullptr; }
+				firstLine = false;
+			}
+			else if (words.empty() || words[0] == "comment" || words[0] == "obj_info") { continue; }
+			else if (words[0] == "end_header") { return sawFormat ? text : nullptr; }
+			else if (words[0] == "format" && words.size() >= 2)
+			{
+				if (words[1] == "ascii") { format = PlyFormat::Ascii; }
+				else if (words[1] == "binary_little_endian") { format = PlyFormat::BinaryLittleEndian; }
+				else if (words[1] == "binary_big_endian") { format = PlyFormat::BinaryBigEndian; }
+				else { return nullptr; }
+				sawFormat = true;
+			}
+			else if (words[0] == "element" && words.size() == 3)
+			{
+				PlyElement element;
+				element.name = words[1];
+				if (std::from_chars(words[2].data(), words[2].data() + words[2].size(), element.count).ec != std::errc()) { return nullptr; }
+				elements.push_back(std::move(element));
+			}
+			else if (words[0] == "property" && !elements.empty())
+			{
+				PlyProperty property;
+				if (words.size() == 5 && words[1] == "list")
+				{
+					property = PlyProperty(std::string(words[4]), ParsePlyType(words[3]), true, ParsePlyType(words[2]));
+					if (property.countType == PlyType::Invalid) { return nullptr; }
+				}
+				else if (words.size() == 3) { property = PlyProperty(std::string(words[2]), ParsePlyType(words[1]), false, PlyType::Invalid); }
+				else { return nullptr; }
+
+				if (property.type == PlyType::Invalid) { return nullptr; }
+				elements.back().properties.push_back(std::move(property));
+			}
+			else { return nullptr; }
+		}
+
+		return nullptr;
+	}
+
+	// Index of the property named name in element, -1 if missing
+	int FindPlyProperty(const PlyElement& element, std::string_view name)
+	{
+		for (std::size_t p = 0; p < element.properties.size(); p++)
+		{
+			if (element.properties[p].name == name) { return (int)p; }
+		}
+		return -1;
+	}
+
+	int FindFaceIndicesProperty(const PlyElement& element)
+	{
+		int property = FindPlyProperty(element, "vertex_indices");
+		return property >= 0 ? property : FindPlyProperty(element, "vertex_index");
+	}
+
+	// Append a fan triangulation of the polygon in corners to indices
+	void AddFan(const long long* corners, std::size_t cornerCount, std::vector<unsigned int>& indices)
+	{
+		for (std::size_t c = 2; c < cornerCount; c++)
+		{
+			indices.push_back((unsigned int)corners[0]);
+			indices.push_back((unsigned int)corners[c - 1]);
+			indices.push_back((unsigned int)corners[c]);
+		}
+	}
+
+	bool ImportAsciiPly(const char* body, const char* end, const std::vector<PlyElement>& elements, mesh::IndexedMesh& mesh)
+	{
+		// Every non-blank line is one element instance, in header order. Work out
+		// which range of line numbers belongs to the vertices and the faces
+		std::size_t vertexFirst = 0, vertexCount = 0, faceFirst = 0, faceCount = 0;
+		int xProperty = -1, yProperty = -1, indicesProperty = -1;
+		const PlyElement* vertexElement = nullptr;
+		const PlyElement* faceElement = nullptr;
+
+		std::size_t lineNumber = 0;
+		for (const PlyElement& element : elements)
+		{
+			if (element.name == "vertex")
+			{
+				vertexElement = &element;
+				vertexFirst = lineNumber;
+				vertexCount = element.count;
+				xProperty = FindPlyProperty(element, "x");
+				yProperty = FindPlyProperty(element, "y");
+			}
+			else if (element.name == "face")
+			{
+				faceElement = &element;
+				faceFirst = lineNumber;
+				faceCount = element.count;
+				indicesProperty = FindFaceIndicesProperty(element);
+			}
+
+			lineNumber += element.count;
+		}
+
+		if (!vertexElement || xProperty < 0 || yProperty < 0 || (faceElement && indicesProperty < 0)) { return false; }
+
+		std::vector<TextChunk> chunks = SplitLines(body, end);
+
+		// Pass 1: count lines so each chunk knows the number of its first line
+		std::vector<std::size_t> lineBase(chunks.size() + 1, 0);
+		jobs::ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t chunkEnd)
+		{
+			for (std::size_t c = begin; c < chunkEnd; c++)
+			{
+				std::size_t lines = 0;
+				ForEachLine(chunks[c], [&lines](const char*, const char*) { lines++; });
+				lineBase[c + 1] = lines;
+			}
+		});
+		for (std::size_t c = 0; c < chunks.size(); c++) { lineBase[c + 1] += lineBase[c]; }
+
+		if (lineBase.back() < lineNumber) { return false; }
+
+		// Pass 2: parse. Vertices go straight to their final slot,
+		// faces to a per-chunk stream that is merged afterwards
+		mesh.vertices.resize(vertexCount);
+		std::vector<std::vector<unsigned int>> chunkIndices(chunks.size());
+		std::atomic<bool> malformed = false;
+
+		jobs::ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t chunkEnd)
+		{
+			std::vector<double> values;
+			std::vector<long long> corners;
+
+			for (std::size_t c = begin; c < chunkEnd; c++)
+			{
+				std::size_t line = lineBase[c];
+				ForEachLine(chunks[c], [&](const char* text, const char* eol)
+				{
+					std::size_t current = line++;
+
+					if (current >= vertexFirst && current < vertexFirst + vertexCount)
+					{
+						values.clear();
+						for (const PlyProperty& property : vertexElement->properties)
+						{
+							double value;
+							if (property.isList || !(text = ParseNumber(text, eol, value))) { malformed = true; return; }
+							values.push_back(value);
+						}
+
+						mesh.vertices[current - vertexFirst] = PositionVertex2D((float)values[xProperty], (float)values[yProperty]);
+					}
+					else if (faceElement && current >= faceFirst && current < faceFirst + faceCount)
+					{
+						for (int p = 0; p < (int)faceElement->properties.size(); p++)
+						{
+							std::size_t listSize = 1;
+							if (faceElement->properties[p].isList && !(text = ParseNumber(text, eol, listSize))) { malformed = true; return; }
+
+							corners.clear();
+							for (std::size_t i = 0; i < listSize; i++)
+							{
+								double corner;
+								if (!(text = ParseNumber(text, eol, corner))) { malformed = true; return; }
+								corners.push_back((long long)corner);
+							}
+
+							if (p == indicesProperty) { AddFan(corners.data(), corners.size(), chunkIndices[c]); }
+						}
+					}
+				});
+			}
+		});
+
+		return !malformed && MergeTriangles(chunkIndices, mesh);
+	}
+
+	bool ImportBinaryPly(const unsigned char* body, const unsigned char* end, const std::vector<PlyElement>& elements,
+		bool swap, mesh::IndexedMesh& mesh)
+	{
+		std::vector<std::vector<unsigned int>> indices(1);
+		const unsigned char* at = body;
+
+		for (const PlyElement& element : elements)
+		{
+			bool fixedSize = std::none_of(element.properties.begin(), element.properties.end(),
+				[](const PlyProperty& property) { return property.isList; });
+
+			std::size_t recordSize = 0;
+			for (const PlyProperty& property : element.properties) { recordSize += PlyTypeSize(property.type); }
+
+			if (element.name == "vertex")
+			{
+				int xProperty = FindPlyProperty(element, "x");
+				int yProperty = FindPlyProperty(element, "y");
+				if (!fixedSize || xProperty < 0 || yProperty < 0) { return false; }
+				if (element.count > (std::size_t)(end - at) / std::max<std::size_t>(recordSize, 1)) { return false; }
+
+				std::size_t xOffset = 0, yOffset = 0;
+				for (int p = 0; p < std::max(xProperty, yProperty); p++)
+				{
+					if (p < xProperty) { xOffset += PlyTypeSize(element.properties[p].type); }
+					if (p < yProperty) { yOffset += PlyTypeSize(element.properties[p].type); }
+				}
+
+				// Fixed size records can be decoded in any order, so split them across threads
+				PlyType xType = element.properties[xProperty].type, yType = element.properties[yProperty].type;
+				mesh.vertices.resize(element.count);
+				jobs::ParallelFor(element.count, 1 << 14, [&](std::size_t begin, std::size_t vertexEnd)
+				{
+					for (std::size_t v = begin; v < vertexEnd; v++)
+					{
+						const unsigned char* record = at + v * recordSize;
+						mesh.vertices[v] = PositionVertex2D((float)ReadPlyScalar(record + xOffset, xType, swap),
+							(float)ReadPlyScalar(record + yOffset, yType, swap));
+					}
+				});
+
+				at += element.count * recordSize;
+			}
+			else if (fixedSize)
+			{
+				if (element.count > (std::size_t)(end - at) / std::max<std::size_t>(recordSize, 1)) { return false; }
+				at += element.count * recordSize;
+			}
+			else
+			{
+				// Variable sized records have to be walked in order
+				int indicesProperty = element.name == "face" ? FindFaceIndicesProperty(element) : -1;
+				std::vector<long long> corners;
+
+				for (std::size_t r = 0; r < element.count; r++)
+				{
+					for (int p = 0; p < (int)element.properties.size(); p++)
+					{
+						const PlyProperty& property = element.properties[p];
+
+						std::size_t listSize = 1;
+						if (property.isList)
+						{
+							if ((std::size_t)(end - at) < PlyTypeSize(property.countType)) { return false; }
+							listSize = (std::size_t)ReadPlyScalar(at, property.countType, swap);
+							at += PlyTypeSize(property.countType);
+						}
+
+						std::size_t size = PlyTypeSize(property.type);
+						if (listSize > (std::size_t)(end - at) / size) { return false; }
+
+						if (p == indicesProperty)
+						{
+							corners.resize(listSize);
+							for (std::size_t i = 0; i < listSize; i++) { corners[i] = (long long)ReadPlyScalar(at + i * size, property.type, swap); }
+							AddFan(corners.data(), corners.size(), indices[0]);
+						}
+
+						at += listSize * size;
+					}
+				}
+			}
+		}
+
+		return MergeTriangles(indices, mesh);
+	}
+}
+
+bool mesh::ImportObj(const char* path, IndexedMesh& mesh)
+{
+	MappedFile file;
+	if (!file.Open(path)) { return false; }
+
+	const char* text = (const char*)file.Data();
+	std::vector<TextChunk> chunks = SplitLines(text, text + file.Size());
+
+	auto isPosition = [](const char* line, const char* eol) { return eol - line > 1 && line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'); };
+	auto isFace     = [](const char* line, const char* eol) { return eol - line > 1 && line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'); };
+
+	// Pass 1: count positions so each chunk knows where its first position lands
+	std::vector<std::size_t> vertexBase(chunks.size() + 1, 0);
+	jobs::ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t c = begin; c < end; c++)
+		{
+			std::size_t positions = 0;
+			ForEachLine(chunks[c], [&](const char* line, const char* eol) { positions += isPosition(line, eol); });
+			vertexBase[c + 1] = positions;
+		}
+	});
+	for (std::size_t c = 0; c < chunks.size(); c++) { vertexBase[c + 1] += vertexBase[c]; }
+
+	// Pass 2: parse. Positions go straight to their final slot, faces to
+	// a per-chunk stream since their count isn't known until parsed
+	mesh.vertices.resize(vertexBase.back());
+	std::vector<std::vector<unsigned int>> chunkIndices(chunks.size());
+	std::atomic<bool> malformed = false;
+
+	jobs::ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end)
+	{
+		std::vector<long long> corners;
+
+		for (std::size_t c = begin; c < end; c++)
+		{
+			std::size_t positions = vertexBase[c];
+			ForEachLine(chunks[c], [&](const char* line, const char* eol)
+			{
+				if (isPosition(line, eol))
+				{
+					PositionVertex2D& vertex = mesh.vertices[positions++];
+					if (!(line = ParseNumber(line + 1, eol, vertex.posX)) || !ParseNumber(line, eol, vertex.posY)) { malformed = true; }
+				}
+				else if (isFace(line, eol))
+				{
+					// Corners look like v, v/vt, v//vn or v/vt/vn. Only v matters.
+					// Negative indices count back from the latest position
+					corners.clear();
+					line = SkipSpaces(line + 1, eol);
+					while (line < eol && *line != '\r')
+					{
+						long long index;
+						if (!ParseNumber(line, eol, index) || index == 0) { malformed = true; return; }
+
+						corners.push_back(index < 0 ? (long long)positions + index : index - 1);
+						line = SkipSpaces(SkipToken(line, eol), eol);
+					}
+
+					AddFan(corners.data(), corners.size(), chunkIndices[c]);
+				}
+			});
+		}
+	});
+
+	if (malformed || !MergeTriangles(chunkIndices, mesh)) { return false; }
+
+	// Weld duplicate positions so each one is stored and transformed once
+	WeldVertices(mesh);
+	return true;
+}
+
+bool mesh::ImportPly(const char* path, IndexedMesh& mesh)
+{
+	MappedFile file;
+	if (!file.Open(path)) { return false; }
+
+	const char* text = (const char*)file.Data();
+	const char* end = text + file.Size();
+
+	PlyFormat format = PlyFormat::Ascii;
+	std::vector<PlyElement> elements;
+	const char* body = ParsePlyHeader(text, end, format, elements);
+	if (!body) { return false; }
+
+	bool imported;
+	if (format == PlyFormat::Ascii) { imported = ImportAsciiPly(body, end, elements, mesh); }
+	else
+	{
+		constexpr unsigned int one = 1;
+		bool littleEndianHost = *(const unsigned char*)&one == 1;
+		bool swap = littleEndianHost != (format == PlyFormat::BinaryLittleEndian);
+		imported = ImportBinaryPly((const unsigned char*)body, (const unsigned char*)end, elements, swap, mesh);
+	}
+
+	if (!imported) { return false; }
+
+	// Weld duplicate positions so each one is stored and transformed once
+	WeldVertices(mesh);
+	return true;
+}
+
+bool mesh::Import(const char* path, IndexedMesh& mesh)
+{
+	std::string_view name(path);
+	std::string extension(name.substr(std::min(name.rfind('.'), name.size())));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+
+	if (extension == ".obj") { return ImportObj(path, mesh); }
+	if (extension == ".ply") { return ImportPly(path, mesh); }
+
+	std::cerr << path << " is not an OBJ or PLY file" << std::endl;
+	return false;
+}
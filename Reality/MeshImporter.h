@@ -0,0 +1,48 @@
+/**
+ * @file MeshImporter.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Multithreaded importers for text mesh formats that
+ *        haven't been converted to binary mesh files
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include "Mesh.h"
+
+namespace mesh {
+
+	/*
+	* Both importers map the file, split it into chunks on line
+	* boundaries and parse the chunks on every core. Each chunk first
+	* counts what it holds so the chunks can write straight into their
+	* own slice of the shared vertex and index streams without locking.
+	* Duplicate positions are welded through a hash table afterwards.
+	*
+	* Only x and y of each position are kept, and faces with more than
+	* three corners are triangulated as fans.
+	*/
+
+	/**
+	* @brief        Import a Wavefront OBJ file
+	*
+	* @param path   OBJ file
+	* @param mesh   mesh to replace with the file's contents
+	* @return       whether the file could be read
+	*/
+	bool ImportObj(const char* path, IndexedMesh& mesh);
+
+	/**
+	* @brief        Import an ASCII or binary (either endianness) PLY file
+	*
+	* @param path   PLY file
+	* @param mesh   mesh to replace with the file's contents
+	* @return       whether the file could be read
+	*/
+	bool ImportPly(const char* path, IndexedMesh& mesh);
+
+	// Pick ImportObj or ImportPly from path's extension
+	bool Import(const char* path, IndexedMesh& mesh);
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+
+namespace {
+
+	// Scoring constants from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	constexpr float CACHE_DECAY_POWER   = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	float VertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		// Vertices no remaining triangle uses are worthless
+		if (remainingTriangles == 0) { return -1.0f; }
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The three vertices of the last triangle get a fixed score so the
+			// next triangle isn't biased towards one of its edges
+			if (cachePosition < 3) { score = LAST_TRIANGLE_SCORE; }
+			else
+			{
+				float scaler = 1.0f / (mesh::VERTEX_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		// Favour vertices with few triangles left so they get finished off
+		score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// Simulate a FIFO cache over indices [begin, end) and return the number of misses
+	unsigned int CountCacheMisses(const mesh::IndexedMesh& mesh, std::size_t begin, std::size_t end,
+		unsigned int cacheSize, std::vector<unsigned int>& timestamps, unsigned int& time)
+	{
+		unsigned int misses = 0;
+		for (std::size_t i = begin; i < end; i++)
+		{
+			unsigned int vertex = mesh.indices[i];
+
+			// A vertex is in the cache if it was added fewer than cacheSize misses ago
+			if (time - timestamps[vertex] >= cacheSize)
+			{
+				timestamps[vertex] = ++time;
+				misses++;
+			}
+		}
+
+		return misses;
+	}
+
+	// Replace mesh's triangles with those listed in order
+	void ReorderTriangles(mesh::IndexedMesh& mesh, const std::vector<unsigned int>& order)
+	{
+		mesh::IndexStream reordered(mesh.vertices.size());
+		reordered.Reserve(order.size() * 3);
+
+		for (unsigned int triangle : order)
+		{
+			reordered.Push(mesh.indices[triangle * 3]);
+			reordered.Push(mesh.indices[triangle * 3 + 1]);
+			reordered.Push(mesh.indices[triangle * 3 + 2]);
+		}
+
+		mesh.indices = std::move(reordered);
+	}
+
+	// Move vertices to remap[old index], dropping those remapped to mesh::NO_NEIGHBOUR
+	void RemapVertices(mesh::IndexedMesh& mesh, const std::vector<unsigned int>& remap, std::size_t newVertexCount)
+	{
+		std::vector<PositionVertex2D> vertices(newVertexCount);
+		for (std::size_t v = 0; v < mesh.vertices.size(); v++)
+		{
+			if (remap[v] != mesh::NO_NEIGHBOUR) { vertices[remap[v]] = mesh.vertices[v]; }
+		}
+
+		for (std::size_t i = 0; i < mesh.indices.Count(); i++) { mesh.indices.Set(i, remap[mesh.indices[i]]); }
+
+		mesh.vertices = std::move(vertices);
+		mesh.indices.FitTo(mesh.vertices.size());
+	}
+}
+
+float mesh::ComputeACMR(const IndexedMesh& mesh, unsigned int cacheSize)
+{
+	if (mesh.TriangleCount() == 0) { return 0.0f; }
+
+	// Start every timestamp far enough in the past to count as a miss
+	unsigned int time = cacheSize;
+	std::vector<unsigned int> timestamps(mesh.vertices.size(), 0);
+
+	unsigned int misses = CountCacheMisses(mesh, 0, mesh.indices.Count(), cacheSize, timestamps, time);
+	return (float)misses / mesh.TriangleCount();
+}
+
+unsigned int mesh::WeldVertices(IndexedMesh& mesh, float epsilon)
+{
+	// Key each vertex by its position's bits, or by
+	// the grid cell it snaps to when epsilon is set
+	auto key = [epsilon](const PositionVertex2D& vertex)
+	{
+		unsigned int x, y;
+		if (epsilon > 0.0f)
+		{
+			x = (unsigned int)(long long)std::floor(vertex.posX / epsilon + 0.5f);
+			y = (unsigned int)(long long)std::floor(vertex.posY / epsilon + 0.5f);
+		}
+		else
+		{
+			// +0.0f turns -0.0f into 0.0f so the two weld
+			float posX = vertex.posX + 0.0f, posY = vertex.posY + 0.0f;
+			std::memcpy(&x, &posX, sizeof(x));
+			std::memcpy(&y, &posY, sizeof(y));
+		}
+
+		return ((unsigned long long)x << 32) | y;
+	};
+
+	// Only vertices that are used survive
+	const std::size_t inputCount = mesh.vertices.size();
+	std::vector<unsigned char> used(inputCount, 0);
+	for (std::size_t i = 0; i < mesh.indices.Count(); i++) { used[mesh.indices[i]] = 1; }
+
+	// Hash every vertex's key, using the finalizer from MurmurHash3 to spread its bits
+	std::vector<unsigned long long> keys(inputCount), hashes(inputCount);
+	jobs::ParallelFor(inputCount, 1 << 14, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t v = begin; v < end; v++)
+		{
+			unsigned long long hash = keys[v] = key(mesh.vertices[v]);
+			hash ^= hash >> 33; hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33; hash *= 0xC4CEB9FE1A85EC53ull;
+			hashes[v] = hash ^ (hash >> 33);
+		}
+	});
+
+	// Bucket used vertices by the top bits of their hash. Equal keys always
+	// land in the same partition, so partitions weld independently without locks
+	constexpr unsigned int PARTITION_BITS = 6;
+	constexpr std::size_t PARTITION_COUNT = 1 << PARTITION_BITS;
+	auto partitionOf = [&hashes](std::size_t v) { return (std::size_t)(hashes[v] >> (64 - PARTITION_BITS)); };
+
+	std::vector<std::size_t> partitionStart(PARTITION_COUNT + 1, 0);
+	for (std::size_t v = 0; v < inputCount; v++) { partitionStart[partitionOf(v) + 1] += used[v]; }
+	for (std::size_t p = 0; p < PARTITION_COUNT; p++) { partitionStart[p + 1] += partitionStart[p]; }
+
+	std::vector<unsigned int> partitioned(partitionStart.back());
+	{
+		std::vector<std::size_t> cursor(partitionStart.begin(), partitionStart.end() - 1);
+		for (std::size_t v = 0; v < inputCount; v++)
+		{
+			if (used[v]) { partitioned[cursor[partitionOf(v)]++] = (unsigned int)v; }
+		}
+	}
+
+	// Within each partition, point every vertex at the first vertex with its key. The
+	// table is open addressing, kept at most half full so probe sequences stay short,
+	// and flat so lookups don't chase the per-node allocations of a std::unordered_map
+	std::vector<unsigned int> representative(inputCount, NO_NEIGHBOUR);
+	jobs::ParallelFor(PARTITION_COUNT, 1, [&](std::size_t begin, std::size_t end)
+	{
+		std::vector<unsigned int> table;
+		for (std::size_t p = begin; p < end; p++)
+		{
+			std::size_t tableSize = 16;
+			while (tableSize < (partitionStart[p + 1] - partitionStart[p]) * 2) { tableSize *= 2; }
+			table.assign(tableSize, NO_NEIGHBOUR);
+
+			for (std::size_t i = partitionStart[p]; i < partitionStart[p + 1]; i++)
+			{
+				unsigned int v = partitioned[i];
+
+				std::size_t slot = (std::size_t)hashes[v] & (tableSize - 1);
+				while (table[slot] != NO_NEIGHBOUR && keys[table[slot]] != keys[v]) { slot = (slot + 1) & (tableSize - 1); }
+
+				if (table[slot] == NO_NEIGHBOUR) { table[slot] = v; }
+				representative[v] = table[slot];
+			}
+		}
+	});
+
+	// Number the surviving vertices in their original order
+	std::vector<unsigned int> remap(inputCount, NO_NEIGHBOUR);
+	unsigned int vertexCount = 0;
+	for (std::size_t v = 0; v < inputCount; v++)
+	{
+		if (representative[v] == v) { remap[v] = vertexCount++; }
+	}
+	for (std::size_t v = 0; v < inputCount; v++)
+	{
+		if (representative[v] != NO_NEIGHBOUR) { remap[v] = remap[representative[v]]; }
+	}
+
+	unsigned int welded = (unsigned int)mesh.vertices.size() - vertexCount;
+	RemapVertices(mesh, remap, vertexCount);
+
+	return welded;
+}
+
+void mesh::OptimizeVertexCache(IndexedMesh& mesh)
+{
+	const unsigned int triangleCount = (unsigned int)mesh.TriangleCount();
+	if (triangleCount == 0) { return; }
+
+	Adjacency adjacency(mesh);
+
+	// Per vertex state
+	std::vector<unsigned int> remaining(mesh.vertices.size());
+	std::vector<int> cachePosition(mesh.vertices.size(), -1);
+	std::vector<float> vertexScore(mesh.vertices.size());
+	for (std::size_t v = 0; v < mesh.vertices.size(); v++)
+	{
+		remaining[v] = (unsigned int)adjacency.TrianglesAroundVertex((unsigned int)v).size();
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	}
+
+	// Per triangle state
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<float> triangleScore(triangleCount);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		Triangle2D triangle = mesh.GetTriangle(t);
+		triangleScore[t] = vertexScore[triangle.vertA] + vertexScore[triangle.vertB] + vertexScore[triangle.vertC];
+	}
+
+	// LRU cache, with room for the three vertices pushed before trimming
+	std::vector<unsigned int> cache, nextCache;
+	cache.reserve(VERTEX_CACHE_SIZE + 3);
+	nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+	std::vector<unsigned int> order;
+	order.reserve(triangleCount);
+
+	unsigned int bestTriangle = 0;
+	unsigned int scanCursor = 0;
+
+	while (true)
+	{
+		emitted[bestTriangle] = true;
+		order.push_back(bestTriangle);
+		if (order.size() == triangleCount) { break; }
+
+		// Move the emitted triangle's vertices to the front of the cache
+		Triangle2D triangle = mesh.GetTriangle(bestTriangle);
+		unsigned int emittedVertices[3] = { triangle.vertA, triangle.vertB, triangle.vertC };
+
+		nextCache.assign(emittedVertices, emittedVertices + 3);
+		for (unsigned int vertex : cache)
+		{
+			if (vertex != emittedVertices[0] && vertex != emittedVertices[1] && vertex != emittedVertices[2]) { nextCache.push_back(vertex); }
+		}
+
+		for (unsigned int vertex : emittedVertices) { remaining[vertex]--; }
+
+		// Rescore every vertex that was or is in the cache, and their triangles.
+		// Vertices that fell off the end get their cache position cleared
+		for (std::size_t i = 0; i < nextCache.size(); i++)
+		{
+			unsigned int vertex = nextCache[i];
+			cachePosition[vertex] = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+			vertexScore[vertex] = VertexScore(cachePosition[vertex], remaining[vertex]);
+		}
+
+		float bestScore = -1.0f;
+		for (unsigned int vertex : nextCache)
+		{
+			for (unsigned int t : adjacency.TrianglesAroundVertex(vertex))
+			{
+				if (emitted[t]) { continue; }
+
+				Triangle2D candidate = mesh.GetTriangle(t);
+				triangleScore[t] = vertexScore[candidate.vertA] + vertexScore[candidate.vertB] + vertexScore[candidate.vertC];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		if (nextCache.size() > VERTEX_CACHE_SIZE) { nextCache.resize(VERTEX_CACHE_SIZE); }
+		std::swap(cache, nextCache);
+
+		// Nothing in the cache connects to a remaining triangle, so
+		// continue from the next triangle in the original order
+		if (bestScore < 0.0f)
+		{
+			while (emitted[scanCursor]) { scanCursor++; }
+			bestTriangle = scanCursor;
+		}
+	}
+
+	ReorderTriangles(mesh, order);
+}
+
+void mesh::OptimizeOverdraw(IndexedMesh& mesh, float threshold)
+{
+	const std::size_t triangleCount = mesh.TriangleCount();
+	if (triangleCount == 0) { return; }
+
+	// Split into clusters wherever a triangle misses on all three vertices.
+	// The cache has been flushed there so clusters can usually move
+	// without costing extra vertex shader invocations
+	std::vector<std::size_t> clusterStarts;
+	{
+		unsigned int time = VERTEX_CACHE_SIZE;
+		std::vector<unsigned int> timestamps(mesh.vertices.size(), 0);
+
+		for (std::size_t t = 0; t < triangleCount; t++)
+		{
+			unsigned int misses = CountCacheMisses(mesh, t * 3, t * 3 + 3, VERTEX_CACHE_SIZE, timestamps, time);
+			if (t == 0 || misses == 3) { clusterStarts.push_back(t); }
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Centroid of the whole mesh, weighting every triangle the same
+	float meshX = 0.0f, meshY = 0.0f;
+	for (std::size_t i = 0; i < mesh.indices.Count(); i++)
+	{
+		meshX += mesh.vertices[mesh.indices[i]].posX;
+		meshY += mesh.vertices[mesh.indices[i]].posY;
+	}
+	meshX /= mesh.indices.Count();
+	meshY /= mesh.indices.Count();
+
+	// Sort clusters by how far their centroid is from the mesh's, furthest first
+	std::vector<std::size_t> clusters(clusterStarts.size() - 1);
+	std::vector<float> distances(clusters.size());
+	for (std::size_t c = 0; c < clusters.size(); c++)
+	{
+		float clusterX = 0.0f, clusterY = 0.0f;
+		for (std::size_t i = clusterStarts[c] * 3; i < clusterStarts[c + 1] * 3; i++)
+		{
+			clusterX += mesh.vertices[mesh.indices[i]].posX;
+			clusterY += mesh.vertices[mesh.indices[i]].posY;
+		}
+
+		float count = (float)(clusterStarts[c + 1] - clusterStarts[c]) * 3;
+		float offsetX = clusterX / count - meshX, offsetY = clusterY / count - meshY;
+
+		clusters[c] = c;
+		distances[c] = offsetX * offsetX + offsetY * offsetY;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[&distances](std::size_t lhs, std::size_t rhs) { return distances[lhs] > distances[rhs]; });
+
+	std::vector<unsigned int> order;
+	order.reserve(triangleCount);
+	for (std::size_t cluster : clusters)
+	{
+		for (std::size_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; t++) { order.push_back((unsigned int)t); }
+	}
+
+	// Clusters that shared vertices across a boundary can lose those hits
+	// when separated, so keep the input order if that costs too much
+	const float acmrBefore = ComputeACMR(mesh, VERTEX_CACHE_SIZE);
+	IndexStream original = mesh.indices;
+
+	ReorderTriangles(mesh, order);
+	if (ComputeACMR(mesh, VERTEX_CACHE_SIZE) > acmrBefore * threshold) { mesh.indices = std::move(original); }
+}
+
+void mesh::OptimizeVertexFetch(IndexedMesh& mesh)
+{
+	std::vector<unsigned int> remap(mesh.vertices.size(), NO_NEIGHBOUR);
+	unsigned int vertexCount = 0;
+
+	for (std::size_t i = 0; i < mesh.indices.Count(); i++)
+	{
+		unsigned int vertex = mesh.indices[i];
+		if (remap[vertex] == NO_NEIGHBOUR) { remap[vertex] = vertexCount++; }
+	}
+
+	RemapVertices(mesh, remap, vertexCount);
+}
+
+mesh::OptimizationReport mesh::Optimize(IndexedMesh& mesh, bool depthTested)
+{
+	OptimizationReport report;
+	report.acmrBefore = ComputeACMR(mesh);
+
+	report.verticesWelded = WeldVertices(mesh);
+	OptimizeVertexCache(mesh);
+	if (depthTested) { OptimizeOverdraw(mesh); }
+	OptimizeVertexFetch(mesh);
+
+	report.acmrAfter = ComputeACMR(mesh);
+	return report;
+}
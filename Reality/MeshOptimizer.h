@@ -0,0 +1,91 @@
+/**
+ * @file MeshOptimizer.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Load time passes that reorder an indexed mesh so the
+ *        GPU runs fewer vertex shader invocations and fetches
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include "Mesh.h"
+
+namespace mesh {
+
+	// Size of the post-transform cache the passes optimize for
+	constexpr unsigned int VERTEX_CACHE_SIZE = 32;
+
+	// Size of the FIFO cache ACMR is measured against. Smaller than
+	// the optimization target so the number is conservative
+	constexpr unsigned int ACMR_CACHE_SIZE = 16;
+
+	// What Optimize changed in a mesh
+	typedef struct OptimizationReport
+	{
+		float acmrBefore;
+		float acmrAfter;
+		unsigned int verticesWelded;
+	} OptimizationReport;
+
+	/**
+	* @brief            Average cache miss ratio: vertex shader invocations
+	*                   per triangle with a FIFO cache of cacheSize entries.
+	*                   0.5 is the best achievable on large grids, 3 the worst
+	*
+	* @param mesh       mesh to measure
+	* @param cacheSize  number of entries in the simulated cache
+	*/
+	float ComputeACMR(const IndexedMesh& mesh, unsigned int cacheSize = ACMR_CACHE_SIZE);
+
+	/**
+	* @brief            Merge vertices whose positions are within epsilon
+	*                   of each other and drop vertices no triangle uses
+	*
+	* @param mesh       mesh to weld
+	* @param epsilon    grid size positions are snapped to before comparing,
+	*                   0 only welds bit-identical positions
+	* @return           number of vertices removed
+	*/
+	unsigned int WeldVertices(IndexedMesh& mesh, float epsilon = 0.0f);
+
+	/**
+	* @brief            Reorder triangles with Tom Forsyth's linear speed
+	*                   vertex cache optimization so consecutive triangles
+	*                   reuse recently transformed vertices
+	*/
+	void OptimizeVertexCache(IndexedMesh& mesh);
+
+	/**
+	* @brief            Split the cache-optimized triangle order into clusters at
+	*                   cache flushes and sort the clusters outside-in so that,
+	*                   with depth testing enabled, occluders tend to draw first.
+	*                   The new order is only kept if ACMR stays within threshold of
+	*                   the input order. Run after OptimizeVertexCache.
+	*
+	*                   Reordering triangles changes how overlapping triangles
+	*                   layer when depth testing is off, so only use this on
+	*                   meshes whose triangles don't overlap or are depth tested
+	*
+	* @param threshold  largest allowed ACMR increase, as a ratio
+	*/
+	void OptimizeOverdraw(IndexedMesh& mesh, float threshold = 1.05f);
+
+	/**
+	* @brief            Reorder the vertex stream into first-use order so
+	*                   vertex fetches walk memory linearly. Run last
+	*/
+	void OptimizeVertexFetch(IndexedMesh& mesh);
+
+	/**
+	* @brief            Run the passes above in the order they are meant to run.
+	*                   OptimizeOverdraw only runs for depth tested meshes, since
+	*                   the renderer otherwise layers triangles in index order
+	*
+	* @param mesh       mesh to optimize in place
+	* @param depthTested whether the mesh is drawn with depth testing enabled
+	* @return           ACMR before and after and how many vertices were welded
+	*/
+	OptimizationReport Optimize(IndexedMesh& mesh, bool depthTested = false);
+}
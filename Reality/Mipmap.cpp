@@ -0,0 +1,351 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "JobSystem.h"
+#include "Mipmap.h"
+#include "Texture.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#else
+#define MIPMAP_SSE2 0
+#endif
+
+namespace {
+
+	// Kaiser window half width in texels of the level being made, and its shape
+	constexpr float KAISER_WIDTH = 2.0f;
+	constexpr float KAISER_ALPHA = 4.0f;
+	constexpr float PI = 3.14159265358979f;
+
+	// Texels per job, so small levels don't get split into uselessly small jobs
+	constexpr std::size_t TEXELS_PER_JOB = 1 << 14;
+
+	// An RGBA texel of 4 floats, one SSE register where available
+#if MIPMAP_SSE2
+	typedef __m128 Texel;
+
+	inline Texel LoadTexel(const float* texel) { return _mm_loadu_ps(texel); }
+	inline void StoreTexel(float* texel, Texel value) { _mm_storeu_ps(texel, value); }
+	inline Texel ZeroTexel() { return _mm_setzero_ps(); }
+	inline Texel Add(Texel a, Texel b) { return _mm_add_ps(a, b); }
+	inline Texel Scale(Texel a, float weight) { return _mm_mul_ps(a, _mm_set1_ps(weight)); }
+	inline Texel MultiplyAdd(Texel sum, Texel a, float weight) { return _mm_add_ps(sum, _mm_mul_ps(a, _mm_set1_ps(weight))); }
+#else
+	typedef struct Texel
+	{
+		float c[4];
+	} Texel;
+
+	inline Texel LoadTexel(const float* texel) { return Texel{ { texel[0], texel[1], texel[2], texel[3] } }; }
+	inline void StoreTexel(float* texel, Texel value) { for (int c = 0; c < 4; c++) { texel[c] = value.c[c]; } }
+	inline Texel ZeroTexel() { return Texel{}; }
+	inline Texel Add(Texel a, Texel b) { for (int c = 0; c < 4; c++) { a.c[c] += b.c[c]; } return a; }
+	inline Texel Scale(Texel a, float weight) { for (int c = 0; c < 4; c++) { a.c[c] *= weight; } return a; }
+	inline Texel MultiplyAdd(Texel sum, Texel a, float weight) { for (int c = 0; c < 4; c++) { sum.c[c] += a.c[c] * weight; } return sum; }
+#endif
+
+	// Decoding sRGB bytes is one lookup. Encoding looks up linear values quantized to 16 bits, fine enough near black
+	constexpr int LINEAR_STEPS = 65535;
+
+	typedef struct GammaTables
+	{
+		float toLinear[256];
+		unsigned char toSrgb[LINEAR_STEPS + 1];
+	} GammaTables;
+
+	const GammaTables& Gamma()
+	{
+		static const GammaTables* tables = []
+		{
+			static GammaTables gamma;
+			for (int b = 0; b < 256; b++)
+			{
+				float encoded = b / 255.0f;
+				gamma.toLinear[b] = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int l = 0; l <= LINEAR_STEPS; l++)
+			{
+				float linear = (float)l / LINEAR_STEPS;
+				float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+				gamma.toSrgb[l] = (unsigned char)(encoded * 255.0f + 0.5f);
+			}
+			return &gamma;
+		}();
+
+		return *tables;
+	}
+
+	// Source texels one texel of a smaller level is made from, along one axis
+	typedef struct Taps
+	{
+		int first;
+		int count;
+		std::size_t weights;    // Index of the first weight
+	} Taps;
+
+	typedef struct Resampler
+	{
+		std::vector<Taps> taps;
+		std::vector<float> weights;
+	} Resampler;
+
+	float Sinc(float x)
+	{
+		if (std::fabs(x) < 1e-5f) { return 1.0f; }
+		return std::sin(PI * x) / (PI * x);
+	}
+
+	// Zeroth order modified Bessel function of the first kind
+	float BesselI0(float x)
+	{
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 32 && term > sum * 1e-8f; k++)
+		{
+			float factor = x / (2.0f * k);
+			term *= factor * factor;
+			sum += term;
+		}
+		return sum;
+	}
+
+	float KaiserWindow(float x)
+	{
+		if (std::fabs(x) >= 1.0f) { return 0.0f; }
+		return BesselI0(KAISER_ALPHA * std::sqrt(1.0f - x * x)) / BesselI0(KAISER_ALPHA);
+	}
+
+	/**
+	* @brief    Weights for shrinking sourceSize texels to targetSize along one axis.
+	*           Exact halves for even sizes, and still correct for odd ones where
+	*           each target texel covers 2 and a bit source texels
+	*/
+	Resampler MakeResampler(int sourceSize, int targetSize, textures::MipFilter filter)
+	{
+		Resampler resampler;
+		resampler.taps.resize(targetSize);
+
+		const float scale = (float)sourceSize / targetSize;
+		const float support = filter == textures::MipFilter::Box ? scale * 0.5f : scale * KAISER_WIDTH;
+
+		std::vector<float> clampedWeights(sourceSize);
+		for (int t = 0; t < targetSize; t++)
+		{
+			float center = (t + 0.5f) * scale;
+			int first = (int)std::floor(center - support), last = (int)std::ceil(center + support);
+
+			// Past the edge texels are the edge texel repeated
+			std::fill(clampedWeights.begin(), clampedWeights.end(), 0.0f);
+			float total = 0.0f;
+			for (int s = first; s <= last; s++)
+			{
+				float weight;
+				if (filter == textures::MipFilter::Box)
+				{
+					// How much of the source texel is inside the box
+					weight = std::max(0.0f, std::min(s + 1.0f, center + support) - std::max((float)s, center - support));
+				}
+				else
+				{
+					float distance = (s + 0.5f - center) / scale;
+					weight = Sinc(distance) * KaiserWindow(distance / KAISER_WIDTH);
+				}
+
+				clampedWeights[std::clamp(s, 0, sourceSize - 1)] += weight;
+				total += weight;
+			}
+
+			int firstTap = std::max(first, 0), lastTap = std::min(last, sourceSize - 1);
+			while (firstTap < lastTap && clampedWeights[firstTap] == 0.0f) { firstTap++; }
+			while (lastTap > firstTap && clampedWeights[lastTap] == 0.0f) { lastTap--; }
+
+			resampler.taps[t] = Taps{ firstTap, lastTap - firstTap + 1, resampler.weights.size() };
+			for (int s = firstTap; s <= lastTap; s++) { resampler.weights.push_back(clampedWeights[s] / total); }
+		}
+
+		return resampler;
+	}
+
+	// Rows of a level per ParallelFor range
+	std::size_t RowGrain(int width)
+	{
+		return std::max<std::size_t>(TEXELS_PER_JOB / std::max(width, 1), 1);
+	}
+
+	// Decode level 0 to linear, premultiplied floats
+	void ToLinear(const unsigned char* rgba, int width, int height, bool srgb, std::vector<float>& linear)
+	{
+		const GammaTables& gamma = Gamma();
+		linear.resize((std::size_t)width * height * 4);
+
+		jobs::ParallelFor(height, RowGrain(width), [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin * width; i < end * width; i++)
+			{
+				const unsigned char* texel = rgba + i * 4;
+				float alpha = texel[3] / 255.0f;
+				for (int c = 0; c < 3; c++) { linear[i * 4 + c] = (srgb ? gamma.toLinear[texel[c]] : texel[c] / 255.0f) * alpha; }
+				linear[i * 4 + 3] = alpha;
+			}
+		});
+	}
+
+	// Encode a level back to bytes
+	void FromLinear(const std::vector<float>& linear, int width, int height, bool srgb, unsigned char* rgba)
+	{
+		const GammaTables& gamma = Gamma();
+
+		jobs::ParallelFor(height, RowGrain(width), [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin * width; i < end * width; i++)
+			{
+				const float* texel = linear.data() + i * 4;
+				float alpha = std::clamp(texel[3], 0.0f, 1.0f);
+				float unpremultiply = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+
+				for (int c = 0; c < 3; c++)
+				{
+					float value = std::clamp(texel[c] * unpremultiply, 0.0f, 1.0f);
+					rgba[i * 4 + c] = srgb ? gamma.toSrgb[(int)(value * LINEAR_STEPS + 0.5f)] : (unsigned char)(value * 255.0f + 0.5f);
+				}
+				rgba[i * 4 + 3] = (unsigned char)(alpha * 255.0f + 0.5f);
+			}
+		});
+	}
+
+	// Exact 2x2 averages, for the common case of both sides even
+	void HalveBox(const std::vector<float>& source, int sourceWidth, std::vector<float>& target, int width, int height)
+	{
+		target.resize((std::size_t)width * height * 4);
+
+		jobs::ParallelFor(height, RowGrain(width), [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t y = begin; y < end; y++)
+			{
+				const float* top = source.data() + y * 2 * sourceWidth * 4;
+				const float* bottom = top + sourceWidth * 4;
+				float* out = target.data() + y * width * 4;
+
+				for (int x = 0; x < width; x++)
+				{
+					Texel sum = Add(Add(LoadTexel(top + x * 8), LoadTexel(top + x * 8 + 4)),
+						Add(LoadTexel(bottom + x * 8), LoadTexel(bottom + x * 8 + 4)));
+					StoreTexel(out + x * 4, Scale(sum, 0.25f));
+				}
+			}
+		});
+	}
+
+	// Separable resampling, rows then columns
+	void Resample(const std::vector<float>& source, int sourceWidth, int sourceHeight, std::vector<float>& target,
+		int width, int height, textures::MipFilter filter)
+	{
+		const Resampler horizontal = MakeResampler(sourceWidth, width, filter);
+		const Resampler vertical = MakeResampler(sourceHeight, height, filter);
+
+		std::vector<float> rows((std::size_t)width * sourceHeight * 4);
+		jobs::ParallelFor(sourceHeight, RowGrain(width), [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t y = begin; y < end; y++)
+			{
+				const float* in = source.data() + y * sourceWidth * 4;
+				float* out = rows.data() + y * width * 4;
+
+				for (int x = 0; x < width; x++)
+				{
+					const Taps& taps = horizontal.taps[x];
+					const float* weights = horizontal.weights.data() + taps.weights;
+
+					Texel sum = ZeroTexel();
+					for (int t = 0; t < taps.count; t++) { sum = MultiplyAdd(sum, LoadTexel(in + (taps.first + t) * 4), weights[t]); }
+					StoreTexel(out + x * 4, sum);
+				}
+			}
+		});
+
+		target.resize((std::size_t)width * height * 4);
+		jobs::ParallelFor(height, RowGrain(width), [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t y = begin; y < end; y++)
+			{
+				const Taps& taps = vertical.taps[y];
+				const float* weights = vertical.weights.data() + taps.weights;
+				float* out = target.data() + y * width * 4;
+
+				// A whole row per tap keeps reads sequential
+				for (int x = 0; x < width; x++) { StoreTexel(out + x * 4, ZeroTexel()); }
+				for (int t = 0; t < taps.count; t++)
+				{
+					const float* in = rows.data() + (std::size_t)(taps.first + t) * width * 4;
+					for (int x = 0; x < width; x++)
+					{
+						StoreTexel(out + x * 4, MultiplyAdd(LoadTexel(out + x * 4), LoadTexel(in + x * 4), weights[t]));
+					}
+				}
+			}
+		});
+	}
+}
+
+void textures::GenerateMipChain(unsigned char* chain, int width, int height, int levels, bool srgb, MipFilter filter)
+{
+	if (levels <= 1) { return; }
+
+	std::vector<float> current, next;
+	ToLinear(chain, width, height, srgb, current);
+
+	unsigned char* level = chain + ImageSize(PixelFormat::RGBA8, width, height);
+	for (int l = 1; l < levels; l++)
+	{
+		int levelWidth = std::max(width >> 1, 1), levelHeight = std::max(height >> 1, 1);
+
+		if (filter == MipFilter::Box && width % 2 == 0 && height % 2 == 0) { HalveBox(current, width, next, levelWidth, levelHeight); }
+		else { Resample(current, width, height, next, levelWidth, levelHeight, filter); }
+
+		FromLinear(next, levelWidth, levelHeight, srgb, level);
+
+		level += ImageSize(PixelFormat::RGBA8, levelWidth, levelHeight);
+		width = levelWidth;
+		height = levelHeight;
+		std::swap(current, next);
+	}
+}
+
+void textures::RunMipBenchmark()
+{
+	std::cout << "Mip chain generation on " << jobs::ThreadCount() << " threads, sRGB\n";
+	std::cout << "size\tbox ms\tkaiser ms\tglGenerateMipmap ms\n";
+
+	for (int size = 256; size <= 4096; size *= 2)
+	{
+		const int levels = FullMipCount(size, size);
+		std::vector<unsigned char> chain(MipChainSize(PixelFormat::SRGB8_ALPHA8, size, size, levels));
+		for (std::size_t i = 0; i < ImageSize(PixelFormat::SRGB8_ALPHA8, size, size); i++) { chain[i] = (unsigned char)(i * 2654435761u >> 24); }
+
+		double milliseconds[2];
+		for (int f = 0; f < 2; f++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			GenerateMipChain(chain.data(), size, size, levels, true, f == 0 ? MipFilter::Box : MipFilter::Kaiser);
+			milliseconds[f] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		Texture texture = Create2D(size, size, PixelFormat::SRGB8_ALPHA8, levels);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, chain.data());
+		glFinish();
+
+		auto start = std::chrono::steady_clock::now();
+		GenerateMipmaps(texture);
+		glFinish();
+		double gpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		Release(texture);
+
+		std::cout << size << "x" << size << '\t' << milliseconds[0] << '\t' << milliseconds[1] << '\t' << gpuMilliseconds << '\n';
+	}
+
+	std::cout << std::flush;
+}
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "RasterKernels.h"
+#include "RasterShaders.h"
+
+#if RASTER_AVX2 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+	constexpr int HALF_PIXEL = raster::SUBPIXEL_SCALE / 2;
+
+	bool CpuHasAvx2()
+	{
+#if RASTER_AVX2 && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) { return false; }
+
+		// The OS has to save YMM registers too, not just the CPU have them
+		__cpuid(info, 1);
+		const bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+
+		__cpuidex(info, 7, 0);
+		return avx && (info[1] & (1 << 5));
+#elif RASTER_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+}
+
+bool raster::SetUpTriangle(const float* pixelX, const float* pixelY, int width, int height, int winding, TriangleSetup& setup)
+{
+	int x[3], y[3];
+	for (int v = 0; v < 3; v++)
+	{
+		x[v] = (int)std::lround(pixelX[v] * SUBPIXEL_SCALE);
+		y[v] = (int)std::lround(pixelY[v] * SUBPIXEL_SCALE);
+	}
+
+	// Make the winding positive so the inside of every edge is where it is positive.
+	// Like GL without face culling, both windings are drawn
+	const std::int64_t area = (std::int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (std::int64_t)(y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0 || (area > 0 ? winding < 0 : winding > 0)) { return false; }
+	if (area < 0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+	}
+
+	// Pixels whose centres the triangle's bounds contain
+	setup.minX = std::max((std::min({ x[0], x[1], x[2] }) - HALF_PIXEL + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS, 0);
+	setup.minY = std::max((std::min({ y[0], y[1], y[2] }) - HALF_PIXEL + SUBPIXEL_SCALE - 1) >> SUBPIXEL_BITS, 0);
+	setup.maxX = std::min((std::max({ x[0], x[1], x[2] }) - HALF_PIXEL) >> SUBPIXEL_BITS, width - 1);
+	setup.maxY = std::min((std::max({ y[0], y[1], y[2] }) - HALF_PIXEL) >> SUBPIXEL_BITS, height - 1);
+	if (setup.minX > setup.maxX || setup.minY > setup.maxY) { return false; }
+
+	for (int e = 0; e < 3; e++)
+	{
+		const int from = e, to = (e + 1) % 3;
+		setup.a[e] = y[from] - y[to];
+		setup.b[e] = x[to] - x[from];
+		setup.c[e] = (std::int64_t)x[from] * y[to] - (std::int64_t)y[from] * x[to];
+
+		// Top-left rule: pixel centres exactly on an edge only count for left and top edges
+		const bool topLeft = setup.a[e] > 0 || (setup.a[e] == 0 && setup.b[e] > 0);
+		if (!topLeft) { setup.c[e] -= 1; }
+	}
+
+	return true;
+}
+
+raster::Kernel raster::BestKernel()
+{
+	if (IsSupported(Kernel::Avx2)) { return Kernel::Avx2; }
+	if (IsSupported(Kernel::Sse2)) { return Kernel::Sse2; }
+	return Kernel::Scalar;
+}
+
+bool raster::IsSupported(Kernel kernel)
+{
+	static const bool avx2 = CpuHasAvx2();
+
+	switch (kernel)
+	{
+	case Kernel::Sse2: return RASTER_SSE2;
+	case Kernel::Avx2: return avx2;
+	default:           return true;
+	}
+}
+
+const char* raster::KernelName(Kernel kernel)
+{
+	switch (kernel)
+	{
+	case Kernel::Sse2: return "SSE2";
+	case Kernel::Avx2: return "AVX2";
+	default:           return "scalar";
+	}
+}
+
+void raster::RunRasterBenchmark()
+{
+	constexpr int FRAMEBUFFER_SIZE = 1024;
+	constexpr std::size_t PIXELS_PER_SIZE = 64 << 20;   // Rough coverage to draw per size so timings settle
+	const int triangleSizes[] = { 4, 16, 64, 256 };
+	const Kernel kernels[] = { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2 };
+
+	std::vector<std::uint32_t> pixels((std::size_t)FRAMEBUFFER_SIZE * FRAMEBUFFER_SIZE);
+	std::mt19937 random(1);
+
+	std::cout << "Rasterization kernels on one thread, " << FRAMEBUFFER_SIZE << "x" << FRAMEBUFFER_SIZE << " framebuffer\n";
+	std::cout << "size\tkernel\tMtriangles/s\tMpixels/s\n";
+
+	for (int size : triangleSizes)
+	{
+		// Random triangles inside size x size squares, about half of which they cover
+		std::uniform_real_distribution<float> corner(0.0f, (float)(FRAMEBUFFER_SIZE - size));
+		std::uniform_real_distribution<float> offset(0.0f, (float)size);
+
+		const std::size_t triangleCount = std::max<std::size_t>(PIXELS_PER_SIZE / (size * size / 2), 1) / 16;
+		std::vector<TriangleSetup> triangles;
+		while (triangles.size() < triangleCount)
+		{
+			const float left = corner(random), top = corner(random);
+			const float x[3] = { left + offset(random), left + offset(random), left + offset(random) };
+			const float y[3] = { top + offset(random), top + offset(random), top + offset(random) };
+
+			TriangleSetup setup;
+			if (SetUpTriangle(x, y, FRAMEBUFFER_SIZE, FRAMEBUFFER_SIZE, 0, setup))
+			{
+				// Nothing else needs draw here, so it holds each triangle's colour
+				setup.draw = (std::uint32_t)random();
+				triangles.push_back(setup);
+			}
+		}
+
+		for (Kernel kernel : kernels)
+		{
+			if (!IsSupported(kernel)) { continue; }
+
+			std::uint64_t written = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int repeat = 0; repeat < 16; repeat++)
+			{
+				for (const TriangleSetup& triangle : triangles)
+				{
+					for (int tileY = triangle.minY / TILE_SIZE * TILE_SIZE; tileY <= triangle.maxY; tileY += TILE_SIZE)
+					{
+						for (int tileX = triangle.minX / TILE_SIZE * TILE_SIZE; tileX <= triangle.maxX; tileX += TILE_SIZE)
+						{
+							written += RasterizeTriangle(kernel, triangle, tileX, tileY, pixels.data(), FRAMEBUFFER_SIZE,
+								GenericFragmentShader{ triangle.draw });
+						}
+					}
+				}
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << size << '\t' << KernelName(kernel) << '\t' << triangles.size() * 16 / seconds / 1e6
+				<< '\t' << written / seconds / 1e6 << '\n';
+		}
+	}
+
+	std::cout << std::flush;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file RasterKernels.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Triangle setup and the SIMD half-space kernels that find
+ *        which pixels of a tile a triangle covers
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RASTER_X86 1
+#else
+#define RASTER_X86 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define RASTER_SSE2 1
+#else
+#define RASTER_SSE2 0
+#endif
+
+// MSVC compiles AVX2 intrinsics anywhere. GCC and Clang need the functions using them marked
+#if RASTER_X86 && (defined(_MSC_VER) || defined(__GNUC__))
+#include <immintrin.h>
+#define RASTER_AVX2 1
+#else
+#define RASTER_AVX2 0
+#endif
+
+#if RASTER_AVX2 && !defined(_MSC_VER)
+#define RASTER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RASTER_TARGET_AVX2
+#endif
+
+namespace raster {
+
+	// Width and height of the screen tiles triangles are binned into
+	constexpr int TILE_SIZE = 64;
+
+	// Side of the blocks tiles are split into, accepted or rejected whole before testing pixels
+	constexpr int BLOCK_SIZE = 8;
+
+	// Largest framebuffer side. Keeps fixed point edge functions inside 32 bits per pixel step
+	constexpr int MAX_SIZE = 8192;
+
+	// Vertices snap to 1/16 pixel
+	constexpr int SUBPIXEL_BITS = 4;
+	constexpr int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+
+	// Edge functions E(x, y) = a * x + b * y + c over 1/16 pixel coordinates, positive inside
+	typedef struct TriangleSetup
+	{
+		int a[3];
+		int b[3];
+		std::int64_t c[3];    // Fill rule bias included
+		int minX, minY;       // Pixel bounds, inclusive, clipped to the framebuffer
+		int maxX, maxY;
+		std::uint32_t draw;   // Left to the caller, to find the triangle's shaders
+	} TriangleSetup;
+
+	// Edge e of triangle at the centre of a pixel
+	inline std::int64_t EvaluateEdge(const TriangleSetup& triangle, int e, int pixelX, int pixelY)
+	{
+		return (std::int64_t)triangle.a[e] * (pixelX * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) +
+			(std::int64_t)triangle.b[e] * (pixelY * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2) + triangle.c[e];
+	}
+
+	/**
+	* @brief            Snap a triangle and find its edge functions and bounds
+	*
+	* @param x, y       pixel coordinates of its 3 vertices, within MAX_SIZE of the origin
+	* @param winding    sign its area must have once snapped, 0 for either. Pieces of
+	*                   clipped triangles that flip are slivers that would overlap others
+	* @return           false if it covers no pixel centres of a width x height framebuffer
+	*/
+	bool SetUpTriangle(const float* x, const float* y, int width, int height, int winding, TriangleSetup& setup);
+
+	enum class Kernel
+	{
+		Scalar,
+		Sse2,   // 4 pixels at a time
+		Avx2    // 8 pixels, a whole block row, at a time
+	};
+
+	// Widest kernel the CPU and build support
+	Kernel BestKernel();
+	bool IsSupported(Kernel kernel);
+	const char* KernelName(Kernel kernel);
+
+	/**
+	* @brief    Time every supported kernel on one thread over triangles of a
+	*           range of sizes and print triangles/s and pixels/s. Needs no GL
+	*/
+	void RunRasterBenchmark();
+
+	/*
+	* Each 8x8 block of the tile inside the triangle's bounds is tested
+	* against every edge at its two corners furthest inside and outside
+	* it. Blocks outside any edge are skipped and blocks inside all of
+	* them are filled without looking at single pixels, so only blocks an
+	* edge passes through are tested pixel by pixel. Edge values are
+	* found once per tile in 64 bits and stepped by adding from there on,
+	* block to block, row to row and lane to lane, in 32 bits.
+	*
+	* The kernels are templates over the fragment shader (see
+	* RasterShaders.h) so each shader is compiled into them.
+	*/
+	namespace kernels {
+
+		// An edge whose value at a tile's first block is further from 0 than this has the
+		// same sign over the whole tile. Anything nearer stays inside 32 bits over the tile
+		constexpr std::int64_t TILE_EDGE_LIMIT = std::int64_t(1) << 30;
+
+		// Stands in for edges a tile is wholly inside, so they always pass
+		constexpr int INSIDE_EDGE = 1 << 30;
+
+		// Every pixel of a block row covered
+		constexpr unsigned int FULL_ROW = 0xFF;
+
+		// Where a partially covered block is and how its edges change across it
+		typedef struct BlockEdges
+		{
+			int values[3];        // At the block's first pixel
+			int stepX[3];         // From one pixel to the next
+			int stepY[3];         // From one row to the next
+			int x, y;             // Block's first pixel
+			int columns;          // Pixels of each row inside the triangle's bounds
+			int rows;
+		} BlockEdges;
+
+		template <typename FragmentShader>
+		std::uint32_t FlatColor(const FragmentShader& shader)
+		{
+			if constexpr (FragmentShader::IS_FLAT) { return shader.Color(); }
+			else { return 0; }
+		}
+
+		/*
+		* Each kernel fills a whole block with a flat colour, and the pixels
+		* of a partial block that are inside every edge, returning how many
+		* it wrote.
+		*/
+
+		typedef struct ScalarKernel
+		{
+			static void FillBlock(std::uint32_t* out, int stride, std::uint32_t color)
+			{
+				for (int row = 0; row < BLOCK_SIZE; row++, out += stride) { std::fill_n(out, BLOCK_SIZE, color); }
+			}
+
+			template <typename FragmentShader>
+			static std::uint64_t FillPartial(std::uint32_t* out, int stride, const BlockEdges& block, const FragmentShader& shader)
+			{
+				std::uint64_t written = 0;
+				std::uint32_t colors[BLOCK_SIZE];
+				std::fill_n(colors, BLOCK_SIZE, FlatColor(shader));
+				int rowValues[3] = { block.values[0], block.values[1], block.values[2] };
+
+				for (int row = 0; row < block.rows; row++, out += stride)
+				{
+					if constexpr (!FragmentShader::IS_FLAT) { shader.Shade(block.x, block.y + row, block.columns, colors); }
+
+					int values[3] = { rowValues[0], rowValues[1], rowValues[2] };
+					for (int x = 0; x < block.columns; x++)
+					{
+						if ((values[0] | values[1] | values[2]) >= 0)
+						{
+							out[x] = colors[x];
+							written++;
+						}
+						for (int e = 0; e < 3; e++) { values[e] += block.stepX[e]; }
+					}
+					for (int e = 0; e < 3; e++) { rowValues[e] += block.stepY[e]; }
+				}
+				return written;
+			}
+		} ScalarKernel;
+
+#if RASTER_SSE2
+		typedef struct Sse2Kernel
+		{
+			static void FillBlock(std::uint32_t* out, int stride, std::uint32_t color)
+			{
+				const __m128i colors = _mm_set1_epi32((int)color);
+				for (int row = 0; row < BLOCK_SIZE; row++, out += stride)
+				{
+					_mm_storeu_si128((__m128i*)out, colors);
+					_mm_storeu_si128((__m128i*)(out + 4), colors);
+				}
+			}
+
+			// Blend colors into the 4 pixels at out where inside is set
+			static std::uint64_t Blend(std::uint32_t* out, __m128i inside, __m128i colors)
+			{
+				const int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+				if (mask == 0) { return 0; }
+
+				if (mask == 0xF) { _mm_storeu_si128((__m128i*)out, colors); }
+				else
+				{
+					__m128i old = _mm_loadu_si128((const __m128i*)out);
+					_mm_storeu_si128((__m128i*)out, _mm_or_si128(_mm_and_si128(inside, colors), _mm_andnot_si128(inside, old)));
+				}
+				return std::popcount((unsigned int)mask);
+			}
+
+			template <typename FragmentShader>
+			static std::uint64_t FillPartial(std::uint32_t* out, int stride, const BlockEdges& block, const FragmentShader& shader)
+			{
+				const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+				const __m128i columns = _mm_set1_epi32(block.columns);
+				const __m128i leftColumns = _mm_cmplt_epi32(lanes, columns);
+				const __m128i rightColumns = _mm_cmplt_epi32(_mm_add_epi32(lanes, _mm_set1_epi32(4)), columns);
+				__m128i leftColors = _mm_set1_epi32((int)FlatColor(shader)), rightColors = leftColors;
+
+				// Left and right halves of the row, stepped down the block
+				__m128i left[3], right[3], stepY[3];
+				for (int e = 0; e < 3; e++)
+				{
+					const int stepX = block.stepX[e];
+					left[e] = _mm_setr_epi32(block.values[e], block.values[e] + stepX, block.values[e] + stepX * 2, block.values[e] + stepX * 3);
+					right[e] = _mm_add_epi32(left[e], _mm_set1_epi32(stepX * 4));
+					stepY[e] = _mm_set1_epi32(block.stepY[e]);
+				}
+
+				std::uint64_t written = 0;
+				for (int row = 0; row < block.rows; row++, out += stride)
+				{
+					// A negative edge sets the sign bit, which the arithmetic shift spreads over the lane
+					__m128i leftOutside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(left[0], left[1]), left[2]), 31);
+					__m128i rightOutside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(right[0], right[1]), right[2]), 31);
+					__m128i leftInside = _mm_andnot_si128(leftOutside, leftColumns);
+					__m128i rightInside = _mm_andnot_si128(rightOutside, rightColumns);
+
+					if constexpr (!FragmentShader::IS_FLAT)
+					{
+						if (_mm_movemask_epi8(_mm_or_si128(leftInside, rightInside)))
+						{
+							alignas(16) std::uint32_t colors[BLOCK_SIZE] = {};
+							shader.Shade(block.x, block.y + row, block.columns, colors);
+							leftColors = _mm_load_si128((const __m128i*)colors);
+							rightColors = _mm_load_si128((const __m128i*)(colors + 4));
+						}
+					}
+
+					written += Blend(out, leftInside, leftColors);
+					written += Blend(out + 4, rightInside, rightColors);
+
+					for (int e = 0; e < 3; e++)
+					{
+						left[e] = _mm_add_epi32(left[e], stepY[e]);
+						right[e] = _mm_add_epi32(right[e], stepY[e]);
+					}
+				}
+				return written;
+			}
+		} Sse2Kernel;
+#endif
+
+#if RASTER_AVX2
+		typedef struct Avx2Kernel
+		{
+			RASTER_TARGET_AVX2 static void FillBlock(std::uint32_t* out, int stride, std::uint32_t color)
+			{
+				const __m256i colors = _mm256_set1_epi32((int)color);
+				for (int row = 0; row < BLOCK_SIZE; row++, out += stride) { _mm256_storeu_si256((__m256i*)out, colors); }
+			}
+
+			template <typename FragmentShader>
+			RASTER_TARGET_AVX2 static std::uint64_t FillPartial(std::uint32_t* out, int stride, const BlockEdges& block,
+				const FragmentShader& shader)
+			{
+				const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+				const __m256i columns = _mm256_cmpgt_epi32(_mm256_set1_epi32(block.columns), lanes);
+				__m256i colors = _mm256_set1_epi32((int)FlatColor(shader));
+
+				// One register holds a whole block row
+				__m256i values[3], stepY[3];
+				for (int e = 0; e < 3; e++)
+				{
+					values[e] = _mm256_add_epi32(_mm256_set1_epi32(block.values[e]), _mm256_mullo_epi32(_mm256_set1_epi32(block.stepX[e]), lanes));
+					stepY[e] = _mm256_set1_epi32(block.stepY[e]);
+				}
+
+				std::uint64_t written = 0;
+				for (int row = 0; row < block.rows; row++, out += stride)
+				{
+					__m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(values[0], values[1]), values[2]), 31);
+					__m256i inside = _mm256_andnot_si256(outside, columns);
+					for (int e = 0; e < 3; e++) { values[e] = _mm256_add_epi32(values[e], stepY[e]); }
+
+					const unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(inside));
+					if (mask == 0) { continue; }
+
+					if constexpr (!FragmentShader::IS_FLAT)
+					{
+						alignas(32) std::uint32_t shaded[BLOCK_SIZE] = {};
+						shader.Shade(block.x, block.y + row, block.columns, shaded);
+						colors = _mm256_load_si256((const __m256i*)shaded);
+					}
+
+					if (mask == FULL_ROW) { _mm256_storeu_si256((__m256i*)out, colors); }
+					else { _mm256_maskstore_epi32((int*)out, inside, colors); }
+					written += std::popcount(mask);
+				}
+				return written;
+			}
+		} Avx2Kernel;
+#endif
+
+		// Walk the blocks of the tile inside the triangle's bounds, handing partial ones to the kernel
+		template <typename KernelType, typename FragmentShader>
+		std::uint64_t RasterizeBlocks(const TriangleSetup& triangle, int tileX, int tileY, std::uint32_t* pixels, int stride,
+			const FragmentShader& shader)
+		{
+			// Blocks start aligned inside the tile, and end with the bounds
+			const int firstX = std::max(triangle.minX, tileX) & ~(BLOCK_SIZE - 1);
+			const int firstY = std::max(triangle.minY, tileY) & ~(BLOCK_SIZE - 1);
+			const int lastX = std::min(triangle.maxX, tileX + TILE_SIZE - 1);
+			const int lastY = std::min(triangle.maxY, tileY + TILE_SIZE - 1);
+
+			BlockEdges block;
+			int blockStepX[3], blockStepY[3], acceptOffset[3], rejectOffset[3], rowValues[3];
+			for (int e = 0; e < 3; e++)
+			{
+				const std::int64_t value = EvaluateEdge(triangle, e, firstX, firstY);
+				if (value < -TILE_EDGE_LIMIT) { return 0; }
+
+				if (value > TILE_EDGE_LIMIT)
+				{
+					rowValues[e] = INSIDE_EDGE;
+					block.stepX[e] = block.stepY[e] = 0;
+				}
+				else
+				{
+					rowValues[e] = (int)value;
+					block.stepX[e] = triangle.a[e] * SUBPIXEL_SCALE;
+					block.stepY[e] = triangle.b[e] * SUBPIXEL_SCALE;
+				}
+
+				blockStepX[e] = block.stepX[e] * BLOCK_SIZE;
+				blockStepY[e] = block.stepY[e] * BLOCK_SIZE;
+
+				// From a block's first pixel to its pixels least and most inside the edge
+				const int acrossX = block.stepX[e] * (BLOCK_SIZE - 1), acrossY = block.stepY[e] * (BLOCK_SIZE - 1);
+				acceptOffset[e] = std::min(acrossX, 0) + std::min(acrossY, 0);
+				rejectOffset[e] = std::max(acrossX, 0) + std::max(acrossY, 0);
+			}
+
+			std::uint64_t written = 0;
+			for (block.y = firstY; block.y <= lastY; block.y += BLOCK_SIZE)
+			{
+				for (int e = 0; e < 3; e++) { block.values[e] = rowValues[e]; }
+				block.rows = std::min(BLOCK_SIZE, lastY - block.y + 1);
+
+				for (block.x = firstX; block.x <= lastX; block.x += BLOCK_SIZE)
+				{
+					bool rejected = false, accepted = true;
+					for (int e = 0; e < 3; e++)
+					{
+						rejected |= block.values[e] + rejectOffset[e] < 0;
+						accepted &= block.values[e] + acceptOffset[e] >= 0;
+					}
+
+					if (!rejected)
+					{
+						std::uint32_t* out = pixels + (std::size_t)block.y * stride + block.x;
+						block.columns = std::min(BLOCK_SIZE, lastX - block.x + 1);
+
+						if (accepted && block.columns == BLOCK_SIZE && block.rows == BLOCK_SIZE)
+						{
+							// Covered blocks are shaded straight into the framebuffer
+							if constexpr (FragmentShader::IS_FLAT) { KernelType::FillBlock(out, stride, shader.Color()); }
+							else
+							{
+								for (int row = 0; row < BLOCK_SIZE; row++) { shader.Shade(block.x, block.y + row, BLOCK_SIZE, out + (std::size_t)row * stride); }
+							}
+							written += BLOCK_SIZE * BLOCK_SIZE;
+						}
+						else { written += KernelType::FillPartial(out, stride, block, shader); }
+					}
+
+					for (int e = 0; e < 3; e++) { block.values[e] += blockStepX[e]; }
+				}
+
+				for (int e = 0; e < 3; e++) { rowValues[e] += blockStepY[e]; }
+			}
+
+			return written;
+		}
+	}
+
+	/**
+	* @brief            Shade the pixels triangle covers in one tile
+	*
+	* @param tileX      pixel position of the tile, a multiple of TILE_SIZE
+	* @param pixels     framebuffer's first pixel, with stride pixels per row
+	* @param shader     fragment shader, see RasterShaders.h
+	* @return           pixels written
+	*/
+	template <typename FragmentShader>
+	std::uint64_t RasterizeTriangle(Kernel kernel, const TriangleSetup& triangle, int tileX, int tileY,
+		std::uint32_t* pixels, int stride, const FragmentShader& shader)
+	{
+		switch (kernel)
+		{
+#if RASTER_AVX2
+		case Kernel::Avx2: return kernels::RasterizeBlocks<kernels::Avx2Kernel>(triangle, tileX, tileY, pixels, stride, shader);
+#endif
+#if RASTER_SSE2
+		case Kernel::Sse2: return kernels::RasterizeBlocks<kernels::Sse2Kernel>(triangle, tileX, tileY, pixels, stride, shader);
+#endif
+		default:           return kernels::RasterizeBlocks<kernels::ScalarKernel>(triangle, tileX, tileY, pixels, stride, shader);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/**
+ * @file RasterShaders.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Shaders of the software rasterizer, written as C++ functors
+ *        so each one is compiled into the loops that run it
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "Mesh.h"
+
+namespace raster {
+
+	// RGBA8 packed so its bytes are R, G, B, A in memory, like GL_RGBA/GL_UNSIGNED_BYTE
+	inline std::uint32_t PackColor(const float rgba[4])
+	{
+		std::uint32_t packed = 0;
+		for (int c = 0; c < 4; c++) { packed |= (std::uint32_t)(std::clamp(rgba[c], 0.0f, 1.0f) * 255.0f + 0.5f) << (c * 8); }
+		return packed;
+	}
+
+	// gl_Position. z and w are left out as nothing is depth tested or projected
+	typedef struct ClipPosition
+	{
+		float x, y;
+	} ClipPosition;
+
+	/*
+	* Draws take their shaders as template parameters rather than through
+	* virtual calls, so a shader is inlined into the setup loop or the
+	* rasterization kernel running it and costs no more than code written
+	* for it by hand.
+	*
+	* A vertex shader is called as shader(vertex) on each vertex of the
+	* draw's vertex type and returns its ClipPosition.
+	*
+	* A fragment shader sets IS_FLAT. A flat shader gives a whole draw one
+	* colour through Color(), so the kernels fill covered blocks with plain
+	* stores of it, as fast as clearing memory. Otherwise the shader's
+	* Shade(x, y, count, colors) writes the colours of count pixels of row
+	* y from pixel x on, and the kernels mask the ones the triangle covers
+	* into the framebuffer. Colours are packed like PackColor.
+	*/
+
+	// Shaders/generic_vertex_shader.vert: gl_Position = position + u_Offset
+	typedef struct GenericVertexShader
+	{
+		float u_Offset[2] = { 0.0f, 0.0f };
+
+		ClipPosition operator()(const PositionVertex2D& vertex) const { return ClipPosition{ vertex.posX + u_Offset[0], vertex.posY + u_Offset[1] }; }
+	} GenericVertexShader;
+
+	// Shaders/generic_fragment_shader.frag: color = u_Color
+	typedef struct GenericFragmentShader
+	{
+		static constexpr bool IS_FLAT = true;
+
+		std::uint32_t u_Color;
+
+		std::uint32_t Color() const { return u_Color; }
+	} GenericFragmentShader;
+}
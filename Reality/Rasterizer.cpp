@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include "JobSystem.h"
+#include "Rasterizer.h"
+
+namespace {
+
+	// Triangles reaching further than this from the origin, in pixels, are clipped
+	// to it. Snapped coordinates then fit 18 bits, so edge function steps across a
+	// whole tile fit 30
+	constexpr float GUARD_BAND = (float)raster::MAX_SIZE;
+
+	constexpr std::size_t TRIANGLES_PER_CHUNK = 4096;
+
+	// Most vertices a triangle can have after clipping to the guard band's 4 sides
+	constexpr int MAX_CLIPPED_VERTICES = 7;
+
+	typedef struct Vertex
+	{
+		float x, y;
+	} Vertex;
+
+	// Sutherland-Hodgman against one side of the guard band
+	int ClipPolygon(const Vertex* in, int count, Vertex* out, int axis, float sign)
+	{
+		int outCount = 0;
+		for (int i = 0; i < count; i++)
+		{
+			const Vertex& current = in[i];
+			const Vertex& next = in[(i + 1) % count];
+			const float currentDistance = GUARD_BAND - sign * (axis == 0 ? current.x : current.y);
+			const float nextDistance = GUARD_BAND - sign * (axis == 0 ? next.x : next.y);
+
+			if (currentDistance >= 0.0f) { out[outCount++] = current; }
+			if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				const float t = currentDistance / (currentDistance - nextDistance);
+				out[outCount++] = Vertex{ current.x + (next.x - current.x) * t, current.y + (next.y - current.y) * t };
+			}
+		}
+		return outCount;
+	}
+}
+
+raster::Rasterizer::Rasterizer(int width, int height)
+{
+	Resize(width, height);
+}
+
+void raster::Rasterizer::Resize(int newWidth, int newHeight)
+{
+	width  = std::clamp(newWidth, 1, MAX_SIZE);
+	height = std::clamp(newHeight, 1, MAX_SIZE);
+	tilesWide = (width + TILE_SIZE - 1) / TILE_SIZE;
+	tilesHigh = (height + TILE_SIZE - 1) / TILE_SIZE;
+	stride = tilesWide * TILE_SIZE;
+	pixels.assign((std::size_t)stride * tilesHigh * TILE_SIZE, 0);
+}
+
+void raster::Rasterizer::Clear(const float color[4])
+{
+	clearColor = PackColor(color);
+}
+
+void raster::Rasterizer::DrawIndexed(std::span<const PositionVertex2D> vertices, const void* indices,
+	std::size_t indexCount, std::size_t indexStride, const float color[4])
+{
+	DrawIndexed(vertices, indices, indexCount, indexStride, GenericVertexShader(), GenericFragmentShader{ PackColor(color) });
+}
+
+void raster::Rasterizer::Draw(const mesh::IndexedMesh& mesh, const float color[4])
+{
+	DrawIndexed(mesh.vertices, mesh.indices.Data(), mesh.indices.Count(), mesh.indices.Stride(), color);
+}
+
+void raster::Rasterizer::Finish()
+{
+	const std::size_t tileCount = (std::size_t)tilesWide * tilesHigh;
+	activeChunks = (queuedTriangles + TRIANGLES_PER_CHUNK - 1) / TRIANGLES_PER_CHUNK;
+
+	if (chunks.size() < activeChunks) { chunks.resize(activeChunks); }
+	for (std::size_t c = 0; c < activeChunks; c++)
+	{
+		chunks[c].triangles.clear();
+		chunks[c].bins.resize(tileCount);
+		for (std::vector<std::uint32_t>& bin : chunks[c].bins) { bin.clear(); }
+	}
+
+	jobs::ParallelFor(activeChunks, 1, [this](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t c = begin; c < end; c++)
+		{
+			SetUpChunk(chunks[c], c * TRIANGLES_PER_CHUNK, std::min((c + 1) * TRIANGLES_PER_CHUNK, queuedTriangles));
+		}
+	});
+
+	std::atomic<std::uint64_t> binned = 0, written = 0;
+	jobs::ParallelFor(tileCount, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t tile = begin; tile < end; tile++)
+		{
+			std::uint64_t tileBinned = 0, tileWritten = 0;
+			RasterizeTile((int)tile, tileBinned, tileWritten);
+			binned += tileBinned;
+			written += tileWritten;
+		}
+	});
+
+	stats.triangles += queuedTriangles;
+	stats.binned += binned;
+	stats.pixels += written;
+
+	draws.clear();
+	queuedTriangles = 0;
+}
+
+void raster::Rasterizer::SetUpChunk(Chunk& chunk, std::size_t firstTriangle, std::size_t lastTriangle)
+{
+	// Last draw starting at or before the chunk's first triangle
+	std::size_t drawIndex = std::upper_bound(draws.begin(), draws.end(), firstTriangle,
+		[](std::size_t triangle, const DrawCall& draw) { return triangle < draw.firstTriangle; }) - draws.begin() - 1;
+
+	// Each draw's share of the chunk goes through the setup loop its vertex shader was compiled into
+	for (std::size_t triangle = firstTriangle; triangle < lastTriangle; drawIndex++)
+	{
+		const DrawCall& draw = draws[drawIndex];
+		const std::size_t end = std::min(draw.firstTriangle + draw.triangleCount, lastTriangle);
+
+		(this->*draw.setUp)(chunk, (std::uint32_t)drawIndex, triangle - draw.firstTriangle, end - draw.firstTriangle);
+		triangle = end;
+	}
+}
+
+void raster::Rasterizer::SetUpClipTriangle(Chunk& chunk, const ClipPosition* positions, std::uint32_t draw)
+{
+	Vertex polygon[MAX_CLIPPED_VERTICES];
+	bool insideGuardBand = true;
+	for (int v = 0; v < 3; v++)
+	{
+		// Clip space to pixels, with the top row first
+		polygon[v] = Vertex{ (positions[v].x * 0.5f + 0.5f) * width, (0.5f - positions[v].y * 0.5f) * height };
+
+		if (!std::isfinite(polygon[v].x) || !std::isfinite(polygon[v].y)) { return; }
+		insideGuardBand &= std::fabs(polygon[v].x) <= GUARD_BAND && std::fabs(polygon[v].y) <= GUARD_BAND;
+	}
+
+	if (insideGuardBand)
+	{
+		const float x[3] = { polygon[0].x, polygon[1].x, polygon[2].x }, y[3] = { polygon[0].y, polygon[1].y, polygon[2].y };
+		SetUpTriangle(chunk, x, y, draw);
+		return;
+	}
+
+	const float area = (polygon[1].x - polygon[0].x) * (polygon[2].y - polygon[0].y) - (polygon[1].y - polygon[0].y) * (polygon[2].x - polygon[0].x);
+	const int winding = area > 0.0f ? 1 : -1;
+
+	Vertex clipped[MAX_CLIPPED_VERTICES];
+	int count = ClipPolygon(polygon, 3, clipped, 0, 1.0f);
+	count = ClipPolygon(clipped, count, polygon, 0, -1.0f);
+	count = ClipPolygon(polygon, count, clipped, 1, 1.0f);
+	count = ClipPolygon(clipped, count, polygon, 1, -1.0f);
+
+	for (int v = 2; v < count; v++)
+	{
+		const float x[3] = { polygon[0].x, polygon[v - 1].x, polygon[v].x }, y[3] = { polygon[0].y, polygon[v - 1].y, polygon[v].y };
+		SetUpTriangle(chunk, x, y, draw, winding);
+	}
+}
+
+void raster::Rasterizer::SetUpTriangle(Chunk& chunk, const float* x, const float* y, std::uint32_t draw, int winding)
+{
+	TriangleSetup setup;
+	if (!raster::SetUpTriangle(x, y, width, height, winding, setup)) { return; }
+
+	setup.draw = draw;
+	chunk.triangles.push_back(setup);
+	Bin(chunk, setup);
+}
+
+void raster::Rasterizer::Bin(Chunk& chunk, const TriangleSetup& triangle)
+{
+	const std::uint32_t index = (std::uint32_t)chunk.triangles.size() - 1;
+	const int firstTileX = triangle.minX / TILE_SIZE, lastTileX = triangle.maxX / TILE_SIZE;
+	const int firstTileY = triangle.minY / TILE_SIZE, lastTileY = triangle.maxY / TILE_SIZE;
+
+	for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+	{
+		for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+		{
+			// Skip tiles inside the bounds but wholly outside an edge, tested at the tile's
+			// pixel furthest inside that edge
+			bool overlaps = true;
+			for (int e = 0; e < 3 && overlaps; e++)
+			{
+				const int cornerX = triangle.a[e] > 0 ? tileX * TILE_SIZE + TILE_SIZE - 1 : tileX * TILE_SIZE;
+				const int cornerY = triangle.b[e] > 0 ? tileY * TILE_SIZE + TILE_SIZE - 1 : tileY * TILE_SIZE;
+				overlaps = EvaluateEdge(triangle, e, cornerX, cornerY) >= 0;
+			}
+
+			if (overlaps) { chunk.bins[(std::size_t)tileY * tilesWide + tileX].push_back(index); }
+		}
+	}
+}
+
+void raster::Rasterizer::RasterizeTile(int tile, std::uint64_t& binned, std::uint64_t& written)
+{
+	const int tileX = tile % tilesWide * TILE_SIZE, tileY = tile / tilesWide * TILE_SIZE;
+
+	for (int row = 0; row < TILE_SIZE; row++)
+	{
+		std::fill_n(pixels.data() + (std::size_t)(tileY + row) * stride + tileX, TILE_SIZE, clearColor);
+	}
+
+	for (std::size_t c = 0; c < activeChunks; c++)
+	{
+		const Chunk& chunk = chunks[c];
+		for (std::uint32_t index : chunk.bins[tile])
+		{
+			const TriangleSetup& triangle = chunk.triangles[index];
+			const DrawCall& draw = draws[triangle.draw];
+			binned++;
+			written += draw.rasterize(kernel, triangle, tileX, tileY, pixels.data(), stride, draw.fragmentShader.get());
+		}
+	}
+}
@@ -0,0 +1,212 @@
+/**
+ * @file Rasterizer.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Tile based software rasterizer, used in place of GL when
+ *        there is no GPU driver to create a context with
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "Mesh.h"
+#include "RasterKernels.h"
+#include "RasterShaders.h"
+
+namespace raster {
+
+	typedef struct RasterStats
+	{
+		std::uint64_t triangles = 0;  // Triangles submitted
+		std::uint64_t binned    = 0;  // Triangle and tile pairs rasterized
+		std::uint64_t pixels    = 0;  // Pixels written
+	} RasterStats;
+
+	/*
+	* Draws are only recorded until Finish. Finish first sets triangles up
+	* and bins them into the tiles their bounds overlap, in chunks of
+	* triangles spread over the job system, each chunk with its own bins.
+	* Then every tile is cleared and rasterized by one job, walking the
+	* chunks' bins in submission order so overlapping triangles land in
+	* the order they were drawn. A tile stays in cache for all of its
+	* triangles and no two jobs write the same pixel, so nothing locks.
+	*
+	* Vertices are snapped to 1/16 pixel and covered pixels are found with
+	* edge functions, 8x8 blocks at a time by the widest SIMD kernel the
+	* CPU has (see RasterKernels.h), with the top-left fill rule so
+	* triangles sharing an edge never both draw a pixel on it.
+	* Triangles reaching far outside the screen are clipped to a guard
+	* band first, which keeps the fixed point maths exact.
+	*
+	* Each draw keeps copies of its shaders and pointers to the setup loop
+	* and kernels instantiated for them, so shaders are inlined while draws
+	* of different shaders still share one queue.
+	*/
+	class Rasterizer
+	{
+	public:
+		Rasterizer(int width, int height);
+
+		Rasterizer(const Rasterizer&) = delete;
+		Rasterizer& operator=(const Rasterizer&) = delete;
+
+		// Resize the framebuffer, clamped to MAX_SIZE. Contents are undefined until the next Finish
+		void Resize(int width, int height);
+
+		// Colour every pixel is cleared to at the start of the next Finish
+		void Clear(const float color[4]);
+
+		/**
+		* @brief                Queue the triangles of an indexed mesh, drawn with a
+		*                       vertex and fragment shader (see RasterShaders.h)
+		*
+		* @param vertices       vertex stream of the type vertexShader takes. It and
+		*                       indices must stay valid until Finish
+		* @param indices        packed index stream of triangles
+		* @param indexStride    2 or 4 byte indices
+		*/
+		template <typename Vertex, typename VertexShader, typename FragmentShader>
+		void DrawIndexed(std::span<const Vertex> vertices, const void* indices, std::size_t indexCount, std::size_t indexStride,
+			const VertexShader& vertexShader, const FragmentShader& fragmentShader);
+
+		/**
+		* @brief                Queue the triangles of an indexed mesh with the generic
+		*                       shaders, the same streams mesh::Upload takes
+		*
+		* @param color          flat colour, as the generic fragment shader's u_Color
+		*/
+		void DrawIndexed(std::span<const PositionVertex2D> vertices, const void* indices,
+			std::size_t indexCount, std::size_t indexStride, const float color[4]);
+
+		void Draw(const mesh::IndexedMesh& mesh, const float color[4]);
+
+		// Rasterize every queued draw and return once the frame is complete
+		void Finish();
+
+		// Rows of Width() pixels, Stride() pixels apart, top row first
+		const std::uint32_t* Pixels() const { return pixels.data(); }
+		int Width() const { return width; }
+		int Height() const { return height; }
+		int Stride() const { return stride; }
+
+		// Kernel tiles are rasterized with, BestKernel() to start with
+		void SetKernel(Kernel newKernel) { if (IsSupported(newKernel)) { kernel = newKernel; } }
+		Kernel GetKernel() const { return kernel; }
+
+		RasterStats Stats() const { return stats; }
+		void ResetStats() { stats = RasterStats(); }
+
+	private:
+		// A run of consecutive triangles, set up and binned by one job
+		typedef struct Chunk
+		{
+			std::vector<TriangleSetup> triangles;
+			std::vector<std::vector<std::uint32_t>> bins;  // Per tile, indices into triangles
+		} Chunk;
+
+		typedef struct DrawCall
+		{
+			const void* vertices;
+			std::size_t vertexCount;
+			const void* indices;
+			std::size_t triangleCount;
+			std::size_t indexStride;
+			std::size_t firstTriangle;  // Of every draw this frame
+
+			std::shared_ptr<const void> vertexShader;
+			std::shared_ptr<const void> fragmentShader;
+
+			// Setup and rasterization with the draw's shaders compiled in
+			void (Rasterizer::*setUp)(Chunk& chunk, std::uint32_t draw, std::size_t firstTriangle, std::size_t lastTriangle);
+			std::uint64_t (*rasterize)(Kernel kernel, const TriangleSetup& triangle, int tileX, int tileY,
+				std::uint32_t* pixels, int stride, const void* shader);
+		} DrawCall;
+
+		void SetUpChunk(Chunk& chunk, std::size_t firstTriangle, std::size_t lastTriangle);
+
+		// Run the vertex shader over triangles [firstTriangle, lastTriangle) of a draw
+		template <typename Vertex, typename VertexShader>
+		void SetUpDraw(Chunk& chunk, std::uint32_t draw, std::size_t firstTriangle, std::size_t lastTriangle);
+
+		template <typename FragmentShader>
+		static std::uint64_t RasterizeDraw(Kernel kernel, const TriangleSetup& triangle, int tileX, int tileY,
+			std::uint32_t* pixels, int stride, const void* shader);
+
+		// Take a triangle from clip space to pixels, clipping it to the guard band if it reaches past it
+		void SetUpClipTriangle(Chunk& chunk, const ClipPosition* positions, std::uint32_t draw);
+
+		/**
+		* @brief            Snap a triangle, find its edge functions and bin it
+		*
+		* @param x, y       pixel coordinates of its 3 vertices
+		* @param winding    sign its area must have once snapped, 0 for either. Pieces of
+		*                   clipped triangles that flip are slivers that would overlap others
+		*/
+		void SetUpTriangle(Chunk& chunk, const float* x, const float* y, std::uint32_t draw, int winding = 0);
+		void Bin(Chunk& chunk, const TriangleSetup& triangle);
+		void RasterizeTile(int tile, std::uint64_t& binned, std::uint64_t& written);
+
+		int width  = 0;
+		int height = 0;
+		int stride = 0;
+		int tilesWide = 0;
+		int tilesHigh = 0;
+		std::vector<std::uint32_t> pixels;  // Padded to whole tiles so blocks never need bounds checks
+		Kernel kernel = BestKernel();
+
+		std::uint32_t clearColor = 0;
+		std::vector<DrawCall> draws;
+		std::size_t queuedTriangles = 0;
+		std::vector<Chunk> chunks;
+		std::size_t activeChunks = 0;         // Chunks holding this frame's triangles
+		RasterStats stats;
+	};
+}
+
+template <typename Vertex, typename VertexShader, typename FragmentShader>
+void raster::Rasterizer::DrawIndexed(std::span<const Vertex> vertices, const void* indices, std::size_t indexCount,
+	std::size_t indexStride, const VertexShader& vertexShader, const FragmentShader& fragmentShader)
+{
+	if (indexCount < 3 || (indexStride != sizeof(unsigned short) && indexStride != sizeof(unsigned int))) { return; }
+
+	draws.push_back(DrawCall{ vertices.data(), vertices.size(), indices, indexCount / 3, indexStride, queuedTriangles,
+		std::make_shared<const VertexShader>(vertexShader), std::make_shared<const FragmentShader>(fragmentShader),
+		&Rasterizer::SetUpDraw<Vertex, VertexShader>, &Rasterizer::RasterizeDraw<FragmentShader> });
+	queuedTriangles += indexCount / 3;
+}
+
+template <typename Vertex, typename VertexShader>
+void raster::Rasterizer::SetUpDraw(Chunk& chunk, std::uint32_t draw, std::size_t firstTriangle, std::size_t lastTriangle)
+{
+	const DrawCall& call = draws[draw];
+	const Vertex* vertices = (const Vertex*)call.vertices;
+	const VertexShader& shader = *(const VertexShader*)call.vertexShader.get();
+
+	for (std::size_t triangle = firstTriangle; triangle < lastTriangle; triangle++)
+	{
+		ClipPosition positions[3];
+		bool valid = true;
+		for (int v = 0; v < 3 && valid; v++)
+		{
+			const std::size_t index = call.indexStride == sizeof(unsigned short) ?
+				((const unsigned short*)call.indices)[triangle * 3 + v] : ((const unsigned int*)call.indices)[triangle * 3 + v];
+			valid = index < call.vertexCount;
+			if (valid) { positions[v] = shader(vertices[index]); }
+		}
+
+		if (valid) { SetUpClipTriangle(chunk, positions, draw); }
+	}
+}
+
+template <typename FragmentShader>
+std::uint64_t raster::Rasterizer::RasterizeDraw(Kernel kernel, const TriangleSetup& triangle, int tileX, int tileY,
+	std::uint32_t* pixels, int stride, const void* shader)
+{
+	return RasterizeTriangle(kernel, triangle, tileX, tileY, pixels, stride, *(const FragmentShader*)shader);
+}
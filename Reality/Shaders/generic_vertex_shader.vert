@@ -1,7 +1,9 @@
 #version 330 core
 
 layout(location = 0) in vec4 position;
+uniform vec2 u_Offset;
+
 void main() 
 {
-    gl_Position = position;
+    gl_Position = position + vec4(u_Offset, 0.0, 0.0);
 };
\ No newline at end of file
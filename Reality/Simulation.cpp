@@ -0,0 +1,63 @@
+#include <algorithm>
+#include "Simulation.h"
+
+namespace {
+
+	// How far the colour turns each step
+	const Vec3f COLOR_ROTATOR = { 0.001f, 0.0002f, 0.0015f };
+
+	// Channels wrap from 1 back to 0, so interpolate the short way across the wrap
+	float InterpolateChannel(float previous, float current, float alpha)
+	{
+		if (current < previous) { current += 1.0f; }
+
+		float value = previous + (current - previous) * alpha;
+		return value > 1.0f ? value - 1.0f : value;
+	}
+}
+
+void sim::Update(State& state)
+{
+	colors::RotateColor_s(state.color, COLOR_ROTATOR);
+}
+
+sim::State sim::Interpolate(const State& previous, const State& current, double alpha)
+{
+	State state = current;
+	for (int c = 0; c < 3; c++) { state.color.rgba[c] = InterpolateChannel(previous.color.rgba[c], current.color.rgba[c], (float)alpha); }
+	return state;
+}
+
+sim::FixedTimestep::FixedTimestep(double step, double maxFrame, int maxSteps)
+	: stepSeconds(step), maxFrameSeconds(maxFrame), maxStepsPerFrame(std::max(maxSteps, 1))
+{
+}
+
+int sim::FixedTimestep::Advance(double frameSeconds)
+{
+	stats.frames++;
+
+	const double clamped = std::clamp(frameSeconds, 0.0, maxFrameSeconds);
+	stats.droppedSeconds += std::max(frameSeconds - clamped, 0.0);
+	accumulator += clamped;
+
+	int steps = (int)(accumulator / stepSeconds);
+	if (steps > maxStepsPerFrame)
+	{
+		// Keep the fraction of a step so the frame still lands between steps where it should
+		const double excess = (steps - maxStepsPerFrame) * stepSeconds;
+		stats.droppedSeconds += excess;
+		accumulator -= excess;
+		steps = maxStepsPerFrame;
+	}
+
+	accumulator -= steps * stepSeconds;
+	stats.steps += steps;
+	return steps;
+}
+
+double sim::FixedTimestep::Alpha() const
+{
+	// Rounding can leave the accumulator a hair outside a step
+	return std::clamp(accumulator / stepSeconds, 0.0, 1.0);
+}
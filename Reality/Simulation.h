@@ -0,0 +1,83 @@
+/**
+ * @file Simulation.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Scene state advanced in fixed timesteps, independently of
+ *        the framerate, and interpolated between steps for drawing
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstdint>
+#include "Colors.h"
+
+namespace sim {
+
+	// Steps a second. The colour moves as far a step as it used to a frame at 60 fps
+	constexpr double STEPS_PER_SECOND = 60.0;
+	constexpr double STEP_SECONDS = 1.0 / STEPS_PER_SECOND;
+
+	// Everything the scene animates
+	typedef struct State
+	{
+		Color color = colors::Red;
+	} State;
+
+	// Advance state by one step
+	void Update(State& state);
+
+	/**
+	* @brief            State drawn between two steps
+	*
+	* @param alpha      how far from previous to current, in [0, 1]
+	*/
+	State Interpolate(const State& previous, const State& current, double alpha);
+
+	typedef struct TimestepStats
+	{
+		std::uint64_t steps = 0;
+		std::uint64_t frames = 0;
+		double droppedSeconds = 0.0;  // Time not simulated because frames were too long
+	} TimestepStats;
+
+	/*
+	* Real time between frames is added to an accumulator and whole steps
+	* are taken out of it, so the simulation runs at the same speed at any
+	* framerate and its cost per second is fixed however fast frames are
+	* drawn. What is left over, less than a step, is how far the drawn
+	* frame sits between the last two steps.
+	*
+	* A long frame, from a stall or the window being dragged, would ask
+	* for many steps at once, which make the next frame longer still.
+	* Frame time is clamped and steps per frame are capped, and the time
+	* cut is dropped, so the simulation slows down instead of spiralling.
+	*/
+	class FixedTimestep
+	{
+	public:
+		/**
+		* @param stepSeconds        simulated time a step covers
+		* @param maxFrameSeconds    longest frame time accepted
+		* @param maxStepsPerFrame   most steps Advance returns
+		*/
+		explicit FixedTimestep(double stepSeconds = STEP_SECONDS, double maxFrameSeconds = 0.25, int maxStepsPerFrame = 8);
+
+		// Add the real time since the last frame and return how many steps to take
+		int Advance(double frameSeconds);
+
+		// How far the frame is from the last step towards the next, in [0, 1)
+		double Alpha() const;
+
+		TimestepStats Stats() const { return stats; }
+
+	private:
+		double stepSeconds;
+		double maxFrameSeconds;
+		int maxStepsPerFrame;
+		double accumulator = 0.0;
+
+		TimestepStats stats;
+	};
+}
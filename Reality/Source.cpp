@@ -6,56 +6,89 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include "BlockCompression.h"
 #include "Colors.h"
-
-// 0:   Launch in 720p
-// 1:   Launch fullscreen, native resolution
-#define LAUNCH_IN_FULLSCREEN 0
-
-// 0:   No error alerts/logging
-// 1:   Enable error alerts/logging
-#define DEBUG_MODE 1
-
-// 0:   Show Every Debug Message
-// 1:   Show Only Warning Messages
-#define DEBUG_MESSAGE_SEVERITY 1
+#include "Config.h"
+#include "DebugLog.h"
+#include "FrameCapture.h"
+#include "FrameEncoder.h"
+#include "FrameHandoff.h"
+#include "FramePacer.h"
+#include "Gltf.h"
+#include "GlTrace.h"
+#include "GoldenImages.h"
+#include "GpuAnnotations.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "Mipmap.h"
+#include "Rasterizer.h"
+#include "Simulation.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "VideoRecorder.h"
+
+// Window size when no resolution is configured and the window isn't fullscreen
+const int DEFAULT_WIDTH  = 1280;
+const int DEFAULT_HEIGHT = 720;
 
 // File path to generic shaders
 const char* GENERIC_VERTEX_SHADER_PATH   = "Shaders/generic_vertex_shader.vert";
 const char* GENERIC_FRAGMENT_SHADER_PATH = "Shaders/generic_fragment_shader.frag";
 
-// struct representing a vertex that
-// carries an x and y coordinate
-typedef struct PositionVertex2D
-{
-    float posX;
-    float posY;
-} PositionVertex2D;
+// How often the main thread polls input while it waits on the render thread
+const std::chrono::microseconds INPUT_POLL_INTERVAL(500);
 
-// struct representing a triangle
-typedef struct Triangle2D
+// Dragging the scene with the left mouse button, in normalized device coordinates
+typedef struct Drag
 {
-    PositionVertex2D& vertA;
-    PositionVertex2D& vertB;
-    PositionVertex2D& vertC;
-} Triangle2D;
+    bool active = false;
+    double startX = 0.0, startY = 0.0;  // Cursor where the drag began, in screen coordinates
+    float base[2] = { 0.0f, 0.0f };     // Offset before the drag
+    float offset[2] = { 0.0f, 0.0f };   // Offset as of the last cursor move the simulation saw
+} Drag;
+
+// What the render thread needs to draw a frame, prepared by the main thread
+typedef struct RenderFrame
+{
+    sim::State scene;            // Interpolated to the frame
+    Drag drag;
+    int framebufferWidth  = 0;   // Only the main thread may ask GLFW
+    int framebufferHeight = 0;
+    int windowWidth  = 0;        // Cursor positions are in window, not framebuffer, coordinates
+    int windowHeight = 0;
+} RenderFrame;
 
 /**
-* @brief            Callback to print error messages that
-*                   occur if DEBUG_MODE flag is set to 1
-*
+* @brief            Offset of the scene with the cursor at x, y
+*                   while dragging
 */
-void APIENTRY HandleErrors(unsigned int source, unsigned int type,
-    unsigned int id, unsigned int severity, int length, const char* message, const void* userParam) 
+static void DragOffset(const Drag& drag, double x, double y, int windowWidth, int windowHeight, float offset[2])
 {
-    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION) { return; }
-    std::cerr << message << std::endl;
+    offset[0] = drag.base[0] + (float)((x - drag.startX) * 2.0 / std::max(windowWidth, 1));
+    offset[1] = drag.base[1] - (float)((y - drag.startY) * 2.0 / std::max(windowHeight, 1));
 }
 
+// Frames drawn by the software renderer before it reports its throughput and exits
+const int SOFTWARE_FRAME_COUNT = 1000;
+
+// Frame --trace records, late enough that loading and warm up are over
+const std::uint64_t TRACE_FRAME = 120;
+
+// Frames --benchmark replay times when not told how many
+const int DEFAULT_REPLAY_ITERATIONS = 200;
+
 /**
 * @brief                Returns the source for a generic vertex
 *                       shader and a generic fragment shader
@@ -144,8 +177,9 @@ static unsigned int CompileShader(unsigned int type, const std::string& source)
 * 
 * @param vertexShader   source code to vertex shader
 * @param fragmentShader source code to fragment shader
+* @param label          name profilers show for the program
 */
-static unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader) 
+static unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader, const char* label) 
 {
     unsigned int program = glCreateProgram();  // Program to run on GPU
     unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);  // Compile vertex shader
@@ -158,6 +192,7 @@ static unsigned int CreateShader(const std::string& vertexShader, const std::str
     // Link and compile program
     glLinkProgram(program);
     glValidateProgram(program);
+    annotate::Label(GL_PROGRAM, program, label);
 
     // Cleanup
     glDeleteShader(vs);
@@ -166,29 +201,264 @@ static unsigned int CreateShader(const std::string& vertexShader, const std::str
     return program;
 }
 
-int main(void)
+/**
+* @brief    The quad drawn when no mesh is given, optimized
+*           for the vertex cache
+*/
+static mesh::IndexedMesh CreateQuad()
+{
+    // 2D points representing triangles. Indexing the
+    // triangles prevents storing duplicate vertices
+    mesh::IndexedMesh quad;
+    quad.vertices = {
+            PositionVertex2D(-0.5f,  0.5f),
+            PositionVertex2D(-0.5f, -0.5f),
+            PositionVertex2D( 0.5f, -0.5f),
+            PositionVertex2D( 0.5f,  0.5f)
+    };
+    quad.AddTriangle(Triangle2D(1, 2, 3));
+    quad.AddTriangle(Triangle2D(0, 1, 3));
+
+    // Reorder the quad for the vertex cache before it reaches the GPU
+    mesh::OptimizationReport report = mesh::Optimize(quad);
+    std::cout << "Mesh ACMR: " << report.acmrBefore << " -> " << report.acmrAfter
+        << " (" << report.verticesWelded << " vertices welded)" << std::endl;
+
+    return quad;
+}
+
+/**
+* @brief            Draw the same scene as the GL loop with the software
+*                   rasterizer for SOFTWARE_FRAME_COUNT frames, then print
+*                   the throughput. Used when no GL context can be created
+*
+* @param meshPath   binary mesh to draw, or null for the quad
+* @return           exit code for main
+*/
+static int RunSoftwareRenderer(const char* meshPath, int resX, int resY)
+{
+    mesh::IndexedMesh quad;
+    mesh::MappedMesh mappedMesh;
+    std::span<const PositionVertex2D> vertices;
+    const void* indices;
+    std::size_t indexCount, indexStride;
+
+    if (meshPath)
+    {
+        if (!mappedMesh.Open(meshPath))
+        {
+            std::cerr << "Failed to load " << meshPath << std::endl;
+            return -3;
+        }
+
+        vertices = mappedMesh.Vertices();
+        indices = mappedMesh.Indices();
+        indexCount = mappedMesh.IndexCount();
+        indexStride = mappedMesh.IndexStride();
+    }
+    else
+    {
+        quad = CreateQuad();
+        vertices = quad.vertices;
+        indices = quad.indices.Data();
+        indexCount = quad.indices.Count();
+        indexStride = quad.indices.Stride();
+    }
+
+    raster::Rasterizer rasterizer(resX, resY);
+    sim::State previous, current;
+    sim::FixedTimestep timestep;
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastFrame = start;
+    for (int frame = 0; frame < SOFTWARE_FRAME_COUNT; frame++)
+    {
+        rasterizer.Clear(colors::Black);
+
+        auto now = std::chrono::steady_clock::now();
+        for (int step = timestep.Advance(std::chrono::duration<double>(now - lastFrame).count()); step > 0; step--)
+        {
+            previous = current;
+            sim::Update(current);
+        }
+        lastFrame = now;
+
+        sim::State shown = sim::Interpolate(previous, current, timestep.Alpha());
+        rasterizer.DrawIndexed(vertices, indices, indexCount, indexStride,
+            raster::GenericVertexShader(), raster::GenericFragmentShader{ raster::PackColor(shown.color) });
+
+        rasterizer.Finish();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    raster::RasterStats stats = rasterizer.Stats();
+    std::cout << "Software rendered " << SOFTWARE_FRAME_COUNT << " frames at " << resX << "x" << resY << " on "
+        << jobs::ThreadCount() << " threads: " << seconds * 1000.0 / SOFTWARE_FRAME_COUNT << " ms/frame, "
+        << stats.triangles / seconds / 1e6 << " Mtriangles/s, " << stats.pixels / seconds / 1e6 << " Mpixels/s" << std::endl;
+
+    return 0;
+}
+
+/**
+* @brief            Run the golden image tests, drawing through GL too when a
+*                   context can be made in a hidden window
+*
+* @param directory  holds the golden images
+* @param record     write the golden images instead of checking against them
+* @return           whether every scene matched
+*/
+static bool RunGoldenImageTests(const std::string& directory, bool record)
+{
+    GLFWwindow* window = nullptr;
+    if (glfwInit())
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(64, 64, "Golden images", NULL, NULL);
+    }
+
+    unsigned int program = 0;
+    if (window)
+    {
+        glfwMakeContextCurrent(window);
+        if (glewInit() == GLEW_OK)
+        {
+            std::string vertexShader, fragmentShader;
+            GetGenericShadersSource(vertexShader, fragmentShader);
+            program = CreateShader(vertexShader, fragmentShader, "Generic shader");
+
+            // A shader that stopped compiling is a failure, not a reason to skip GL
+            int linked;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if (linked == GL_FALSE)
+            {
+                std::cerr << "The generic shaders failed to compile or link" << std::endl;
+                glDeleteProgram(program);
+                glfwTerminate();
+                return false;
+            }
+        }
+    }
+
+    bool passed = golden::RunGoldenTests(directory, record, program);
+
+    if (program) { glDeleteProgram(program); }
+    glfwTerminate();
+    return passed;
+}
+
+int main(int argc, char** argv)
 {
+    // --config <file>, the setting options and the launch options, in any order, choose
+    // how to launch; see Config.h. Anything bad is reported along with every option
+    config::Settings settings;
+    config::Launch launch;
+    if (!config::ParseArguments(argc, argv, settings, launch))
+    {
+        config::PrintUsage(std::cerr);
+        return -1;
+    }
+
+    // --dump writes every frame the GL loop draws, --record records them through ffmpeg,
+    // which must be on the PATH, and --trace records the GL calls of one frame
+    const char* dumpDirectory = launch.dumpDirectory.empty() ? nullptr : launch.dumpDirectory.c_str();
+    const char* recordPath = launch.recordPath.empty() ? nullptr : launch.recordPath.c_str();
+    const char* tracePath = launch.tracePath.empty() ? nullptr : launch.tracePath.c_str();
+    capture::FrameFormat dumpFormat = launch.dumpFormat;
+
+    // --convert <in.obj|in.ply> <out.rmesh> converts a mesh offline and exits
+    if (launch.command == config::Command::Convert)
+    {
+        return mesh::ConvertToMeshFile(launch.arguments[0].c_str(), launch.arguments[1].c_str()) ? 0 : -1;
+    }
+
+    // --golden <check|record> [directory] renders the test scenes with the software rasterizer and,
+    // given a GL driver, through GL offscreen, against the golden images in directory, or records
+    // them, and exits with whether they all matched. Golden/ holds the scalar kernel's recordings,
+    // so --golden check is the check to run before and after changing a draw path
+    if (launch.command == config::Command::Golden)
+    {
+        return RunGoldenImageTests(launch.arguments[1], launch.arguments[0] == "record") ? 0 : 1;
+    }
+
+    // --mesh <file.rmesh|file.gltf|file.glb> draws a binary mesh or glTF scene instead of the quad
+    const char* meshPath = launch.meshPath.empty() ? nullptr : launch.meshPath.c_str();
+    std::string meshExtension = meshPath ? std::filesystem::path(meshPath).extension().string() : "";
+    bool isGltf = meshExtension == ".gltf" || meshExtension == ".glb";
+
+    // --benchmark textures measures texture upload bandwidth and exits
+    // --benchmark decode <images...> measures loading images through the decode pool and exits
+    // --benchmark mips compares CPU mip generation against glGenerateMipmap and exits
+    // --benchmark bc [images...] measures BC1/BC3/BC7 compression speed and quality and exits
+    // --benchmark capture compares asynchronous frame readback against glReadPixels and exits
+    // --benchmark raster measures the software rasterizer's kernels on one thread and exits
+    // --benchmark encode measures encoding frames to QOI and PNG and exits
+    // --benchmark yuv measures converting frames to YUV for recording and exits
+    // --benchmark replay <trace> [iterations] times replaying a frame recorded with --trace and exits
+    std::string benchmark = launch.command == config::Command::Benchmark ? launch.arguments[0] : "";
+    std::vector<std::string> benchmarkArguments;
+    if (!benchmark.empty()) { benchmarkArguments.assign(launch.arguments.begin() + 1, launch.arguments.end()); }
+
+    // Runs on the CPU alone, so before anything needs a GL driver
+    if (benchmark == "raster")
+    {
+        raster::RunRasterBenchmark();
+        return 0;
+    }
+    if (benchmark == "encode")
+    {
+        capture::RunEncodeBenchmark();
+        return 0;
+    }
+    if (benchmark == "yuv")
+    {
+        capture::RunYuvBenchmark();
+        return 0;
+    }
+
+    std::cout << "Settings: " << config::Describe(settings) << std::endl;
+
     GLFWwindow* window;
 
+    // Fullscreen windows without a resolution take the monitor's, once GLFW can say what it is
+    int resX = settings.width > 0 ? settings.width : DEFAULT_WIDTH;
+    int resY = settings.width > 0 ? settings.height : DEFAULT_HEIGHT;
+
+    // Without a GL driver, e.g. on headless nodes, the scene is drawn on the CPU.
+    // The benchmarks measure GL and glTF scenes load straight into GL buffers,
+    // so those still need it
+    bool canRenderInSoftware = benchmark.empty() && !isGltf;
+    if (settings.backend == config::Backend::Software && canRenderInSoftware) { return RunSoftwareRenderer(meshPath, resX, resY); }
+
     /* Initialize the library */
     if (!glfwInit())
-        return -1;
+    {
+        if (!canRenderInSoftware) { return -1; }
+
+        std::cerr << "glfwInit failed, rendering on the CPU instead" << std::endl;
+        return RunSoftwareRenderer(meshPath, resX, resY);
+    }
 
-    // Make the window 720p unless LAUNCH_IN_FULLSCREEN flag is set
-    int resX = 1280, resY = 720;
+    GLFWmonitor* monitor = settings.fullscreen ? glfwGetPrimaryMonitor() : nullptr;
+    if (monitor && settings.width == 0)
+    {
+        const GLFWvidmode* screen = glfwGetVideoMode(monitor);
+        resX = screen->width;
+        resY = screen->height;
+    }
 
-#if LAUNCH_IN_FULLSCREEN
-    const GLFWvidmode* screen = glfwGetVideoMode(glfwGetPrimaryMonitor());
-    resX = screen->width;
-    resY = screen->height;
-#endif
+    // A debug context costs driver validation on every call, so lean runs go without
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, settings.debug != config::DebugOutput::Off);
+    glfwWindowHint(GLFW_SAMPLES, settings.msaaSamples);
 
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(resX, resY, "Turquoise Triangle", NULL, NULL);
+    /* Create a window, fullscreen on the primary monitor if asked, and its OpenGL context */
+    window = glfwCreateWindow(resX, resY, "Turquoise Triangle", monitor, NULL);
     if (!window)
     {
         glfwTerminate();
-        return -1;
+        if (!canRenderInSoftware) { return -1; }
+
+        std::cerr << "No GL context available, rendering on the CPU instead" << std::endl;
+        return RunSoftwareRenderer(meshPath, resX, resY);
     }
     
     /* Make the window's context current */
@@ -197,88 +467,320 @@ int main(void)
     /* Initialize glew*/
     if (glewInit() != GLEW_OK) { 
         std::cerr << "glewInit failed to complete :(";
-        return -2;
+        glfwTerminate();
+        if (!canRenderInSoftware) { return -2; }
+
+        std::cerr << " rendering on the CPU instead" << std::endl;
+        return RunSoftwareRenderer(meshPath, resX, resY);
     }
 
     // Print OpenGL version
     std::cout << glGetString(GL_VERSION) << std::endl;
 
-#if DEBUG_MODE
-    glEnable(GL_DEBUG_OUTPUT);
-
-#if DEBUG_MESSAGE_SEVERITY > 0
-    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, 0, GL_FALSE);
-#endif
-
-    glDebugMessageCallback(HandleErrors, nullptr);
-#endif
-
-    // 2D points representing triangles
-    PositionVertex2D triangleVerts[4]{
-            PositionVertex2D(-0.5f,  0.5f),
-            PositionVertex2D(-0.5f, -0.5f),
-            PositionVertex2D( 0.5f, -0.5f),
-            PositionVertex2D( 0.5f,  0.5f)
-    };
-
-    // Index buffer defining which vertices to use for each triangle
-    // Using an index buffer prevent storing duplicate vertices
-    unsigned int indices[6]{
-        1, 2, 3,
-        0, 1, 3
-    };
-
-    // Create buffer
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
+    // Debug messages are queued by the driver's callback and written on a thread of their own
+    std::unique_ptr<gldebug::DebugLog> debugLog;
+    if (settings.debug != config::DebugOutput::Off)
+    {
+        debugLog = std::make_unique<gldebug::DebugLog>();
+        for (unsigned int id : settings.mutedDebugIds) { debugLog->SetIdMuted(id, true); }
+
+        // The driver echoes every annotation group back as a message
+        debugLog->SetTypeMuted(GL_DEBUG_TYPE_PUSH_GROUP, true);
+        debugLog->SetTypeMuted(GL_DEBUG_TYPE_POP_GROUP, true);
+        debugLog->Install();
+
+        // Filtered in the driver, so they aren't even generated
+        if (settings.debug == config::DebugOutput::Warnings)
+        {
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, 0, GL_FALSE);
+        }
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float), triangleVerts, GL_STATIC_DRAW);
+    if (settings.msaaSamples > 0) { glEnable(GL_MULTISAMPLE); }
 
-    glEnableVertexAttribArray(0);  // Enable drawing of vertex
+    // Object labels and pass groups for GL capture tools. F9 toggles them while running
+    annotate::Init();
+    if (settings.annotations) { annotate::SetEnabled(true); }
 
-    // Define data structure 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0); 
+    if (!benchmark.empty())
+    {
+        int result = 0;
+        if (benchmark == "textures") { textures::RunUploadBenchmark(); }
+        else if (benchmark == "decode") { textures::RunDecodeBenchmark(benchmarkArguments); }
+        else if (benchmark == "mips") { textures::RunMipBenchmark(); }
+        else if (benchmark == "bc") { textures::RunCompressionBenchmark(benchmarkArguments); }
+        else if (benchmark == "capture") { capture::RunCaptureBenchmark(); }
+        else if (benchmark == "replay")
+        {
+            int iterations = benchmarkArguments.size() >= 2 ? std::atoi(benchmarkArguments[1].c_str()) : DEFAULT_REPLAY_ITERATIONS;
+            result = gltrace::Replay(benchmarkArguments[0], iterations) ? 0 : 1;
+        }
 
-    unsigned int indexBufferObj;
-    glGenBuffers(1, &indexBufferObj);
+        glfwTerminate();
+        return result;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferObj);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    mesh::GpuMesh gpuMesh;
+    gltf::Scene scene;
+    if (isGltf)
+    {
+        // glTF buffers are uploaded straight from the mapped file
+        if (!gltf::Load(meshPath, scene))
+        {
+            glfwTerminate();
+            return -3;
+        }
+    }
+    else if (meshPath)
+    {
+        // The file's streams are uploaded straight from the mapping
+        mesh::MappedMesh mappedMesh;
+        if (!mappedMesh.Open(meshPath))
+        {
+            std::cerr << "Failed to load " << meshPath << std::endl;
+            glfwTerminate();
+            return -3;
+        }
+
+        gpuMesh = mesh::Upload(mappedMesh);
+    }
+    else
+    {
+        // Copy the quad's vertex and index streams to the GPU
+        gpuMesh = mesh::Upload(CreateQuad());
+    }
 
     // Get source code for vertex and fragment shaders
     std::string vertexShader, fragmentShader;
     GetGenericShadersSource(vertexShader, fragmentShader);
 
     // Create and use shader
-    unsigned int shader = CreateShader(vertexShader, fragmentShader);
+    unsigned int shader = CreateShader(vertexShader, fragmentShader, "Generic shader");
     glUseProgram(shader);
     
-    // Define the color to draw in the fragment shader
-    Color color = colors::Red;
     int colorUniformLocation = glGetUniformLocation(shader, "u_Color");
-    glUniform4fv(colorUniformLocation, 1, color);
-    
+    int offsetUniformLocation = glGetUniformLocation(shader, "u_Offset");
+
+    // Frames are read back without stalling and encoded off the GL thread
+    std::unique_ptr<capture::FrameEncoder> frameEncoder;
+    std::unique_ptr<capture::VideoRecorder> videoRecorder;
+    if (dumpDirectory) { frameEncoder = std::make_unique<capture::FrameEncoder>(dumpDirectory, dumpFormat); }
+    if (recordPath) { videoRecorder = std::make_unique<capture::VideoRecorder>(recordPath); }
+
+    /*
+    * The main thread polls events and simulates while a render thread
+    * owns the GL context and draws, a frame behind: while frame N is
+    * drawn and swapped, frame N + 1 is simulated into the other half of
+    * the handoff. GLFW only allows polling and querying the window on
+    * the main thread, so anything the render thread needs from the
+    * window goes through the handoff too.
+    *
+    * Input is polled on the main thread before it simulates a frame and
+    * continually while, with that frame ready, it waits for the render
+    * thread to take it. The render thread latches the newest cursor
+    * right before drawing, so a drag follows the mouse a frame sooner
+    * than the simulation alone could.
+    */
+    std::unique_ptr<input::InputSystem> inputSystem = std::make_unique<input::InputSystem>(window);
+    FrameHandoff<RenderFrame> handoff;
+    pacing::PacingStats pacingStats;
+    pacing::SwapMode swapModeUsed = settings.vsync;
+    capture::CaptureStats captureStats;
+
+    glfwMakeContextCurrent(nullptr);
+    std::thread renderThread([&]
+    {
+        glfwMakeContextCurrent(window);
+        pacing::FramePacer framePacer(settings.vsync, settings.maxFramerate);
+
+        std::unique_ptr<capture::FrameCapture> frameCapture;
+        if (frameEncoder || videoRecorder)
+        {
+            frameCapture = std::make_unique<capture::FrameCapture>([&](const capture::CapturedFrame& frame)
+            {
+                if (frameEncoder) { frameEncoder->Submit(frame); }
+                if (videoRecorder) { videoRecorder->Submit(frame); }
+            });
+        }
+
+        std::uint64_t frameIndex = 0;
+        while (const RenderFrame* frame = handoff.Acquire())
+        {
+            const bool traced = tracePath && frameIndex++ == TRACE_FRAME;
+            if (traced) { gltrace::BeginFrame(frame->framebufferWidth, frame->framebufferHeight); }
+
+            input::Cursor cursor;
+
+            /* Render here */
+            {
+                annotate::Scope pass("Scene");
+                gltrace::Clear(GL_COLOR_BUFFER_BIT);
+                glUniform4fv(colorUniformLocation, 1, frame->scene.color.rgba);
+
+                // Late latch: the cursor may have moved since the main thread simulated this frame
+                float offset[2] = { frame->drag.offset[0], frame->drag.offset[1] };
+                if (frame->drag.active)
+                {
+                    cursor = inputSystem->LatestCursor();
+                    DragOffset(frame->drag, cursor.x, cursor.y, frame->windowWidth, frame->windowHeight, offset);
+                }
+                glUniform2fv(offsetUniformLocation, 1, offset);
+
+                if (isGltf) { gltf::Draw(scene); }
+                else { mesh::Draw(gpuMesh); }
+            }
+
+            gltrace::TraceStats traceStats;
+            if (traced && gltrace::EndFrame(tracePath, traceStats))
+            {
+                std::cout << "Traced frame " << TRACE_FRAME << ": " << traceStats.calls << " calls, " << traceStats.draws << " draws, "
+                    << traceStats.bytes / 1e3 << " KB to " << tracePath << std::endl;
+                if (traceStats.unsupported > 0) { std::cerr << traceStats.unsupported << " traced calls used client memory and won't replay" << std::endl; }
+            }
+
+            if (frameCapture)
+            {
+                annotate::Scope pass("Frame capture");
+                frameCapture->Capture(frame->framebufferWidth, frame->framebufferHeight);
+            }
+
+            // Once released, the main thread can publish and fill this half again while the swap blocks
+            const bool dragging = frame->drag.active;
+            handoff.Release();
+
+            /* Swap front and back buffers */
+            glfwSwapBuffers(window);
+            if (dragging) { inputSystem->RecordPresented(cursor); }
+            framePacer.EndFrame();
+        }
+
+        pacingStats = framePacer.Stats();
+        swapModeUsed = framePacer.Mode();
+        if (frameCapture)
+        {
+            captureStats = frameCapture->Stats();
+            frameCapture.reset();  // Flushes the frames still in flight while GL is alive
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    });
+
+    // The scene is simulated in fixed steps, and each frame draws it
+    // interpolated between the last two
+    sim::State previous, current;
+    sim::FixedTimestep timestep;
+    auto lastFrame = std::chrono::steady_clock::now();
+    Drag drag;
+    int windowWidth, windowHeight;
+
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
-        /* Render here */
-        glClear(GL_COLOR_BUFFER_BIT);
+        // Events polled while waiting on the last frame are handled here, along with any since
+        inputSystem->Poll();
+
+        glfwGetWindowSize(window, &windowWidth, &windowHeight);
+        input::Event event;
+        while (inputSystem->Next(event))
+        {
+            if (event.type == input::EventType::Key && event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS)
+            {
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+            }
+            else if (event.type == input::EventType::Key && event.code == GLFW_KEY_F9 && event.action == GLFW_PRESS)
+            {
+                // Toggled between frames, so a capture can start with names from the next one
+                annotate::SetEnabled(!annotate::Enabled());
+            }
+            else if (event.type == input::EventType::MouseButton && event.code == GLFW_MOUSE_BUTTON_LEFT)
+            {
+                if (event.action == GLFW_PRESS)
+                {
+                    drag.active = true;
+                    drag.startX = event.x;
+                    drag.startY = event.y;
+                    std::copy(drag.offset, drag.offset + 2, drag.base);
+                }
+                else if (event.action == GLFW_RELEASE && drag.active)
+                {
+                    DragOffset(drag, event.x, event.y, windowWidth, windowHeight, drag.offset);
+                    drag.active = false;
+                }
+            }
+            else if (event.type == input::EventType::CursorMove && drag.active)
+            {
+                DragOffset(drag, event.x, event.y, windowWidth, windowHeight, drag.offset);
+            }
+        }
+
+        // Simulate up to now
+        auto now = std::chrono::steady_clock::now();
+        for (int step = timestep.Advance(std::chrono::duration<double>(now - lastFrame).count()); step > 0; step--)
+        {
+            previous = current;
+            sim::Update(current);
+        }
+        lastFrame = now;
+
+        RenderFrame& frame = handoff.Back();
+        frame.scene = sim::Interpolate(previous, current, timestep.Alpha());
+        frame.drag = drag;
+        frame.windowWidth = windowWidth;
+        frame.windowHeight = windowHeight;
+        glfwGetFramebufferSize(window, &frame.framebufferWidth, &frame.framebufferHeight);
+
+        // Keep polling while the render thread finishes the last frame, so events are stamped
+        // close to when they happened and the render thread can latch the newest cursor
+        while (!handoff.WaitPublishable(INPUT_POLL_INTERVAL)) { inputSystem->Poll(); }
+        if (!handoff.Publish()) { break; }
+    }
 
-        // Change the color
-        colors::RotateColor_s(color, Vec3f(0.001, 0.0002, 0.0015));
-        glUniform4fv(colorUniformLocation, 1, color);
+    handoff.Stop();
+    renderThread.join();
+    glfwMakeContextCurrent(window);
+
+    HandoffStats handoffStats = handoff.Stats();
+    std::cout << "Vsync " << pacing::SwapModeName(swapModeUsed) << ", limit " << settings.maxFramerate << " fps: " << pacingStats.frames
+        << " frames, " << pacingStats.meanMs << " ms mean, " << pacingStats.jitterMs << " ms jitter, " << pacingStats.worstMs
+        << " ms worst, " << pacingStats.late << " late" << std::endl;
+    std::cout << "Main thread waited " << handoffStats.producerWaitSeconds << " s on the render thread, which waited "
+        << handoffStats.consumerWaitSeconds << " s on it" << std::endl;
 
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    input::LatencyStats latencyStats = inputSystem->Stats();
+    std::cout << "Input: " << latencyStats.events << " events (" << latencyStats.dropped << " dropped), " << latencyStats.queueMs
+        << " ms mean queued; " << latencyStats.latched << " frames late latched, " << latencyStats.latchToSwapMs << " ms mean and "
+        << latencyStats.worstLatchToSwapMs << " ms worst from input to swap" << std::endl;
 
-        /* Swap front and back buffers */
-        glfwSwapBuffers(window);
+    if (frameEncoder)
+    {
+        frameEncoder->Finish();
+        capture::EncoderStats encoderStats = frameEncoder->Stats();
+        std::cout << "Dumped " << encoderStats.frames << " frames (" << captureStats.dropped << " dropped), "
+            << encoderStats.bytes / 1e6 << " MB to " << dumpDirectory << std::endl;
+    }
 
-        /* Poll for and process events */
-        glfwPollEvents();
+    if (videoRecorder)
+    {
+        bool recorded = videoRecorder->Finish();
+        capture::RecordingStats recordingStats = videoRecorder->Stats();
+        std::cout << (recorded ? "Recorded " : "Failed to record ") << recordingStats.videoFrames << " video frames from "
+            << recordingStats.frames << " captured (" << captureStats.dropped << " dropped, " << recordingStats.skipped
+            << " skipped) to " << recordPath << std::endl;
     }
 
+    inputSystem.reset();  // Removes its callbacks while the window is alive
+
+    if (debugLog)
+    {
+        debugLog->Uninstall();
+        debugLog->Finish();
+        gldebug::LogStats logStats = debugLog->Stats();
+        std::cout << "GL debug: " << logStats.written << " messages, " << logStats.repeats << " repeats folded, "
+            << logStats.filtered << " muted, " << logStats.dropped << " dropped" << std::endl;
+    }
     glDeleteProgram(shader);  // Delete shader when done using it
+    mesh::Release(gpuMesh);
+    gltf::Release(scene);
 
     glfwTerminate();
     return 0;
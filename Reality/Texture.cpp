@@ -0,0 +1,508 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include "GpuAnnotations.h"
+#include "Texture.h"
+
+namespace {
+
+	// PBO offsets are kept aligned well past what any pixel format needs
+	constexpr std::size_t STAGING_ALIGNMENT = 256;
+
+	typedef struct GLFormat
+	{
+		unsigned int internalFormat;
+		unsigned int format;
+		unsigned int type;
+	} GLFormat;
+
+	GLFormat ToGL(textures::PixelFormat format)
+	{
+		switch (format)
+		{
+		case textures::PixelFormat::SRGB8_ALPHA8: return GLFormat{ GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC1:          return GLFormat{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC1_SRGB:     return GLFormat{ GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC3:          return GLFormat{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC3_SRGB:     return GLFormat{ GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC7:          return GLFormat{ GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA, GL_UNSIGNED_BYTE };
+		case textures::PixelFormat::BC7_SRGB:     return GLFormat{ GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GL_RGBA, GL_UNSIGNED_BYTE };
+		default:                                  return GLFormat{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+		}
+	}
+
+	bool HasBufferStorage()
+	{
+		return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	}
+
+	bool HasTextureStorage()
+	{
+		return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+	}
+
+	void SetSamplingForLevels(unsigned int target, int levels)
+	{
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+}
+
+bool textures::IsCompressed(PixelFormat format)
+{
+	return format != PixelFormat::RGBA8 && format != PixelFormat::SRGB8_ALPHA8;
+}
+
+bool textures::IsSrgb(PixelFormat format)
+{
+	return format == PixelFormat::SRGB8_ALPHA8 || format == PixelFormat::BC1_SRGB ||
+		format == PixelFormat::BC3_SRGB || format == PixelFormat::BC7_SRGB;
+}
+
+bool textures::IsSupported(PixelFormat format)
+{
+	switch (format)
+	{
+	case PixelFormat::BC1:
+	case PixelFormat::BC3:      return GLEW_EXT_texture_compression_s3tc;
+	case PixelFormat::BC1_SRGB:
+	case PixelFormat::BC3_SRGB: return GLEW_EXT_texture_compression_s3tc && GLEW_EXT_texture_sRGB;
+	case PixelFormat::BC7:
+	case PixelFormat::BC7_SRGB: return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+	default:                    return true;
+	}
+}
+
+std::size_t textures::ImageSize(PixelFormat format, int width, int height)
+{
+	if (!IsCompressed(format)) { return (std::size_t)width * height * 4; }
+
+	const std::size_t blockSize = format == PixelFormat::BC1 || format == PixelFormat::BC1_SRGB ? 8 : 16;
+	return (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+std::size_t textures::MipChainSize(PixelFormat format, int width, int height, int levels)
+{
+	std::size_t size = 0;
+	for (int level = 0; level < levels; level++) { size += ImageSize(format, std::max(width >> level, 1), std::max(height >> level, 1)); }
+	return size;
+}
+
+int textures::FullMipCount(int width, int height)
+{
+	int levels = 1;
+	for (int size = std::max(width, height); size > 1; size >>= 1) { levels++; }
+	return levels;
+}
+
+textures::Texture textures::Create2D(int width, int height, PixelFormat format, int levels)
+{
+	Texture texture;
+	texture.target = GL_TEXTURE_2D;
+	texture.format = format;
+	texture.width  = width;
+	texture.height = height;
+	texture.layers = 1;
+	texture.levels = levels > 0 ? levels : FullMipCount(width, height);
+
+	GLFormat glFormat = ToGL(format);
+	glGenTextures(1, &texture.id);
+	glBindTexture(GL_TEXTURE_2D, texture.id);
+
+	if (HasTextureStorage()) { glTexStorage2D(GL_TEXTURE_2D, texture.levels, glFormat.internalFormat, width, height); }
+	else
+	{
+		for (int level = 0; level < texture.levels; level++)
+		{
+			glTexImage2D(GL_TEXTURE_2D, level, glFormat.internalFormat, std::max(width >> level, 1), std::max(height >> level, 1),
+				0, glFormat.format, glFormat.type, nullptr);
+		}
+	}
+
+	SetSamplingForLevels(GL_TEXTURE_2D, texture.levels);
+	return texture;
+}
+
+textures::Texture textures::Create2DArray(int width, int height, int layers, PixelFormat format, int levels)
+{
+	Texture texture;
+	texture.target = GL_TEXTURE_2D_ARRAY;
+	texture.format = format;
+	texture.width  = width;
+	texture.height = height;
+	texture.layers = layers;
+	texture.levels = levels > 0 ? levels : FullMipCount(width, height);
+
+	GLFormat glFormat = ToGL(format);
+	glGenTextures(1, &texture.id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id);
+
+	if (HasTextureStorage()) { glTexStorage3D(GL_TEXTURE_2D_ARRAY, texture.levels, glFormat.internalFormat, width, height, layers); }
+	else
+	{
+		for (int level = 0; level < texture.levels; level++)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, glFormat.internalFormat, std::max(width >> level, 1), std::max(height >> level, 1),
+				layers, 0, glFormat.format, glFormat.type, nullptr);
+		}
+	}
+
+	SetSamplingForLevels(GL_TEXTURE_2D_ARRAY, texture.levels);
+	return texture;
+}
+
+void textures::GenerateMipmaps(const Texture& texture)
+{
+	glBindTexture(texture.target, texture.id);
+	glGenerateMipmap(texture.target);
+}
+
+void textures::Bind(const Texture& texture, unsigned int unit)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(texture.target, texture.id);
+}
+
+void textures::Release(Texture& texture)
+{
+	glDeleteTextures(1, &texture.id);
+	texture = Texture();
+}
+
+textures::UploadRing::~UploadRing()
+{
+	Destroy();
+}
+
+bool textures::UploadRing::Create(std::size_t ringCapacity)
+{
+	Destroy();
+	capacity = ringCapacity;
+
+	if (!HasBufferStorage())
+	{
+		clientMemory.resize(capacity);
+		return true;
+	}
+
+	// Persistent and coherent: stays mapped for the ring's lifetime and
+	// CPU writes are visible to the GPU without explicit flushes
+	const unsigned int flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, capacity, nullptr, flags);
+	annotate::Label(GL_BUFFER, buffer, "Texture upload ring");
+	mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, capacity, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!mapped)
+	{
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void textures::UploadRing::Destroy()
+{
+	std::lock_guard<std::mutex> lock(regionMutex);
+
+	for (Region& region : regions)
+	{
+		if (region.fence) { glDeleteSync((GLsync)region.fence); }
+	}
+	regions.clear();
+	head = 0;
+
+	if (buffer)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+	}
+
+	buffer = 0;
+	mapped = nullptr;
+	clientMemory.clear();
+	capacity = 0;
+}
+
+textures::StagingAllocation textures::UploadRing::Allocate(std::size_t size)
+{
+	std::lock_guard<std::mutex> lock(regionMutex);
+	if (size == 0 || size > capacity) { return StagingAllocation(); }
+
+	std::size_t begin;
+	if (regions.empty()) { begin = 0; }
+	else
+	{
+		// Live regions either run from the oldest to head without wrapping, leaving
+		// free space after head and before the oldest, or they wrap past the end
+		// of the ring, leaving only the space between head and the oldest
+		const std::size_t oldest = regions.front().begin;
+		const bool wrapped = regions.back().begin < oldest;
+		begin = (head + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+
+		if (wrapped)
+		{
+			if (begin + size > oldest) { return StagingAllocation(); }
+		}
+		else if (begin + size > capacity)
+		{
+			if (size > oldest) { return StagingAllocation(); }
+			begin = 0;
+		}
+	}
+
+	regions.push_back(Region{ begin, begin + size, nullptr, false });
+	head = begin + size;
+
+	unsigned char* base = mapped ? mapped : clientMemory.data();
+	return StagingAllocation{ base + begin, begin, size };
+}
+
+textures::StagingAllocation textures::UploadRing::AllocateBlocking(std::size_t size)
+{
+	while (true)
+	{
+		StagingAllocation allocation = Allocate(size);
+		if (allocation.data) { return allocation; }
+
+		std::size_t liveRegions;
+		{
+			std::lock_guard<std::mutex> lock(regionMutex);
+			liveRegions = regions.size();
+		}
+
+		// Stop if waiting can't free anything, e.g. the oldest allocation was never uploaded
+		Retire(true);
+
+		std::lock_guard<std::mutex> lock(regionMutex);
+		if (regions.size() == liveRegions) { return StagingAllocation(); }
+	}
+}
+
+void textures::UploadRing::Free(const StagingAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(regionMutex);
+
+	for (Region& region : regions)
+	{
+		if (region.begin == allocation.offset && !region.fence) { region.freed = true; }
+	}
+
+	while (!regions.empty() && regions.front().freed) { regions.pop_front(); }
+}
+
+void textures::UploadRing::SubImage(const Texture& texture, int level, int layer, int x, int y, int width, int height,
+	const StagingAllocation& allocation, std::size_t offset)
+{
+	GLFormat glFormat = ToGL(texture.format);
+
+	// Out of a PBO the pixel pointer is an offset into the buffer
+	const void* pixels = mapped ? (const void*)(allocation.offset + offset) : (const void*)(allocation.data + offset);
+	if (mapped) { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer); }
+
+	glBindTexture(texture.target, texture.id);
+	if (IsCompressed(texture.format))
+	{
+		const int size = (int)ImageSize(texture.format, width, height);
+		if (texture.target == GL_TEXTURE_2D_ARRAY)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, glFormat.internalFormat, size, pixels);
+		}
+		else { glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, glFormat.internalFormat, size, pixels); }
+	}
+	else if (texture.target == GL_TEXTURE_2D_ARRAY)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, 1, glFormat.format, glFormat.type, pixels);
+	}
+	else { glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, glFormat.format, glFormat.type, pixels); }
+
+	if (mapped) { glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); }
+
+	uploadedBytes += ImageSize(texture.format, width, height);
+	uploadCount++;
+}
+
+void textures::UploadRing::ReleaseAfterUpload(const StagingAllocation& allocation)
+{
+	// Client memory is copied before glTexSubImage returns, so it can be reused right away
+	if (!mapped)
+	{
+		Free(allocation);
+		return;
+	}
+
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	std::lock_guard<std::mutex> lock(regionMutex);
+	for (Region& region : regions)
+	{
+		if (region.begin == allocation.offset && !region.fence) { region.fence = fence; break; }
+	}
+}
+
+void textures::UploadRing::Upload(const Texture& texture, int level, int layer, int x, int y, int width, int height,
+	const StagingAllocation& allocation)
+{
+	SubImage(texture, level, layer, x, y, width, height, allocation, 0);
+	ReleaseAfterUpload(allocation);
+}
+
+void textures::UploadRing::UploadLevels(const Texture& texture, int layer, int levels, const StagingAllocation& allocation)
+{
+	UploadLevels(texture, layer, 0, 0, texture.width, texture.height, levels, allocation);
+}
+
+void textures::UploadRing::UploadLevels(const Texture& texture, int layer, int x, int y, int width, int height, int levels,
+	const StagingAllocation& allocation)
+{
+	std::size_t offset = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		const int levelWidth  = std::max(width >> level, 1);
+		const int levelHeight = std::max(height >> level, 1);
+
+		SubImage(texture, level, layer, x >> level, y >> level, levelWidth, levelHeight, allocation, offset);
+		offset += ImageSize(texture.format, levelWidth, levelHeight);
+	}
+
+	// One fence covers every level
+	ReleaseAfterUpload(allocation);
+}
+
+void textures::UploadRing::Upload(const Texture& texture, int level, int layer, const void* pixels)
+{
+	const int width  = std::max(texture.width >> level, 1);
+	const int height = std::max(texture.height >> level, 1);
+
+	// Compressed images can only be split between rows of blocks
+	const int rowHeight = IsCompressed(texture.format) ? 4 : 1;
+	const std::size_t rowSize = ImageSize(texture.format, width, rowHeight);
+
+	// Upload as many rows at a time as fit in the ring
+	int rowsPerPiece = (int)std::min<std::size_t>((height + rowHeight - 1) / rowHeight, capacity / rowSize) * rowHeight;
+	if (rowsPerPiece == 0) { return; }
+
+	for (int row = 0; row < height; row += rowsPerPiece)
+	{
+		int rows = std::min(rowsPerPiece, height - row);
+		std::size_t size = ImageSize(texture.format, width, rows);
+		StagingAllocation allocation = AllocateBlocking(size);
+		if (!allocation.data) { return; }
+
+		std::memcpy(allocation.data, (const unsigned char*)pixels + row / rowHeight * rowSize, size);
+		Upload(texture, level, layer, 0, row, width, rows, allocation);
+	}
+}
+
+void textures::UploadRing::Retire(bool wait)
+{
+	std::unique_lock<std::mutex> lock(regionMutex);
+
+	while (!regions.empty())
+	{
+		Region& oldest = regions.front();
+		if (oldest.freed) { regions.pop_front(); continue; }
+
+		// Allocated but not uploaded yet, so nothing behind it can be released either
+		if (!oldest.fence) { break; }
+
+		GLsync fence = (GLsync)oldest.fence;
+		GLenum status;
+		if (wait)
+		{
+			// Don't hold other threads' Allocate calls up while blocked on the GPU
+			lock.unlock();
+			auto start = std::chrono::steady_clock::now();
+			do { status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000); } while (status == GL_TIMEOUT_EXPIRED);
+			stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			lock.lock();
+			wait = false;
+		}
+		else { status = glClientWaitSync(fence, 0, 0); }
+
+		// Until the fence has signalled the GPU may still be reading the range, so it stays allocated
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) { break; }
+
+		glDeleteSync(fence);
+		regions.pop_front();
+	}
+}
+
+textures::UploadStats textures::UploadRing::Stats() const
+{
+	UploadStats stats;
+	stats.bytes = uploadedBytes;
+	stats.uploads = uploadCount;
+	stats.stallSeconds = stallSeconds;
+	return stats;
+}
+
+void textures::UploadRing::ResetStats()
+{
+	uploadedBytes = 0;
+	uploadCount = 0;
+	stallSeconds = 0.0;
+}
+
+void textures::RunUploadBenchmark()
+{
+	constexpr std::size_t RING_CAPACITY = 64 << 20;
+	constexpr std::size_t BYTES_PER_SIZE = 512 << 20;  // Upload this much at every size so timings settle
+
+	UploadRing ring;
+	if (!ring.Create(RING_CAPACITY))
+	{
+		std::cerr << "Failed to create the upload ring" << std::endl;
+		return;
+	}
+
+	std::cout << "Texture upload bandwidth (" << (ring.IsPersistent() ? "persistent PBO ring" : "client memory ring") << ")\n";
+	std::cout << "size\tring MB/s\tdirect MB/s\tring stall ms\n";
+
+	for (int size = 256; size <= 4096; size *= 2)
+	{
+		Texture texture = Create2D(size, size, PixelFormat::RGBA8, 1);
+		std::vector<unsigned char> pixels(ImageSize(PixelFormat::RGBA8, size, size));
+		for (std::size_t i = 0; i < pixels.size(); i++) { pixels[i] = (unsigned char)(i * 31); }
+
+		const std::size_t repeats = std::max<std::size_t>(BYTES_PER_SIZE / pixels.size(), 1);
+		const double megabytes = repeats * pixels.size() / (double)(1 << 20);
+
+		// glFinish on both sides so each timing covers the GPU actually receiving the data
+		glFinish();
+		ring.ResetStats();
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t r = 0; r < repeats; r++)
+		{
+			ring.Upload(texture, 0, 0, pixels.data());
+			ring.Retire();
+		}
+		glFinish();
+		double ringSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double stallSeconds = ring.Stats().stallSeconds;
+
+		start = std::chrono::steady_clock::now();
+		glBindTexture(GL_TEXTURE_2D, texture.id);
+		for (std::size_t r = 0; r < repeats; r++)
+		{
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		}
+		glFinish();
+		double directSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << size << "x" << size << '\t' << megabytes / ringSeconds << '\t' << megabytes / directSeconds
+			<< '\t' << stallSeconds * 1000.0 << '\n';
+
+		ring.Retire(true);
+		Release(texture);
+	}
+
+	std::cout << std::flush;
+}
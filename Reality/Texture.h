@@ -0,0 +1,200 @@
+/**
+ * @file Texture.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Immutable 2D and array textures, and a ring of pixel
+ *        buffer memory that streams uploads to them
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace textures {
+
+	enum class PixelFormat
+	{
+		RGBA8,
+		SRGB8_ALPHA8,
+
+		// Block compressed, 4x4 texels per block. See BlockCompression.h
+		BC1,            // 8 bytes per block, RGB with 1 bit alpha (S3TC DXT1)
+		BC1_SRGB,
+		BC3,            // 16 bytes per block, RGB and smooth alpha (S3TC DXT5)
+		BC3_SRGB,
+		BC7,            // 16 bytes per block, RGBA at close to RGBA8 quality (BPTC)
+		BC7_SRGB
+	};
+
+	bool IsCompressed(PixelFormat format);
+	bool IsSrgb(PixelFormat format);
+
+	// Whether the driver can sample format. Needs an initialised GLEW
+	bool IsSupported(PixelFormat format);
+
+	// Bytes needed for one width x height image in format. Compressed images are whole blocks
+	std::size_t ImageSize(PixelFormat format, int width, int height);
+
+	// Number of levels in a full mip chain down to 1x1
+	int FullMipCount(int width, int height);
+
+	// Bytes needed for levels mip levels stored one after another, largest first
+	std::size_t MipChainSize(PixelFormat format, int width, int height, int levels);
+
+	typedef struct Texture
+	{
+		unsigned int id = 0;
+		unsigned int target = 0;    // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+		PixelFormat format = PixelFormat::RGBA8;
+		int width  = 0;
+		int height = 0;
+		int layers = 0;
+		int levels = 0;
+	} Texture;
+
+	/**
+	* @brief        Create a texture with immutable storage (glTexStorage2D) so the
+	*               driver never has to revalidate or reallocate it
+	*
+	* @param levels number of mip levels, 0 for a full chain
+	*/
+	Texture Create2D(int width, int height, PixelFormat format, int levels = 0);
+
+	// Same as Create2D but with layers slices (glTexStorage3D)
+	Texture Create2DArray(int width, int height, int layers, PixelFormat format, int levels = 0);
+
+	// Fill every level below 0 from level 0 on the GPU. Uncompressed formats only
+	void GenerateMipmaps(const Texture& texture);
+
+	void Bind(const Texture& texture, unsigned int unit);
+	void Release(Texture& texture);
+
+	// A range of the upload ring that can be written to
+	typedef struct StagingAllocation
+	{
+		unsigned char* data = nullptr;
+		std::size_t offset = 0;
+		std::size_t size = 0;
+	} StagingAllocation;
+
+	typedef struct UploadStats
+	{
+		std::uint64_t bytes   = 0;
+		std::uint64_t uploads = 0;
+		double stallSeconds   = 0.0;  // Time the GL thread spent waiting for the GPU to free ring space
+	} UploadStats;
+
+	/**
+	* @brief    Ring buffer of pixel unpack memory. With GL 4.4 or ARB_buffer_storage
+	*           it is one persistently mapped PBO: pixels are written straight into
+	*           memory the GPU copies from, and fences tell when a range can be
+	*           reused, so CPU writes for one upload overlap the GPU transfer of
+	*           the previous ones. Without it, plain memory is used and uploads
+	*           copy from client memory.
+	*
+	*           Allocate and Free may be called from any thread so pixels can be
+	*           produced off the GL thread. Everything else is GL thread only.
+	*/
+	class UploadRing
+	{
+	public:
+		UploadRing() = default;
+		~UploadRing();
+
+		UploadRing(const UploadRing&) = delete;
+		UploadRing& operator=(const UploadRing&) = delete;
+
+		// Create the ring's buffer. GL thread only
+		bool Create(std::size_t capacity);
+		void Destroy();
+
+		/**
+		* @brief        Reserve size bytes of the ring without blocking
+		*
+		* @return       the reserved range, or an allocation with null
+		*               data if the ring has no free range that large yet
+		*/
+		StagingAllocation Allocate(std::size_t size);
+
+		// Like Allocate, but waits for the GPU to finish with older uploads if needed. GL thread only
+		StagingAllocation AllocateBlocking(std::size_t size);
+
+		// Give back an allocation that won't be uploaded
+		void Free(const StagingAllocation& allocation);
+
+		/**
+		* @brief            Copy allocation's pixels into a region of texture and
+		*                   release the allocation once the GPU has read it
+		*
+		* @param layer      array slice, 0 for 2D textures
+		*/
+		void Upload(const Texture& texture, int level, int layer, int x, int y, int width, int height,
+			const StagingAllocation& allocation);
+
+		// Upload the first levels mip levels of texture from allocation, laid out as for MipChainSize
+		void UploadLevels(const Texture& texture, int layer, int levels, const StagingAllocation& allocation);
+
+		// Like UploadLevels, for a region of texture whose position and size halve each level
+		void UploadLevels(const Texture& texture, int layer, int x, int y, int width, int height, int levels,
+			const StagingAllocation& allocation);
+
+		// Upload a whole level from client memory, in pieces if it is larger than the ring
+		void Upload(const Texture& texture, int level, int layer, const void* pixels);
+
+		/**
+		* @brief        Release allocations whose uploads the GPU has finished. Called
+		*               every frame so other threads' Allocate calls can succeed
+		*
+		* @param wait   block until at least the oldest upload has finished
+		*/
+		void Retire(bool wait = false);
+
+		std::size_t Capacity() const { return capacity; }
+		bool IsPersistent() const { return mapped != nullptr && buffer != 0; }
+
+		UploadStats Stats() const;
+		void ResetStats();
+
+	private:
+		void SubImage(const Texture& texture, int level, int layer, int x, int y, int width, int height,
+			const StagingAllocation& allocation, std::size_t offset);
+
+		// Fence allocation so Retire frees it once the GPU has read it
+		void ReleaseAfterUpload(const StagingAllocation& allocation);
+
+		typedef struct Region
+		{
+			std::size_t begin;
+			std::size_t end;
+			void* fence;      // GLsync, null until uploaded
+			bool freed;       // Given back without an upload
+		} Region;
+
+		unsigned int buffer = 0;
+		unsigned char* mapped = nullptr;
+		std::vector<unsigned char> clientMemory;  // Backing memory without buffer storage
+		std::size_t capacity = 0;
+
+		std::mutex regionMutex;
+		std::deque<Region> regions;  // Live allocations, oldest first
+		std::size_t head = 0;
+
+		std::atomic<std::uint64_t> uploadedBytes = 0;
+		std::atomic<std::uint64_t> uploadCount = 0;
+		double stallSeconds = 0.0;
+	};
+
+	/**
+	* @brief    Measure upload bandwidth for a range of texture sizes through
+	*           the ring and straight from client memory, and print the results.
+	*           Needs a current GL context
+	*/
+	void RunUploadBenchmark();
+}
@@ -0,0 +1,407 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "TextureAtlas.h"
+#include "Mipmap.h"
+
+namespace {
+
+	const textures::AtlasRegion EMPTY_REGION = {};
+
+	/**
+	* @brief        Write an image with its edge texels extended gutter texels
+	*               out on every side, so sampling past its edge at any level
+	*               gets the image's own border instead of a neighbour
+	*
+	* @param out    receives (width + 2 * gutter) x (height + 2 * gutter) RGBA texels
+	*               in rows of outWidth texels
+	*/
+	void ExtrudeGutter(const unsigned char* rgba, int width, int height, int gutter, unsigned char* out, int outWidth)
+	{
+		const std::size_t rowSize = (std::size_t)width * 4;
+		const std::size_t outRowSize = (std::size_t)outWidth * 4;
+
+		for (int y = 0; y < height + gutter * 2; y++)
+		{
+			const unsigned char* source = rgba + std::clamp(y - gutter, 0, height - 1) * rowSize;
+			unsigned char* row = out + y * outRowSize;
+
+			for (int x = 0; x < gutter; x++) { std::memcpy(row + x * 4, source, 4); }
+			std::memcpy(row + gutter * 4, source, rowSize);
+			for (int x = 0; x < gutter; x++) { std::memcpy(row + (gutter + width + x) * 4, source + rowSize - 4, 4); }
+		}
+	}
+}
+
+textures::TextureAtlas::~TextureAtlas()
+{
+	Destroy();
+}
+
+bool textures::TextureAtlas::Create(const AtlasSettings& atlasSettings, UploadRing& uploadRing)
+{
+	Destroy();
+
+	if (atlasSettings.size <= 0 || atlasSettings.maxLayers <= 0 || atlasSettings.gutter < 0 || atlasSettings.padding < 0 ||
+		atlasSettings.mipLevels < 1 || atlasSettings.mipLevels > FullMipCount(atlasSettings.size, atlasSettings.size) ||
+		IsCompressed(atlasSettings.format)) { return false; }
+
+	settings = atlasSettings;
+	ring = &uploadRing;
+	texture = Create2DArray(settings.size, settings.size, settings.maxLayers, settings.format, settings.mipLevels);
+
+	// Sprites shouldn't wrap into the opposite edge of the layer
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return true;
+}
+
+void textures::TextureAtlas::Destroy()
+{
+	if (texture.id) { Release(texture); }
+
+	ring = nullptr;
+	layers.clear();
+	entries.clear();
+	freeHandles.clear();
+	liveArea = 0;
+	holeArea = 0;
+}
+
+int textures::TextureAtlas::SlotSize(int size) const
+{
+	// One texel of the last mip level
+	const int alignment = 1 << (settings.mipLevels - 1);
+	int slot = size + settings.gutter * 2 + settings.padding;
+	return (slot + alignment - 1) / alignment * alignment;
+}
+
+textures::TextureAtlas::Layer textures::TextureAtlas::NewLayer() const
+{
+	Layer layer;
+	if (settings.method == PackingMethod::Skyline) { layer.skyline.push_back(SkylineNode{ 0, 0, settings.size }); }
+	else { layer.freeRects.push_back(Rect{ 0, 0, settings.size, settings.size }); }
+
+	return layer;
+}
+
+bool textures::TextureAtlas::Pack(Layer& layer, int width, int height, int& x, int& y) const
+{
+	return settings.method == PackingMethod::Skyline ? PackSkyline(layer, width, height, x, y) : PackMaxRects(layer, width, height, x, y);
+}
+
+bool textures::TextureAtlas::PackSkyline(Layer& layer, int width, int height, int& x, int& y) const
+{
+	std::vector<SkylineNode>& nodes = layer.skyline;
+
+	// Bottom left: the position that leaves the new top edge lowest, then the narrowest node
+	std::size_t best = nodes.size();
+	int bestTop = INT_MAX, bestWidth = INT_MAX, bestY = 0;
+
+	for (std::size_t n = 0; n < nodes.size() && nodes[n].x + width <= settings.size; n++)
+	{
+		// Rests on the highest node under its width
+		int restY = 0;
+		for (std::size_t under = n, covered = 0; covered < (std::size_t)width; under++)
+		{
+			restY = std::max(restY, nodes[under].y);
+			covered += nodes[under].width;
+		}
+
+		if (restY + height > settings.size) { continue; }
+
+		if (restY + height < bestTop || (restY + height == bestTop && nodes[n].width < bestWidth))
+		{
+			best = n;
+			bestTop = restY + height;
+			bestWidth = nodes[n].width;
+			bestY = restY;
+		}
+	}
+
+	if (best == nodes.size()) { return false; }
+
+	x = nodes[best].x;
+	y = bestY;
+	nodes.insert(nodes.begin() + best, SkylineNode{ x, bestY + height, width });
+
+	// Trim the nodes now under the new one
+	const int newEnd = x + width;
+	for (std::size_t n = best + 1; n < nodes.size();)
+	{
+		if (nodes[n].x >= newEnd) { break; }
+
+		int overlap = newEnd - nodes[n].x;
+		if (overlap < nodes[n].width)
+		{
+			nodes[n].x += overlap;
+			nodes[n].width -= overlap;
+			break;
+		}
+
+		nodes.erase(nodes.begin() + n);
+	}
+
+	// Merge neighbours at the same height
+	for (std::size_t n = 0; n + 1 < nodes.size();)
+	{
+		if (nodes[n].y == nodes[n + 1].y)
+		{
+			nodes[n].width += nodes[n + 1].width;
+			nodes.erase(nodes.begin() + n + 1);
+		}
+		else { n++; }
+	}
+
+	return true;
+}
+
+bool textures::TextureAtlas::PackMaxRects(Layer& layer, int width, int height, int& x, int& y) const
+{
+	std::vector<Rect>& freeRects = layer.freeRects;
+
+	// Best short side fit: the free rectangle with the least space left along its tighter side
+	int bestShort = INT_MAX, bestLong = INT_MAX;
+	for (const Rect& free : freeRects)
+	{
+		if (free.width < width || free.height < height) { continue; }
+
+		int shortSide = std::min(free.width - width, free.height - height);
+		int longSide = std::max(free.width - width, free.height - height);
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			bestShort = shortSide;
+			bestLong = longSide;
+			x = free.x;
+			y = free.y;
+		}
+	}
+
+	if (bestShort == INT_MAX) { return false; }
+
+	// Split every free rectangle the placed one overlaps into the up to 4 maximal rectangles around it
+	const Rect placed = { x, y, width, height };
+	std::vector<Rect> split;
+	for (std::size_t f = 0; f < freeRects.size();)
+	{
+		Rect free = freeRects[f];
+		if (placed.x >= free.x + free.width || placed.x + placed.width <= free.x ||
+			placed.y >= free.y + free.height || placed.y + placed.height <= free.y)
+		{
+			f++;
+			continue;
+		}
+
+		if (placed.x > free.x) { split.push_back(Rect{ free.x, free.y, placed.x - free.x, free.height }); }
+		if (placed.x + placed.width < free.x + free.width)
+		{
+			split.push_back(Rect{ placed.x + placed.width, free.y, free.x + free.width - placed.x - placed.width, free.height });
+		}
+		if (placed.y > free.y) { split.push_back(Rect{ free.x, free.y, free.width, placed.y - free.y }); }
+		if (placed.y + placed.height < free.y + free.height)
+		{
+			split.push_back(Rect{ free.x, placed.y + placed.height, free.width, free.y + free.height - placed.y - placed.height });
+		}
+
+		freeRects[f] = freeRects.back();
+		freeRects.pop_back();
+	}
+
+	for (const Rect& rect : split) { FreeMaxRect(layer, rect); }
+	return true;
+}
+
+void textures::TextureAtlas::FreeMaxRect(Layer& layer, const Rect& rect) const
+{
+	auto contains = [](const Rect& outer, const Rect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y &&
+			inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+	};
+
+	// Free rectangles may overlap but none is kept inside another
+	std::vector<Rect>& freeRects = layer.freeRects;
+	for (const Rect& free : freeRects)
+	{
+		if (contains(free, rect)) { return; }
+	}
+
+	std::erase_if(freeRects, [&](const Rect& free) { return contains(rect, free); });
+	freeRects.push_back(rect);
+}
+
+bool textures::TextureAtlas::Place(std::vector<Layer>& into, int width, int height, AtlasRegion& region) const
+{
+	const int slotWidth = SlotSize(width), slotHeight = SlotSize(height);
+	if (slotWidth > settings.size || slotHeight > settings.size) { return false; }
+
+	int x, y;
+	std::size_t layer = 0;
+	for (; layer < into.size(); layer++)
+	{
+		if (Pack(into[layer], slotWidth, slotHeight, x, y)) { break; }
+	}
+
+	if (layer == into.size())
+	{
+		if ((int)into.size() == settings.maxLayers) { return false; }
+
+		into.push_back(NewLayer());
+		Pack(into.back(), slotWidth, slotHeight, x, y);
+	}
+
+	const float texel = 1.0f / settings.size;
+	region.layer = (int)layer;
+	region.x = x + settings.gutter;
+	region.y = y + settings.gutter;
+	region.width = width;
+	region.height = height;
+	region.u0 = region.x * texel;
+	region.v0 = region.y * texel;
+	region.u1 = (region.x + width) * texel;
+	region.v1 = (region.y + height) * texel;
+	return true;
+}
+
+void textures::TextureAtlas::UploadEntry(const Entry& entry)
+{
+	const AtlasRegion& region = entry.region;
+	const int gutter = settings.gutter;
+	const int x = region.x - gutter, y = region.y - gutter;
+
+	// The whole slot, so its padding is cleared and each level's texels cover only this image
+	const int slotWidth = SlotSize(region.width), slotHeight = SlotSize(region.height);
+	const int levels = settings.mipLevels;
+	const std::size_t size = MipChainSize(settings.format, slotWidth, slotHeight, levels);
+
+	// Filtered in private memory, the staging mapping is write only
+	std::vector<unsigned char> chain(size);
+	ExtrudeGutter(entry.pixels.data(), region.width, region.height, gutter, chain.data(), slotWidth);
+	GenerateMipChain(chain.data(), slotWidth, slotHeight, levels, IsSrgb(settings.format));
+
+	StagingAllocation staging = ring->AllocateBlocking(size);
+	if (staging.data)
+	{
+		std::memcpy(staging.data, chain.data(), size);
+		ring->UploadLevels(texture, region.layer, x, y, slotWidth, slotHeight, levels, staging);
+		return;
+	}
+
+	// Larger than the whole ring
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id);
+	std::size_t offset = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x >> level, y >> level, region.layer, slotWidth >> level, slotHeight >> level, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, chain.data() + offset);
+		offset += ImageSize(settings.format, slotWidth >> level, slotHeight >> level);
+	}
+}
+
+textures::AtlasHandle textures::TextureAtlas::Insert(const unsigned char* rgba, int width, int height)
+{
+	if (!ring || !rgba || width <= 0 || height <= 0) { return INVALID_ATLAS_HANDLE; }
+
+	AtlasRegion region;
+	if (!Place(layers, width, height, region))
+	{
+		// Reclaim removed images' space and try again, if there is enough of it to possibly help
+		if (holeArea < (std::size_t)SlotSize(width) * SlotSize(height) || !Repack() || !Place(layers, width, height, region))
+		{
+			return INVALID_ATLAS_HANDLE;
+		}
+	}
+
+	AtlasHandle handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		entries.emplace_back();
+		handle = (AtlasHandle)entries.size();
+	}
+
+	Entry& entry = entries[handle - 1];
+	entry.live = true;
+	entry.region = region;
+	entry.pixels.assign(rgba, rgba + (std::size_t)width * height * 4);
+	liveArea += (std::size_t)width * height;
+
+	UploadEntry(entry);
+	return handle;
+}
+
+void textures::TextureAtlas::Remove(AtlasHandle handle)
+{
+	if (handle == INVALID_ATLAS_HANDLE || handle > entries.size() || !entries[handle - 1].live) { return; }
+
+	Entry& entry = entries[handle - 1];
+	const AtlasRegion& region = entry.region;
+
+	if (settings.method == PackingMethod::MaxRects)
+	{
+		Rect slot = { region.x - settings.gutter, region.y - settings.gutter, SlotSize(region.width), SlotSize(region.height) };
+		FreeMaxRect(layers[region.layer], slot);
+	}
+
+	liveArea -= (std::size_t)region.width * region.height;
+	holeArea += (std::size_t)SlotSize(region.width) * SlotSize(region.height);
+
+	entry.live = false;
+	entry.pixels = std::vector<unsigned char>();
+	freeHandles.push_back(handle);
+}
+
+bool textures::TextureAtlas::Repack()
+{
+	std::vector<std::size_t> order;
+	for (std::size_t e = 0; e < entries.size(); e++)
+	{
+		if (entries[e].live) { order.push_back(e); }
+	}
+
+	// Largest side first, then largest area, packs tightest for both methods
+	std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b)
+	{
+		const AtlasRegion& first = entries[a].region;
+		const AtlasRegion& second = entries[b].region;
+		int firstSide = std::max(first.width, first.height), secondSide = std::max(second.width, second.height);
+		if (firstSide != secondSide) { return firstSide > secondSide; }
+		return first.width * first.height > second.width * second.height;
+	});
+
+	// Pack into new layers first so nothing changes if the images don't fit
+	std::vector<Layer> packed;
+	std::vector<AtlasRegion> regions(entries.size());
+	for (std::size_t e : order)
+	{
+		if (!Place(packed, entries[e].region.width, entries[e].region.height, regions[e])) { return false; }
+	}
+
+	layers = std::move(packed);
+	for (std::size_t e : order)
+	{
+		entries[e].region = regions[e];
+		UploadEntry(entries[e]);
+	}
+
+	holeArea = 0;
+	generation++;
+	return true;
+}
+
+const textures::AtlasRegion& textures::TextureAtlas::Region(AtlasHandle handle) const
+{
+	if (handle == INVALID_ATLAS_HANDLE || handle > entries.size() || !entries[handle - 1].live) { return EMPTY_REGION; }
+	return entries[handle - 1].region;
+}
+
+float textures::TextureAtlas::Occupancy() const
+{
+	if (layers.empty()) { return 0.0f; }
+	return (float)liveArea / ((float)layers.size() * settings.size * settings.size);
+}
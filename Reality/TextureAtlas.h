@@ -0,0 +1,158 @@
+/**
+ * @file TextureAtlas.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Packs images into the layers of an array texture at
+ *        runtime so sprites can be batched without switching
+ *        textures
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Texture.h"
+
+namespace textures {
+
+	typedef unsigned int AtlasHandle;
+	constexpr AtlasHandle INVALID_ATLAS_HANDLE = 0;
+
+	enum class PackingMethod
+	{
+		Skyline,    // Fastest, best for images of similar height like glyphs
+		MaxRects    // Tighter for mixed sizes, slower as the free list grows
+	};
+
+	typedef struct AtlasSettings
+	{
+		int size       = 2048;  // Width and height of each layer
+		int maxLayers  = 8;
+		int mipLevels  = 1;
+		int gutter     = 2;     // Border texels copied around each image so filtering doesn't bleed in neighbours
+		int padding    = 0;     // Extra empty texels between images
+		PixelFormat format = PixelFormat::SRGB8_ALPHA8;  // Uncompressed only, images land at any texel
+		PackingMethod method = PackingMethod::Skyline;
+	} AtlasSettings;
+
+	// Where an image is in the atlas. UVs exclude the gutter
+	typedef struct AtlasRegion
+	{
+		int layer;
+		int x, y;               // Texel position of the image, excluding the gutter
+		int width, height;
+		float u0, v0, u1, v1;
+	} AtlasRegion;
+
+	/*
+	* Layers are filled in order, each with its own packer, so inserting
+	* only touches the packer of the layer the image lands in and uploads
+	* just that image. With mip levels, every slot is aligned to the size
+	* of one texel of the smallest level, so a texel at any level covers
+	* exactly one image and its gutter. A gutter at least that size keeps
+	* the last level from blending neighbours. Each image's slot is
+	* uploaded with its own mip chain, filtered on the CPU like loaded
+	* textures, so inserts never regenerate a whole layer. Removing an
+	* image leaves a hole. When an insert doesn't fit and the holes add
+	* up to enough room for it, the atlas repacks every image it holds
+	* from scratch, which moves regions and bumps Generation().
+	*/
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas() = default;
+		~TextureAtlas();
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		/**
+		* @brief        Create the array texture. GL thread only, like everything else
+		*
+		* @param ring   ring images are uploaded through. Must outlive the atlas
+		*/
+		bool Create(const AtlasSettings& settings, UploadRing& ring);
+		void Destroy();
+
+		/**
+		* @brief        Pack and upload an RGBA8 image. The atlas keeps a copy for repacking
+		*
+		* @return       handle to the image's region, or INVALID_ATLAS_HANDLE
+		*               if it doesn't fit even after repacking
+		*/
+		AtlasHandle Insert(const unsigned char* rgba, int width, int height);
+
+		// Free an image's space. MaxRects layers reuse it right away, skyline layers after the next repack
+		void Remove(AtlasHandle handle);
+
+		/**
+		* @brief        Repack every image from scratch, largest first, and upload
+		*               them all again. Regions change, so Generation() is bumped
+		*
+		* @return       false, leaving the atlas as it was, if they no longer fit
+		*/
+		bool Repack();
+
+		const AtlasRegion& Region(AtlasHandle handle) const;
+		const Texture& GetTexture() const { return texture; }
+
+		// Changes whenever existing regions move, so cached UVs can be refreshed
+		std::uint32_t Generation() const { return generation; }
+
+		// Fraction of the used layers' area covered by images
+		float Occupancy() const;
+		int LayersUsed() const { return (int)layers.size(); }
+
+	private:
+		typedef struct Rect
+		{
+			int x, y, width, height;
+		} Rect;
+
+		typedef struct SkylineNode
+		{
+			int x, y, width;
+		} SkylineNode;
+
+		// Packing state of one layer
+		typedef struct Layer
+		{
+			std::vector<SkylineNode> skyline;
+			std::vector<Rect> freeRects;
+		} Layer;
+
+		typedef struct Entry
+		{
+			bool live = false;
+			AtlasRegion region;
+			std::vector<unsigned char> pixels;
+		} Entry;
+
+		Layer NewLayer() const;
+		bool Pack(Layer& layer, int width, int height, int& x, int& y) const;
+		bool PackSkyline(Layer& layer, int width, int height, int& x, int& y) const;
+		bool PackMaxRects(Layer& layer, int width, int height, int& x, int& y) const;
+		void FreeMaxRect(Layer& layer, const Rect& rect) const;
+
+		// Size of the slot an image takes, with gutter, padding and alignment
+		int SlotSize(int size) const;
+
+		// Pack an image into the first of layers with room, adding a layer if allowed
+		bool Place(std::vector<Layer>& into, int width, int height, AtlasRegion& region) const;
+		void UploadEntry(const Entry& entry);
+
+		AtlasSettings settings;
+		UploadRing* ring = nullptr;
+		Texture texture;
+
+		std::vector<Layer> layers;
+		std::vector<Entry> entries;           // Indexed by handle - 1
+		std::vector<AtlasHandle> freeHandles;
+		std::size_t liveArea = 0;             // Texels of live images
+		std::size_t holeArea = 0;             // Texels of removed images' slots not yet reclaimed
+		std::uint32_t generation = 0;
+	};
+}
@@ -0,0 +1,179 @@
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "BlockCompression.h"
+#include "Image.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "Mipmap.h"
+#include "TextureLoader.h"
+
+textures::TextureLoader::TextureLoader(UploadRing& uploadRing, std::size_t queueCapacity)
+	: ring(uploadRing), decodedImages(queueCapacity) {}
+
+textures::TextureLoader::~TextureLoader()
+{
+	// Workers hold this loader until their image is queued
+	while (Pending() > 0)
+	{
+		DecodedImage* image;
+		if (!decodedImages.TryPop(image))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (image->staging.data) { ring.Free(image->staging); }
+		delete image;
+		pending--;
+	}
+}
+
+void textures::TextureLoader::Load(const std::string& path, PixelFormat format, int levels)
+{
+	// Without driver support, compressed formats load uncompressed
+	if (!IsSupported(format)) { format = IsSrgb(format) ? PixelFormat::SRGB8_ALPHA8 : PixelFormat::RGBA8; }
+	pending++;
+
+	jobs::Submit([this, path, format, levels]
+	{
+		DecodedImage* image = new DecodedImage();
+		image->path = path;
+		image->format = format;
+		image->levels = levels;
+		Decode(*image);
+
+		// Only waits if the GL thread has fallen a whole queue behind
+		while (!decodedImages.TryPush(image)) { std::this_thread::yield(); }
+	});
+}
+
+void textures::TextureLoader::Decode(DecodedImage& image)
+{
+	MappedFile file;
+	image::ImageInfo info;
+	if (!file.Open(image.path.c_str()) || !image::ReadInfo(file.Data(), file.Size(), info)) { return; }
+
+	image.width = info.width;
+	image.height = info.height;
+	if (image.levels <= 0) { image.levels = FullMipCount(info.width, info.height); }
+
+	// Room for the whole chain, so it can go up in one upload
+	std::size_t size = MipChainSize(image.format, info.width, info.height, image.levels);
+	image.staging = ring.Allocate(size);
+
+	// The ring's mapping is write-only, so reading it back is undefined, and uncached on
+	// real drivers besides. Filtering reads every level it writes, so chains are decoded
+	// and filtered in plain memory and only the finished chain is written to staging
+	if (!IsCompressed(image.format))
+	{
+		image.pixels.resize(size);
+		image.decoded = image::Decode(file.Data(), file.Size(), image.pixels.data());
+		if (!image.decoded) { return; }
+
+		GenerateMipChain(image.pixels.data(), info.width, info.height, image.levels, IsSrgb(image.format));
+		if (image.staging.data)
+		{
+			std::memcpy(image.staging.data, image.pixels.data(), size);
+			image.pixels = std::vector<unsigned char>();
+		}
+		return;
+	}
+
+	// Compression only writes its output, so it can write straight into staging
+	unsigned char* pixels = image.staging.data;
+	if (!pixels)
+	{
+		image.pixels.resize(size);
+		pixels = image.pixels.data();
+	}
+
+	std::vector<unsigned char> rgba(MipChainSize(PixelFormat::RGBA8, info.width, info.height, image.levels));
+	image.decoded = image::Decode(file.Data(), file.Size(), rgba.data());
+	if (image.decoded)
+	{
+		GenerateMipChain(rgba.data(), info.width, info.height, image.levels, IsSrgb(image.format));
+		CompressMipChain(rgba.data(), info.width, info.height, image.levels, image.format, pixels);
+	}
+}
+
+std::size_t textures::TextureLoader::Poll(std::vector<LoadedTexture>& loaded, std::size_t maxLoads)
+{
+	std::size_t count = 0;
+	DecodedImage* decodedImage;
+
+	while (count < maxLoads && decodedImages.TryPop(decodedImage))
+	{
+		std::unique_ptr<DecodedImage> image(decodedImage);
+		pending--;
+		count++;
+
+		LoadedTexture result;
+		result.path = image->path;
+
+		if (!image->decoded)
+		{
+			std::cerr << "Failed to load texture " << image->path << std::endl;
+			if (image->staging.data) { ring.Free(image->staging); }
+
+			loaded.push_back(std::move(result));
+			continue;
+		}
+
+		result.texture = Create2D(image->width, image->height, image->format, image->levels);
+		if (image->staging.data) { ring.UploadLevels(result.texture, 0, image->levels, image->staging); }
+		else
+		{
+			std::size_t offset = 0;
+			for (int level = 0; level < image->levels; level++)
+			{
+				ring.Upload(result.texture, level, 0, image->pixels.data() + offset);
+				offset += ImageSize(image->format, std::max(image->width >> level, 1), std::max(image->height >> level, 1));
+			}
+		}
+		loaded.push_back(std::move(result));
+	}
+
+	ring.Retire();
+	return count;
+}
+
+void textures::RunDecodeBenchmark(const std::vector<std::string>& paths)
+{
+	constexpr std::size_t RING_CAPACITY = 256 << 20;
+
+	UploadRing ring;
+	if (!ring.Create(RING_CAPACITY))
+	{
+		std::cerr << "Failed to create the upload ring" << std::endl;
+		return;
+	}
+
+	TextureLoader loader(ring);
+	std::vector<LoadedTexture> loaded;
+
+	auto start = std::chrono::steady_clock::now();
+	for (const std::string& path : paths) { loader.Load(path); }
+
+	while (loader.Pending() > 0)
+	{
+		if (loader.Poll(loaded) == 0) { std::this_thread::yield(); }
+	}
+	glFinish();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::size_t textureCount = 0;
+	for (LoadedTexture& result : loaded)
+	{
+		if (result.texture.id) { textureCount++; }
+		Release(result.texture);
+	}
+
+	UploadStats stats = ring.Stats();
+	std::cout << "Loaded " << textureCount << " of " << paths.size() << " images on " << jobs::ThreadCount()
+		<< " threads in " << seconds * 1000.0 << " ms, " << stats.bytes / (double)(1 << 20) / seconds << " MB/s of pixels" << std::endl;
+}
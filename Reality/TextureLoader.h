@@ -0,0 +1,101 @@
+/**
+ * @file TextureLoader.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Loads image files into textures without blocking the
+ *        GL thread: images decode on the job system's workers
+ *        and only the upload happens on the GL thread
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LockFreeQueue.h"
+#include "Texture.h"
+
+namespace textures {
+
+	typedef struct LoadedTexture
+	{
+		std::string path;
+		Texture texture;    // id is 0 if the image couldn't be loaded
+	} LoadedTexture;
+
+	/*
+	* Each Load maps the file and decodes it on a worker. Workers reserve
+	* the image's size from the upload ring and decode straight into that
+	* mapped memory, then fill in the mip chain behind it on the CPU, so
+	* the GL thread's only work is the glTexSubImage2D calls from the
+	* buffer. If the ring has no room the image decodes into its own
+	* memory instead and is copied through the ring when uploaded.
+	* Finished images come back through a lock-free queue that Poll drains.
+	*/
+	class TextureLoader
+	{
+	public:
+		/**
+		* @brief                Load through ring, which must outlive the loader
+		*
+		* @param queueCapacity  decoded images that can wait for Poll before workers stall
+		*/
+		explicit TextureLoader(UploadRing& ring, std::size_t queueCapacity = 256);
+
+		// Waits for queued loads to finish and discards them. GL thread only
+		~TextureLoader();
+
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+
+		/**
+		* @brief        Start loading an image file and return immediately
+		*
+		* @param levels mip levels to create, 0 for a full chain. Levels are generated on the worker
+		*/
+		void Load(const std::string& path, PixelFormat format = PixelFormat::SRGB8_ALPHA8, int levels = 0);
+
+		/**
+		* @brief            Create and upload textures for images that finished
+		*                   decoding, and retire finished uploads. GL thread only,
+		*                   called once a frame
+		*
+		* @param loaded     finished loads are appended, failed ones with a 0 id
+		* @param maxLoads   most images to upload this call, to bound the frame's cost
+		* @return           number of loads appended to loaded
+		*/
+		std::size_t Poll(std::vector<LoadedTexture>& loaded, std::size_t maxLoads = SIZE_MAX);
+
+		// Loads that haven't been returned by Poll yet
+		std::size_t Pending() const { return pending.load(std::memory_order_relaxed); }
+
+	private:
+		typedef struct DecodedImage
+		{
+			std::string path;
+			PixelFormat format;
+			int levels;
+			int width  = 0;
+			int height = 0;
+			bool decoded = false;
+			StagingAllocation staging;          // Where the pixels are, if the ring had room
+			std::vector<unsigned char> pixels;  // Otherwise
+		} DecodedImage;
+
+		void Decode(DecodedImage& image);
+
+		UploadRing& ring;
+		LockFreeQueue<DecodedImage*> decodedImages;
+		std::atomic<std::size_t> pending = 0;
+	};
+
+	/**
+	* @brief        Load every file in paths through a TextureLoader and print
+	*               the decode and upload throughput. Needs a current GL context
+	*/
+	void RunDecodeBenchmark(const std::vector<std::string>& paths);
+}
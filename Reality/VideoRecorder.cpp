@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include "JobSystem.h"
+#include "VideoRecorder.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define VIDEO_SSE2 1
+#else
+#define VIDEO_SSE2 0
+#endif
+
+namespace {
+
+	// Frames converted, queued or being written at once
+	constexpr int FRAME_BUFFERS = 3;
+
+	// Row pairs converted by one job
+	constexpr std::size_t ROW_PAIRS_PER_JOB = 16;
+
+	/*
+	* BT.601 limited range in 8 bit fixed point, which is what ffmpeg and
+	* players assume of yuv420p that carries no colour tags.
+	*/
+	inline unsigned char Luma(int r, int g, int b) { return (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+	inline unsigned char BlueChroma(int r, int g, int b) { return (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+	inline unsigned char RedChroma(int r, int g, int b) { return (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+
+	// Convert a pair of rows from pixel begin on, writing both luma rows and one row of each chroma plane
+	void ConvertRowPairScalar(const unsigned char* top, const unsigned char* bottom, int begin, int width,
+		unsigned char* topLuma, unsigned char* bottomLuma, unsigned char* u, unsigned char* v)
+	{
+		for (int x = begin; x < width; x += 2)
+		{
+			const unsigned char* pixels[4] = { top + x * 4, top + x * 4 + 4, bottom + x * 4, bottom + x * 4 + 4 };
+
+			topLuma[x]        = Luma(pixels[0][0], pixels[0][1], pixels[0][2]);
+			topLuma[x + 1]    = Luma(pixels[1][0], pixels[1][1], pixels[1][2]);
+			bottomLuma[x]     = Luma(pixels[2][0], pixels[2][1], pixels[2][2]);
+			bottomLuma[x + 1] = Luma(pixels[3][0], pixels[3][1], pixels[3][2]);
+
+			int sums[3] = { 0 };
+			for (const unsigned char* pixel : pixels)
+			{
+				for (int c = 0; c < 3; c++) { sums[c] += pixel[c]; }
+			}
+
+			const int r = (sums[0] + 2) >> 2, g = (sums[1] + 2) >> 2, b = (sums[2] + 2) >> 2;
+			u[x / 2] = BlueChroma(r, g, b);
+			v[x / 2] = RedChroma(r, g, b);
+		}
+	}
+
+#if VIDEO_SSE2
+	// Split 8 RGBA pixels into 16 bit R, G and B lanes
+	inline void Deinterleave(const unsigned char* pixels, __m128i& r, __m128i& g, __m128i& b)
+	{
+		const __m128i low = _mm_loadu_si128((const __m128i*)pixels);
+		const __m128i high = _mm_loadu_si128((const __m128i*)(pixels + 16));
+		const __m128i mask = _mm_set1_epi32(0xFF);
+
+		r = _mm_packs_epi32(_mm_and_si128(low, mask), _mm_and_si128(high, mask));
+		g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 8), mask), _mm_and_si128(_mm_srli_epi32(high, 8), mask));
+		b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(low, 16), mask), _mm_and_si128(_mm_srli_epi32(high, 16), mask));
+	}
+
+	// Luma of 8 pixels. The weighted sum stays under 2^16, so unsigned 16 bit lanes hold it exactly
+	inline void StoreLuma(unsigned char* out, __m128i r, __m128i g, __m128i b)
+	{
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+		sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+		const __m128i luma = _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+		_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(luma, luma));
+	}
+
+	// Average each 2x2 block of 8 pixels by 2 rows into 4 16 bit lanes, duplicated into the upper 4
+	inline __m128i AverageBlocks(__m128i top, __m128i bottom)
+	{
+		const __m128i pairs = _mm_madd_epi16(_mm_add_epi16(top, bottom), _mm_set1_epi16(1));
+		const __m128i average = _mm_srli_epi32(_mm_add_epi32(pairs, _mm_set1_epi32(2)), 2);
+		return _mm_packs_epi32(average, average);
+	}
+
+	// One chroma value from each of 4 averages. Every partial sum fits in signed 16 bits
+	inline void StoreChroma(unsigned char* out, __m128i r, __m128i g, __m128i b, short rWeight, short gWeight, short bWeight)
+	{
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(rWeight)), _mm_mullo_epi16(g, _mm_set1_epi16(gWeight)));
+		sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(bWeight)), _mm_set1_epi16(128)));
+		const __m128i chroma = _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+
+		const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(chroma, chroma));
+		std::memcpy(out, &packed, 4);
+	}
+
+	// Convert 8 pixels of a row pair at a time, returning where it stopped
+	int ConvertRowPairSse2(const unsigned char* top, const unsigned char* bottom, int width,
+		unsigned char* topLuma, unsigned char* bottomLuma, unsigned char* u, unsigned char* v)
+	{
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m128i topR, topG, topB, bottomR, bottomG, bottomB;
+			Deinterleave(top + x * 4, topR, topG, topB);
+			Deinterleave(bottom + x * 4, bottomR, bottomG, bottomB);
+
+			StoreLuma(topLuma + x, topR, topG, topB);
+			StoreLuma(bottomLuma + x, bottomR, bottomG, bottomB);
+
+			const __m128i r = AverageBlocks(topR, bottomR), g = AverageBlocks(topG, bottomG), b = AverageBlocks(topB, bottomB);
+			StoreChroma(u + x / 2, r, g, b, -38, -74, 112);
+			StoreChroma(v + x / 2, r, g, b, 112, -94, -18);
+		}
+		return x;
+	}
+#endif
+
+	void ConvertRows(const unsigned char* rgba, std::size_t rowSize, int width, int height, bool bottomUp, unsigned char* yuv,
+		std::size_t firstPair, std::size_t endPair, bool simd)
+	{
+		unsigned char* lumaPlane = yuv;
+		unsigned char* uPlane = yuv + (std::size_t)width * height;
+		unsigned char* vPlane = uPlane + (std::size_t)width * height / 4;
+		auto row = [&](int y) { return rgba + (std::size_t)(bottomUp ? height - 1 - y : y) * rowSize; };
+
+		for (std::size_t pair = firstPair; pair < endPair; pair++)
+		{
+			const int y = (int)pair * 2;
+			unsigned char* topLuma = lumaPlane + (std::size_t)y * width;
+			unsigned char* bottomLuma = topLuma + width;
+			unsigned char* u = uPlane + pair * (width / 2);
+			unsigned char* v = vPlane + pair * (width / 2);
+
+			int x = 0;
+#if VIDEO_SSE2
+			if (simd) { x = ConvertRowPairSse2(row(y), row(y + 1), width, topLuma, bottomLuma, u, v); }
+#endif
+			ConvertRowPairScalar(row(y), row(y + 1), x, width, topLuma, bottomLuma, u, v);
+		}
+	}
+
+	std::FILE* OpenPipe(const std::string& command)
+	{
+#ifdef _WIN32
+		return _popen(command.c_str(), "wb");
+#else
+		return popen(command.c_str(), "w");
+#endif
+	}
+
+	int ClosePipe(std::FILE* pipe)
+	{
+#ifdef _WIN32
+		return _pclose(pipe);
+#else
+		return pclose(pipe);
+#endif
+	}
+}
+
+void capture::RgbaToYuv420(const unsigned char* rgba, std::size_t rowSize, int width, int height, bool bottomUp, unsigned char* yuv)
+{
+	jobs::ParallelFor(height / 2, ROW_PAIRS_PER_JOB, [&](std::size_t begin, std::size_t end)
+	{
+		ConvertRows(rgba, rowSize, width, height, bottomUp, yuv, begin, end, true);
+	});
+}
+
+capture::VideoRecorder::VideoRecorder(const std::string& path, double videoFramerate, VideoFormat videoFormat, const std::string& options)
+	: outputPath(path), framerate(videoFramerate), format(videoFormat), encoderOptions(options)
+{
+	for (int f = 0; f < FRAME_BUFFERS; f++)
+	{
+		frames.push_back(std::make_unique<Frame>());
+		freeFrames.push_back(frames.back().get());
+	}
+
+	writer = std::thread([this] { Write(); });
+}
+
+capture::VideoRecorder::~VideoRecorder()
+{
+	Finish();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	frameQueued.notify_all();
+	writer.join();
+}
+
+bool capture::VideoRecorder::Start(int frameWidth, int frameHeight)
+{
+	started = true;
+	width = frameWidth & ~1;
+	height = frameHeight & ~1;
+	if (width == 0 || height == 0) { return false; }
+
+#ifndef _WIN32
+	// An encoder that exits early should fail the writes, not kill the process
+	std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+	// Bottom up RGBA is flipped by ffmpeg, YUV is flipped while converting
+	std::ostringstream command;
+	command << "ffmpeg -loglevel error -y -f rawvideo -pix_fmt " << (format == VideoFormat::Yuv420 ? "yuv420p" : "rgba")
+		<< " -video_size " << width << "x" << height << " -framerate " << framerate << " -i -"
+		<< (format == VideoFormat::Rgba ? " -vf vflip " : " ") << encoderOptions << " \"" << outputPath << "\"";
+
+	pipe = OpenPipe(command.str());
+	if (!pipe)
+	{
+		std::cerr << "Failed to start " << command.str() << std::endl;
+		return false;
+	}
+
+	const std::size_t frameSize = format == VideoFormat::Yuv420 ? (std::size_t)width * height * 3 / 2 : (std::size_t)width * height * 4;
+	for (std::unique_ptr<Frame>& frame : frames) { frame->data.resize(frameSize); }
+	return true;
+}
+
+void capture::VideoRecorder::Submit(const CapturedFrame& captured)
+{
+	bool startFailed = false;
+	if (!started)
+	{
+		firstSeconds = captured.seconds;
+		startFailed = !Start(captured.width, captured.height);
+	}
+
+	std::uint64_t videoFrame = (std::uint64_t)std::llround(std::max(captured.seconds - firstSeconds, 0.0) * framerate);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		failed |= startFailed;
+		if (finished || failed) { return; }
+
+		// Rendering faster than the video's framerate, or resized
+		if (videoFrame < nextVideoFrame || (captured.width & ~1) != width || (captured.height & ~1) != height)
+		{
+			stats.skipped++;
+			return;
+		}
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	Frame* frame;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		frameFreed.wait(lock, [this] { return !freeFrames.empty(); });
+		frame = freeFrames.back();
+		freeFrames.pop_back();
+	}
+	auto converting = std::chrono::steady_clock::now();
+
+	const std::size_t rowSize = (std::size_t)captured.width * 4;
+	if (format == VideoFormat::Yuv420) { RgbaToYuv420(captured.pixels, rowSize, width, height, true, frame->data.data()); }
+	else
+	{
+		for (int y = 0; y < height; y++) { std::memcpy(frame->data.data() + (std::size_t)y * width * 4, captured.pixels + y * rowSize, (std::size_t)width * 4); }
+	}
+
+	// Cover every video frame since the last one with this frame
+	frame->repeats = videoFrame - nextVideoFrame + 1;
+	nextVideoFrame = videoFrame + 1;
+
+	auto end = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queuedFrames.push_back(frame);
+		stats.frames++;
+		stats.blockedSeconds += std::chrono::duration<double>(converting - begin).count();
+		stats.convertSeconds += std::chrono::duration<double>(end - converting).count();
+	}
+	frameQueued.notify_one();
+}
+
+void capture::VideoRecorder::Write()
+{
+	while (true)
+	{
+		Frame* frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameQueued.wait(lock, [this] { return stopping || !queuedFrames.empty(); });
+			if (queuedFrames.empty()) { return; }
+
+			frame = queuedFrames.front();
+			queuedFrames.pop_front();
+		}
+
+		auto begin = std::chrono::steady_clock::now();
+		std::uint64_t written = 0;
+		bool writeFailed = false;
+		for (; written < frame->repeats && !writeFailed; written++)
+		{
+			writeFailed = std::fwrite(frame->data.data(), 1, frame->data.size(), pipe) != frame->data.size();
+		}
+		if (writeFailed) { written--; }
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (writeFailed && !failed) { std::cerr << "ffmpeg stopped reading frames for " << outputPath << std::endl; }
+			failed |= writeFailed;
+
+			freeFrames.push_back(frame);
+			stats.videoFrames += written;
+			stats.writeSeconds += seconds;
+		}
+		frameFreed.notify_all();
+	}
+}
+
+bool capture::VideoRecorder::Finish()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		frameFreed.wait(lock, [this] { return freeFrames.size() == frames.size(); });
+		if (finished) { return false; }
+		finished = true;
+	}
+
+	if (!pipe) { return false; }
+
+	// Closing the pipe ends ffmpeg's input, and pclose waits for it to finish the file
+	const int status = ClosePipe(pipe);
+	pipe = nullptr;
+	if (status != 0) { std::cerr << "ffmpeg failed to record " << outputPath << std::endl; }
+	return status == 0 && !failed;
+}
+
+capture::RecordingStats capture::VideoRecorder::Stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void capture::RunYuvBenchmark()
+{
+	constexpr int REPEATS = 10;
+	const int sizes[][2] = { { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+
+	std::cout << "RGBA to YUV 4:2:0 (" << (VIDEO_SSE2 ? "SSE2" : "no SIMD") << ", " << jobs::ThreadCount() << " threads)\n";
+	std::cout << "size\tscalar ms\tsimd ms\tparallel ms\tmismatches\n";
+
+	for (const int* size : sizes)
+	{
+		const int width = size[0], height = size[1];
+		const std::size_t rowSize = (std::size_t)width * 4;
+		const std::size_t yuvSize = (std::size_t)width * height * 3 / 2;
+
+		// Noise, so neighbouring pixels differ and every chroma average is exercised
+		std::vector<unsigned char> rgba(rowSize * height);
+		std::uint32_t state = 1;
+		for (unsigned char& byte : rgba)
+		{
+			state = state * 1664525u + 1013904223u;
+			byte = (unsigned char)(state >> 24);
+		}
+
+		std::vector<unsigned char> scalar(yuvSize), simd(yuvSize), parallel(yuvSize);
+		auto time = [&](auto&& convert)
+		{
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < REPEATS; r++) { convert(); }
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / REPEATS;
+		};
+
+		double scalarMs = time([&] { ConvertRows(rgba.data(), rowSize, width, height, true, scalar.data(), 0, height / 2, false); });
+		double simdMs = time([&] { ConvertRows(rgba.data(), rowSize, width, height, true, simd.data(), 0, height / 2, true); });
+		double parallelMs = time([&] { RgbaToYuv420(rgba.data(), rowSize, width, height, true, parallel.data()); });
+
+		std::size_t mismatches = 0;
+		for (std::size_t i = 0; i < yuvSize; i++) { mismatches += (scalar[i] != simd[i]) + (scalar[i] != parallel[i]); }
+
+		std::cout << width << "x" << height << '\t' << scalarMs << '\t' << simdMs << '\t' << parallelMs << '\t' << mismatches << '\n';
+	}
+
+	std::cout << std::flush;
+}
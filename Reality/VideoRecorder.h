@@ -0,0 +1,152 @@
+/**
+ * @file VideoRecorder.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief Records captured frames to video by piping them raw into a
+ *        local ffmpeg process
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameCapture.h"
+
+namespace capture {
+
+	// What is written down the pipe
+	enum class VideoFormat
+	{
+		Yuv420,  // Converted here, 37.5% the size of RGBA, and what x264 encodes anyway
+		Rgba     // As captured, leaving ffmpeg to convert
+	};
+
+	// Options given to ffmpeg for the output
+	constexpr const char* DEFAULT_ENCODER_OPTIONS = "-c:v libx264 -preset veryfast -crf 18 -pix_fmt yuv420p";
+
+	typedef struct RecordingStats
+	{
+		std::uint64_t frames      = 0;    // Captured frames recorded
+		std::uint64_t videoFrames = 0;    // Frames written to the video, repeats of slow frames included
+		std::uint64_t skipped     = 0;    // Captured frames left out to keep to the video's framerate
+		double convertSeconds     = 0.0;  // Time spent converting frames for the pipe
+		double writeSeconds       = 0.0;  // Time the writer thread spent writing to the pipe
+		double blockedSeconds     = 0.0;  // Time Submit waited for the writer
+	} RecordingStats;
+
+	/**
+	* @brief            Convert RGBA8 to planar YUV 4:2:0, BT.601 limited range:
+	*                   a width * height Y plane followed by U then V planes a
+	*                   quarter of its size. Chroma is the average of each 2x2
+	*                   block. Uses SSE2 where available, split across the job system
+	*
+	* @param rowSize    bytes between rows of rgba, at least width * 4
+	* @param width      even, as is height
+	* @param bottomUp   rgba is stored bottom row first, as glReadPixels returns it
+	* @param yuv        receives width * height * 3 / 2 bytes
+	*/
+	void RgbaToYuv420(const unsigned char* rgba, std::size_t rowSize, int width, int height, bool bottomUp, unsigned char* yuv);
+
+	/*
+	* The recorder starts ffmpeg on the first frame, once the frame size is
+	* known, reading raw video from its stdin. Submit converts each frame
+	* into one of a few buffers and queues it, and a writer thread writes
+	* the queue down the pipe, so converting one frame overlaps writing the
+	* last. When the encoder falls behind, the pipe fills, the writer
+	* blocks, and Submit blocks waiting for a buffer. Called from
+	* FrameCapture's consumer, that makes FrameCapture drop frames and the
+	* render loop never waits on the encoder.
+	*
+	* The video has a fixed framerate while frames arrive whenever they are
+	* rendered and captured, so frames are placed by their capture time:
+	* a frame landing on the same video frame as the last one is skipped,
+	* and one arriving late is repeated over the frames it missed. Dropped
+	* or slow frames then don't speed the recording up, and it plays back
+	* in real time.
+	*
+	* Frames of odd sizes lose their last column or row, and frames of a
+	* different size to the first are skipped.
+	*/
+	class VideoRecorder
+	{
+	public:
+		/**
+		* @brief                Start the writer thread. ffmpeg starts on the first frame
+		*
+		* @param outputPath     video file ffmpeg writes, its container chosen by extension
+		* @param encoderOptions ffmpeg options for the output
+		*/
+		VideoRecorder(const std::string& outputPath, double framerate = 60.0, VideoFormat format = VideoFormat::Yuv420,
+			const std::string& encoderOptions = DEFAULT_ENCODER_OPTIONS);
+
+		// Finishes and stops the writer thread
+		~VideoRecorder();
+
+		VideoRecorder(const VideoRecorder&) = delete;
+		VideoRecorder& operator=(const VideoRecorder&) = delete;
+
+		// Convert frame and queue it for the pipe. Blocks while every buffer is queued
+		void Submit(const CapturedFrame& frame);
+
+		/**
+		* @brief    Write every frame submitted, close the pipe and wait for ffmpeg
+		*           to finish the file. Frames submitted afterwards are ignored
+		*
+		* @return   whether ffmpeg started and exited successfully
+		*/
+		bool Finish();
+
+		RecordingStats Stats() const;
+
+	private:
+		typedef struct Frame
+		{
+			std::vector<unsigned char> data;
+			std::uint64_t repeats = 0;   // Times it is written
+		} Frame;
+
+		bool Start(int width, int height);
+		void Write();
+
+		std::string outputPath;
+		double framerate;
+		VideoFormat format;
+		std::string encoderOptions;
+
+		std::FILE* pipe = nullptr;
+		bool started  = false;
+		bool finished = false;
+		bool failed   = false;
+		int width  = 0;
+		int height = 0;
+		double firstSeconds = 0.0;
+		std::uint64_t nextVideoFrame = 0;
+
+		std::vector<std::unique_ptr<Frame>> frames;
+		std::vector<Frame*> freeFrames;
+		std::deque<Frame*> queuedFrames;
+		mutable std::mutex mutex;
+		std::condition_variable frameFreed;
+		std::condition_variable frameQueued;
+		std::thread writer;
+		bool stopping = false;
+
+		RecordingStats stats;
+	};
+
+	/**
+	* @brief    Time RgbaToYuv420 against plain C++ at a range of frame sizes,
+	*           check they agree, and print the results. CPU only
+	*/
+	void RunYuvBenchmark();
+}
@@ -0,0 +1,934 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include "JobSystem.h"
+#include "Zlib.h"
+
+namespace {
+
+	// Codes up to FAST_BITS long are decoded with a single table lookup
+	constexpr int FAST_BITS = 10;
+	constexpr int MAX_CODE_BITS = 15;
+	constexpr int MAX_SYMBOLS = 288;
+
+	constexpr std::uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::uint16_t DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr std::uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	constexpr std::uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// Canonical Huffman code
+	typedef struct Huffman
+	{
+		std::uint16_t fast[1 << FAST_BITS];        // (length << 9) | symbol, 0 if the code is longer than FAST_BITS
+		std::uint16_t counts[MAX_CODE_BITS + 1];   // Number of codes of each length
+		std::uint16_t symbols[MAX_SYMBOLS];        // Symbols ordered by code
+	} Huffman;
+
+	bool BuildHuffman(Huffman& huffman, const std::uint8_t* lengths, int count)
+	{
+		std::memset(huffman.fast, 0, sizeof(huffman.fast));
+		std::memset(huffman.counts, 0, sizeof(huffman.counts));
+
+		for (int s = 0; s < count; s++) { huffman.counts[lengths[s]]++; }
+		huffman.counts[0] = 0;
+
+		// More codes of a length than the code space allows. Incomplete codes are fine
+		int left = 1;
+		for (int length = 1; length <= MAX_CODE_BITS; length++)
+		{
+			left = (left << 1) - huffman.counts[length];
+			if (left < 0) { return false; }
+		}
+
+		std::uint16_t offsets[MAX_CODE_BITS + 1] = { 0 };
+		int nextCode[MAX_CODE_BITS + 1] = { 0 };
+		for (int length = 1; length < MAX_CODE_BITS; length++)
+		{
+			offsets[length + 1] = offsets[length] + huffman.counts[length];
+			nextCode[length + 1] = (nextCode[length] + huffman.counts[length]) << 1;
+		}
+
+		for (int s = 0; s < count; s++)
+		{
+			int length = lengths[s];
+			if (length == 0) { continue; }
+
+			huffman.symbols[offsets[length]++] = (std::uint16_t)s;
+
+			int code = nextCode[length]++;
+			if (length > FAST_BITS) { continue; }
+
+			// Codes are packed starting from their most significant bit, so the
+			// table is indexed by the reversed code plus every possible suffix
+			int reversed = 0;
+			for (int b = 0; b < length; b++) { reversed |= ((code >> b) & 1) << (length - 1 - b); }
+			for (int r = reversed; r < (1 << FAST_BITS); r += 1 << length)
+			{
+				huffman.fast[r] = (std::uint16_t)((length << 9) | s);
+			}
+		}
+
+		return true;
+	}
+
+	class BitReader
+	{
+	public:
+		BitReader(const unsigned char* data, std::size_t size) : at(data), end(data + size) {}
+
+		void Ensure(int count)
+		{
+			while (bitCount < count && bitCount <= 56)
+			{
+				// Past the end zeros are fed in and counted so Overrun can catch reads of them
+				std::uint64_t byte = 0;
+				if (at < end) { byte = *at++; }
+				else { padding++; }
+
+				bits |= byte << bitCount;
+				bitCount += 8;
+			}
+		}
+
+		std::uint32_t Peek(int count) const { return (std::uint32_t)(bits & ((1ull << count) - 1)); }
+
+		void Consume(int count)
+		{
+			bits >>= count;
+			bitCount -= count;
+		}
+
+		std::uint32_t Read(int count)
+		{
+			Ensure(count);
+			std::uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+
+		void AlignToByte() { Consume(bitCount & 7); }
+
+		// Whether any bits that were read came from past the end of the data
+		bool Overrun() const { return padding * 8 > bitCount; }
+
+		// Copy count whole bytes after aligning to a byte
+		bool CopyBytes(unsigned char* out, std::size_t count)
+		{
+			while (count > 0 && bitCount >= 8)
+			{
+				*out++ = (unsigned char)Read(8);
+				count--;
+			}
+			if (Overrun() || (std::size_t)(end - at) < count) { return false; }
+
+			if (count > 0) { std::memcpy(out, at, count); }
+			at += count;
+			return true;
+		}
+
+		int Decode(const Huffman& huffman)
+		{
+			Ensure(MAX_CODE_BITS);
+
+			std::uint16_t entry = huffman.fast[Peek(FAST_BITS)];
+			if (entry)
+			{
+				Consume(entry >> 9);
+				return entry & 511;
+			}
+
+			// Longer codes, a bit at a time
+			std::uint32_t next = Peek(MAX_CODE_BITS);
+			int code = 0, first = 0, index = 0;
+			for (int length = 1; length <= MAX_CODE_BITS; length++)
+			{
+				code |= (next >> (length - 1)) & 1;
+				int count = huffman.counts[length];
+				if (code - first < count)
+				{
+					Consume(length);
+					return huffman.symbols[index + code - first];
+				}
+
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+
+			return -1;
+		}
+
+	private:
+		const unsigned char* at;
+		const unsigned char* end;
+		std::uint64_t bits = 0;
+		int bitCount = 0;
+		int padding = 0;
+	};
+
+	class Inflater
+	{
+	public:
+		Inflater(const unsigned char* data, std::size_t size, std::vector<unsigned char>& output, std::size_t sizeHint,
+			std::size_t maxOutputSize) : reader(data, size), out(output), maxSize(maxOutputSize)
+		{
+			out.resize(std::min(sizeHint, maxSize));
+		}
+
+		bool Run()
+		{
+			bool last;
+			do
+			{
+				last = reader.Read(1);
+				bool valid;
+				switch (reader.Read(2))
+				{
+				case 0:  valid = StoredBlock(); break;
+				case 1:  valid = FixedBlock();  break;
+				case 2:  valid = DynamicBlock(); break;
+				default: valid = false;
+				}
+
+				if (!valid || reader.Overrun()) { return false; }
+			} while (!last);
+
+			out.resize(outSize);
+			return true;
+		}
+
+		BitReader& Reader() { return reader; }
+
+	private:
+		bool Reserve(std::size_t count)
+		{
+			if (outSize + count <= out.size()) { return true; }
+			if (outSize + count > maxSize) { return false; }
+
+			std::size_t grown = std::max<std::size_t>({ out.size() * 2, outSize + count, 1 << 16 });
+			out.resize(std::min(grown, maxSize));
+			return true;
+		}
+
+		bool StoredBlock()
+		{
+			reader.AlignToByte();
+			std::uint32_t length = reader.Read(16);
+			std::uint32_t inverse = reader.Read(16);
+			if ((length ^ 0xFFFF) != inverse || !Reserve(length)) { return false; }
+
+			if (!reader.CopyBytes(out.data() + outSize, length)) { return false; }
+			outSize += length;
+			return true;
+		}
+
+		bool FixedBlock()
+		{
+			static const Huffman* tables = []
+			{
+				static Huffman fixed[2];
+				std::uint8_t lengths[MAX_SYMBOLS];
+				std::memset(lengths, 8, 144);
+				std::memset(lengths + 144, 9, 112);
+				std::memset(lengths + 256, 7, 24);
+				std::memset(lengths + 280, 8, 8);
+				BuildHuffman(fixed[0], lengths, MAX_SYMBOLS);
+
+				std::memset(lengths, 5, 32);
+				BuildHuffman(fixed[1], lengths, 32);
+				return fixed;
+			}();
+
+			return Codes(tables[0], tables[1]);
+		}
+
+		bool DynamicBlock()
+		{
+			int literalCount = reader.Read(5) + 257;
+			int distanceCount = reader.Read(5) + 1;
+			int codeLengthCount = reader.Read(4) + 4;
+			if (literalCount > 286 || distanceCount > 30) { return false; }
+
+			std::uint8_t lengths[MAX_SYMBOLS + 32] = { 0 };
+			for (int c = 0; c < codeLengthCount; c++) { lengths[CODE_LENGTH_ORDER[c]] = (std::uint8_t)reader.Read(3); }
+
+			Huffman codeLengths;
+			if (!BuildHuffman(codeLengths, lengths, 19)) { return false; }
+
+			// Literal/length and distance code lengths are one run-length coded sequence
+			std::memset(lengths, 0, 19);
+			int total = literalCount + distanceCount;
+			for (int l = 0; l < total;)
+			{
+				int symbol = reader.Decode(codeLengths);
+				if (symbol < 0) { return false; }
+
+				if (symbol < 16)
+				{
+					lengths[l++] = (std::uint8_t)symbol;
+					continue;
+				}
+
+				std::uint8_t value = 0;
+				int repeat;
+				if (symbol == 16)
+				{
+					if (l == 0) { return false; }
+					value = lengths[l - 1];
+					repeat = 3 + reader.Read(2);
+				}
+				else if (symbol == 17) { repeat = 3 + reader.Read(3); }
+				else { repeat = 11 + reader.Read(7); }
+
+				if (l + repeat > total) { return false; }
+				std::memset(lengths + l, value, repeat);
+				l += repeat;
+			}
+
+			// Without an end of block code the block can't end
+			if (lengths[256] == 0) { return false; }
+
+			Huffman literals, distances;
+			if (!BuildHuffman(literals, lengths, literalCount) ||
+				!BuildHuffman(distances, lengths + literalCount, distanceCount)) { return false; }
+
+			return Codes(literals, distances);
+		}
+
+		bool Codes(const Huffman& literals, const Huffman& distances)
+		{
+			while (true)
+			{
+				int symbol = reader.Decode(literals);
+				if (symbol < 0) { return false; }
+
+				if (symbol < 256)
+				{
+					if (!Reserve(1)) { return false; }
+					out[outSize++] = (unsigned char)symbol;
+					continue;
+				}
+				if (symbol == 256) { return true; }
+
+				symbol -= 257;
+				if (symbol >= 29) { return false; }
+				std::size_t length = LENGTH_BASE[symbol] + reader.Read(LENGTH_EXTRA[symbol]);
+
+				int distanceSymbol = reader.Decode(distances);
+				if (distanceSymbol < 0 || distanceSymbol >= 30) { return false; }
+				std::size_t distance = DISTANCE_BASE[distanceSymbol] + reader.Read(DISTANCE_EXTRA[distanceSymbol]);
+
+				if (distance > outSize || !Reserve(length) || reader.Overrun()) { return false; }
+
+				unsigned char* to = out.data() + outSize;
+				const unsigned char* from = to - distance;
+				if (distance >= length) { std::memcpy(to, from, length); }
+				else
+				{
+					// Overlapping copies repeat the last distance bytes
+					for (std::size_t b = 0; b < length; b++) { to[b] = from[b]; }
+				}
+				outSize += length;
+			}
+		}
+
+		BitReader reader;
+		std::vector<unsigned char>& out;
+		std::size_t outSize = 0;
+		std::size_t maxSize;
+	};
+
+	/*
+	* Compression is greedy LZ77 over a 32K window with hash chains, each
+	* block of tokens then written with Huffman codes built for it, or
+	* stored if that comes out smaller.
+	*/
+
+	constexpr std::size_t WINDOW_SIZE = 32768;
+	constexpr int MIN_MATCH = 3;
+	constexpr int MAX_MATCH = 258;
+	constexpr int HASH_BITS = 15;
+	constexpr int MAX_CHAIN = 16;               // Candidates tried for each match
+	constexpr int LAZY_INSERT_LIMIT = 32;       // Longer matches only hash their first position
+	constexpr std::size_t BLOCK_TOKENS = 16384;
+	constexpr std::size_t MAX_STORED = 65535;   // Largest stored block
+	constexpr int LITERAL_CODES = 286;
+	constexpr int DISTANCE_CODES = 30;
+	constexpr int CODE_LENGTH_CODES = 19;
+	constexpr int MAX_CODE_LENGTH_BITS = 7;
+	constexpr int END_OF_BLOCK = 256;
+
+	// Inputs larger than this are split into chunks compressed in parallel
+	constexpr std::size_t PARALLEL_CHUNK = 256 << 10;
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<unsigned char>& output) : out(output) {}
+
+		// Codes go in least significant bit first, so Huffman codes have to be bit reversed.
+		// Bits are flushed 32 at a time, so count is at most 32
+		void Write(std::uint32_t value, int count)
+		{
+			bits |= (std::uint64_t)value << bitCount;
+			bitCount += count;
+			if (bitCount >= 32)
+			{
+				const unsigned char bytes[4] = { (unsigned char)bits, (unsigned char)(bits >> 8), (unsigned char)(bits >> 16), (unsigned char)(bits >> 24) };
+				out.insert(out.end(), bytes, bytes + 4);
+				bits >>= 32;
+				bitCount -= 32;
+			}
+		}
+
+		// Pad to a byte boundary and flush every whole byte
+		void AlignToByte()
+		{
+			bitCount = (bitCount + 7) & ~7;
+			while (bitCount > 0)
+			{
+				out.push_back((unsigned char)bits);
+				bits >>= 8;
+				bitCount -= 8;
+			}
+		}
+
+		void WriteBytes(const unsigned char* data, std::size_t count) { out.insert(out.end(), data, data + count); }
+
+	private:
+		std::vector<unsigned char>& out;
+		std::uint64_t bits = 0;
+		int bitCount = 0;
+	};
+
+	// A literal when distance is 0, otherwise a match
+	typedef struct Token
+	{
+		std::uint16_t value;      // Literal byte or match length
+		std::uint16_t distance;
+	} Token;
+
+	typedef struct SymbolFrequency
+	{
+		std::uint32_t frequency;
+		std::uint16_t symbol;
+	} SymbolFrequency;
+
+	/**
+	* @brief            Huffman code lengths for frequencies, at most maxBits long
+	*
+	* @param lengths    receives a length per symbol, 0 for unused ones
+	*/
+	void BuildCodeLengths(const std::uint32_t* frequencies, int count, int maxBits, std::uint8_t* lengths)
+	{
+		std::memset(lengths, 0, count);
+
+		SymbolFrequency used[MAX_SYMBOLS];
+		int usedCount = 0;
+		for (int s = 0; s < count; s++)
+		{
+			if (frequencies[s]) { used[usedCount++] = SymbolFrequency{ frequencies[s], (std::uint16_t)s }; }
+		}
+
+		// Decoders handle a single code, but some reject it, so there are always two
+		for (int s = 0; usedCount < 2 && s < count; s++)
+		{
+			if (!frequencies[s]) { used[usedCount++] = SymbolFrequency{ 1, (std::uint16_t)s }; }
+		}
+
+		std::sort(used, used + usedCount, [](const SymbolFrequency& a, const SymbolFrequency& b) { return a.frequency < b.frequency; });
+
+		// Moffat and Katajainen's in place minimum redundancy code: weights become
+		// parent links, then depths, then the code length of each symbol
+		std::uint32_t tree[MAX_SYMBOLS] = { 0 };
+		for (int i = 0; i < usedCount; i++) { tree[i] = used[i].frequency; }
+
+		int root = 0, leaf = 2;
+		tree[0] += tree[1];
+		for (int next = 1; next < usedCount - 1; next++)
+		{
+			if (leaf >= usedCount || tree[root] < tree[leaf]) { tree[next] = tree[root]; tree[root++] = next; }
+			else { tree[next] = tree[leaf++]; }
+
+			if (leaf >= usedCount || (root < next && tree[root] < tree[leaf])) { tree[next] += tree[root]; tree[root++] = next; }
+			else { tree[next] += tree[leaf++]; }
+		}
+
+		tree[usedCount - 2] = 0;
+		for (int next = usedCount - 3; next >= 0; next--) { tree[next] = tree[tree[next]] + 1; }
+
+		int available = 1, usedNodes = 0, depth = 0;
+		root = usedCount - 2;
+		int next = usedCount - 1;
+		while (available > 0)
+		{
+			while (root >= 0 && (int)tree[root] == depth) { usedNodes++; root--; }
+			while (available > usedNodes) { tree[next--] = depth; available--; }
+			available = 2 * usedNodes;
+			depth++;
+			usedNodes = 0;
+		}
+
+		// Cap the lengths, then take codes from the shortest lengths and give them to the
+		// longest until the code fits the code space exactly again
+		int lengthCounts[MAX_SYMBOLS] = { 0 };
+		for (int i = 0; i < usedCount; i++) { lengthCounts[std::min((int)tree[i], maxBits)]++; }
+
+		std::uint32_t total = 0;
+		for (int length = maxBits; length > 0; length--) { total += (std::uint32_t)lengthCounts[length] << (maxBits - length); }
+		while (total != (1u << maxBits))
+		{
+			lengthCounts[maxBits]--;
+			for (int length = maxBits - 1; length > 0; length--)
+			{
+				if (lengthCounts[length])
+				{
+					lengthCounts[length]--;
+					lengthCounts[length + 1] += 2;
+					break;
+				}
+			}
+			total--;
+		}
+
+		// Rarest symbols get the longest codes
+		int symbol = 0;
+		for (int length = maxBits; length > 0; length--)
+		{
+			for (int c = lengthCounts[length]; c > 0; c--) { lengths[used[symbol++].symbol] = (std::uint8_t)length; }
+		}
+	}
+
+	// Canonical codes for lengths, bit reversed for BitWriter
+	void BuildCodes(const std::uint8_t* lengths, int count, std::uint16_t* codes)
+	{
+		int lengthCounts[MAX_CODE_BITS + 1] = { 0 };
+		for (int s = 0; s < count; s++) { lengthCounts[lengths[s]]++; }
+		lengthCounts[0] = 0;
+
+		int nextCode[MAX_CODE_BITS + 2] = { 0 };
+		for (int length = 1; length <= MAX_CODE_BITS; length++) { nextCode[length + 1] = (nextCode[length] + lengthCounts[length]) << 1; }
+
+		for (int s = 0; s < count; s++)
+		{
+			const int length = lengths[s];
+			if (length == 0) { continue; }
+
+			const int code = nextCode[length]++;
+			int reversed = 0;
+			for (int b = 0; b < length; b++) { reversed |= ((code >> b) & 1) << (length - 1 - b); }
+			codes[s] = (std::uint16_t)reversed;
+		}
+	}
+
+	int LengthCode(int length)
+	{
+		return (int)(std::upper_bound(LENGTH_BASE, LENGTH_BASE + 29, length) - LENGTH_BASE) - 1;
+	}
+
+	int DistanceCode(int distance)
+	{
+		return (int)(std::upper_bound(DISTANCE_BASE, DISTANCE_BASE + 30, distance) - DISTANCE_BASE) - 1;
+	}
+
+	// Compresses one range of the input, primed with up to 32K of the input before it
+	class Deflater
+	{
+	public:
+		/**
+		* @param data       whole input
+		* @param begin      first byte to compress. Matches may reach back to begin - 32K
+		* @param end        byte after the last to compress
+		*/
+		Deflater(const unsigned char* data, std::size_t begin, std::size_t end, std::vector<unsigned char>& output)
+			: data(data), windowStart(begin > WINDOW_SIZE ? begin - WINDOW_SIZE : 0), begin(begin), end(end),
+			writer(output), head((std::size_t)1 << HASH_BITS, -1), previous(WINDOW_SIZE, -1)
+		{
+			tokens.reserve(BLOCK_TOKENS);
+		}
+
+		/**
+		* @brief        Compress the range
+		*
+		* @param last   mark the final block last. Otherwise the output ends with an
+		*               empty stored block so it ends on a byte boundary and another
+		*               range's output can follow it
+		*/
+		void Run(bool last)
+		{
+			for (std::size_t position = windowStart; position < begin; position++) { Insert(position); }
+
+			std::size_t position = begin, blockStart = begin;
+			while (position < end)
+			{
+				int distance = 0;
+				const int length = FindMatch(position, distance);
+
+				if (length >= MIN_MATCH)
+				{
+					tokens.push_back(Token{ (std::uint16_t)length, (std::uint16_t)distance });
+					Insert(position);
+					if (length <= LAZY_INSERT_LIMIT)
+					{
+						for (int i = 1; i < length; i++) { Insert(position + i); }
+					}
+					position += length;
+				}
+				else
+				{
+					tokens.push_back(Token{ data[position], 0 });
+					Insert(position);
+					position++;
+				}
+
+				if (tokens.size() >= BLOCK_TOKENS)
+				{
+					WriteBlock(blockStart, position, last && position == end);
+					blockStart = position;
+				}
+			}
+
+			if (!tokens.empty() || blockStart == begin) { WriteBlock(blockStart, position, last); }
+
+			if (!last)
+			{
+				// Empty stored block, as zlib's sync flush writes
+				writer.Write(0, 3);
+				writer.AlignToByte();
+				writer.Write(0x0000, 16);
+				writer.Write(0xFFFF, 16);
+			}
+			writer.AlignToByte();
+		}
+
+	private:
+		std::uint32_t Hash(std::size_t position) const
+		{
+			const std::uint32_t bytes = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+			return (bytes * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		void Insert(std::size_t position)
+		{
+			if (position + MIN_MATCH > end) { return; }
+
+			const std::uint32_t hash = Hash(position);
+			previous[(position - windowStart) & (WINDOW_SIZE - 1)] = head[hash];
+			head[hash] = (std::int32_t)(position - windowStart);
+		}
+
+		int FindMatch(std::size_t position, int& distance) const
+		{
+			if (position + MIN_MATCH > end) { return 0; }
+
+			const int maxLength = (int)std::min<std::size_t>(MAX_MATCH, end - position);
+			const unsigned char* current = data + position;
+			int bestLength = MIN_MATCH - 1;
+
+			std::int32_t candidate = head[Hash(position)];
+			for (int chain = 0; chain < MAX_CHAIN && candidate >= 0; chain++)
+			{
+				const std::size_t match = windowStart + candidate;
+				if (position - match > WINDOW_SIZE) { break; }
+
+				const unsigned char* previousBytes = data + match;
+				if (previousBytes[bestLength] == current[bestLength])
+				{
+					int length = 0;
+					while (length + 8 <= maxLength)
+					{
+						std::uint64_t a, b;
+						std::memcpy(&a, current + length, 8);
+						std::memcpy(&b, previousBytes + length, 8);
+						if (a != b)
+						{
+							length += std::countr_zero(a ^ b) >> 3;
+							break;
+						}
+						length += 8;
+					}
+					if (length + 8 > maxLength)
+					{
+						while (length < maxLength && current[length] == previousBytes[length]) { length++; }
+					}
+
+					if (length > bestLength)
+					{
+						bestLength = length;
+						distance = (int)(position - match);
+						if (length >= maxLength) { break; }
+					}
+				}
+
+				const std::int32_t next = previous[candidate & (WINDOW_SIZE - 1)];
+				if (next >= candidate) { break; }
+				candidate = next;
+			}
+
+			return bestLength >= MIN_MATCH ? bestLength : 0;
+		}
+
+		// Write tokens, which cover input [blockStart, blockEnd), as one block
+		void WriteBlock(std::size_t blockStart, std::size_t blockEnd, bool last)
+		{
+			std::uint32_t literalFrequencies[LITERAL_CODES] = { 0 }, distanceFrequencies[DISTANCE_CODES] = { 0 };
+			for (const Token& token : tokens)
+			{
+				if (token.distance == 0) { literalFrequencies[token.value]++; }
+				else
+				{
+					literalFrequencies[257 + LengthCode(token.value)]++;
+					distanceFrequencies[DistanceCode(token.distance)]++;
+				}
+			}
+			literalFrequencies[END_OF_BLOCK] = 1;
+
+			std::uint8_t literalLengths[LITERAL_CODES], distanceLengths[DISTANCE_CODES];
+			BuildCodeLengths(literalFrequencies, LITERAL_CODES, MAX_CODE_BITS, literalLengths);
+			BuildCodeLengths(distanceFrequencies, DISTANCE_CODES, MAX_CODE_BITS, distanceLengths);
+
+			int literalCount = LITERAL_CODES, distanceCount = DISTANCE_CODES;
+			while (literalCount > 257 && literalLengths[literalCount - 1] == 0) { literalCount--; }
+			while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) { distanceCount--; }
+
+			// Both code lengths run length coded as one sequence of code length symbols
+			std::uint8_t lengths[LITERAL_CODES + DISTANCE_CODES];
+			std::memcpy(lengths, literalLengths, literalCount);
+			std::memcpy(lengths + literalCount, distanceLengths, distanceCount);
+			const int lengthCount = literalCount + distanceCount;
+
+			std::uint8_t runs[LITERAL_CODES + DISTANCE_CODES], runExtras[LITERAL_CODES + DISTANCE_CODES];
+			std::uint32_t runFrequencies[CODE_LENGTH_CODES] = { 0 };
+			int runCount = 0;
+			for (int i = 0; i < lengthCount;)
+			{
+				int repeat = 1;
+				while (i + repeat < lengthCount && lengths[i + repeat] == lengths[i]) { repeat++; }
+
+				if (lengths[i] == 0 && repeat >= 3)
+				{
+					repeat = std::min(repeat, 138);
+					runs[runCount] = repeat >= 11 ? 18 : 17;
+					runExtras[runCount] = (std::uint8_t)(repeat - (repeat >= 11 ? 11 : 3));
+				}
+				else if (lengths[i] != 0 && repeat >= 4)
+				{
+					// The length itself, then up to 6 repeats of it
+					runs[runCount] = lengths[i];
+					runFrequencies[lengths[i]]++;
+					runCount++;
+					repeat = std::min(repeat - 1, 6) + 1;
+					runs[runCount] = 16;
+					runExtras[runCount] = (std::uint8_t)(repeat - 4);
+				}
+				else
+				{
+					repeat = 1;
+					runs[runCount] = lengths[i];
+				}
+
+				runFrequencies[runs[runCount]]++;
+				runCount++;
+				i += repeat;
+			}
+
+			std::uint8_t runLengths[CODE_LENGTH_CODES];
+			BuildCodeLengths(runFrequencies, CODE_LENGTH_CODES, MAX_CODE_LENGTH_BITS, runLengths);
+
+			int orderCount = CODE_LENGTH_CODES;
+			while (orderCount > 4 && runLengths[CODE_LENGTH_ORDER[orderCount - 1]] == 0) { orderCount--; }
+
+			// Size of the block both ways, to store it if compressing doesn't pay
+			std::uint64_t dynamicBits = 3 + 5 + 5 + 4 + 3 * orderCount;
+			for (int r = 0; r < runCount; r++)
+			{
+				dynamicBits += runLengths[runs[r]] + (runs[r] == 16 ? 2 : runs[r] == 17 ? 3 : runs[r] == 18 ? 7 : 0);
+			}
+			for (int s = 0; s < LITERAL_CODES; s++)
+			{
+				dynamicBits += (std::uint64_t)literalFrequencies[s] * (literalLengths[s] + (s > 256 ? LENGTH_EXTRA[s - 257] : 0));
+			}
+			for (int s = 0; s < DISTANCE_CODES; s++) { dynamicBits += (std::uint64_t)distanceFrequencies[s] * (distanceLengths[s] + DISTANCE_EXTRA[s]); }
+
+			const std::size_t blockSize = blockEnd - blockStart;
+			const std::uint64_t storedBits = (blockSize + 5 * (blockSize / MAX_STORED + 1)) * 8 + 7;
+
+			if (storedBits <= dynamicBits)
+			{
+				WriteStored(blockStart, blockEnd, last);
+				tokens.clear();
+				return;
+			}
+
+			std::uint16_t literalCodes[LITERAL_CODES] = { 0 }, distanceCodes[DISTANCE_CODES] = { 0 }, runCodes[CODE_LENGTH_CODES] = { 0 };
+			BuildCodes(literalLengths, LITERAL_CODES, literalCodes);
+			BuildCodes(distanceLengths, DISTANCE_CODES, distanceCodes);
+			BuildCodes(runLengths, CODE_LENGTH_CODES, runCodes);
+
+			writer.Write(last ? 1 : 0, 1);
+			writer.Write(2, 2);
+			writer.Write(literalCount - 257, 5);
+			writer.Write(distanceCount - 1, 5);
+			writer.Write(orderCount - 4, 4);
+			for (int i = 0; i < orderCount; i++) { writer.Write(runLengths[CODE_LENGTH_ORDER[i]], 3); }
+
+			for (int r = 0; r < runCount; r++)
+			{
+				writer.Write(runCodes[runs[r]], runLengths[runs[r]]);
+				if (runs[r] == 16) { writer.Write(runExtras[r], 2); }
+				else if (runs[r] == 17) { writer.Write(runExtras[r], 3); }
+				else if (runs[r] == 18) { writer.Write(runExtras[r], 7); }
+			}
+
+			for (const Token& token : tokens)
+			{
+				if (token.distance == 0)
+				{
+					writer.Write(literalCodes[token.value], literalLengths[token.value]);
+					continue;
+				}
+
+				const int lengthCode = LengthCode(token.value), distanceCode = DistanceCode(token.distance);
+				writer.Write(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+				writer.Write(token.value - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+				writer.Write(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+				writer.Write(token.distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+			}
+			writer.Write(literalCodes[END_OF_BLOCK], literalLengths[END_OF_BLOCK]);
+
+			tokens.clear();
+		}
+
+		void WriteStored(std::size_t blockStart, std::size_t blockEnd, bool last)
+		{
+			do
+			{
+				const std::size_t size = std::min(blockEnd - blockStart, MAX_STORED);
+				writer.Write(last && blockStart + size == blockEnd ? 1 : 0, 1);
+				writer.Write(0, 2);
+				writer.AlignToByte();
+				writer.Write((std::uint32_t)size, 16);
+				writer.Write((std::uint32_t)~size & 0xFFFF, 16);
+				writer.WriteBytes(data + blockStart, size);
+				blockStart += size;
+			} while (blockStart < blockEnd);
+		}
+
+		const unsigned char* data;
+		std::size_t windowStart;
+		std::size_t begin;
+		std::size_t end;
+		BitWriter writer;
+		std::vector<Token> tokens;
+		std::vector<std::int32_t> head;      // Latest position with each hash, relative to windowStart
+		std::vector<std::int32_t> previous;  // Position before it with the same hash, by position in the window
+	};
+}
+
+bool zlib::Inflate(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out,
+	std::size_t sizeHint, std::size_t maxSize)
+{
+	out.clear();
+	if (size < 6) { return false; }
+
+	// Deflate with at most a 32K window, a valid header check, and no preset dictionary
+	unsigned int method = data[0], flags = data[1];
+	if ((method & 15) != 8 || (method >> 4) > 7 || ((method << 8) | flags) % 31 != 0 || (flags & 0x20)) { return false; }
+
+	Inflater inflater(data + 2, size - 2, out, sizeHint, maxSize);
+	if (!inflater.Run()) { return false; }
+
+	BitReader& reader = inflater.Reader();
+	reader.AlignToByte();
+
+	std::uint32_t checksum = 0;
+	for (int b = 0; b < 4; b++) { checksum = (checksum << 8) | reader.Read(8); }
+
+	return !reader.Overrun() && checksum == Adler32(out.data(), out.size());
+}
+
+bool zlib::InflateRaw(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out,
+	std::size_t sizeHint, std::size_t maxSize)
+{
+	out.clear();
+	return Inflater(data, size, out, sizeHint, maxSize).Run();
+}
+
+std::uint32_t zlib::Adler32(const unsigned char* data, std::size_t size, std::uint32_t adler)
+{
+	// Largest run of bytes that can be summed before the sums could overflow 32 bits
+	constexpr std::size_t MAX_RUN = 5552;
+	constexpr std::uint32_t MODULUS = 65521;
+
+	std::uint32_t a = adler & 0xFFFF, b = adler >> 16;
+	while (size > 0)
+	{
+		std::size_t run = std::min(size, MAX_RUN);
+		for (std::size_t i = 0; i < run; i++)
+		{
+			a += data[i];
+			b += a;
+		}
+
+		a %= MODULUS;
+		b %= MODULUS;
+		data += run;
+		size -= run;
+	}
+
+	return (b << 16) | a;
+}
+
+std::uint32_t zlib::Adler32Combine(std::uint32_t adler, std::uint32_t nextAdler, std::size_t nextSize)
+{
+	constexpr std::uint32_t MODULUS = 65521;
+
+	// a sums shift by the first part's a, b sums by nextSize copies of it
+	const std::uint32_t remainder = (std::uint32_t)(nextSize % MODULUS);
+	std::uint32_t a = adler & 0xFFFF;
+	std::uint32_t b = (remainder * a) % MODULUS;
+	a += (nextAdler & 0xFFFF) + MODULUS - 1;
+	b += (adler >> 16) + (nextAdler >> 16) + MODULUS - remainder;
+
+	a %= MODULUS;
+	b %= MODULUS;
+	return (b << 16) | a;
+}
+
+void zlib::Deflate(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out)
+{
+	const std::size_t chunkCount = std::max<std::size_t>((size + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK, 1);
+	std::vector<std::vector<unsigned char>> chunks(chunkCount);
+	std::vector<std::uint32_t> checksums(chunkCount);
+
+	jobs::ParallelFor(chunkCount, 1, [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t c = first; c < last; c++)
+		{
+			const std::size_t begin = c * PARALLEL_CHUNK, end = std::min(begin + PARALLEL_CHUNK, size);
+			chunks[c].reserve((end - begin) / 2);
+			Deflater(data, begin, end, chunks[c]).Run(c == chunkCount - 1);
+			checksums[c] = Adler32(data + begin, end - begin);
+		}
+	});
+
+	// 32K window, default compression, no dictionary
+	out.clear();
+	out.push_back(0x78);
+	out.push_back(0x9C);
+
+	std::uint32_t checksum = 1;
+	for (std::size_t c = 0; c < chunkCount; c++)
+	{
+		out.insert(out.end(), chunks[c].begin(), chunks[c].end());
+		const std::size_t begin = c * PARALLEL_CHUNK;
+		checksum = Adler32Combine(checksum, checksums[c], std::min(begin + PARALLEL_CHUNK, size) - begin);
+	}
+
+	for (int b = 3; b >= 0; b--) { out.push_back((unsigned char)(checksum >> (b * 8))); }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file Zlib.h
+ * @author Sam Cain (samuelrcain@gmail.com)
+ * @brief zlib (RFC 1950) and deflate (RFC 1951) compression and
+ *        decompression for image formats that store pixels compressed
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zlib {
+
+	/**
+	* @brief            Decompress a zlib stream and verify its checksum
+	*
+	* @param data       zlib header, deflate data and Adler-32 trailer
+	* @param out        receives the decompressed bytes
+	* @param sizeHint   expected decompressed size, if known, so out is allocated once
+	* @param maxSize    fail instead of decompressing more than this many bytes
+	* @return           whether the stream was valid and complete
+	*/
+	bool Inflate(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out,
+		std::size_t sizeHint = 0, std::size_t maxSize = SIZE_MAX);
+
+	// Decompress raw deflate data with no zlib header or trailer
+	bool InflateRaw(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out,
+		std::size_t sizeHint = 0, std::size_t maxSize = SIZE_MAX);
+
+	std::uint32_t Adler32(const unsigned char* data, std::size_t size, std::uint32_t adler = 1);
+
+	// Adler-32 of two pieces of data joined, from each piece's checksum and the second's size
+	std::uint32_t Adler32Combine(std::uint32_t adler, std::uint32_t nextAdler, std::size_t nextSize);
+
+	/**
+	* @brief        Compress data to a zlib stream. Large inputs are split into
+	*               chunks compressed in parallel on the job system, each primed
+	*               with the 32K before it so matches still reach across chunks
+	*
+	* @param out    receives the stream, replacing its contents
+	*/
+	void Deflate(const unsigned char* data, std::size_t size, std::vector<unsigned char>& out);
+}